@@ -64,6 +64,7 @@
 #include "units.h"
 #include "language.h"
 #include "gimp-debug.h"
+#include "gimp-startup-profile.h"
 
 #include "gimp-intl.h"
 
@@ -186,6 +187,8 @@ app_run (const gchar         *full_prog_name,
       filenames = NULL;
     }
 
+  gimp_startup_profile_begin ("startup");
+
   /*  Create an instance of the "Gimp" object which is the root of the
    *  core object system
    */
@@ -235,13 +238,17 @@ app_run (const gchar         *full_prog_name,
 
   g_object_unref (gimpdir);
 
+  gimp_startup_profile_begin ("config");
   gimp_load_config (gimp, alternate_system_gimprc, alternate_gimprc);
+  gimp_startup_profile_end ();
 
   /*  change the locale if a language if specified  */
   language_init (gimp->config->language);
 
   /*  initialize lowlevel stuff  */
+  gimp_startup_profile_begin ("gegl");
   gimp_gegl_init (gimp);
+  gimp_startup_profile_end ();
 
   /*  Connect our restore_after callback before gui_init() connects
    *  theirs, so ours runs first and can grab the initial monitor
@@ -253,7 +260,11 @@ app_run (const gchar         *full_prog_name,
 
 #ifndef GIMP_CONSOLE_COMPILATION
   if (! no_interface)
-    update_status_func = gui_init (gimp, no_splash);
+    {
+      gimp_startup_profile_begin ("gui");
+      update_status_func = gui_init (gimp, no_splash);
+      gimp_startup_profile_end ();
+    }
 #endif
 
   if (! update_status_func)
@@ -262,11 +273,15 @@ app_run (const gchar         *full_prog_name,
   /*  Create all members of the global Gimp instance which need an already
    *  parsed gimprc, e.g. the data factories
    */
+  gimp_startup_profile_begin ("initialize");
   gimp_initialize (gimp, update_status_func);
+  gimp_startup_profile_end ();
 
   /*  Load all data files
    */
+  gimp_startup_profile_begin ("restore");
   gimp_restore (gimp, update_status_func);
+  gimp_startup_profile_end ();
 
   /*  enable autosave late so we don't autosave when the
    *  monitor resolution is set in gui_init()
@@ -285,6 +300,8 @@ app_run (const gchar         *full_prog_name,
     {
       gint i;
 
+      gimp_startup_profile_begin ("images");
+
       for (i = 0; filenames[i] != NULL; i++)
         {
           if (run_loop)
@@ -298,8 +315,13 @@ app_run (const gchar         *full_prog_name,
               g_object_unref (file);
             }
         }
+
+      gimp_startup_profile_end ();
     }
 
+  /*  batch commands and the main loop are not part of the startup  */
+  gimp_startup_profile_end ();
+
   if (run_loop)
     batch_run (gimp, batch_interpreter, batch_commands);
 
@@ -312,12 +334,16 @@ app_run (const gchar         *full_prog_name,
 
   g_main_loop_unref (loop);
 
+  gimp_gegl_exit (gimp);
+
   g_object_unref (gimp);
 
   gimp_debug_instances ();
 
   errors_exit ();
   gegl_exit ();
+
+  gimp_startup_profile_exit ();
 }
 
 
@@ -371,6 +397,8 @@ app_exit_after_callback (Gimp       *gimp,
 
   gegl_exit ();
 
+  gimp_startup_profile_exit ();
+
   exit (EXIT_SUCCESS);
 
 #endif
@@ -283,6 +283,37 @@ gimp_position_get_type (void)
   return type;
 }
 
+GType
+gimp_xcf_compression_get_type (void)
+{
+  static const GEnumValue values[] =
+  {
+    { GIMP_XCF_COMPRESSION_RLE, "GIMP_XCF_COMPRESSION_RLE", "rle" },
+    { GIMP_XCF_COMPRESSION_ZLIB, "GIMP_XCF_COMPRESSION_ZLIB", "zlib" },
+    { GIMP_XCF_COMPRESSION_ZSTD, "GIMP_XCF_COMPRESSION_ZSTD", "zstd" },
+    { 0, NULL, NULL }
+  };
+
+  static const GimpEnumDesc descs[] =
+  {
+    { GIMP_XCF_COMPRESSION_RLE, NC_("xcf-compression", "RLE"), NULL },
+    { GIMP_XCF_COMPRESSION_ZLIB, NC_("xcf-compression", "zlib"), NULL },
+    { GIMP_XCF_COMPRESSION_ZSTD, NC_("xcf-compression", "Zstandard"), NULL },
+    { 0, NULL, NULL }
+  };
+
+  static GType type = 0;
+
+  if (G_UNLIKELY (! type))
+    {
+      type = g_enum_register_static ("GimpXcfCompression", values);
+      gimp_type_set_translation_context (type, "xcf-compression");
+      gimp_enum_set_value_descriptions (type, descs);
+    }
+
+  return type;
+}
+
 
 /* Generated data ends here */
 
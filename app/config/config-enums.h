@@ -124,4 +124,16 @@ typedef enum
   GIMP_POSITION_RIGHT   /*< desc="Right" >*/
 } GimpPosition;
 
+
+#define GIMP_TYPE_XCF_COMPRESSION (gimp_xcf_compression_get_type ())
+
+GType gimp_xcf_compression_get_type (void) G_GNUC_CONST;
+
+typedef enum
+{
+  GIMP_XCF_COMPRESSION_RLE,  /*< desc="RLE"       >*/
+  GIMP_XCF_COMPRESSION_ZLIB, /*< desc="zlib"      >*/
+  GIMP_XCF_COMPRESSION_ZSTD  /*< desc="Zstandard" >*/
+} GimpXcfCompression;
+
 #endif /* __CONFIG_ENUMS_H__ */
@@ -96,6 +96,7 @@ enum
   PROP_DEFAULT_GRID,
   PROP_UNDO_LEVELS,
   PROP_UNDO_SIZE,
+  PROP_UNDO_COMPRESSED_SIZE,
   PROP_UNDO_PREVIEW_SIZE,
   PROP_PLUG_IN_HISTORY_SIZE,
   PROP_PLUGINRC_PATH,
@@ -107,6 +108,12 @@ enum
   PROP_COLOR_PROFILE_POLICY,
   PROP_SAVE_DOCUMENT_HISTORY,
   PROP_QUICK_MASK_COLOR,
+  PROP_XCF_LAZY_LOADING,
+  PROP_XCF_COMPRESSION,
+  PROP_XCF_COMPRESSION_LEVEL,
+  PROP_XCF_SAVE_MIPMAPS,
+  PROP_BRUSH_CACHE_SIZE,
+  PROP_LAZY_DATA_LOADING,
 
   /* ignored, only for backward compatibility: */
   PROP_INSTALL_COLORMAP,
@@ -448,6 +455,11 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                                     0, GIMP_MAX_MEMSIZE, undo_size,
                                     GIMP_PARAM_STATIC_STRINGS |
                                     GIMP_CONFIG_PARAM_CONFIRM);
+  GIMP_CONFIG_INSTALL_PROP_MEMSIZE (object_class, PROP_UNDO_COMPRESSED_SIZE,
+                                    "undo-compressed-size",
+                                    UNDO_COMPRESSED_SIZE_BLURB,
+                                    0, GIMP_MAX_MEMSIZE, 1 << 28,
+                                    GIMP_PARAM_STATIC_STRINGS);
   GIMP_CONFIG_INSTALL_PROP_ENUM (object_class, PROP_UNDO_PREVIEW_SIZE,
                                  "undo-preview-size", UNDO_PREVIEW_SIZE_BLURB,
                                  GIMP_TYPE_VIEW_SIZE,
@@ -506,6 +518,37 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                                 "quick-mask-color", QUICK_MASK_COLOR_BLURB,
                                 TRUE, &red,
                                 GIMP_PARAM_STATIC_STRINGS);
+  GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_XCF_LAZY_LOADING,
+                                    "xcf-lazy-loading",
+                                    XCF_LAZY_LOADING_BLURB,
+                                    FALSE,
+                                    GIMP_PARAM_STATIC_STRINGS);
+  GIMP_CONFIG_INSTALL_PROP_ENUM (object_class, PROP_XCF_COMPRESSION,
+                                 "xcf-compression",
+                                 XCF_COMPRESSION_BLURB,
+                                 GIMP_TYPE_XCF_COMPRESSION,
+                                 GIMP_XCF_COMPRESSION_ZLIB,
+                                 GIMP_PARAM_STATIC_STRINGS);
+  GIMP_CONFIG_INSTALL_PROP_INT (object_class, PROP_XCF_COMPRESSION_LEVEL,
+                                "xcf-compression-level",
+                                XCF_COMPRESSION_LEVEL_BLURB,
+                                0, 9, 0,
+                                GIMP_PARAM_STATIC_STRINGS);
+  GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_XCF_SAVE_MIPMAPS,
+                                    "xcf-save-mipmaps",
+                                    XCF_SAVE_MIPMAPS_BLURB,
+                                    FALSE,
+                                    GIMP_PARAM_STATIC_STRINGS);
+  GIMP_CONFIG_INSTALL_PROP_MEMSIZE (object_class, PROP_BRUSH_CACHE_SIZE,
+                                    "brush-cache-size",
+                                    BRUSH_CACHE_SIZE_BLURB,
+                                    0, GIMP_MAX_MEMSIZE, 1 << 25,
+                                    GIMP_PARAM_STATIC_STRINGS);
+  GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_LAZY_DATA_LOADING,
+                                    "lazy-data-loading",
+                                    LAZY_DATA_LOADING_BLURB,
+                                    FALSE,
+                                    GIMP_PARAM_STATIC_STRINGS);
 
   /*  only for backward compatibility:  */
   GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_INSTALL_COLORMAP,
@@ -758,6 +801,9 @@ gimp_core_config_set_property (GObject      *object,
     case PROP_UNDO_SIZE:
       core_config->undo_size = g_value_get_uint64 (value);
       break;
+    case PROP_UNDO_COMPRESSED_SIZE:
+      core_config->undo_compressed_size = g_value_get_uint64 (value);
+      break;
     case PROP_UNDO_PREVIEW_SIZE:
       core_config->undo_preview_size = g_value_get_enum (value);
       break;
@@ -791,6 +837,24 @@ gimp_core_config_set_property (GObject      *object,
     case PROP_QUICK_MASK_COLOR:
       gimp_value_get_rgb (value, &core_config->quick_mask_color);
       break;
+    case PROP_XCF_LAZY_LOADING:
+      core_config->xcf_lazy_loading = g_value_get_boolean (value);
+      break;
+    case PROP_XCF_COMPRESSION:
+      core_config->xcf_compression = g_value_get_enum (value);
+      break;
+    case PROP_XCF_COMPRESSION_LEVEL:
+      core_config->xcf_compression_level = g_value_get_int (value);
+      break;
+    case PROP_XCF_SAVE_MIPMAPS:
+      core_config->xcf_save_mipmaps = g_value_get_boolean (value);
+      break;
+    case PROP_BRUSH_CACHE_SIZE:
+      core_config->brush_cache_size = g_value_get_uint64 (value);
+      break;
+    case PROP_LAZY_DATA_LOADING:
+      core_config->lazy_data_loading = g_value_get_boolean (value);
+      break;
 
     case PROP_INSTALL_COLORMAP:
     case PROP_MIN_COLORS:
@@ -939,6 +1003,9 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_UNDO_SIZE:
       g_value_set_uint64 (value, core_config->undo_size);
       break;
+    case PROP_UNDO_COMPRESSED_SIZE:
+      g_value_set_uint64 (value, core_config->undo_compressed_size);
+      break;
     case PROP_UNDO_PREVIEW_SIZE:
       g_value_set_enum (value, core_config->undo_preview_size);
       break;
@@ -969,6 +1036,24 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_QUICK_MASK_COLOR:
       gimp_value_set_rgb (value, &core_config->quick_mask_color);
       break;
+    case PROP_XCF_LAZY_LOADING:
+      g_value_set_boolean (value, core_config->xcf_lazy_loading);
+      break;
+    case PROP_XCF_COMPRESSION:
+      g_value_set_enum (value, core_config->xcf_compression);
+      break;
+    case PROP_XCF_COMPRESSION_LEVEL:
+      g_value_set_int (value, core_config->xcf_compression_level);
+      break;
+    case PROP_XCF_SAVE_MIPMAPS:
+      g_value_set_boolean (value, core_config->xcf_save_mipmaps);
+      break;
+    case PROP_BRUSH_CACHE_SIZE:
+      g_value_set_uint64 (value, core_config->brush_cache_size);
+      break;
+    case PROP_LAZY_DATA_LOADING:
+      g_value_set_boolean (value, core_config->lazy_data_loading);
+      break;
 
     case PROP_INSTALL_COLORMAP:
     case PROP_MIN_COLORS:
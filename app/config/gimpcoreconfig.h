@@ -80,6 +80,7 @@ struct _GimpCoreConfig
   GimpGrid               *default_grid;
   gint                    levels_of_undo;
   guint64                 undo_size;
+  guint64                 undo_compressed_size;
   GimpViewSize            undo_preview_size;
   gint                    plug_in_history_size;
   gchar                  *plug_in_rc_path;
@@ -91,6 +92,12 @@ struct _GimpCoreConfig
   GimpColorProfilePolicy  color_profile_policy;
   gboolean                save_document_history;
   GimpRGB                 quick_mask_color;
+  gboolean                xcf_lazy_loading;
+  GimpXcfCompression      xcf_compression;
+  gint                    xcf_compression_level;
+  gboolean                xcf_save_mipmaps;
+  guint64                 brush_cache_size;
+  gboolean                lazy_data_loading;
 };
 
 struct _GimpCoreConfigClass
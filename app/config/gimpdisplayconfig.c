@@ -41,6 +41,7 @@
 #define DEFAULT_MONITOR_RESOLUTION   96.0
 #define DEFAULT_MARCHING_ANTS_SPEED  200
 #define DEFAULT_USE_EVENT_HISTORY    FALSE
+#define DEFAULT_COLOR_TRANSFORM_LUT  FALSE
 
 enum
 {
@@ -70,6 +71,7 @@ enum
   PROP_SPACE_BAR_ACTION,
   PROP_ZOOM_QUALITY,
   PROP_USE_EVENT_HISTORY,
+  PROP_COLOR_TRANSFORM_LUT,
 
   /* ignored, only for backward compatibility: */
   PROP_DEFAULT_SNAP_TO_GUIDES,
@@ -243,6 +245,12 @@ gimp_display_config_class_init (GimpDisplayConfigClass *klass)
                                     DEFAULT_USE_EVENT_HISTORY,
                                     GIMP_PARAM_STATIC_STRINGS);
 
+  GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_COLOR_TRANSFORM_LUT,
+                                    "color-transform-lut",
+                                    COLOR_TRANSFORM_LUT_BLURB,
+                                    DEFAULT_COLOR_TRANSFORM_LUT,
+                                    GIMP_PARAM_STATIC_STRINGS);
+
   /*  only for backward compatibility:  */
   GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_DEFAULT_SNAP_TO_GUIDES,
                                     "default-snap-to-guides", NULL,
@@ -403,6 +411,9 @@ gimp_display_config_set_property (GObject      *object,
     case PROP_USE_EVENT_HISTORY:
       display_config->use_event_history = g_value_get_boolean (value);
       break;
+    case PROP_COLOR_TRANSFORM_LUT:
+      display_config->color_transform_lut = g_value_get_boolean (value);
+      break;
 
     case PROP_DEFAULT_SNAP_TO_GUIDES:
     case PROP_DEFAULT_SNAP_TO_GRID:
@@ -504,6 +515,9 @@ gimp_display_config_get_property (GObject    *object,
     case PROP_USE_EVENT_HISTORY:
       g_value_set_boolean (value, display_config->use_event_history);
       break;
+    case PROP_COLOR_TRANSFORM_LUT:
+      g_value_set_boolean (value, display_config->color_transform_lut);
+      break;
 
     case PROP_DEFAULT_SNAP_TO_GUIDES:
     case PROP_DEFAULT_SNAP_TO_GRID:
@@ -66,6 +66,7 @@ struct _GimpDisplayConfig
   GimpSpaceBarAction  space_bar_action;
   GimpZoomQuality     zoom_quality;
   gboolean            use_event_history;
+  gboolean            color_transform_lut;
 };
 
 struct _GimpDisplayConfigClass
@@ -19,6 +19,10 @@ _("When enabled, an image will become the active image when its image " \
 
 #define BRUSH_PATH_WRITABLE_BLURB ""
 
+#define BRUSH_CACHE_SIZE_BLURB \
+_("Sets the amount of memory each brush in use may spend on keeping " \
+  "scaled, rotated and distorted copies of itself around while painting.")
+
 #define DYNAMICS_PATH_BLURB \
 _("Sets the dynamics search path.")
 
@@ -42,6 +46,11 @@ _("Specifies how the area around the image should be drawn.")
 #define COLOR_PROFILE_POLICY_BLURB \
 _("How to handle embedded color profiles when opening a file.")
 
+#define COLOR_TRANSFORM_LUT_BLURB \
+_("When enabled, the transform to the monitor profile is computed once " \
+  "into a lookup table, which makes color managed display faster.  The " \
+  "table is not used if it differs too much from the exact transform.")
+
 #define CURSOR_FORMAT_BLURB \
 _("Sets the pixel format to use for mouse pointers.")
 
@@ -288,6 +297,10 @@ _("Sets whether GIMP should create previews of layers and channels. " \
 _("Sets the preview size used for layers and channel previews in newly " \
   "created dialogs.")
 
+#define LAZY_DATA_LOADING_BLURB \
+_("When enabled, brushes and patterns are listed from an index at " \
+  "startup, and their pixels are only read when they are first used.")
+
 #define QUICK_MASK_COLOR_BLURB \
 _("Sets the default quick mask color.")
 
@@ -475,6 +488,11 @@ _("Sets an upper limit to the memory that is used per image to keep " \
   "operations on the undo stack. Regardless of this setting, at least " \
   "as many undo-levels as configured can be undone.")
 
+#define UNDO_COMPRESSED_SIZE_BLURB \
+_("Undo steps which are not the most recent one are compressed in the " \
+  "background. This sets the memory that is used per image to keep " \
+  "compressed undo steps, older ones are moved to the swap folder.")
+
 #define UNDO_PREVIEW_SIZE_BLURB \
 _("Sets the size of the previews in the Undo History.")
 
@@ -492,6 +510,25 @@ _("When enabled, uses OpenCL for some operations.")
 "The location of the online user manual. This is used if " \
 "'user-manual-online' is enabled."
 
+#define XCF_LAZY_LOADING_BLURB \
+_("When enabled, the pixels of layers and layer masks in XCF files are " \
+  "only read from disk when they are first needed.  The file is kept " \
+  "open while the image is open.")
+
+#define XCF_COMPRESSION_BLURB \
+_("The compression used for the pixels of XCF files.  RLE files can be " \
+  "read by older versions of GIMP, Zstandard is faster than zlib at " \
+  "similar file sizes.")
+
+#define XCF_COMPRESSION_LEVEL_BLURB \
+_("The compression level used for zlib and Zstandard compressed XCF " \
+  "files, from 1 (fastest) to 9 (smallest).  0 uses the codec's default.")
+
+#define XCF_SAVE_MIPMAPS_BLURB \
+_("When enabled, XCF files also contain downscaled copies of all " \
+  "layers, so thumbnails can be created without reading the full " \
+  "size pixels.  The files become about a third larger.")
+
 #define ZOOM_QUALITY_BLURB \
 "There's a tradeoff between speed and quality of the zoomed-out display."
 
@@ -0,0 +1,388 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "core-types.h"
+
+#include "config/gimpgeglconfig.h"
+
+#include "gimp.h"
+#include "gimp-parallel.h"
+
+
+/*  Work is distributed to a single pool of worker threads, whose size
+ *  follows GimpGeglConfig:num-processors.  The calling thread always
+ *  processes one part of the work itself, so the pool holds one
+ *  thread less than the configured number of processors.
+ */
+
+
+typedef struct
+{
+  GimpParallelDistributeFunc  func;
+  gint                        n;
+  gpointer                    user_data;
+
+  gint                        remaining;
+  GMutex                      mutex;
+  GCond                       cond;
+} GimpParallelJob;
+
+typedef struct
+{
+  GimpParallelJob *job;
+  gint             i;
+} GimpParallelTask;
+
+typedef struct
+{
+  GimpParallelDistributeRangeFunc  func;
+  gsize                            size;
+  gpointer                         user_data;
+} GimpParallelRangeData;
+
+typedef struct
+{
+  GimpParallelDistributeAreaFunc  func;
+  const GeglRectangle            *area;
+  gpointer                        user_data;
+} GimpParallelAreaData;
+
+
+/*  local function prototypes  */
+
+static void   gimp_parallel_notify_num_processors (GimpGeglConfig    *config);
+static void   gimp_parallel_set_n_threads         (gint               n_threads);
+
+static void   gimp_parallel_worker                (GimpParallelTask  *task,
+                                                   gpointer           unused);
+static void   gimp_parallel_range_func            (gint               i,
+                                                   gint               n,
+                                                   GimpParallelRangeData *data);
+static void   gimp_parallel_area_func             (gint               i,
+                                                   gint               n,
+                                                   GimpParallelAreaData  *data);
+
+
+/*  local variables  */
+
+static GThreadPool *gimp_parallel_pool      = NULL;
+static gint         gimp_parallel_n_threads = 1;
+
+/*  held for reading while work is distributed, and for writing while
+ *  the pool is resized or freed
+ */
+static GRWLock      gimp_parallel_lock;
+
+/*  set in threads which are currently running distributed work, nested
+ *  distribution from such a thread runs serially to avoid deadlocks
+ */
+static GPrivate     gimp_parallel_nested;
+
+
+/*  public functions  */
+
+void
+gimp_parallel_init (Gimp *gimp)
+{
+  GimpGeglConfig *config;
+
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+
+  config = GIMP_GEGL_CONFIG (gimp->config);
+
+  g_signal_connect (config, "notify::num-processors",
+                    G_CALLBACK (gimp_parallel_notify_num_processors),
+                    NULL);
+
+  gimp_parallel_notify_num_processors (config);
+}
+
+void
+gimp_parallel_exit (Gimp *gimp)
+{
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+
+  g_signal_handlers_disconnect_by_func (gimp->config,
+                                        gimp_parallel_notify_num_processors,
+                                        NULL);
+
+  gimp_parallel_set_n_threads (1);
+}
+
+gint
+gimp_parallel_get_n_threads (void)
+{
+  return g_atomic_int_get (&gimp_parallel_n_threads);
+}
+
+/*  Calls @func @n times, with i = 0 ... n - 1, in parallel, and returns
+ *  when all calls are finished.  @n is at most @max_n, or the number of
+ *  threads if @max_n is negative.
+ */
+void
+gimp_parallel_distribute (gint                       max_n,
+                          GimpParallelDistributeFunc func,
+                          gpointer                   user_data)
+{
+  GimpParallelJob   job;
+  GimpParallelTask *tasks;
+  gint              n;
+  gint              i;
+
+  g_return_if_fail (func != NULL);
+
+  if (max_n == 0)
+    return;
+
+  if (g_private_get (&gimp_parallel_nested))
+    {
+      func (0, 1, user_data);
+
+      return;
+    }
+
+  g_rw_lock_reader_lock (&gimp_parallel_lock);
+
+  n = gimp_parallel_n_threads;
+
+  if (max_n > 0)
+    n = MIN (n, max_n);
+
+  if (n == 1 || ! gimp_parallel_pool)
+    {
+      g_rw_lock_reader_unlock (&gimp_parallel_lock);
+
+      func (0, 1, user_data);
+
+      return;
+    }
+
+  job.func      = func;
+  job.n         = n;
+  job.user_data = user_data;
+  job.remaining = n - 1;
+
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+
+  tasks = g_newa (GimpParallelTask, n - 1);
+
+  for (i = 1; i < n; i++)
+    {
+      tasks[i - 1].job = &job;
+      tasks[i - 1].i   = i;
+
+      g_thread_pool_push (gimp_parallel_pool, &tasks[i - 1], NULL);
+    }
+
+  g_private_set (&gimp_parallel_nested, GINT_TO_POINTER (TRUE));
+
+  func (0, n, user_data);
+
+  g_private_set (&gimp_parallel_nested, GINT_TO_POINTER (FALSE));
+
+  g_mutex_lock (&job.mutex);
+
+  while (job.remaining > 0)
+    g_cond_wait (&job.cond, &job.mutex);
+
+  g_mutex_unlock (&job.mutex);
+
+  g_rw_lock_reader_unlock (&gimp_parallel_lock);
+
+  g_cond_clear (&job.cond);
+  g_mutex_clear (&job.mutex);
+}
+
+/*  Splits the range [0, @size) into sub-ranges of at least
+ *  @min_sub_size elements and calls @func for each of them in parallel.
+ */
+void
+gimp_parallel_distribute_range (gsize                           size,
+                                gsize                           min_sub_size,
+                                GimpParallelDistributeRangeFunc func,
+                                gpointer                        user_data)
+{
+  GimpParallelRangeData data;
+  gint                  max_n;
+
+  g_return_if_fail (func != NULL);
+
+  if (size == 0)
+    return;
+
+  if (min_sub_size > 0)
+    max_n = MIN (size / min_sub_size, G_MAXINT);
+  else
+    max_n = MIN (size, G_MAXINT);
+
+  max_n = MAX (max_n, 1);
+
+  data.func      = func;
+  data.size      = size;
+  data.user_data = user_data;
+
+  gimp_parallel_distribute (max_n,
+                            (GimpParallelDistributeFunc) gimp_parallel_range_func,
+                            &data);
+}
+
+/*  Splits @area into horizontal stripes of at least @min_sub_area
+ *  pixels and calls @func for each of them in parallel.
+ */
+void
+gimp_parallel_distribute_area (const GeglRectangle            *area,
+                               gsize                           min_sub_area,
+                               GimpParallelDistributeAreaFunc  func,
+                               gpointer                        user_data)
+{
+  GimpParallelAreaData data;
+  gsize                n_pixels;
+  gint                 max_n;
+
+  g_return_if_fail (area != NULL);
+  g_return_if_fail (func != NULL);
+
+  if (area->width <= 0 || area->height <= 0)
+    return;
+
+  n_pixels = (gsize) area->width * (gsize) area->height;
+
+  if (min_sub_area > 0)
+    max_n = MIN (n_pixels / min_sub_area, area->height);
+  else
+    max_n = area->height;
+
+  max_n = MAX (max_n, 1);
+
+  data.func      = func;
+  data.area      = area;
+  data.user_data = user_data;
+
+  gimp_parallel_distribute (max_n,
+                            (GimpParallelDistributeFunc) gimp_parallel_area_func,
+                            &data);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_parallel_notify_num_processors (GimpGeglConfig *config)
+{
+  gimp_parallel_set_n_threads (config->num_processors);
+}
+
+static void
+gimp_parallel_set_n_threads (gint n_threads)
+{
+  n_threads = MAX (n_threads, 1);
+
+  /*  wait for all distributed work to finish, other threads can
+   *  distribute work while the pool is being replaced otherwise
+   */
+  g_rw_lock_writer_lock (&gimp_parallel_lock);
+
+  if (n_threads == gimp_parallel_n_threads &&
+      (n_threads == 1) == (gimp_parallel_pool == NULL))
+    {
+      g_rw_lock_writer_unlock (&gimp_parallel_lock);
+
+      return;
+    }
+
+  if (n_threads > 1)
+    {
+      if (! gimp_parallel_pool)
+        {
+          gimp_parallel_pool =
+            g_thread_pool_new ((GFunc) gimp_parallel_worker, NULL,
+                               n_threads - 1, FALSE, NULL);
+        }
+      else
+        {
+          g_thread_pool_set_max_threads (gimp_parallel_pool,
+                                         n_threads - 1, NULL);
+        }
+    }
+  else if (gimp_parallel_pool)
+    {
+      /*  no work is queued, but wait for the threads to exit  */
+      g_thread_pool_free (gimp_parallel_pool, FALSE, TRUE);
+      gimp_parallel_pool = NULL;
+    }
+
+  g_atomic_int_set (&gimp_parallel_n_threads, n_threads);
+
+  g_rw_lock_writer_unlock (&gimp_parallel_lock);
+}
+
+static void
+gimp_parallel_worker (GimpParallelTask *task,
+                      gpointer          unused)
+{
+  GimpParallelJob *job = task->job;
+
+  g_private_set (&gimp_parallel_nested, GINT_TO_POINTER (TRUE));
+
+  job->func (task->i, job->n, job->user_data);
+
+  g_private_set (&gimp_parallel_nested, GINT_TO_POINTER (FALSE));
+
+  g_mutex_lock (&job->mutex);
+
+  if (--job->remaining == 0)
+    g_cond_signal (&job->cond);
+
+  g_mutex_unlock (&job->mutex);
+}
+
+static void
+gimp_parallel_range_func (gint                   i,
+                          gint                   n,
+                          GimpParallelRangeData *data)
+{
+  gsize offset = data->size * i / n;
+  gsize end    = data->size * (i + 1) / n;
+
+  if (end > offset)
+    data->func (offset, end - offset, data->user_data);
+}
+
+static void
+gimp_parallel_area_func (gint                  i,
+                         gint                  n,
+                         GimpParallelAreaData *data)
+{
+  GeglRectangle sub_area;
+  gint          y1 = data->area->height * i / n;
+  gint          y2 = data->area->height * (i + 1) / n;
+
+  if (y2 <= y1)
+    return;
+
+  sub_area.x      = data->area->x;
+  sub_area.y      = data->area->y + y1;
+  sub_area.width  = data->area->width;
+  sub_area.height = y2 - y1;
+
+  data->func (&sub_area, data->user_data);
+}
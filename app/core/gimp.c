@@ -54,6 +54,7 @@
 #include "gimp-utils.h"
 #include "gimpbrush-load.h"
 #include "gimpbrush.h"
+#include "gimpbrushcache.h"
 #include "gimpbrushclipboard.h"
 #include "gimpbrushgenerated-load.h"
 #include "gimpbrushpipe-load.h"
@@ -82,6 +83,7 @@
 #include "gimptoolpreset.h"
 #include "gimptoolpreset-load.h"
 
+#include "gimp-startup-profile.h"
 #include "gimp-intl.h"
 
 
@@ -131,6 +133,8 @@ static void      gimp_edit_config_notify   (GObject           *edit_config,
                                             GParamSpec        *param_spec,
                                             GObject           *global_config);
 
+static void      gimp_brush_cache_size_notify (GimpCoreConfig *config);
+
 
 G_DEFINE_TYPE (Gimp, gimp, GIMP_TYPE_OBJECT)
 
@@ -667,6 +671,11 @@ gimp_real_initialize (Gimp               *gimp,
 
   gimp_fonts_init (gimp);
 
+  gimp_brush_cache_size_notify (gimp->config);
+  g_signal_connect (gimp->config, "notify::brush-cache-size",
+                    G_CALLBACK (gimp_brush_cache_size_notify),
+                    NULL);
+
   gimp->brush_factory =
     gimp_data_factory_new (gimp,
                            GIMP_TYPE_BRUSH,
@@ -783,8 +792,10 @@ gimp_real_restore (Gimp               *gimp,
   if (gimp->be_verbose)
     g_print ("INIT: %s\n", G_STRFUNC);
 
+  gimp_startup_profile_begin ("plug-ins");
   gimp_plug_in_manager_restore (gimp->plug_in_manager,
                                 gimp_get_user_context (gimp), status_callback);
+  gimp_startup_profile_end ();
 
   gimp->restored = TRUE;
 }
@@ -968,6 +979,12 @@ gimp_edit_config_notify (GObject    *edit_config,
   g_value_unset (&global_value);
 }
 
+static void
+gimp_brush_cache_size_notify (GimpCoreConfig *config)
+{
+  gimp_brush_cache_set_max_memsize (config->brush_cache_size);
+}
+
 void
 gimp_load_config (Gimp  *gimp,
                   GFile *alternate_system_gimprc,
@@ -1033,7 +1050,9 @@ gimp_restore (Gimp               *gimp,
 
   /*  initialize  the global parasite table  */
   status_callback (_("Looking for data files"), _("Parasites"), 0.0);
+  gimp_startup_profile_begin ("parasites");
   gimp_parasiterc_load (gimp);
+  gimp_startup_profile_end ();
 
   /*  initialize the list of gimp brushes    */
   status_callback (NULL, _("Brushes"), 0.1);
@@ -1063,10 +1082,16 @@ gimp_restore (Gimp               *gimp,
   /*  initialize the list of fonts  */
   status_callback (NULL, _("Fonts (this may take a while)"), 0.6);
   if (! gimp->no_fonts)
-    gimp_fonts_load (gimp);
+    {
+      gimp_startup_profile_begin ("fonts");
+      gimp_fonts_load (gimp);
+      gimp_startup_profile_end ();
+    }
 
   /*  initialize the color history   */
+  gimp_startup_profile_begin ("color history");
   gimp_palettes_load (gimp);
+  gimp_startup_profile_end ();
 
   /*  initialize the list of gimp tool presets if we have a GUI  */
   if (! gimp->no_interface)
@@ -1078,14 +1103,19 @@ gimp_restore (Gimp               *gimp,
 
   /*  initialize the template list  */
   status_callback (NULL, _("Templates"), 0.7);
+  gimp_startup_profile_begin ("templates");
   gimp_templates_load (gimp);
+  gimp_startup_profile_end ();
 
   /*  initialize the module list  */
   status_callback (NULL, _("Modules"), 0.8);
+  gimp_startup_profile_begin ("modules");
   gimp_modules_load (gimp);
+  gimp_startup_profile_end ();
 
   /* update tag cache */
   status_callback (NULL, _("Updating tag cache"), 0.9);
+  gimp_startup_profile_begin ("tag cache");
   gimp_tag_cache_load (gimp->tag_cache);
   gimp_tag_cache_add_container (gimp->tag_cache,
                                 gimp_data_factory_get_container (gimp->brush_factory));
@@ -1099,8 +1129,12 @@ gimp_restore (Gimp               *gimp,
                                 gimp_data_factory_get_container (gimp->palette_factory));
   gimp_tag_cache_add_container (gimp->tag_cache,
                                 gimp_data_factory_get_container (gimp->tool_preset_factory));
+  gimp_startup_profile_end ();
 
+  /*  the handlers restore the plug-ins and the user interface  */
+  gimp_startup_profile_begin ("restore handlers");
   g_signal_emit (gimp, gimp_signals[RESTORE], 0, status_callback);
+  gimp_startup_profile_end ();
 
   /* when done, make sure everything is clean, to clean out dirty
    * states from data object which reference each other and got
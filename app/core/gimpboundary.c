@@ -32,6 +32,9 @@
 /* GimpBoundSeg array growth parameter */
 #define MAX_SEGS_INC  2048
 
+/* the size of the tiles GimpBoundaryCache keeps segments for */
+#define CACHE_TILE_SIZE  128
+
 
 typedef struct _GimpBoundary GimpBoundary;
 
@@ -52,6 +55,22 @@ struct _GimpBoundary
   gint          max_empty_segs;
 };
 
+struct _GimpBoundaryCache
+{
+  /*  what the cached segments were found for  */
+  GeglBuffer    *buffer;
+  const Babl    *format;
+  gfloat         threshold;
+  gint           width;
+  gint           height;
+  GeglRectangle  bounds;
+
+  /*  the segments of each tile, NULL if they are not known  */
+  gint           n_cols;
+  gint           n_rows;
+  GArray       **tiles;
+};
+
 
 /*  local function prototypes  */
 
@@ -101,6 +120,12 @@ static GimpBoundary * generate_boundary        (GeglBuffer          *buffer,
                                                 gint                 y2,
                                                 gfloat               threshold);
 
+static void       gimp_boundary_cache_reset    (GimpBoundaryCache   *cache);
+static GArray   * gimp_boundary_cache_tile     (GimpBoundaryCache   *cache,
+                                                gint                 col,
+                                                gint                 row);
+static void       gimp_boundary_cache_stitch   (GArray              *segs);
+
 static gint       cmp_segptr_xy1_addr     (const GimpBoundSeg **seg_ptr_a,
                                            const GimpBoundSeg **seg_ptr_b);
 static gint       cmp_segptr_xy2_addr     (const GimpBoundSeg **seg_ptr_a,
@@ -409,6 +434,241 @@ gimp_boundary_offset (GimpBoundSeg *segs,
 }
 
 
+/**
+ * gimp_boundary_cache_new:
+ *
+ * Creates a cache for gimp_boundary_cache_find(), which keeps the
+ * boundary segments of a buffer per tile, so only the tiles which
+ * changed need to be scanned again.
+ *
+ * Return value: the new cache.
+ **/
+GimpBoundaryCache *
+gimp_boundary_cache_new (void)
+{
+  return g_slice_new0 (GimpBoundaryCache);
+}
+
+void
+gimp_boundary_cache_free (GimpBoundaryCache *cache)
+{
+  g_return_if_fail (cache != NULL);
+
+  gimp_boundary_cache_reset (cache);
+
+  g_slice_free (GimpBoundaryCache, cache);
+}
+
+/**
+ * gimp_boundary_cache_invalidate:
+ * @cache: a #GimpBoundaryCache
+ * @rect:  the changed area of the buffer, or %NULL
+ *
+ * Forgets the segments which depend on the pixels in @rect, or all
+ * segments if @rect is %NULL.  This must also be called when the
+ * buffer passed to gimp_boundary_cache_find() is replaced.
+ **/
+void
+gimp_boundary_cache_invalidate (GimpBoundaryCache   *cache,
+                                const GeglRectangle *rect)
+{
+  gint col1, row1, col2, row2;
+  gint col, row;
+
+  g_return_if_fail (cache != NULL);
+
+  if (! cache->tiles)
+    return;
+
+  if (! rect)
+    {
+      gimp_boundary_cache_reset (cache);
+      return;
+    }
+
+  if (rect->width <= 0 || rect->height <= 0)
+    return;
+
+  /*  a tile's segments depend on the pixels one beyond its edges  */
+  col1 = MAX (rect->x - 1, 0) / CACHE_TILE_SIZE;
+  row1 = MAX (rect->y - 1, 0) / CACHE_TILE_SIZE;
+  col2 = MIN ((rect->x + rect->width)  / CACHE_TILE_SIZE, cache->n_cols - 1);
+  row2 = MIN ((rect->y + rect->height) / CACHE_TILE_SIZE, cache->n_rows - 1);
+
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      {
+        GArray **tile = &cache->tiles[row * cache->n_cols + col];
+
+        if (*tile)
+          {
+            g_array_free (*tile, TRUE);
+            *tile = NULL;
+          }
+      }
+}
+
+/**
+ * gimp_boundary_cache_find:
+ * @cache:     a #GimpBoundaryCache
+ * @buffer:    a #GeglBuffer
+ * @region:    the area of @buffer which can contain pixels above
+ *             @threshold, or %NULL
+ * @format:    a #Babl float format representing the component to analyze
+ * @x1:        left side of bounds
+ * @y1:        top side of bounds
+ * @x2:        right side of bounds
+ * @y2:        botton side of bounds
+ * @threshold: pixel value of boundary line
+ * @num_segs:  number of returned #GimpBoundSeg's
+ *
+ * Returns the same segments as gimp_boundary_find() with
+ * %GIMP_BOUNDARY_WITHIN_BOUNDS, but only scans the tiles of @buffer
+ * which were invalidated since the last call.  The segments are not
+ * in the same order.
+ *
+ * Return value: the boundary array.
+ **/
+GimpBoundSeg *
+gimp_boundary_cache_find (GimpBoundaryCache   *cache,
+                          GeglBuffer          *buffer,
+                          const GeglRectangle *region,
+                          const Babl          *format,
+                          gint                 x1,
+                          gint                 y1,
+                          gint                 x2,
+                          gint                 y2,
+                          gfloat               threshold,
+                          gint                *num_segs)
+{
+  GeglRectangle  bounds;
+  GeglRectangle  area;
+  GArray        *segs;
+  gint           width;
+  gint           height;
+  gint           col, row;
+
+  g_return_val_if_fail (cache != NULL, NULL);
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (babl_format_get_bytes_per_pixel (format) ==
+                        sizeof (gfloat), NULL);
+  g_return_val_if_fail (num_segs != NULL, NULL);
+
+  *num_segs = 0;
+
+  width  = gegl_buffer_get_width  (buffer);
+  height = gegl_buffer_get_height (buffer);
+
+  x1 = CLAMP (x1, 0, width);
+  y1 = CLAMP (y1, 0, height);
+  x2 = CLAMP (x2, 0, width);
+  y2 = CLAMP (y2, 0, height);
+
+  bounds.x      = x1;
+  bounds.y      = y1;
+  bounds.width  = x2 - x1;
+  bounds.height = y2 - y1;
+
+  if (buffer    != cache->buffer    ||
+      format    != cache->format    ||
+      threshold != cache->threshold ||
+      width     != cache->width     ||
+      height    != cache->height    ||
+      ! gegl_rectangle_equal (&bounds, &cache->bounds))
+    {
+      gimp_boundary_cache_reset (cache);
+
+      cache->buffer    = buffer;
+      cache->format    = format;
+      cache->threshold = threshold;
+      cache->width     = width;
+      cache->height    = height;
+      cache->bounds    = bounds;
+    }
+
+  if (bounds.width <= 0 || bounds.height <= 0)
+    return NULL;
+
+  if (! cache->tiles)
+    {
+      cache->n_cols = (width  + CACHE_TILE_SIZE - 1) / CACHE_TILE_SIZE;
+      cache->n_rows = (height + CACHE_TILE_SIZE - 1) / CACHE_TILE_SIZE;
+      cache->tiles  = g_new0 (GArray *, cache->n_cols * cache->n_rows);
+    }
+
+  /*  only tiles which touch @region can have segments, including the
+   *  ones right of and below it, which own the lines along its right
+   *  and bottom edges
+   */
+  if (region)
+    gegl_rectangle_intersect (&area, region, &bounds);
+  else
+    area = bounds;
+
+  if (area.width <= 0 || area.height <= 0)
+    return NULL;
+
+  area.width++;
+  area.height++;
+
+  segs = g_array_new (FALSE, FALSE, sizeof (GimpBoundSeg));
+
+  for (row = area.y / CACHE_TILE_SIZE;
+       row <= MIN ((area.y + area.height - 1) / CACHE_TILE_SIZE,
+                   cache->n_rows - 1);
+       row++)
+    {
+      for (col = area.x / CACHE_TILE_SIZE;
+           col <= MIN ((area.x + area.width - 1) / CACHE_TILE_SIZE,
+                       cache->n_cols - 1);
+           col++)
+        {
+          GArray **tile = &cache->tiles[row * cache->n_cols + col];
+
+          if (! *tile)
+            *tile = gimp_boundary_cache_tile (cache, col, row);
+
+          g_array_append_vals (segs, (*tile)->data, (*tile)->len);
+        }
+    }
+
+  gimp_boundary_cache_stitch (segs);
+
+  *num_segs = segs->len;
+
+  if (segs->len == 0)
+    {
+      g_array_free (segs, TRUE);
+      return NULL;
+    }
+
+  return (GimpBoundSeg *) g_array_free (segs, FALSE);
+}
+
+gint64
+gimp_boundary_cache_get_memsize (GimpBoundaryCache *cache)
+{
+  gint64 memsize = 0;
+  gint   i;
+
+  g_return_val_if_fail (cache != NULL, 0);
+
+  if (! cache->tiles)
+    return 0;
+
+  memsize += cache->n_cols * cache->n_rows * sizeof (GArray *);
+
+  for (i = 0; i < cache->n_cols * cache->n_rows; i++)
+    {
+      if (cache->tiles[i])
+        memsize += sizeof (GArray) + cache->tiles[i]->len * sizeof (GimpBoundSeg);
+    }
+
+  return memsize;
+}
+
+
 /*  private functions  */
 
 static GimpBoundary *
@@ -542,8 +802,6 @@ find_empty_segs (const GeglRectangle *region,
 
   endx = end;
 
-  line_data += start;
-
   for (x = start; x < end;)
     {
       if (type == GIMP_BOUNDARY_IGNORE_BOUNDS && (endx > x1 || x < x2))
@@ -688,7 +946,18 @@ generate_boundary (GeglBuffer          *buffer,
 
   boundary = gimp_boundary_new (region);
 
-  line_rect.width  = gegl_buffer_get_width (buffer);
+  /*  only read the columns which are scanned  */
+  if (type == GIMP_BOUNDARY_WITHIN_BOUNDS)
+    {
+      line_rect.x     = x1;
+      line_rect.width = MAX (x2 - x1, 0);
+    }
+  else
+    {
+      line_rect.x     = region->x;
+      line_rect.width = region->width;
+    }
+
   line_rect.height = 1;
 
   line_data = g_alloca (sizeof (gfloat) * line_rect.width);
@@ -769,6 +1038,205 @@ generate_boundary (GeglBuffer          *buffer,
   return boundary;
 }
 
+static void
+gimp_boundary_cache_reset (GimpBoundaryCache *cache)
+{
+  if (cache->tiles)
+    {
+      gint i;
+
+      for (i = 0; i < cache->n_cols * cache->n_rows; i++)
+        {
+          if (cache->tiles[i])
+            g_array_free (cache->tiles[i], TRUE);
+        }
+
+      g_free (cache->tiles);
+      cache->tiles = NULL;
+    }
+
+  cache->buffer = NULL;
+  cache->format = NULL;
+  cache->n_cols = 0;
+  cache->n_rows = 0;
+}
+
+/*  Finds the segments on the lines a tile owns: the horizontal lines
+ *  along the top of its rows and the vertical lines along the left of
+ *  its columns, plus the lines along the bottom and right edges of
+ *  the buffer for the last row and column of tiles.  The tile is
+ *  scanned with a border of one pixel, which is enough to get all of
+ *  these right, and the segments are cut at the tile's edges.
+ */
+static GArray *
+gimp_boundary_cache_tile (GimpBoundaryCache *cache,
+                          gint               col,
+                          gint               row)
+{
+  GimpBoundary  *boundary;
+  GArray        *segs;
+  GeglRectangle  tile;
+  GeglRectangle  region;
+  GeglRectangle  within;
+  gint           max_x;
+  gint           max_y;
+  gint           i;
+
+  segs = g_array_new (FALSE, FALSE, sizeof (GimpBoundSeg));
+
+  tile.x      = col * CACHE_TILE_SIZE;
+  tile.y      = row * CACHE_TILE_SIZE;
+  tile.width  = MIN (CACHE_TILE_SIZE, cache->width  - tile.x);
+  tile.height = MIN (CACHE_TILE_SIZE, cache->height - tile.y);
+
+  region.x      = tile.x - 1;
+  region.y      = tile.y - 1;
+  region.width  = tile.width  + 2;
+  region.height = tile.height + 2;
+
+  gegl_rectangle_intersect (&region, &region,
+                            GEGL_RECTANGLE (0, 0,
+                                            cache->width, cache->height));
+
+  if (! gegl_rectangle_intersect (&within, &region, &cache->bounds))
+    return segs;
+
+  boundary = generate_boundary (cache->buffer, &region, cache->format,
+                                GIMP_BOUNDARY_WITHIN_BOUNDS,
+                                within.x,
+                                within.y,
+                                within.x + within.width,
+                                within.y + within.height,
+                                cache->threshold);
+
+  max_x = tile.x + tile.width;
+  max_y = tile.y + tile.height;
+
+  if (col < cache->n_cols - 1)
+    max_x--;
+
+  if (row < cache->n_rows - 1)
+    max_y--;
+
+  for (i = 0; i < boundary->num_segs; i++)
+    {
+      GimpBoundSeg seg = boundary->segs[i];
+
+      if (seg.y1 == seg.y2)
+        {
+          if (seg.y1 < tile.y || seg.y1 > max_y)
+            continue;
+
+          seg.x1 = MAX (seg.x1, tile.x);
+          seg.x2 = MIN (seg.x2, tile.x + tile.width);
+
+          if (seg.x1 >= seg.x2)
+            continue;
+        }
+      else
+        {
+          if (seg.x1 < tile.x || seg.x1 > max_x)
+            continue;
+
+          seg.y1 = MAX (seg.y1, tile.y);
+          seg.y2 = MIN (seg.y2, tile.y + tile.height);
+
+          if (seg.y1 >= seg.y2)
+            continue;
+        }
+
+      seg.visited = FALSE;
+
+      g_array_append_val (segs, seg);
+    }
+
+  gimp_boundary_free (boundary, TRUE);
+
+  return segs;
+}
+
+/*  Joins the segments which were cut at tile edges again, so the
+ *  result has the same segments as a scan of the whole buffer.  The
+ *  pieces of a segment come in tile order, so each piece is appended
+ *  to the one before it.
+ */
+static void
+gimp_boundary_cache_stitch (GArray *segs)
+{
+  GimpBoundSeg *seg = (GimpBoundSeg *) segs->data;
+  GHashTable   *horiz_starts;
+  GHashTable   *vert_starts;
+  gint64       *keys;
+  gint          i, n;
+
+#define POINT_KEY(x,y) (((gint64) (x) << 32) | (guint32) (y))
+
+  horiz_starts = g_hash_table_new (g_int64_hash, g_int64_equal);
+  vert_starts  = g_hash_table_new (g_int64_hash, g_int64_equal);
+
+  keys = g_new (gint64, segs->len);
+
+  /*  the pieces which start at a tile edge  */
+  for (i = 0; i < segs->len; i++)
+    {
+      keys[i] = POINT_KEY (seg[i].x1, seg[i].y1);
+
+      if (seg[i].y1 == seg[i].y2)
+        {
+          if (seg[i].x1 > 0 && seg[i].x1 % CACHE_TILE_SIZE == 0)
+            g_hash_table_insert (horiz_starts, &keys[i], GINT_TO_POINTER (i + 1));
+        }
+      else
+        {
+          if (seg[i].y1 > 0 && seg[i].y1 % CACHE_TILE_SIZE == 0)
+            g_hash_table_insert (vert_starts, &keys[i], GINT_TO_POINTER (i + 1));
+        }
+    }
+
+  for (i = 0; i < segs->len; i++)
+    {
+      gboolean horiz = (seg[i].y1 == seg[i].y2);
+
+      if (seg[i].visited)
+        continue;
+
+      while (horiz ?
+             seg[i].x2 % CACHE_TILE_SIZE == 0 :
+             seg[i].y2 % CACHE_TILE_SIZE == 0)
+        {
+          gint64 key = POINT_KEY (seg[i].x2, seg[i].y2);
+          gint   j;
+
+          j = GPOINTER_TO_INT (g_hash_table_lookup (horiz ?
+                                                    horiz_starts :
+                                                    vert_starts,
+                                                    &key)) - 1;
+
+          if (j < 0 || seg[j].visited || seg[j].open != seg[i].open)
+            break;
+
+          seg[i].x2      = seg[j].x2;
+          seg[i].y2      = seg[j].y2;
+          seg[j].visited = TRUE;
+        }
+    }
+
+#undef POINT_KEY
+
+  g_free (keys);
+  g_hash_table_unref (horiz_starts);
+  g_hash_table_unref (vert_starts);
+
+  /*  drop the pieces which were appended  */
+  for (i = 0, n = 0; i < segs->len; i++)
+    {
+      if (! seg[i].visited)
+        seg[n++] = seg[i];
+    }
+
+  g_array_set_size (segs, n);
+}
+
 /*  sorting utility functions  */
 
 static inline gint
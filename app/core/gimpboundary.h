@@ -65,4 +65,23 @@ void       gimp_boundary_offset        (GimpBoundSeg        *segs,
                                         gint                 off_y);
 
 
+GimpBoundaryCache * gimp_boundary_cache_new         (void);
+void                gimp_boundary_cache_free        (GimpBoundaryCache   *cache);
+
+void                gimp_boundary_cache_invalidate  (GimpBoundaryCache   *cache,
+                                                     const GeglRectangle *rect);
+GimpBoundSeg      * gimp_boundary_cache_find        (GimpBoundaryCache   *cache,
+                                                     GeglBuffer          *buffer,
+                                                     const GeglRectangle *region,
+                                                     const Babl          *format,
+                                                     gint                 x1,
+                                                     gint                 y1,
+                                                     gint                 x2,
+                                                     gint                 y2,
+                                                     gfloat               threshold,
+                                                     gint                *num_segs);
+
+gint64              gimp_boundary_cache_get_memsize (GimpBoundaryCache   *cache);
+
+
 #endif  /*  __GIMP_BOUNDARY_H__  */
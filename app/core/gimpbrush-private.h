@@ -32,6 +32,9 @@ struct _GimpBrushPrivate
   GimpBrushCache *mask_cache;
   GimpBrushCache *pixmap_cache;
   GimpBrushCache *boundary_cache;
+
+  gint            width;      /*  the indexed size, used until   */
+  gint            height;     /*  the mask is loaded             */
 };
 
 
@@ -17,6 +17,8 @@
 
 #include "config.h"
 
+#include <stdio.h>
+
 #include <cairo.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
@@ -81,6 +83,11 @@ static gchar       * gimp_brush_get_description       (GimpViewable         *vie
 
 static void          gimp_brush_dirty                 (GimpData             *data);
 static const gchar * gimp_brush_get_extension         (GimpData             *data);
+static gchar       * gimp_brush_get_index             (GimpData             *data);
+static gboolean      gimp_brush_set_index             (GimpData             *data,
+                                                       const gchar          *index);
+static gboolean      gimp_brush_load_indexed          (GimpData             *data,
+                                                       GError              **error);
 
 static void          gimp_brush_real_begin_use        (GimpBrush            *brush);
 static void          gimp_brush_real_end_use          (GimpBrush            *brush);
@@ -93,6 +100,11 @@ static gboolean      gimp_brush_real_want_null_motion (GimpBrush            *bru
 
 static gchar       * gimp_brush_get_checksum          (GimpTagged           *tagged);
 
+static gint64        gimp_brush_temp_buf_get_memsize  (gpointer              temp_buf,
+                                                       gint64               *gui_size);
+static gint64        gimp_brush_boundary_get_memsize  (gpointer              boundary,
+                                                       gint64               *gui_size);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpBrush, gimp_brush, GIMP_TYPE_DATA,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_TAGGED,
@@ -133,6 +145,9 @@ gimp_brush_class_init (GimpBrushClass *klass)
 
   data_class->dirty                 = gimp_brush_dirty;
   data_class->get_extension         = gimp_brush_get_extension;
+  data_class->get_index             = gimp_brush_get_index;
+  data_class->set_index             = gimp_brush_set_index;
+  data_class->load_indexed          = gimp_brush_load_indexed;
 
   klass->begin_use                  = gimp_brush_real_begin_use;
   klass->end_use                    = gimp_brush_real_end_use;
@@ -262,6 +277,18 @@ gimp_brush_get_memsize (GimpObject *object,
   memsize += gimp_temp_buf_get_memsize (brush->priv->mask);
   memsize += gimp_temp_buf_get_memsize (brush->priv->pixmap);
 
+  if (brush->priv->mask_cache)
+    memsize += gimp_object_get_memsize (GIMP_OBJECT (brush->priv->mask_cache),
+                                        NULL);
+
+  if (brush->priv->pixmap_cache)
+    memsize += gimp_object_get_memsize (GIMP_OBJECT (brush->priv->pixmap_cache),
+                                        NULL);
+
+  if (brush->priv->boundary_cache)
+    memsize += gimp_object_get_memsize (GIMP_OBJECT (brush->priv->boundary_cache),
+                                        NULL);
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -273,8 +300,8 @@ gimp_brush_get_size (GimpViewable *viewable,
 {
   GimpBrush *brush = GIMP_BRUSH (viewable);
 
-  *width  = gimp_temp_buf_get_width  (brush->priv->mask);
-  *height = gimp_temp_buf_get_height (brush->priv->mask);
+  *width  = gimp_brush_get_width  (brush);
+  *height = gimp_brush_get_height (brush);
 
   return TRUE;
 }
@@ -286,8 +313,8 @@ gimp_brush_get_new_preview (GimpViewable *viewable,
                             gint          height)
 {
   GimpBrush         *brush       = GIMP_BRUSH (viewable);
-  const GimpTempBuf *mask_buf    = brush->priv->mask;
-  const GimpTempBuf *pixmap_buf  = brush->priv->pixmap;
+  const GimpTempBuf *mask_buf;
+  const GimpTempBuf *pixmap_buf;
   GimpTempBuf       *return_buf  = NULL;
   gint               mask_width;
   gint               mask_height;
@@ -296,6 +323,15 @@ gimp_brush_get_new_preview (GimpViewable *viewable,
   gint               x, y;
   gboolean           scaled = FALSE;
 
+  /*  don't load the brush just to show it in the brush dialog  */
+  return_buf = gimp_data_get_index_preview (GIMP_DATA (brush), width, height);
+
+  if (return_buf)
+    return return_buf;
+
+  mask_buf   = gimp_brush_get_mask (brush);
+  pixmap_buf = gimp_brush_get_pixmap (brush);
+
   mask_width  = gimp_temp_buf_get_width  (mask_buf);
   mask_height = gimp_temp_buf_get_height (mask_buf);
 
@@ -396,8 +432,8 @@ gimp_brush_get_description (GimpViewable  *viewable,
 
   return g_strdup_printf ("%s (%d × %d)",
                           gimp_object_get_name (brush),
-                          gimp_temp_buf_get_width  (brush->priv->mask),
-                          gimp_temp_buf_get_height (brush->priv->mask));
+                          gimp_brush_get_width  (brush),
+                          gimp_brush_get_height (brush));
 }
 
 static void
@@ -423,17 +459,115 @@ gimp_brush_get_extension (GimpData *data)
   return GIMP_BRUSH_FILE_EXTENSION;
 }
 
+static gchar *
+gimp_brush_get_index (GimpData *data)
+{
+  GimpBrush *brush = GIMP_BRUSH (data);
+
+  /*  only plain .gbr brushes can be reloaded by gimp_brush_load_indexed(),
+   *  not subclasses or brushes from .abr files
+   */
+  if (G_TYPE_FROM_INSTANCE (brush) != GIMP_TYPE_BRUSH ||
+      g_strcmp0 (gimp_data_get_mime_type (data), "image/x-gimp-gbr") ||
+      ! brush->priv->mask)
+    return NULL;
+
+  return g_strdup_printf ("%d %d %d",
+                          gimp_temp_buf_get_width  (brush->priv->mask),
+                          gimp_temp_buf_get_height (brush->priv->mask),
+                          brush->priv->spacing);
+}
+
+static gboolean
+gimp_brush_set_index (GimpData    *data,
+                      const gchar *index)
+{
+  GimpBrush *brush = GIMP_BRUSH (data);
+  gint       width;
+  gint       height;
+  gint       spacing;
+
+  if (sscanf (index, "%d %d %d", &width, &height, &spacing) != 3 ||
+      width <= 0 || height <= 0)
+    return FALSE;
+
+  brush->priv->width    = width;
+  brush->priv->height   = height;
+  brush->priv->spacing  = spacing;
+  brush->priv->x_axis.x = width  / 2.0;
+  brush->priv->x_axis.y = 0.0;
+  brush->priv->y_axis.x = 0.0;
+  brush->priv->y_axis.y = height / 2.0;
+
+  return TRUE;
+}
+
+static gboolean
+gimp_brush_load_indexed (GimpData  *data,
+                         GError   **error)
+{
+  GimpBrush    *brush  = GIMP_BRUSH (data);
+  GFile        *file   = gimp_data_get_file (data);
+  GimpBrush    *loaded = NULL;
+  GInputStream *input;
+
+  input = G_INPUT_STREAM (g_file_read (file, NULL, error));
+
+  if (input)
+    {
+      loaded = gimp_brush_load_brush (NULL, file, input, error);
+
+      g_object_unref (input);
+    }
+
+  if (loaded)
+    {
+      brush->priv->mask   = loaded->priv->mask;
+      brush->priv->pixmap = loaded->priv->pixmap;
+      brush->priv->x_axis = loaded->priv->x_axis;
+      brush->priv->y_axis = loaded->priv->y_axis;
+
+      loaded->priv->mask   = NULL;
+      loaded->priv->pixmap = NULL;
+
+      g_object_unref (loaded);
+    }
+  else
+    {
+      /*  keep the brush usable  */
+      brush->priv->mask = gimp_temp_buf_new (brush->priv->width,
+                                             brush->priv->height,
+                                             babl_format ("Y u8"));
+      gimp_temp_buf_data_clear (brush->priv->mask);
+    }
+
+  /*  the file changed since it was indexed  */
+  if (gimp_temp_buf_get_width  (brush->priv->mask) != brush->priv->width ||
+      gimp_temp_buf_get_height (brush->priv->mask) != brush->priv->height)
+    {
+      gimp_viewable_size_changed (GIMP_VIEWABLE (brush));
+    }
+
+  return loaded != NULL;
+}
+
 static void
 gimp_brush_real_begin_use (GimpBrush *brush)
 {
   brush->priv->mask_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref, 'M', 'm');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref,
+                          gimp_brush_temp_buf_get_memsize,
+                          'M', 'm');
 
   brush->priv->pixmap_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref, 'P', 'p');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref,
+                          gimp_brush_temp_buf_get_memsize,
+                          'P', 'p');
 
   brush->priv->boundary_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_bezier_desc_free, 'B', 'b');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_bezier_desc_free,
+                          gimp_brush_boundary_get_memsize,
+                          'B', 'b');
 }
 
 static void
@@ -498,6 +632,20 @@ gimp_brush_get_checksum (GimpTagged *tagged)
   return checksum_string;
 }
 
+static gint64
+gimp_brush_temp_buf_get_memsize (gpointer  temp_buf,
+                                 gint64   *gui_size)
+{
+  return gimp_temp_buf_get_memsize (temp_buf);
+}
+
+static gint64
+gimp_brush_boundary_get_memsize (gpointer  boundary,
+                                 gint64   *gui_size)
+{
+  return gimp_bezier_desc_get_memsize (boundary);
+}
+
 /*  public functions  */
 
 GimpData *
@@ -598,8 +746,8 @@ gimp_brush_transform_size (GimpBrush     *brush,
       aspect_ratio == 0.0 &&
       ((angle == 0.0) || (angle == 0.5) || (angle == 1.0)))
     {
-      *width  = gimp_temp_buf_get_width  (brush->priv->mask);
-      *height = gimp_temp_buf_get_height (brush->priv->mask);
+      *width  = gimp_brush_get_width  (brush);
+      *height = gimp_brush_get_height (brush);
 
       return;
     }
@@ -623,6 +771,8 @@ gimp_brush_transform_mask (GimpBrush *brush,
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), NULL);
   g_return_val_if_fail (scale > 0.0, NULL);
 
+  gimp_data_load (GIMP_DATA (brush));
+
   gimp_brush_transform_size (brush,
                              scale, aspect_ratio, angle,
                              &width, &height);
@@ -670,6 +820,9 @@ gimp_brush_transform_pixmap (GimpBrush *brush,
   gint               height;
 
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), NULL);
+
+  gimp_data_load (GIMP_DATA (brush));
+
   g_return_val_if_fail (brush->priv->pixmap != NULL, NULL);
   g_return_val_if_fail (scale > 0.0, NULL);
 
@@ -724,6 +877,8 @@ gimp_brush_transform_boundary (GimpBrush *brush,
   g_return_val_if_fail (width != NULL, NULL);
   g_return_val_if_fail (height != NULL, NULL);
 
+  gimp_data_load (GIMP_DATA (brush));
+
   gimp_brush_transform_size (brush,
                              scale, aspect_ratio, angle,
                              width, height);
@@ -745,8 +900,7 @@ gimp_brush_transform_boundary (GimpBrush *brush,
       /*  while the brush mask is always at least 1x1 pixels, its
        *  outline can correctly be NULL
        *
-       *  FIXME: make the cache handle NULL things when it is
-       *         properly implemented
+       *  FIXME: make the cache handle NULL things
        */
       if (boundary)
         gimp_brush_cache_add (brush->priv->boundary_cache,
@@ -764,6 +918,8 @@ gimp_brush_get_mask (const GimpBrush *brush)
   g_return_val_if_fail (brush != NULL, NULL);
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), NULL);
 
+  gimp_data_load (GIMP_DATA (brush));
+
   return brush->priv->mask;
 }
 
@@ -773,6 +929,8 @@ gimp_brush_get_pixmap (const GimpBrush *brush)
   g_return_val_if_fail (brush != NULL, NULL);
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), NULL);
 
+  gimp_data_load (GIMP_DATA (brush));
+
   return brush->priv->pixmap;
 }
 
@@ -781,6 +939,9 @@ gimp_brush_get_width (const GimpBrush *brush)
 {
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), 0);
 
+  if (! brush->priv->mask)
+    return brush->priv->width;
+
   return gimp_temp_buf_get_width (brush->priv->mask);
 }
 
@@ -789,6 +950,9 @@ gimp_brush_get_height (const GimpBrush *brush)
 {
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), 0);
 
+  if (! brush->priv->mask)
+    return brush->priv->height;
+
   return gimp_temp_buf_get_height (brush->priv->mask);
 }
 
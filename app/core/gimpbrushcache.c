@@ -20,33 +20,89 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gegl.h>
 
+#include "libgimpmath/gimpmath.h"
+
 #include "core-types.h"
 
+#include "gimp-memsize.h"
 #include "gimpbrushcache.h"
 
 #include "gimp-log.h"
 #include "gimp-intl.h"
 
 
+/*  the transform parameters are quantized to these steps before they
+ *  are used as cache keys, so that the tiny changes of pressure or tilt
+ *  between two dabs hit the cache
+ */
+#define SCALE_STEPS        1000.0  /* per unit       */
+#define ASPECT_RATIO_STEPS  100.0  /* per unit       */
+#define ANGLE_STEPS        3600.0  /* per full turn  */
+#define HARDNESS_STEPS      256.0  /* per unit       */
+
+
 enum
 {
   PROP_0,
-  PROP_DATA_DESTROY
+  PROP_DATA_DESTROY,
+  PROP_DATA_MEMSIZE
 };
 
 
-static void   gimp_brush_cache_constructed  (GObject      *object);
-static void   gimp_brush_cache_finalize     (GObject      *object);
-static void   gimp_brush_cache_set_property (GObject      *object,
-                                             guint         property_id,
-                                             const GValue *value,
-                                             GParamSpec   *pspec);
-static void   gimp_brush_cache_get_property (GObject      *object,
-                                             guint         property_id,
-                                             GValue       *value,
-                                             GParamSpec   *pspec);
+typedef struct _GimpBrushCacheKey  GimpBrushCacheKey;
+typedef struct _GimpBrushCacheUnit GimpBrushCacheUnit;
+
+struct _GimpBrushCacheKey
+{
+  gint width;
+  gint height;
+  gint scale;
+  gint aspect_ratio;
+  gint angle;
+  gint hardness;
+};
+
+struct _GimpBrushCacheUnit
+{
+  GimpBrushCacheKey  key;
+  gpointer           data;
+  gint64             memsize;
+  GList              link;
+};
+
+
+static void     gimp_brush_cache_constructed  (GObject            *object);
+static void     gimp_brush_cache_finalize     (GObject            *object);
+static void     gimp_brush_cache_set_property (GObject            *object,
+                                               guint               property_id,
+                                               const GValue       *value,
+                                               GParamSpec         *pspec);
+static void     gimp_brush_cache_get_property (GObject            *object,
+                                               guint               property_id,
+                                               GValue             *value,
+                                               GParamSpec         *pspec);
+
+static gint64   gimp_brush_cache_get_memsize  (GimpObject         *object,
+                                               gint64             *gui_size);
+
+static void     gimp_brush_cache_key_init     (GimpBrushCacheKey  *key,
+                                               gint                width,
+                                               gint                height,
+                                               gdouble             scale,
+                                               gdouble             aspect_ratio,
+                                               gdouble             angle,
+                                               gdouble             hardness);
+static guint    gimp_brush_cache_key_hash     (gconstpointer       key);
+static gboolean gimp_brush_cache_key_equal    (gconstpointer       key1,
+                                               gconstpointer       key2);
+
+static void     gimp_brush_cache_remove_unit  (GimpBrushCache     *cache,
+                                               GimpBrushCacheUnit *unit);
+static void     gimp_brush_cache_log_stats    (GimpBrushCache     *cache);
 
 
 G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
@@ -54,26 +110,42 @@ G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
 #define parent_class gimp_brush_cache_parent_class
 
 
+static guint64 gimp_brush_cache_max_memsize = 1 << 25;
+
+
 static void
 gimp_brush_cache_class_init (GimpBrushCacheClass *klass)
 {
-  GObjectClass  *object_class = G_OBJECT_CLASS (klass);
+  GObjectClass    *object_class      = G_OBJECT_CLASS (klass);
+  GimpObjectClass *gimp_object_class = GIMP_OBJECT_CLASS (klass);
+
+  object_class->constructed      = gimp_brush_cache_constructed;
+  object_class->finalize         = gimp_brush_cache_finalize;
+  object_class->set_property     = gimp_brush_cache_set_property;
+  object_class->get_property     = gimp_brush_cache_get_property;
 
-  object_class->constructed  = gimp_brush_cache_constructed;
-  object_class->finalize     = gimp_brush_cache_finalize;
-  object_class->set_property = gimp_brush_cache_set_property;
-  object_class->get_property = gimp_brush_cache_get_property;
+  gimp_object_class->get_memsize = gimp_brush_cache_get_memsize;
 
   g_object_class_install_property (object_class, PROP_DATA_DESTROY,
                                    g_param_spec_pointer ("data-destroy",
                                                          NULL, NULL,
                                                          GIMP_PARAM_READWRITE |
                                                          G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (object_class, PROP_DATA_MEMSIZE,
+                                   g_param_spec_pointer ("data-memsize",
+                                                         NULL, NULL,
+                                                         GIMP_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT_ONLY));
 }
 
 static void
-gimp_brush_cache_init (GimpBrushCache *brush)
+gimp_brush_cache_init (GimpBrushCache *cache)
 {
+  cache->units = g_hash_table_new (gimp_brush_cache_key_hash,
+                                   gimp_brush_cache_key_equal);
+
+  g_queue_init (&cache->lru);
 }
 
 static void
@@ -84,6 +156,7 @@ gimp_brush_cache_constructed (GObject *object)
   G_OBJECT_CLASS (parent_class)->constructed (object);
 
   g_assert (cache->data_destroy != NULL);
+  g_assert (cache->data_memsize != NULL);
 }
 
 static void
@@ -91,11 +164,9 @@ gimp_brush_cache_finalize (GObject *object)
 {
   GimpBrushCache *cache = GIMP_BRUSH_CACHE (object);
 
-  if (cache->last_data)
-    {
-      cache->data_destroy (cache->last_data);
-      cache->last_data = NULL;
-    }
+  gimp_brush_cache_clear (cache);
+
+  g_hash_table_unref (cache->units);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -113,6 +184,9 @@ gimp_brush_cache_set_property (GObject      *object,
     case PROP_DATA_DESTROY:
       cache->data_destroy = g_value_get_pointer (value);
       break;
+    case PROP_DATA_MEMSIZE:
+      cache->data_memsize = g_value_get_pointer (value);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -133,6 +207,9 @@ gimp_brush_cache_get_property (GObject    *object,
     case PROP_DATA_DESTROY:
       g_value_set_pointer (value, cache->data_destroy);
       break;
+    case PROP_DATA_MEMSIZE:
+      g_value_set_pointer (value, cache->data_memsize);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -140,20 +217,38 @@ gimp_brush_cache_get_property (GObject    *object,
     }
 }
 
+static gint64
+gimp_brush_cache_get_memsize (GimpObject *object,
+                              gint64     *gui_size)
+{
+  GimpBrushCache *cache   = GIMP_BRUSH_CACHE (object);
+  gint64          memsize = 0;
+
+  memsize += gimp_g_hash_table_get_memsize (cache->units,
+                                            sizeof (GimpBrushCacheUnit));
+  memsize += cache->memsize;
+
+  return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
+                                                                  gui_size);
+}
+
 
 /*  public functions  */
 
 GimpBrushCache *
 gimp_brush_cache_new (GDestroyNotify  data_destroy,
+                      GimpMemsizeFunc data_memsize,
                       gchar           debug_hit,
                       gchar           debug_miss)
 {
   GimpBrushCache *cache;
 
   g_return_val_if_fail (data_destroy != NULL, NULL);
+  g_return_val_if_fail (data_memsize != NULL, NULL);
 
   cache =  g_object_new (GIMP_TYPE_BRUSH_CACHE,
                          "data-destroy", data_destroy,
+                         "data-memsize", data_memsize,
                          NULL);
 
   cache->debug_hit  = debug_hit;
@@ -167,11 +262,13 @@ gimp_brush_cache_clear (GimpBrushCache *cache)
 {
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
 
-  if (cache->last_data)
-    {
-      cache->data_destroy (cache->last_data);
-      cache->last_data = NULL;
-    }
+  gimp_brush_cache_log_stats (cache);
+
+  while (cache->lru.head)
+    gimp_brush_cache_remove_unit (cache, cache->lru.head->data);
+
+  cache->n_hits   = 0;
+  cache->n_misses = 0;
 }
 
 gconstpointer
@@ -183,22 +280,33 @@ gimp_brush_cache_get (GimpBrushCache *cache,
                       gdouble         angle,
                       gdouble         hardness)
 {
+  GimpBrushCacheKey   key;
+  GimpBrushCacheUnit *unit;
+
   g_return_val_if_fail (GIMP_IS_BRUSH_CACHE (cache), NULL);
 
-  if (cache->last_data                         &&
-      cache->last_width        == width        &&
-      cache->last_height       == height       &&
-      cache->last_scale        == scale        &&
-      cache->last_aspect_ratio == aspect_ratio &&
-      cache->last_angle        == angle        &&
-      cache->last_hardness     == hardness)
+  gimp_brush_cache_key_init (&key,
+                             width, height,
+                             scale, aspect_ratio, angle, hardness);
+
+  unit = g_hash_table_lookup (cache->units, &key);
+
+  if (unit)
     {
+      /*  move the unit to the front of the LRU list  */
+      g_queue_unlink (&cache->lru, &unit->link);
+      g_queue_push_head_link (&cache->lru, &unit->link);
+
+      cache->n_hits++;
+
       if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
         g_printerr ("%c", cache->debug_hit);
 
-      return (gconstpointer) cache->last_data;
+      return (gconstpointer) unit->data;
     }
 
+  cache->n_misses++;
+
   if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
     g_printerr ("%c", cache->debug_miss);
 
@@ -215,20 +323,122 @@ gimp_brush_cache_add (GimpBrushCache *cache,
                       gdouble         angle,
                       gdouble         hardness)
 {
+  GimpBrushCacheKey   key;
+  GimpBrushCacheUnit *unit;
+
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
   g_return_if_fail (data != NULL);
 
-  if (data == cache->last_data)
-    return;
+  gimp_brush_cache_key_init (&key,
+                             width, height,
+                             scale, aspect_ratio, angle, hardness);
 
-  if (cache->last_data)
-    cache->data_destroy (cache->last_data);
+  unit = g_hash_table_lookup (cache->units, &key);
 
-  cache->last_data         = data;
-  cache->last_width        = width;
-  cache->last_height       = height;
-  cache->last_scale        = scale;
-  cache->last_aspect_ratio = aspect_ratio;
-  cache->last_angle        = angle;
-  cache->last_hardness     = hardness;
+  if (unit)
+    {
+      if (data == unit->data)
+        return;
+
+      gimp_brush_cache_remove_unit (cache, unit);
+    }
+
+  unit = g_slice_new0 (GimpBrushCacheUnit);
+
+  unit->key       = key;
+  unit->data      = data;
+  unit->memsize   = cache->data_memsize (data, NULL);
+  unit->link.data = unit;
+
+  g_hash_table_insert (cache->units, &unit->key, unit);
+  g_queue_push_head_link (&cache->lru, &unit->link);
+
+  cache->memsize += unit->memsize;
+
+  /*  evict the least recently used units, but never the one we just
+   *  added, the caller is about to use it
+   */
+  while (cache->memsize > gimp_brush_cache_max_memsize &&
+         cache->lru.tail != &unit->link)
+    {
+      gimp_brush_cache_remove_unit (cache, cache->lru.tail->data);
+    }
+}
+
+void
+gimp_brush_cache_set_max_memsize (guint64 max_memsize)
+{
+  gimp_brush_cache_max_memsize = max_memsize;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_brush_cache_key_init (GimpBrushCacheKey *key,
+                           gint               width,
+                           gint               height,
+                           gdouble            scale,
+                           gdouble            aspect_ratio,
+                           gdouble            angle,
+                           gdouble            hardness)
+{
+  key->width        = width;
+  key->height       = height;
+  key->scale        = RINT (scale        * SCALE_STEPS);
+  key->aspect_ratio = RINT (aspect_ratio * ASPECT_RATIO_STEPS);
+  key->angle        = RINT (angle        * ANGLE_STEPS);
+  key->hardness     = RINT (hardness     * HARDNESS_STEPS);
+}
+
+static guint
+gimp_brush_cache_key_hash (gconstpointer key)
+{
+  const GimpBrushCacheKey *k = key;
+  guint                    hash;
+
+  hash = k->width;
+  hash = hash * 31 + k->height;
+  hash = hash * 31 + k->scale;
+  hash = hash * 31 + k->aspect_ratio;
+  hash = hash * 31 + k->angle;
+  hash = hash * 31 + k->hardness;
+
+  return hash;
+}
+
+static gboolean
+gimp_brush_cache_key_equal (gconstpointer key1,
+                            gconstpointer key2)
+{
+  return ! memcmp (key1, key2, sizeof (GimpBrushCacheKey));
+}
+
+static void
+gimp_brush_cache_remove_unit (GimpBrushCache     *cache,
+                              GimpBrushCacheUnit *unit)
+{
+  g_hash_table_remove (cache->units, &unit->key);
+  g_queue_unlink (&cache->lru, &unit->link);
+
+  cache->memsize -= unit->memsize;
+
+  cache->data_destroy (unit->data);
+
+  g_slice_free (GimpBrushCacheUnit, unit);
+}
+
+static void
+gimp_brush_cache_log_stats (GimpBrushCache *cache)
+{
+  if (cache->n_hits || cache->n_misses)
+    {
+      GIMP_LOG (BRUSH_CACHE,
+                "\n'%c' cache: %d hits, %d misses, "
+                "%u units, %" G_GINT64_FORMAT " bytes",
+                cache->debug_hit,
+                cache->n_hits, cache->n_misses,
+                g_queue_get_length (&cache->lru),
+                cache->memsize);
+    }
 }
@@ -37,20 +37,20 @@ typedef struct _GimpBrushCacheClass GimpBrushCacheClass;
 
 struct _GimpBrushCache
 {
-  GimpObject      parent_instance;
+  GimpObject       parent_instance;
 
-  GDestroyNotify  data_destroy;
+  GDestroyNotify   data_destroy;
+  GimpMemsizeFunc  data_memsize;
 
-  gpointer        last_data;
-  gint            last_width;
-  gint            last_height;
-  gdouble         last_scale;
-  gdouble         last_aspect_ratio;
-  gdouble         last_angle;
-  gdouble         last_hardness;
+  GHashTable      *units;
+  GQueue           lru;
+  gint64           memsize;
 
-  gchar           debug_hit;
-  gchar           debug_miss;
+  gint             n_hits;
+  gint             n_misses;
+
+  gchar            debug_hit;
+  gchar            debug_miss;
 };
 
 struct _GimpBrushCacheClass
@@ -61,7 +61,8 @@ struct _GimpBrushCacheClass
 
 GType            gimp_brush_cache_get_type (void) G_GNUC_CONST;
 
-GimpBrushCache * gimp_brush_cache_new      (GDestroyNotify  data_destory,
+GimpBrushCache * gimp_brush_cache_new      (GDestroyNotify  data_destroy,
+                                            GimpMemsizeFunc data_memsize,
                                             gchar           debug_hit,
                                             gchar           debug_miss);
 
@@ -83,5 +84,7 @@ void             gimp_brush_cache_add      (GimpBrushCache *cache,
                                             gdouble         angle,
                                             gdouble         hardness);
 
+void             gimp_brush_cache_set_max_memsize (guint64 max_memsize);
+
 
 #endif  /*  __GIMP_BRUSH_CACHE_H__  */
@@ -137,6 +137,11 @@ static void       gimp_channel_convert_type  (GimpDrawable      *drawable,
                                               gint               layer_dither_type,
                                               gint               mask_dither_type,
                                               gboolean           push_undo);
+static void gimp_channel_update               (GimpDrawable       *drawable,
+                                                gint                x,
+                                                gint                y,
+                                                gint                width,
+                                                gint                height);
 static void gimp_channel_invalidate_boundary   (GimpDrawable       *drawable);
 static void gimp_channel_get_active_components (const GimpDrawable *drawable,
                                                 gboolean           *active);
@@ -290,6 +295,7 @@ gimp_channel_class_init (GimpChannelClass *klass)
   item_class->raise_failed         = _("Channel cannot be raised higher.");
   item_class->lower_failed         = _("Channel cannot be lowered more.");
 
+  drawable_class->update                = gimp_channel_update;
   drawable_class->convert_type          = gimp_channel_convert_type;
   drawable_class->invalidate_boundary   = gimp_channel_invalidate_boundary;
   drawable_class->get_active_components = gimp_channel_get_active_components;
@@ -334,8 +340,10 @@ gimp_channel_init (GimpChannel *channel)
   channel->segs_out       = NULL;
   channel->num_segs_in    = 0;
   channel->num_segs_out   = 0;
+  channel->boundary_cache = NULL;
   channel->empty          = FALSE;
   channel->bounds_known   = FALSE;
+  channel->bounds_summary = NULL;
   channel->x1             = 0;
   channel->y1             = 0;
   channel->x2             = 0;
@@ -365,6 +373,18 @@ gimp_channel_finalize (GObject *object)
       channel->segs_out = NULL;
     }
 
+  if (channel->boundary_cache)
+    {
+      gimp_boundary_cache_free (channel->boundary_cache);
+      channel->boundary_cache = NULL;
+    }
+
+  if (channel->bounds_summary)
+    {
+      gimp_mask_summary_free (channel->bounds_summary);
+      channel->bounds_summary = NULL;
+    }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -377,6 +397,12 @@ gimp_channel_get_memsize (GimpObject *object,
   *gui_size += channel->num_segs_in  * sizeof (GimpBoundSeg);
   *gui_size += channel->num_segs_out * sizeof (GimpBoundSeg);
 
+  if (channel->boundary_cache)
+    *gui_size += gimp_boundary_cache_get_memsize (channel->boundary_cache);
+
+  if (channel->bounds_summary)
+    *gui_size += gimp_mask_summary_get_memsize (channel->bounds_summary);
+
   return GIMP_OBJECT_CLASS (parent_class)->get_memsize (object, gui_size);
 }
 
@@ -895,6 +921,36 @@ gimp_channel_convert_type (GimpDrawable      *drawable,
   g_object_unref (dest_buffer);
 }
 
+static void
+gimp_channel_update (GimpDrawable *drawable,
+                     gint          x,
+                     gint          y,
+                     gint          width,
+                     gint          height)
+{
+  GimpChannel *channel = GIMP_CHANNEL (drawable);
+
+  /*  only forget the boundary of the changed tiles, the rest of the
+   *  cache stays valid across gimp_drawable_invalidate_boundary()
+   */
+  if (channel->boundary_cache)
+    {
+      gimp_boundary_cache_invalidate (channel->boundary_cache,
+                                      GEGL_RECTANGLE (x, y, width, height));
+
+      channel->boundary_known = FALSE;
+    }
+
+  /*  same for the bounds, which are only recalculated when
+   *  bounds_known is FALSE
+   */
+  if (channel->bounds_summary)
+    gimp_mask_summary_invalidate (channel->bounds_summary,
+                                  GEGL_RECTANGLE (x, y, width, height));
+
+  GIMP_DRAWABLE_CLASS (parent_class)->update (drawable, x, y, width, height);
+}
+
 static void
 gimp_channel_invalidate_boundary (GimpDrawable *drawable)
 {
@@ -982,6 +1038,12 @@ gimp_channel_set_buffer (GimpDrawable *drawable,
 
   channel->bounds_known = FALSE;
 
+  if (channel->boundary_cache)
+    gimp_boundary_cache_invalidate (channel->boundary_cache, NULL);
+
+  if (channel->bounds_summary)
+    gimp_mask_summary_invalidate (channel->bounds_summary, NULL);
+
   if (gimp_filter_peek_node (GIMP_FILTER (channel)))
     {
       const Babl *color_format;
@@ -1063,25 +1125,39 @@ gimp_channel_real_boundary (GimpChannel         *channel,
 
           buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
 
-          channel->segs_out = gimp_boundary_find (buffer, &rect,
-                                                  babl_format ("Y float"),
-                                                  GIMP_BOUNDARY_IGNORE_BOUNDS,
-                                                  x1, y1, x2, y2,
-                                                  GIMP_BOUNDARY_HALF_WAY,
-                                                  &channel->num_segs_out);
-          x1 = MAX (x1, x3);
-          y1 = MAX (y1, y3);
-          x2 = MIN (x2, x4);
-          y2 = MIN (y2, y4);
-
-          if (x2 > x1 && y2 > y1)
+          if (x3 >= x1 && y3 >= y1 && x4 <= x2 && y4 <= y2)
             {
-              channel->segs_in = gimp_boundary_find (buffer, NULL,
-                                                     babl_format ("Y float"),
-                                                     GIMP_BOUNDARY_WITHIN_BOUNDS,
-                                                     x1, y1, x2, y2,
-                                                     GIMP_BOUNDARY_HALF_WAY,
-                                                     &channel->num_segs_in);
+              /*  nothing is selected outside the bounds  */
+              channel->segs_out     = NULL;
+              channel->num_segs_out = 0;
+            }
+          else
+            {
+              channel->segs_out = gimp_boundary_find (buffer, &rect,
+                                                      babl_format ("Y float"),
+                                                      GIMP_BOUNDARY_IGNORE_BOUNDS,
+                                                      x1, y1, x2, y2,
+                                                      GIMP_BOUNDARY_HALF_WAY,
+                                                      &channel->num_segs_out);
+            }
+
+          if (MIN (x2, x4) > MAX (x1, x3) &&
+              MIN (y2, y4) > MAX (y1, y3))
+            {
+              /*  the cache is asked for the whole bounds, and not just
+               *  their intersection with the selected area, so it stays
+               *  valid when that area grows
+               */
+              if (! channel->boundary_cache)
+                channel->boundary_cache = gimp_boundary_cache_new ();
+
+              channel->segs_in =
+                gimp_boundary_cache_find (channel->boundary_cache,
+                                          buffer, &rect,
+                                          babl_format ("Y float"),
+                                          x1, y1, x2, y2,
+                                          GIMP_BOUNDARY_HALF_WAY,
+                                          &channel->num_segs_in);
             }
           else
             {
@@ -1130,7 +1206,12 @@ gimp_channel_real_bounds (GimpChannel *channel,
 
   buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
 
-  channel->empty = ! gimp_gegl_mask_bounds (buffer, x1, y1, x2, y2);
+  /*  only look at the tiles which changed since the last time  */
+  if (! channel->bounds_summary)
+    channel->bounds_summary = gimp_mask_summary_new ();
+
+  channel->empty = ! gimp_mask_summary_bounds (channel->bounds_summary,
+                                               buffer, x1, y1, x2, y2);
 
   channel->x1 = *x1;
   channel->y1 = *y1;
@@ -1152,7 +1233,10 @@ gimp_channel_real_is_empty (GimpChannel *channel)
 
   buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
 
-  if (! gimp_gegl_mask_is_empty (buffer))
+  if (! channel->bounds_summary)
+    channel->bounds_summary = gimp_mask_summary_new ();
+
+  if (! gimp_mask_summary_is_empty (channel->bounds_summary, buffer))
     return FALSE;
 
   /*  The mask is empty, meaning we can set the bounds as known  */
@@ -1284,6 +1368,11 @@ gimp_channel_real_clear (GimpChannel *channel,
   gimp_drawable_update (GIMP_DRAWABLE (channel), 0, 0,
                         gimp_item_get_width  (GIMP_ITEM (channel)),
                         gimp_item_get_height (GIMP_ITEM (channel)));
+
+  if (channel->bounds_summary)
+    gimp_mask_summary_fill (channel->bounds_summary,
+                            gimp_drawable_get_buffer (GIMP_DRAWABLE (channel)),
+                            FALSE);
 }
 
 static void
@@ -1315,6 +1404,11 @@ gimp_channel_real_all (GimpChannel *channel,
   gimp_drawable_update (GIMP_DRAWABLE (channel), 0, 0,
                         gimp_item_get_width  (GIMP_ITEM (channel)),
                         gimp_item_get_height (GIMP_ITEM (channel)));
+
+  if (channel->bounds_summary)
+    gimp_mask_summary_fill (channel->bounds_summary,
+                            gimp_drawable_get_buffer (GIMP_DRAWABLE (channel)),
+                            TRUE);
 }
 
 static void
@@ -0,0 +1,456 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpcompressedbuffer.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  A GimpCompressedBuffer keeps the pixels of a GeglBuffer as a series
+ *  of Zstandard compressed row chunks.  Compression runs in a separate
+ *  thread, which only reads the source buffer; the main thread has to
+ *  stop it before the source buffer is modified, which restoring and
+ *  freeing do.  Once complete, the compressed data can be moved to a
+ *  file in the swap folder.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <zstd.h>
+
+#include <gegl.h>
+#include <glib/gstdio.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core-types.h"
+
+#include "gimp-memsize.h"
+#include "gimpcompressedbuffer.h"
+
+#include "gimp-intl.h"
+
+
+/*  the uncompressed size of one chunk, and so the amount of work
+ *  which is done before the compression thread checks for being stopped
+ */
+#define CHUNK_SIZE        (1 << 20)
+
+/*  the fastest level, undo data is compressed often and rarely read  */
+#define COMPRESSION_LEVEL 1
+
+
+struct _GimpCompressedBuffer
+{
+  GeglBuffer    *buffer;       /*  the source buffer, while compressing  */
+  const Babl    *format;
+  GeglRectangle  extent;
+
+  gint           chunk_height;
+  gint           n_chunks;
+  gint           n_compressed;
+  gsize         *chunk_sizes;  /*  equal to the raw size if not compressed  */
+
+  guchar        *data;         /*  NULL when swapped out                  */
+  gsize          data_size;
+
+  gchar         *swap_file;
+
+  GThread       *thread;
+  gint           stop;
+  GMutex         mutex;        /*  guards the chunk data while compressing  */
+};
+
+
+/*  local function prototypes  */
+
+static void   gimp_compressed_buffer_stop (GimpCompressedBuffer *compressed);
+
+
+/*  public functions  */
+
+GimpCompressedBuffer *
+gimp_compressed_buffer_new (GeglBuffer *buffer)
+{
+  GimpCompressedBuffer *compressed;
+  gint                  rowstride;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+
+  compressed = g_slice_new0 (GimpCompressedBuffer);
+
+  compressed->buffer = g_object_ref (buffer);
+  compressed->format = gegl_buffer_get_format (buffer);
+  compressed->extent = *gegl_buffer_get_extent (buffer);
+
+  rowstride = (compressed->extent.width *
+               babl_format_get_bytes_per_pixel (compressed->format));
+
+  if (rowstride > 0 && compressed->extent.height > 0)
+    {
+      compressed->chunk_height = CLAMP (CHUNK_SIZE / rowstride,
+                                        1, compressed->extent.height);
+      compressed->n_chunks     = ((compressed->extent.height +
+                                   compressed->chunk_height - 1) /
+                                  compressed->chunk_height);
+    }
+
+  compressed->chunk_sizes = g_new0 (gsize, MAX (compressed->n_chunks, 1));
+
+  g_mutex_init (&compressed->mutex);
+
+  return compressed;
+}
+
+void
+gimp_compressed_buffer_free (GimpCompressedBuffer *compressed)
+{
+  g_return_if_fail (compressed != NULL);
+
+  gimp_compressed_buffer_stop (compressed);
+
+  g_clear_object (&compressed->buffer);
+
+  g_free (compressed->chunk_sizes);
+  g_free (compressed->data);
+
+  if (compressed->swap_file)
+    {
+      g_unlink (compressed->swap_file);
+      g_free (compressed->swap_file);
+    }
+
+  g_mutex_clear (&compressed->mutex);
+
+  g_slice_free (GimpCompressedBuffer, compressed);
+}
+
+static void
+gimp_compressed_buffer_get_chunk (GimpCompressedBuffer *compressed,
+                                  gint                  chunk,
+                                  GeglRectangle        *rect,
+                                  gsize                *size)
+{
+  rect->x      = compressed->extent.x;
+  rect->y      = compressed->extent.y + chunk * compressed->chunk_height;
+  rect->width  = compressed->extent.width;
+  rect->height = MIN (compressed->chunk_height,
+                      compressed->extent.y + compressed->extent.height -
+                      rect->y);
+
+  *size = ((gsize) rect->width * rect->height *
+           babl_format_get_bytes_per_pixel (compressed->format));
+}
+
+static gpointer
+gimp_compressed_buffer_thread (GimpCompressedBuffer *compressed)
+{
+  GeglRectangle  rect;
+  guchar        *src;
+  guchar        *dest;
+  gsize          src_size;
+  gsize          bound;
+  gint           chunk;
+
+  /*  the first chunk is the largest one  */
+  gimp_compressed_buffer_get_chunk (compressed, 0, &rect, &src_size);
+
+  bound = ZSTD_compressBound (src_size);
+
+  src  = g_malloc (src_size);
+  dest = g_malloc (bound);
+
+  /*  the main thread doesn't change n_compressed while we run  */
+  for (chunk = compressed->n_compressed;
+       chunk < compressed->n_chunks && ! g_atomic_int_get (&compressed->stop);
+       chunk++)
+    {
+      const guchar *data = dest;
+      gsize         size;
+
+      gimp_compressed_buffer_get_chunk (compressed, chunk, &rect, &src_size);
+
+      gegl_buffer_get (compressed->buffer, &rect, 1.0,
+                       compressed->format, src,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      size = ZSTD_compress (dest, bound, src, src_size, COMPRESSION_LEVEL);
+
+      /*  keep chunks which don't compress as they are  */
+      if (ZSTD_isError (size) || size >= src_size)
+        {
+          data = src;
+          size = src_size;
+        }
+
+      g_mutex_lock (&compressed->mutex);
+
+      compressed->data = g_realloc (compressed->data,
+                                    compressed->data_size + size);
+      memcpy (compressed->data + compressed->data_size, data, size);
+
+      compressed->data_size += size;
+
+      compressed->chunk_sizes[chunk] = size;
+      compressed->n_compressed       = chunk + 1;
+
+      g_mutex_unlock (&compressed->mutex);
+    }
+
+  g_free (src);
+  g_free (dest);
+
+  return NULL;
+}
+
+static void
+gimp_compressed_buffer_stop (GimpCompressedBuffer *compressed)
+{
+  if (compressed->thread)
+    {
+      g_atomic_int_set (&compressed->stop, TRUE);
+
+      g_thread_join (compressed->thread);
+      compressed->thread = NULL;
+    }
+}
+
+/*  Starts compressing the buffer in a separate thread, if it isn't
+ *  running yet.  Returns TRUE when the whole buffer is compressed, the
+ *  source buffer is released then.
+ */
+gboolean
+gimp_compressed_buffer_compress (GimpCompressedBuffer *compressed)
+{
+  g_return_val_if_fail (compressed != NULL, FALSE);
+
+  if (! gimp_compressed_buffer_is_finished (compressed))
+    {
+      if (! compressed->thread)
+        {
+          compressed->stop   = FALSE;
+          compressed->thread =
+            g_thread_new ("compress-buffer",
+                          (GThreadFunc) gimp_compressed_buffer_thread,
+                          compressed);
+        }
+
+      return FALSE;
+    }
+
+  gimp_compressed_buffer_stop (compressed);
+
+  g_clear_object (&compressed->buffer);
+
+  return TRUE;
+}
+
+gboolean
+gimp_compressed_buffer_is_finished (GimpCompressedBuffer *compressed)
+{
+  gboolean finished;
+
+  g_return_val_if_fail (compressed != NULL, FALSE);
+
+  g_mutex_lock (&compressed->mutex);
+  finished = (compressed->n_compressed == compressed->n_chunks);
+  g_mutex_unlock (&compressed->mutex);
+
+  return finished;
+}
+
+/*  Moves the compressed data to a new file in @swap_dir.  The buffer
+ *  must be completely compressed.
+ */
+gboolean
+gimp_compressed_buffer_swap_out (GimpCompressedBuffer  *compressed,
+                                 const gchar           *swap_dir,
+                                 GError               **error)
+{
+  gchar *filename;
+  gint   fd;
+
+  g_return_val_if_fail (compressed != NULL, FALSE);
+  g_return_val_if_fail (gimp_compressed_buffer_is_finished (compressed),
+                        FALSE);
+  g_return_val_if_fail (swap_dir != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (compressed->swap_file)
+    return TRUE;
+
+  filename = g_build_filename (swap_dir, "gimp-undo-XXXXXX", NULL);
+
+  fd = g_mkstemp (filename);
+
+  if (fd == -1)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   _("Could not create swap file '%s': %s"),
+                   gimp_filename_to_utf8 (filename), g_strerror (errno));
+      g_free (filename);
+
+      return FALSE;
+    }
+
+  g_close (fd, NULL);
+
+  if (! g_file_set_contents (filename,
+                             (const gchar *) compressed->data,
+                             compressed->data_size,
+                             error))
+    {
+      g_unlink (filename);
+      g_free (filename);
+
+      return FALSE;
+    }
+
+  g_free (compressed->data);
+  compressed->data = NULL;
+
+  compressed->swap_file = filename;
+
+  return TRUE;
+}
+
+gboolean
+gimp_compressed_buffer_is_swapped (GimpCompressedBuffer *compressed)
+{
+  g_return_val_if_fail (compressed != NULL, FALSE);
+
+  return compressed->swap_file != NULL;
+}
+
+/*  Returns a new reference to a buffer with the original pixels.  If
+ *  compression is not finished, it is stopped and the source buffer
+ *  itself is returned.  If the swap file can't be read or the data is
+ *  corrupt, NULL is returned and @error is set.
+ */
+GeglBuffer *
+gimp_compressed_buffer_restore (GimpCompressedBuffer  *compressed,
+                                GError               **error)
+{
+  GeglBuffer   *buffer;
+  const guchar *data;
+  gchar        *contents = NULL;
+  guchar       *dest     = NULL;
+  gint          i;
+
+  g_return_val_if_fail (compressed != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  gimp_compressed_buffer_stop (compressed);
+
+  if (compressed->buffer)
+    return g_object_ref (compressed->buffer);
+
+  buffer = gegl_buffer_new (&compressed->extent, compressed->format);
+
+  if (compressed->swap_file)
+    {
+      gsize length;
+
+      if (! g_file_get_contents (compressed->swap_file, &contents, &length,
+                                 error))
+        {
+          g_object_unref (buffer);
+
+          return NULL;
+        }
+
+      if (length != compressed->data_size)
+        {
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                       _("Swap file '%s' is truncated"),
+                       gimp_filename_to_utf8 (compressed->swap_file));
+          g_free (contents);
+          g_object_unref (buffer);
+
+          return NULL;
+        }
+
+      data = (const guchar *) contents;
+    }
+  else
+    {
+      data = compressed->data;
+    }
+
+  for (i = 0; i < compressed->n_chunks; i++)
+    {
+      GeglRectangle rect;
+      gsize         size;
+
+      gimp_compressed_buffer_get_chunk (compressed, i, &rect, &size);
+
+      if (compressed->chunk_sizes[i] == size)
+        {
+          gegl_buffer_set (buffer, &rect, 0, compressed->format,
+                           data, GEGL_AUTO_ROWSTRIDE);
+        }
+      else
+        {
+          /*  the first chunk is the largest one  */
+          if (! dest)
+            dest = g_malloc (size);
+
+          if (ZSTD_isError (ZSTD_decompress (dest, size,
+                                             data,
+                                             compressed->chunk_sizes[i])))
+            {
+              g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                                   _("Compressed undo data is corrupt"));
+              g_clear_object (&buffer);
+              break;
+            }
+
+          gegl_buffer_set (buffer, &rect, 0, compressed->format,
+                           dest, GEGL_AUTO_ROWSTRIDE);
+        }
+
+      data += compressed->chunk_sizes[i];
+    }
+
+  g_free (dest);
+  g_free (contents);
+
+  return buffer;
+}
+
+/*  Returns the memory used by the compressed data, not counting the
+ *  source buffer while compressing.
+ */
+gint64
+gimp_compressed_buffer_get_memsize (GimpCompressedBuffer *compressed)
+{
+  gint64 memsize;
+
+  if (! compressed)
+    return 0;
+
+  g_mutex_lock (&compressed->mutex);
+
+  memsize = (sizeof (GimpCompressedBuffer)                      +
+             MAX (compressed->n_chunks, 1) * sizeof (gsize)      +
+             (compressed->data ? compressed->data_size : 0)      +
+             gimp_string_get_memsize (compressed->swap_file));
+
+  g_mutex_unlock (&compressed->mutex);
+
+  return memsize;
+}
@@ -32,6 +32,7 @@
 #include "gimpmarshal.h"
 #include "gimptag.h"
 #include "gimptagged.h"
+#include "gimptempbuf.h"
 
 #include "gimp-intl.h"
 
@@ -62,6 +63,7 @@ struct _GimpDataPrivate
   guint   deletable : 1;
   guint   dirty     : 1;
   guint   internal  : 1;
+  guint   unloaded  : 1;
   gint    freeze_count;
   gint64  mtime;
 
@@ -71,6 +73,11 @@ struct _GimpDataPrivate
   gchar  *identifier;
 
   GList  *tags;
+
+  /*  the preview from the GimpDataIndex, used until @data is loaded  */
+  GimpTempBuf *index_preview;
+  gint         index_preview_width;
+  gint         index_preview_height;
 };
 
 #define GIMP_DATA_GET_PRIVATE(data) \
@@ -180,6 +187,9 @@ gimp_data_class_init (GimpDataClass *klass)
   klass->save                     = NULL;
   klass->get_extension            = NULL;
   klass->duplicate                = NULL;
+  klass->get_index                = NULL;
+  klass->set_index                = NULL;
+  klass->load_indexed             = NULL;
 
   g_object_class_install_property (object_class, PROP_FILE,
                                    g_param_spec_object ("file", NULL, NULL,
@@ -266,6 +276,12 @@ gimp_data_finalize (GObject *object)
       private->identifier = NULL;
     }
 
+  if (private->index_preview)
+    {
+      gimp_temp_buf_unref (private->index_preview);
+      private->index_preview = NULL;
+    }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -360,6 +376,8 @@ gimp_data_get_memsize (GimpObject *object,
 
   memsize += gimp_g_object_get_memsize (G_OBJECT (private->file));
 
+  *gui_size += gimp_temp_buf_get_memsize (private->index_preview);
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -1082,6 +1100,8 @@ gimp_data_duplicate (GimpData *data)
 {
   g_return_val_if_fail (GIMP_IS_DATA (data), NULL);
 
+  gimp_data_load (data);
+
   if (GIMP_DATA_GET_CLASS (data)->duplicate)
     {
       GimpData        *new     = GIMP_DATA_GET_CLASS (data)->duplicate (data);
@@ -1105,6 +1125,203 @@ gimp_data_duplicate (GimpData *data)
   return NULL;
 }
 
+/**
+ * gimp_data_get_index:
+ * @data: a #GimpData object
+ *
+ * Returns the few values which are needed to show @data in the data
+ * editors and views without loading it, like its size and checksum,
+ * as a string for a #GimpDataIndex.
+ *
+ * Returns: a newly allocated string, or %NULL if @data can't be
+ *          loaded lazily.
+ **/
+gchar *
+gimp_data_get_index (GimpData *data)
+{
+  g_return_val_if_fail (GIMP_IS_DATA (data), NULL);
+
+  if (GIMP_DATA_GET_CLASS (data)->get_index &&
+      GIMP_DATA_GET_CLASS (data)->load_indexed)
+    {
+      return GIMP_DATA_GET_CLASS (data)->get_index (data);
+    }
+
+  return NULL;
+}
+
+/**
+ * gimp_data_set_index:
+ * @data:  a newly created #GimpData object
+ * @index: a string returned by gimp_data_get_index()
+ *
+ * Makes @data an empty object which only knows the values in @index.
+ * Its contents are loaded from the file set with gimp_data_set_file()
+ * by gimp_data_load(), which subclasses call before they need them.
+ *
+ * Returns: %TRUE if @index could be parsed.
+ **/
+gboolean
+gimp_data_set_index (GimpData    *data,
+                     const gchar *index)
+{
+  GimpDataPrivate *private;
+
+  g_return_val_if_fail (GIMP_IS_DATA (data), FALSE);
+  g_return_val_if_fail (index != NULL, FALSE);
+
+  private = GIMP_DATA_GET_PRIVATE (data);
+
+  if (! GIMP_DATA_GET_CLASS (data)->set_index ||
+      ! GIMP_DATA_GET_CLASS (data)->load_indexed)
+    return FALSE;
+
+  if (! GIMP_DATA_GET_CLASS (data)->set_index (data, index))
+    return FALSE;
+
+  private->unloaded = TRUE;
+
+  return TRUE;
+}
+
+gboolean
+gimp_data_is_loaded (GimpData *data)
+{
+  g_return_val_if_fail (GIMP_IS_DATA (data), FALSE);
+
+  return ! GIMP_DATA_GET_PRIVATE (data)->unloaded;
+}
+
+/**
+ * gimp_data_load:
+ * @data: a #GimpData object
+ *
+ * Loads the contents of @data from its file if it was created by
+ * gimp_data_set_index(), and does nothing otherwise.  If loading
+ * fails, a message is shown and @data gets empty contents of the
+ * indexed size.
+ **/
+void
+gimp_data_load (GimpData *data)
+{
+  GimpDataPrivate *private;
+  GError          *error = NULL;
+
+  g_return_if_fail (GIMP_IS_DATA (data));
+
+  private = GIMP_DATA_GET_PRIVATE (data);
+
+  if (! private->unloaded)
+    return;
+
+  /*  never try twice  */
+  private->unloaded = FALSE;
+
+  /*  the real preview can be rendered from now on  */
+  if (private->index_preview)
+    {
+      gimp_temp_buf_unref (private->index_preview);
+      private->index_preview = NULL;
+    }
+
+  if (! GIMP_DATA_GET_CLASS (data)->load_indexed (data, &error))
+    {
+      if (error)
+        g_message (_("Error loading '%s': %s"),
+                   gimp_file_get_utf8_name (private->file), error->message);
+      else
+        g_message (_("Error loading '%s'"),
+                   gimp_file_get_utf8_name (private->file));
+
+      g_clear_error (&error);
+    }
+}
+
+/**
+ * gimp_data_set_index_preview:
+ * @data:    a #GimpData object created by gimp_data_set_index()
+ * @preview: the preview @data had for a view of @width x @height
+ * @width:   the view's width
+ * @height:  the view's height
+ *
+ * Remembers a preview from the #GimpDataIndex, which
+ * gimp_data_get_index_preview() returns until @data is loaded.
+ **/
+void
+gimp_data_set_index_preview (GimpData    *data,
+                             GimpTempBuf *preview,
+                             gint         width,
+                             gint         height)
+{
+  GimpDataPrivate *private;
+
+  g_return_if_fail (GIMP_IS_DATA (data));
+  g_return_if_fail (preview != NULL);
+  g_return_if_fail (width > 0 && height > 0);
+
+  private = GIMP_DATA_GET_PRIVATE (data);
+
+  if (! private->unloaded)
+    return;
+
+  gimp_temp_buf_ref (preview);
+
+  if (private->index_preview)
+    gimp_temp_buf_unref (private->index_preview);
+
+  private->index_preview        = preview;
+  private->index_preview_width  = width;
+  private->index_preview_height = height;
+}
+
+/**
+ * gimp_data_get_index_preview:
+ * @data:   a #GimpData object
+ * @width:  the width of the view
+ * @height: the height of the view
+ *
+ * Returns a copy of the preview set by gimp_data_set_index_preview()
+ * if @data is not loaded yet and the preview is the one @data would
+ * render for a view of @width x @height.  That is the case for the
+ * view it was made for, and for all views which are larger than
+ * @data if the preview shows all of it.
+ *
+ * Returns: a new #GimpTempBuf, or %NULL if the preview must be
+ *          rendered from the loaded @data.
+ **/
+GimpTempBuf *
+gimp_data_get_index_preview (GimpData *data,
+                             gint      width,
+                             gint      height)
+{
+  GimpDataPrivate *private;
+  gint             data_width;
+  gint             data_height;
+
+  g_return_val_if_fail (GIMP_IS_DATA (data), NULL);
+
+  private = GIMP_DATA_GET_PRIVATE (data);
+
+  if (! private->unloaded || ! private->index_preview)
+    return NULL;
+
+  if (width  == private->index_preview_width &&
+      height == private->index_preview_height)
+    {
+      return gimp_temp_buf_copy (private->index_preview);
+    }
+
+  if (gimp_viewable_get_size (GIMP_VIEWABLE (data),
+                              &data_width, &data_height) &&
+      data_width  <= MIN (width,  private->index_preview_width) &&
+      data_height <= MIN (height, private->index_preview_height))
+    {
+      return gimp_temp_buf_copy (private->index_preview);
+    }
+
+  return NULL;
+}
+
 /**
  * gimp_data_make_internal:
  * @data: a #GimpData object.
@@ -62,6 +62,13 @@ struct _GimpDataClass
                                    GError        **error);
   const gchar * (* get_extension) (GimpData       *data);
   GimpData    * (* duplicate)     (GimpData       *data);
+
+  /*  lazy loading from a GimpDataIndex  */
+  gchar       * (* get_index)     (GimpData       *data);
+  gboolean      (* set_index)     (GimpData       *data,
+                                   const gchar    *index);
+  gboolean      (* load_indexed)  (GimpData       *data,
+                                   GError        **error);
 };
 
 
@@ -106,6 +113,19 @@ gint64        gimp_data_get_mtime        (GimpData     *data);
 
 GimpData    * gimp_data_duplicate        (GimpData     *data);
 
+gchar       * gimp_data_get_index        (GimpData     *data);
+gboolean      gimp_data_set_index        (GimpData     *data,
+                                          const gchar  *index);
+gboolean      gimp_data_is_loaded        (GimpData     *data);
+void          gimp_data_load             (GimpData     *data);
+void          gimp_data_set_index_preview (GimpData    *data,
+                                           GimpTempBuf *preview,
+                                           gint         width,
+                                           gint         height);
+GimpTempBuf * gimp_data_get_index_preview (GimpData    *data,
+                                           gint         width,
+                                           gint         height);
+
 void          gimp_data_make_internal    (GimpData     *data,
                                           const gchar  *identifier);
 gboolean      gimp_data_is_internal      (GimpData     *data);
@@ -32,13 +32,17 @@
 
 #include "core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "gimp.h"
 #include "gimp-utils.h"
 #include "gimpcontext.h"
 #include "gimpdata.h"
 #include "gimpdatafactory.h"
+#include "gimpdataindex.h"
 #include "gimplist.h"
 
+#include "gimp-startup-profile.h"
 #include "gimp-intl.h"
 
 
@@ -68,6 +72,8 @@ struct _GimpDataFactoryPriv
 
   GimpDataNewFunc                   data_new_func;
   GimpDataGetStandardFunc           data_get_standard_func;
+
+  GimpDataIndex                    *index;
 };
 
 
@@ -87,6 +93,7 @@ static void    gimp_data_factory_data_load      (GimpDataFactory     *factory,
 
 static GFile * gimp_data_factory_get_save_dir   (GimpDataFactory     *factory,
                                                  GError             **error);
+static GFile * gimp_data_factory_get_index_file (GimpDataFactory     *factory);
 
 static void    gimp_data_factory_load_directory (GimpDataFactory     *factory,
                                                  GimpContext         *context,
@@ -100,6 +107,7 @@ static void    gimp_data_factory_load_data      (GimpDataFactory     *factory,
                                                  gboolean             dir_writable,
                                                  GFile               *file,
                                                  guint64              mtime,
+                                                 goffset              size,
                                                  GFile               *top_directory);
 
 
@@ -243,14 +251,46 @@ gimp_data_factory_data_init (GimpDataFactory *factory,
 
   if (! no_data)
     {
+      const gchar *name = gimp_object_get_name (factory);
+
       if (factory->priv->gimp->be_verbose)
+        g_print ("Loading '%s' data\n", name ? name : "???");
+
+      gimp_startup_profile_begin (name ? name : "???");
+
+      if (factory->priv->gimp->config->lazy_data_loading)
         {
-          const gchar *name = gimp_object_get_name (factory);
+          GFile  *file  = gimp_data_factory_get_index_file (factory);
+          GError *error = NULL;
+
+          factory->priv->index = gimp_data_index_new ();
+
+          if (! gimp_data_index_load (factory->priv->index, file, &error))
+            {
+              gimp_message_literal (factory->priv->gimp, NULL,
+                                    GIMP_MESSAGE_WARNING, error->message);
+              g_clear_error (&error);
+            }
 
-          g_print ("Loading '%s' data\n", name ? name : "???");
+          gimp_data_factory_data_load (factory, context, NULL);
+
+          if (gimp_data_index_is_dirty (factory->priv->index) &&
+              ! gimp_data_index_save (factory->priv->index, file, &error))
+            {
+              gimp_message_literal (factory->priv->gimp, NULL,
+                                    GIMP_MESSAGE_WARNING, error->message);
+              g_clear_error (&error);
+            }
+
+          g_clear_pointer (&factory->priv->index, gimp_data_index_free);
+          g_object_unref (file);
+        }
+      else
+        {
+          gimp_data_factory_data_load (factory, context, NULL);
         }
 
-      gimp_data_factory_data_load (factory, context, NULL);
+      gimp_startup_profile_end ();
     }
 
   gimp_container_thaw (factory->priv->container);
@@ -781,6 +821,31 @@ gimp_data_factory_get_save_dir (GimpDataFactory  *factory,
   return writable_dir;
 }
 
+/*  The index of all data directories is kept in the user's gimp
+ *  directory, since the system directories are usually read-only.
+ */
+static GFile *
+gimp_data_factory_get_index_file (GimpDataFactory *factory)
+{
+  const gchar *property = factory->priv->path_property_name;
+  gchar       *basename;
+  GFile       *file;
+
+  /*  "brush-path" becomes "brushindex"  */
+  if (g_str_has_suffix (property, "-path"))
+    basename = g_strdup_printf ("%.*sindex",
+                                (gint) (strlen (property) - strlen ("-path")),
+                                property);
+  else
+    basename = g_strdup_printf ("%sindex", property);
+
+  file = gimp_directory_file (basename, NULL);
+
+  g_free (basename);
+
+  return file;
+}
+
 static void
 gimp_data_factory_load_directory (GimpDataFactory *factory,
                                   GimpContext     *context,
@@ -795,6 +860,7 @@ gimp_data_factory_load_directory (GimpDataFactory *factory,
                                           G_FILE_ATTRIBUTE_STANDARD_NAME ","
                                           G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
                                           G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE ","
                                           G_FILE_ATTRIBUTE_TIME_MODIFIED,
                                           G_FILE_QUERY_INFO_NONE,
                                           NULL, NULL);
@@ -834,6 +900,7 @@ gimp_data_factory_load_directory (GimpDataFactory *factory,
               gimp_data_factory_load_data (factory, context, cache,
                                            dir_writable,
                                            child, mtime,
+                                           g_file_info_get_size (info),
                                            top_directory);
             }
 
@@ -852,6 +919,7 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
                              gboolean         dir_writable,
                              GFile           *file,
                              guint64          mtime,
+                             goffset          size,
                              GFile           *top_directory)
 {
   const GimpDataFactoryLoaderEntry *loader    = NULL;
@@ -895,10 +963,25 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
         }
     }
 
+  if (factory->priv->index && mtime != 0)
+    {
+      GimpData *data = gimp_data_index_lookup (factory->priv->index,
+                                               file, mtime, size);
+
+      if (data)
+        {
+          data_list = g_list_prepend (NULL, data);
+
+          goto add;
+        }
+    }
+
   input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
 
   if (input)
     {
+      gimp_startup_profile_add_file (size);
+
       data_list = loader->load_func (context, file, input, &error);
 
       if (error)
@@ -913,6 +996,12 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
                        _("Error loading '%s'"),
                        gimp_file_get_utf8_name (file));
         }
+      else if (factory->priv->index && mtime != 0 && ! data_list->next)
+        {
+          gimp_data_index_add (factory->priv->index,
+                               file, mtime, size, data_list->data,
+                               context);
+        }
 
       g_object_unref (input);
     }
@@ -923,6 +1012,7 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
                       gimp_file_get_utf8_name (file));
     }
 
+ add:
   if (G_LIKELY (data_list))
     {
       GList    *list;
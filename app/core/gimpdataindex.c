@@ -0,0 +1,597 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpdataindex.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  A GimpDataIndex remembers, for each data file, the type, name and
+ *  gimp_data_get_index() string of the object it was loaded into, so
+ *  the next session can create an unloaded object from the index
+ *  instead of reading the file.  It also keeps the object's preview
+ *  for the data dialogs, so showing them doesn't load everything.
+ *  Entries are only used while the file's mtime and size are
+ *  unchanged, and entries which were not looked up are dropped when
+ *  the index is saved.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpconfig/gimpconfig.h"
+
+#include "core-types.h"
+
+#include "gimpcontext.h"
+#include "gimpdata.h"
+#include "gimpdataindex.h"
+#include "gimptempbuf.h"
+
+#include "gimp-intl.h"
+
+
+#define DATA_INDEX_FILE_VERSION 2
+
+/*  the view size of the brush and pattern dialogs  */
+#define DATA_INDEX_PREVIEW_SIZE GIMP_VIEW_SIZE_MEDIUM
+
+
+typedef struct _IndexEntry IndexEntry;
+
+struct _IndexEntry
+{
+  gchar       *uri;
+  guint64      mtime;
+  goffset      size;
+  gchar       *type_name;
+  gchar       *mime_type;
+  gchar       *name;
+  gchar       *index;
+
+  /*  the preview for a view of DATA_INDEX_PREVIEW_SIZE, or NULL  */
+  GimpTempBuf *preview;
+
+  gboolean     used;
+};
+
+struct _GimpDataIndex
+{
+  GHashTable *entries;  /*  uri -> IndexEntry  */
+  gboolean    dirty;
+};
+
+
+enum
+{
+  FILE_VERSION = 1,
+  DATA,
+  PREVIEW
+};
+
+
+static IndexEntry * gimp_data_index_entry_new   (void);
+static void         gimp_data_index_entry_free  (IndexEntry    *entry);
+
+static GTokenType   gimp_data_index_deserialize (GimpDataIndex *index,
+                                                 GScanner      *scanner);
+static GTokenType   gimp_data_index_deserialize_preview
+                                                (IndexEntry    *entry,
+                                                 GScanner      *scanner);
+
+
+/*  public functions  */
+
+GimpDataIndex *
+gimp_data_index_new (void)
+{
+  GimpDataIndex *index = g_slice_new0 (GimpDataIndex);
+
+  index->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          NULL,
+                                          (GDestroyNotify)
+                                          gimp_data_index_entry_free);
+
+  return index;
+}
+
+void
+gimp_data_index_free (GimpDataIndex *index)
+{
+  g_return_if_fail (index != NULL);
+
+  g_hash_table_unref (index->entries);
+
+  g_slice_free (GimpDataIndex, index);
+}
+
+/*  Replaces the index' entries by the ones in @file.  A missing
+ *  file is not an error, it just leaves the index empty.
+ */
+gboolean
+gimp_data_index_load (GimpDataIndex  *index,
+                      GFile          *file,
+                      GError        **error)
+{
+  GScanner   *scanner;
+  gint        file_version = DATA_INDEX_FILE_VERSION;
+  GTokenType  token;
+  GError     *my_error     = NULL;
+
+  g_return_val_if_fail (index != NULL, FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  g_hash_table_remove_all (index->entries);
+  index->dirty = FALSE;
+
+  scanner = gimp_scanner_new_gfile (file, &my_error);
+
+  if (! scanner)
+    {
+      if (my_error->code == GIMP_CONFIG_ERROR_OPEN_ENOENT)
+        {
+          g_clear_error (&my_error);
+
+          return TRUE;
+        }
+
+      g_propagate_error (error, my_error);
+
+      return FALSE;
+    }
+
+  g_scanner_scope_add_symbol (scanner, 0,
+                              "file-version", GINT_TO_POINTER (FILE_VERSION));
+  g_scanner_scope_add_symbol (scanner, 0,
+                              "data", GINT_TO_POINTER (DATA));
+  g_scanner_scope_add_symbol (scanner, 0,
+                              "preview", GINT_TO_POINTER (PREVIEW));
+
+  token = G_TOKEN_LEFT_PAREN;
+
+  while (file_version == DATA_INDEX_FILE_VERSION &&
+         g_scanner_peek_next_token (scanner) == token)
+    {
+      token = g_scanner_get_next_token (scanner);
+
+      switch (token)
+        {
+        case G_TOKEN_LEFT_PAREN:
+          token = G_TOKEN_SYMBOL;
+          break;
+
+        case G_TOKEN_SYMBOL:
+          switch (GPOINTER_TO_INT (scanner->value.v_symbol))
+            {
+            case FILE_VERSION:
+              token = G_TOKEN_INT;
+              if (gimp_scanner_parse_int (scanner, &file_version))
+                token = G_TOKEN_RIGHT_PAREN;
+              break;
+
+            case DATA:
+              token = gimp_data_index_deserialize (index, scanner);
+              break;
+
+            default:
+              break;
+            }
+          break;
+
+        case G_TOKEN_RIGHT_PAREN:
+          token = G_TOKEN_LEFT_PAREN;
+          break;
+
+        default: /* do nothing */
+          break;
+        }
+    }
+
+  if (file_version < DATA_INDEX_FILE_VERSION)
+    {
+      gimp_scanner_destroy (scanner);
+
+      /*  an index of an older version is silently rebuilt  */
+      g_hash_table_remove_all (index->entries);
+      index->dirty = TRUE;
+
+      return TRUE;
+    }
+
+  if (file_version != DATA_INDEX_FILE_VERSION ||
+      token        != G_TOKEN_LEFT_PAREN)
+    {
+      if (file_version != DATA_INDEX_FILE_VERSION)
+        {
+          g_set_error (error,
+                       GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_VERSION,
+                       _("Skipping '%s': wrong data index file format version."),
+                       gimp_file_get_utf8_name (file));
+        }
+      else
+        {
+          g_scanner_get_next_token (scanner);
+          g_scanner_unexp_token (scanner, token, NULL, NULL, NULL,
+                                 _("fatal parse error"), TRUE);
+        }
+
+      gimp_scanner_destroy (scanner);
+
+      /*  a broken index is simply rebuilt  */
+      g_hash_table_remove_all (index->entries);
+      index->dirty = TRUE;
+
+      return FALSE;
+    }
+
+  gimp_scanner_destroy (scanner);
+
+  return TRUE;
+}
+
+/*  Writes the entries which were looked up or added since the
+ *  index was loaded.
+ */
+gboolean
+gimp_data_index_save (GimpDataIndex  *index,
+                      GFile          *file,
+                      GError        **error)
+{
+  GimpConfigWriter *writer;
+  GHashTableIter    iter;
+  IndexEntry       *entry;
+
+  g_return_val_if_fail (index != NULL, FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  writer = gimp_config_writer_new_gfile (file,
+                                         FALSE,
+                                         "GIMP data index\n\n"
+                                         "This file can safely be removed and "
+                                         "will be automatically regenerated "
+                                         "when the data files are loaded.",
+                                         error);
+  if (! writer)
+    return FALSE;
+
+  gimp_config_writer_open (writer, "file-version");
+  gimp_config_writer_printf (writer, "%d", DATA_INDEX_FILE_VERSION);
+  gimp_config_writer_close (writer);
+
+  gimp_config_writer_linefeed (writer);
+
+  g_hash_table_iter_init (&iter, index->entries);
+
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    {
+      if (! entry->used)
+        continue;
+
+      gimp_config_writer_open (writer, "data");
+      gimp_config_writer_string (writer, entry->uri);
+      gimp_config_writer_printf (writer,
+                                 "%" G_GUINT64_FORMAT " %" G_GINT64_FORMAT,
+                                 entry->mtime, (gint64) entry->size);
+      gimp_config_writer_string (writer, entry->type_name);
+      gimp_config_writer_string (writer, entry->mime_type);
+      gimp_config_writer_string (writer, entry->name);
+      gimp_config_writer_string (writer, entry->index);
+
+      if (entry->preview)
+        {
+          GimpTempBuf *preview = entry->preview;
+          gchar       *base64;
+
+          base64 = g_base64_encode (gimp_temp_buf_get_data (preview),
+                                    gimp_temp_buf_get_data_size (preview));
+
+          gimp_config_writer_open (writer, "preview");
+          gimp_config_writer_printf (writer, "%d %d",
+                                     gimp_temp_buf_get_width  (preview),
+                                     gimp_temp_buf_get_height (preview));
+          gimp_config_writer_string (writer,
+                                     babl_get_name (gimp_temp_buf_get_format (preview)));
+          gimp_config_writer_string (writer, base64);
+          gimp_config_writer_close (writer);
+
+          g_free (base64);
+        }
+
+      gimp_config_writer_close (writer);
+    }
+
+  if (! gimp_config_writer_finish (writer, "end of data index", error))
+    return FALSE;
+
+  index->dirty = FALSE;
+
+  return TRUE;
+}
+
+/*  Returns whether saving the index would change its file  */
+gboolean
+gimp_data_index_is_dirty (GimpDataIndex *index)
+{
+  GHashTableIter  iter;
+  IndexEntry     *entry;
+
+  g_return_val_if_fail (index != NULL, FALSE);
+
+  if (index->dirty)
+    return TRUE;
+
+  g_hash_table_iter_init (&iter, index->entries);
+
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    {
+      if (! entry->used)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*  Returns a new unloaded data object for @file if the index has an
+ *  entry for it with the same @mtime and @size, or %NULL.  The
+ *  caller still has to set the object's file.
+ */
+GimpData *
+gimp_data_index_lookup (GimpDataIndex *index,
+                        GFile         *file,
+                        guint64        mtime,
+                        goffset        size)
+{
+  IndexEntry *entry;
+  GimpData   *data;
+  GType       type;
+  gchar      *uri;
+
+  g_return_val_if_fail (index != NULL, NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  uri   = g_file_get_uri (file);
+  entry = g_hash_table_lookup (index->entries, uri);
+  g_free (uri);
+
+  if (! entry || entry->mtime != mtime || entry->size != size)
+    return NULL;
+
+  type = g_type_from_name (entry->type_name);
+
+  if (! g_type_is_a (type, GIMP_TYPE_DATA))
+    return NULL;
+
+  data = g_object_new (type,
+                       "name",      entry->name,
+                       "mime-type", entry->mime_type,
+                       NULL);
+
+  if (! gimp_data_set_index (data, entry->index))
+    {
+      g_object_unref (data);
+
+      return NULL;
+    }
+
+  if (entry->preview)
+    gimp_data_set_index_preview (data, entry->preview,
+                                 DATA_INDEX_PREVIEW_SIZE,
+                                 DATA_INDEX_PREVIEW_SIZE);
+
+  entry->used = TRUE;
+
+  return data;
+}
+
+/*  Remembers @data, which was just loaded from @file, if it can be
+ *  loaded lazily, together with its preview in @context.
+ */
+void
+gimp_data_index_add (GimpDataIndex *index,
+                     GFile         *file,
+                     guint64        mtime,
+                     goffset        size,
+                     GimpData      *data,
+                     GimpContext   *context)
+{
+  IndexEntry *entry;
+  gchar      *data_index;
+
+  g_return_if_fail (index != NULL);
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (GIMP_IS_DATA (data));
+  g_return_if_fail (GIMP_IS_CONTEXT (context));
+
+  data_index = gimp_data_get_index (data);
+
+  if (! data_index)
+    return;
+
+  entry = gimp_data_index_entry_new ();
+
+  entry->uri       = g_file_get_uri (file);
+  entry->mtime     = mtime;
+  entry->size      = size;
+  entry->type_name = g_strdup (G_OBJECT_TYPE_NAME (data));
+  entry->mime_type = g_strdup (gimp_data_get_mime_type (data));
+  entry->name      = g_strdup (gimp_object_get_name (data));
+  entry->index     = data_index;
+  entry->preview   = gimp_viewable_get_new_preview (GIMP_VIEWABLE (data),
+                                                    context,
+                                                    DATA_INDEX_PREVIEW_SIZE,
+                                                    DATA_INDEX_PREVIEW_SIZE);
+  entry->used      = TRUE;
+
+  if (! entry->mime_type)
+    entry->mime_type = g_strdup ("");
+
+  g_hash_table_replace (index->entries, entry->uri, entry);
+
+  index->dirty = TRUE;
+}
+
+
+/*  private functions  */
+
+static IndexEntry *
+gimp_data_index_entry_new (void)
+{
+  return g_slice_new0 (IndexEntry);
+}
+
+static void
+gimp_data_index_entry_free (IndexEntry *entry)
+{
+  g_free (entry->uri);
+  g_free (entry->type_name);
+  g_free (entry->mime_type);
+  g_free (entry->name);
+  g_free (entry->index);
+
+  if (entry->preview)
+    gimp_temp_buf_unref (entry->preview);
+
+  g_slice_free (IndexEntry, entry);
+}
+
+static GTokenType
+gimp_data_index_deserialize (GimpDataIndex *index,
+                             GScanner      *scanner)
+{
+  IndexEntry *entry = gimp_data_index_entry_new ();
+  gint64      mtime;
+  gint64      size;
+
+  if (! gimp_scanner_parse_string (scanner, &entry->uri))
+    goto error_string;
+
+  if (! gimp_scanner_parse_int64 (scanner, &mtime) ||
+      ! gimp_scanner_parse_int64 (scanner, &size))
+    {
+      gimp_data_index_entry_free (entry);
+
+      return G_TOKEN_INT;
+    }
+
+  entry->mtime = mtime;
+  entry->size  = size;
+
+  if (! gimp_scanner_parse_string (scanner, &entry->type_name) ||
+      ! gimp_scanner_parse_string (scanner, &entry->mime_type) ||
+      ! gimp_scanner_parse_string (scanner, &entry->name)      ||
+      ! gimp_scanner_parse_string (scanner, &entry->index))
+    goto error_string;
+
+  if (g_scanner_peek_next_token (scanner) == G_TOKEN_LEFT_PAREN)
+    {
+      GTokenType token;
+
+      g_scanner_get_next_token (scanner);
+
+      token = gimp_data_index_deserialize_preview (entry, scanner);
+
+      if (token != G_TOKEN_NONE)
+        {
+          gimp_data_index_entry_free (entry);
+
+          return token;
+        }
+    }
+
+  if (! gimp_scanner_parse_token (scanner, G_TOKEN_RIGHT_PAREN))
+    {
+      gimp_data_index_entry_free (entry);
+
+      return G_TOKEN_RIGHT_PAREN;
+    }
+
+  /*  data without a mime type was written with an empty string  */
+  if (! strlen (entry->mime_type))
+    {
+      g_free (entry->mime_type);
+      entry->mime_type = NULL;
+    }
+
+  g_hash_table_replace (index->entries, entry->uri, entry);
+
+  return G_TOKEN_LEFT_PAREN;
+
+ error_string:
+  gimp_data_index_entry_free (entry);
+
+  return G_TOKEN_STRING;
+}
+
+/*  Parses the "preview" list of an entry, after its left paren  */
+static GTokenType
+gimp_data_index_deserialize_preview (IndexEntry *entry,
+                                     GScanner   *scanner)
+{
+  const Babl *format;
+  gchar      *format_name = NULL;
+  gchar      *base64      = NULL;
+  guchar     *data;
+  gsize       data_size;
+  gint        width;
+  gint        height;
+  GTokenType  token       = G_TOKEN_NONE;
+
+  if (! gimp_scanner_parse_token (scanner, G_TOKEN_SYMBOL) ||
+      GPOINTER_TO_INT (scanner->value.v_symbol) != PREVIEW)
+    return G_TOKEN_SYMBOL;
+
+  if (! gimp_scanner_parse_int (scanner, &width) ||
+      ! gimp_scanner_parse_int (scanner, &height))
+    return G_TOKEN_INT;
+
+  if (! gimp_scanner_parse_string (scanner, &format_name) ||
+      ! gimp_scanner_parse_string (scanner, &base64))
+    {
+      token = G_TOKEN_STRING;
+      goto out;
+    }
+
+  if (! gimp_scanner_parse_token (scanner, G_TOKEN_RIGHT_PAREN))
+    {
+      token = G_TOKEN_RIGHT_PAREN;
+      goto out;
+    }
+
+  data   = g_base64_decode (base64, &data_size);
+  format = babl_format_exists (format_name) ? babl_format (format_name) : NULL;
+
+  /*  a broken preview is just dropped, the data still can be loaded  */
+  if (format && width > 0 && height > 0 &&
+      data_size == (gsize) width * height *
+                   babl_format_get_bytes_per_pixel (format))
+    {
+      entry->preview = gimp_temp_buf_new (width, height, format);
+
+      memcpy (gimp_temp_buf_get_data (entry->preview), data, data_size);
+    }
+
+  g_free (data);
+
+ out:
+  g_free (format_name);
+  g_free (base64);
+
+  return token;
+}
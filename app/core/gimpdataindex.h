@@ -0,0 +1,48 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpdataindex.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_DATA_INDEX_H__
+#define __GIMP_DATA_INDEX_H__
+
+
+GimpDataIndex * gimp_data_index_new      (void);
+void            gimp_data_index_free     (GimpDataIndex  *index);
+
+gboolean        gimp_data_index_load     (GimpDataIndex  *index,
+                                          GFile          *file,
+                                          GError        **error);
+gboolean        gimp_data_index_save     (GimpDataIndex  *index,
+                                          GFile          *file,
+                                          GError        **error);
+
+gboolean        gimp_data_index_is_dirty (GimpDataIndex  *index);
+
+GimpData      * gimp_data_index_lookup   (GimpDataIndex  *index,
+                                          GFile          *file,
+                                          guint64         mtime,
+                                          goffset         size);
+void            gimp_data_index_add      (GimpDataIndex  *index,
+                                          GFile          *file,
+                                          guint64         mtime,
+                                          goffset         size,
+                                          GimpData       *data,
+                                          GimpContext    *context);
+
+
+#endif /* __GIMP_DATA_INDEX_H__ */
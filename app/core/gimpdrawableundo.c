@@ -57,6 +57,9 @@ static void     gimp_drawable_undo_pop          (GimpUndo            *undo,
                                                  GimpUndoAccumulator *accum);
 static void     gimp_drawable_undo_free         (GimpUndo            *undo,
                                                  GimpUndoMode         undo_mode);
+static GeglBuffer * gimp_drawable_undo_get_buffer (GimpUndo          *undo);
+static void     gimp_drawable_undo_set_buffer   (GimpUndo            *undo,
+                                                 GeglBuffer          *buffer);
 
 
 G_DEFINE_TYPE (GimpDrawableUndo, gimp_drawable_undo, GIMP_TYPE_ITEM_UNDO)
@@ -79,6 +82,8 @@ gimp_drawable_undo_class_init (GimpDrawableUndoClass *klass)
 
   undo_class->pop                = gimp_drawable_undo_pop;
   undo_class->free               = gimp_drawable_undo_free;
+  undo_class->get_buffer         = gimp_drawable_undo_get_buffer;
+  undo_class->set_buffer         = gimp_drawable_undo_set_buffer;
 
   g_object_class_install_property (object_class, PROP_BUFFER,
                                    g_param_spec_object ("buffer", NULL, NULL,
@@ -215,3 +220,24 @@ gimp_drawable_undo_free (GimpUndo     *undo,
 
   GIMP_UNDO_CLASS (parent_class)->free (undo, undo_mode);
 }
+
+static GeglBuffer *
+gimp_drawable_undo_get_buffer (GimpUndo *undo)
+{
+  return GIMP_DRAWABLE_UNDO (undo)->buffer;
+}
+
+static void
+gimp_drawable_undo_set_buffer (GimpUndo   *undo,
+                               GeglBuffer *buffer)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+
+  if (buffer)
+    g_object_ref (buffer);
+
+  if (drawable_undo->buffer)
+    g_object_unref (drawable_undo->buffer);
+
+  drawable_undo->buffer = buffer;
+}
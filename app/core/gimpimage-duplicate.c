@@ -400,6 +400,10 @@ gimp_image_duplicate_mask (GimpImage *image,
 
   GIMP_CHANNEL (new_mask)->bounds_known   = FALSE;
   GIMP_CHANNEL (new_mask)->boundary_known = FALSE;
+
+  gimp_drawable_update (new_mask, 0, 0,
+                        gimp_item_get_width  (GIMP_ITEM (new_mask)),
+                        gimp_item_get_height (GIMP_ITEM (new_mask)));
 }
 
 static void
@@ -112,6 +112,8 @@ struct _GimpImagePrivate
   GimpUndoStack     *redo_stack;            /*  stack for redo operations    */
   gint               group_count;           /*  nested undo groups           */
   GimpUndoType       pushing_undo_group;    /*  undo group status flag       */
+  guint              undo_compress_idle_id; /*  compresses old undo steps    */
+  gboolean           undo_swap_failed;      /*  don't retry a failed swap    */
 
   /*  Signal emission accumulator  */
   GimpImageFlushAccumulator  flush_accum;
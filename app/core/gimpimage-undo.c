@@ -20,6 +20,8 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
+#include "libgimpconfig/gimpconfig.h"
+
 #include "core-types.h"
 
 #include "config/gimpcoreconfig.h"
@@ -34,16 +36,39 @@
 #include "gimplist.h"
 #include "gimpundostack.h"
 
+#include "gimp-priorities.h"
+
+#include "gimp-intl.h"
+
+
+/*  how often the undo compression thread is checked on, in ms  */
+#define UNDO_COMPRESS_INTERVAL 50
+
 
 /*  local function prototypes  */
 
-static void          gimp_image_undo_pop_stack       (GimpImage     *image,
+static gboolean      gimp_image_undo_pop_stack       (GimpImage     *image,
                                                       GimpUndoStack *undo_stack,
                                                       GimpUndoStack *redo_stack,
                                                       GimpUndoMode   undo_mode);
 static void          gimp_image_undo_free_space      (GimpImage     *image);
 static void          gimp_image_undo_free_redo       (GimpImage     *image);
 
+static void          gimp_image_undo_compress_start  (GimpImage     *image);
+static gboolean      gimp_image_undo_compress_idle   (GimpImage     *image);
+static gboolean      gimp_image_undo_compress_undo   (GimpUndoStack *stack,
+                                                      GimpUndo      *undo);
+static gboolean      gimp_image_undo_uncompress_undo (GimpUndoStack *stack,
+                                                      GimpUndo      *undo,
+                                                      GError       **error);
+static gint64        gimp_image_undo_get_compressed_size
+                                                     (GimpUndo      *undo);
+static gboolean      gimp_image_undo_swap_out        (GimpImage     *image);
+static gboolean      gimp_image_undo_swap_out_undo   (GimpUndoStack *stack,
+                                                      GimpUndo      *undo,
+                                                      const gchar   *swap_dir,
+                                                      GError       **error);
+
 static GimpDirtyMask gimp_image_undo_dirty_from_type (GimpUndoType   undo_type);
 
 
@@ -124,12 +149,10 @@ gimp_image_undo (GimpImage *image)
   g_return_val_if_fail (private->pushing_undo_group == GIMP_UNDO_GROUP_NONE,
                         FALSE);
 
-  gimp_image_undo_pop_stack (image,
-                             private->undo_stack,
-                             private->redo_stack,
-                             GIMP_UNDO_MODE_UNDO);
-
-  return TRUE;
+  return gimp_image_undo_pop_stack (image,
+                                    private->undo_stack,
+                                    private->redo_stack,
+                                    GIMP_UNDO_MODE_UNDO);
 }
 
 gboolean
@@ -144,12 +167,10 @@ gimp_image_redo (GimpImage *image)
   g_return_val_if_fail (private->pushing_undo_group == GIMP_UNDO_GROUP_NONE,
                         FALSE);
 
-  gimp_image_undo_pop_stack (image,
-                             private->redo_stack,
-                             private->undo_stack,
-                             GIMP_UNDO_MODE_REDO);
-
-  return TRUE;
+  return gimp_image_undo_pop_stack (image,
+                                    private->redo_stack,
+                                    private->undo_stack,
+                                    GIMP_UNDO_MODE_REDO);
 }
 
 /*
@@ -171,13 +192,14 @@ gimp_image_strong_undo (GimpImage *image)
 
   undo = gimp_undo_stack_peek (private->undo_stack);
 
-  gimp_image_undo (image);
+  if (! gimp_image_undo (image))
+    return FALSE;
 
   while (gimp_undo_is_weak (undo))
     {
       undo = gimp_undo_stack_peek (private->undo_stack);
-      if (gimp_undo_is_weak (undo))
-        gimp_image_undo (image);
+      if (gimp_undo_is_weak (undo) && ! gimp_image_undo (image))
+        return FALSE;
     }
 
   return TRUE;
@@ -204,13 +226,14 @@ gimp_image_strong_redo (GimpImage *image)
 
   undo = gimp_undo_stack_peek (private->redo_stack);
 
-  gimp_image_redo (image);
+  if (! gimp_image_redo (image))
+    return FALSE;
 
   while (gimp_undo_is_weak (undo))
     {
       undo = gimp_undo_stack_peek (private->redo_stack);
-      if (gimp_undo_is_weak (undo))
-        gimp_image_redo (image);
+      if (gimp_undo_is_weak (undo) && ! gimp_image_redo (image))
+        return FALSE;
     }
 
   return TRUE;
@@ -246,6 +269,12 @@ gimp_image_undo_free (GimpImage *image)
    */
   gimp_image_undo_event (image, GIMP_UNDO_EVENT_UNDO_FREE, NULL);
 
+  if (private->undo_compress_idle_id)
+    {
+      g_source_remove (private->undo_compress_idle_id);
+      private->undo_compress_idle_id = 0;
+    }
+
   gimp_undo_free (GIMP_UNDO (private->undo_stack), GIMP_UNDO_MODE_UNDO);
   gimp_undo_free (GIMP_UNDO (private->redo_stack), GIMP_UNDO_MODE_REDO);
 
@@ -347,6 +376,8 @@ gimp_image_undo_group_end (GimpImage *image)
                              gimp_undo_stack_peek (private->undo_stack));
 
       gimp_image_undo_free_space (image);
+
+      gimp_image_undo_compress_start (image);
     }
 
   return TRUE;
@@ -410,6 +441,8 @@ gimp_image_undo_push (GimpImage     *image,
 
       gimp_image_undo_free_space (image);
 
+      gimp_image_undo_compress_start (image);
+
       /*  freeing undo space may have freed the newly pushed undo  */
       if (gimp_undo_stack_peek (private->undo_stack) == undo)
         return undo;
@@ -485,7 +518,7 @@ gimp_image_undo_get_fadeable (GimpImage *image)
 
 /*  private functions  */
 
-static void
+static gboolean
 gimp_image_undo_pop_stack (GimpImage     *image,
                            GimpUndoStack *undo_stack,
                            GimpUndoStack *redo_stack,
@@ -493,6 +526,26 @@ gimp_image_undo_pop_stack (GimpImage     *image,
 {
   GimpUndo            *undo;
   GimpUndoAccumulator  accum = { 0, };
+  GError              *error = NULL;
+
+  undo = gimp_undo_stack_peek (undo_stack);
+
+  /*  an undo step whose compressed buffers can't be restored is left
+   *  on its stack, and nothing is undone or redone
+   */
+  if (undo && ! gimp_image_undo_uncompress_undo (undo_stack, undo, &error))
+    {
+      gimp_message (image->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    (undo_mode == GIMP_UNDO_MODE_UNDO) ?
+                    _("Could not undo, the undo step can't be "
+                      "restored:\n\n%s") :
+                    _("Could not redo, the redo step can't be "
+                      "restored:\n\n%s"),
+                    error->message);
+      g_clear_error (&error);
+
+      return FALSE;
+    }
 
   g_object_freeze_notify (G_OBJECT (image));
 
@@ -529,9 +582,15 @@ gimp_image_undo_pop_stack (GimpImage     *image,
                              (undo_mode == GIMP_UNDO_MODE_UNDO) ?
                              GIMP_UNDO_EVENT_UNDO : GIMP_UNDO_EVENT_REDO,
                              undo);
+
+      /*  redoing made the previous undo step an old one  */
+      if (undo_mode == GIMP_UNDO_MODE_REDO)
+        gimp_image_undo_compress_start (image);
     }
 
   g_object_thaw_notify (G_OBJECT (image));
+
+  return TRUE;
 }
 
 static void
@@ -545,6 +604,11 @@ gimp_image_undo_free_space (GimpImage *image)
 
   container = private->undo_stack->undos;
 
+  /*  the newest undo step can have changed its size since it was
+   *  pushed, e.g. a closed undo group whose last undo removed a layer
+   */
+  gimp_undo_stack_update_top_memsize (private->undo_stack);
+
   min_undo_levels = image->gimp->config->levels_of_undo;
   max_undo_levels = 1024; /* FIXME */
   undo_size       = image->gimp->config->undo_size;
@@ -552,14 +616,14 @@ gimp_image_undo_free_space (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
   g_printerr ("undo_steps: %d    undo_bytes: %ld\n",
               gimp_container_get_n_children (container),
-              (glong) gimp_object_get_memsize (GIMP_OBJECT (container), NULL));
+              (glong) gimp_undo_stack_get_undos_memsize (private->undo_stack));
 #endif
 
   /*  keep at least min_undo_levels undo steps  */
   if (gimp_container_get_n_children (container) <= min_undo_levels)
     return;
 
-  while ((gimp_object_get_memsize (GIMP_OBJECT (container), NULL) > undo_size) ||
+  while ((gimp_undo_stack_get_undos_memsize (private->undo_stack) > undo_size) ||
          (gimp_container_get_n_children (container) > max_undo_levels))
     {
       GimpUndo *freed = gimp_undo_stack_free_bottom (private->undo_stack,
@@ -568,8 +632,7 @@ gimp_image_undo_free_space (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
       g_printerr ("freed one step: undo_steps: %d    undo_bytes: %ld\n",
                   gimp_container_get_n_children (container),
-                  (glong) gimp_object_get_memsize (GIMP_OBJECT (container),
-                                                   NULL));
+                  (glong) gimp_undo_stack_get_undos_memsize (private->undo_stack));
 #endif
 
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_UNDO_EXPIRED, freed);
@@ -590,7 +653,7 @@ gimp_image_undo_free_redo (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
   g_printerr ("redo_steps: %d    redo_bytes: %ld\n",
               gimp_container_get_n_children (container),
-              (glong) gimp_object_get_memsize (GIMP_OBJECT (container), NULL));
+              (glong) gimp_undo_stack_get_undos_memsize (private->redo_stack));
 #endif
 
   if (gimp_container_is_empty (container))
@@ -604,8 +667,7 @@ gimp_image_undo_free_redo (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
       g_printerr ("freed one step: redo_steps: %d    redo_bytes: %ld\n",
                   gimp_container_get_n_children (container),
-                  (glong )gimp_object_get_memsize (GIMP_OBJECT (container),
-                                                   NULL));
+                  (glong) gimp_undo_stack_get_undos_memsize (private->redo_stack));
 #endif
 
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_REDO_EXPIRED, freed);
@@ -627,6 +689,222 @@ gimp_image_undo_free_redo (GimpImage *image)
     }
 }
 
+/*  All undo steps but the newest one are compressed in a separate
+ *  thread, one step after the other, which a low priority timeout
+ *  starts and checks on.  Once the compressed data exceeds the
+ *  "undo-compressed-size" budget, the oldest compressed steps are
+ *  moved to the swap folder.  Popping an undo step restores it.
+ */
+static void
+gimp_image_undo_compress_start (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+
+  if (! private->undo_compress_idle_id)
+    {
+      private->undo_compress_idle_id =
+        g_timeout_add_full (GIMP_PRIORITY_UNDO_COMPRESS_IDLE,
+                            UNDO_COMPRESS_INTERVAL,
+                            (GSourceFunc) gimp_image_undo_compress_idle,
+                            image, NULL);
+    }
+}
+
+static gboolean
+gimp_image_undo_compress_idle (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GList            *list;
+
+  list = GIMP_LIST (private->undo_stack->undos)->list;
+
+  /*  keep the newest undo step as it is, it is the one which is most
+   *  likely undone, faded or compressed with the next undo step
+   */
+  for (list = g_list_next (list); list; list = g_list_next (list))
+    {
+      if (gimp_image_undo_compress_undo (private->undo_stack, list->data))
+        return TRUE;
+    }
+
+  if (gimp_image_undo_swap_out (image))
+    return TRUE;
+
+  private->undo_compress_idle_id = 0;
+
+  return FALSE;
+}
+
+static gboolean
+gimp_image_undo_compress_undo (GimpUndoStack *stack,
+                               GimpUndo      *undo)
+{
+  gboolean compressed = FALSE;
+
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GimpUndoStack *group = GIMP_UNDO_STACK (undo);
+      GList         *list;
+
+      for (list = GIMP_LIST (group->undos)->list;
+           list && ! compressed;
+           list = g_list_next (list))
+        {
+          compressed = gimp_image_undo_compress_undo (group, list->data);
+        }
+    }
+  else
+    {
+      compressed = gimp_undo_compress (undo);
+    }
+
+  if (compressed)
+    gimp_undo_stack_update_memsize (stack, undo);
+
+  return compressed;
+}
+
+static gboolean
+gimp_image_undo_uncompress_undo (GimpUndoStack  *stack,
+                                 GimpUndo       *undo,
+                                 GError        **error)
+{
+  gboolean success = TRUE;
+
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GimpUndoStack *group = GIMP_UNDO_STACK (undo);
+      GList         *list;
+
+      for (list = GIMP_LIST (group->undos)->list;
+           list && success;
+           list = g_list_next (list))
+        {
+          success = gimp_image_undo_uncompress_undo (group, list->data,
+                                                     error);
+        }
+    }
+  else
+    {
+      success = gimp_undo_uncompress (undo, error);
+    }
+
+  /*  also if it failed, earlier undos of a group can be restored  */
+  gimp_undo_stack_update_memsize (stack, undo);
+
+  return success;
+}
+
+static gint64
+gimp_image_undo_get_compressed_size (GimpUndo *undo)
+{
+  gint64 size = 0;
+
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GList *list;
+
+      for (list = GIMP_LIST (GIMP_UNDO_STACK (undo)->undos)->list;
+           list;
+           list = g_list_next (list))
+        {
+          size += gimp_image_undo_get_compressed_size (list->data);
+        }
+    }
+  else
+    {
+      size = gimp_undo_get_compressed_size (undo);
+    }
+
+  return size;
+}
+
+/*  Swaps out the newest compressed undo step which doesn't fit into
+ *  the budget any longer.  Returns FALSE if there is nothing to do.
+ */
+static gboolean
+gimp_image_undo_swap_out (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GimpCoreConfig   *config  = image->gimp->config;
+  GList            *list;
+  gint64            compressed_size = 0;
+
+  if (private->undo_swap_failed)
+    return FALSE;
+
+  for (list = GIMP_LIST (private->undo_stack->undos)->list;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *undo = list->data;
+      gint64    size = gimp_image_undo_get_compressed_size (undo);
+
+      compressed_size += size;
+
+      if (size > 0 && compressed_size > config->undo_compressed_size)
+        {
+          GimpGeglConfig *gegl_config = GIMP_GEGL_CONFIG (config);
+          gchar          *swap_dir;
+          GError         *error = NULL;
+
+          swap_dir = gimp_config_path_expand (gegl_config->swap_path ?
+                                              gegl_config->swap_path :
+                                              gegl_config->temp_path,
+                                              TRUE, NULL);
+
+          if (! gimp_image_undo_swap_out_undo (private->undo_stack, undo,
+                                               swap_dir, &error))
+            {
+              gimp_message (image->gimp, NULL, GIMP_MESSAGE_WARNING,
+                            _("Could not move undo steps to the swap "
+                              "folder, they are kept in memory:\n\n%s"),
+                            error->message);
+              g_clear_error (&error);
+
+              private->undo_swap_failed = TRUE;
+            }
+
+          g_free (swap_dir);
+
+          return ! private->undo_swap_failed;
+        }
+    }
+
+  return FALSE;
+}
+
+static gboolean
+gimp_image_undo_swap_out_undo (GimpUndoStack  *stack,
+                               GimpUndo       *undo,
+                               const gchar    *swap_dir,
+                               GError        **error)
+{
+  gboolean success = TRUE;
+
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GimpUndoStack *group = GIMP_UNDO_STACK (undo);
+      GList         *list;
+
+      for (list = GIMP_LIST (group->undos)->list;
+           list && success;
+           list = g_list_next (list))
+        {
+          success = gimp_image_undo_swap_out_undo (group, list->data,
+                                                   swap_dir, error);
+        }
+    }
+  else
+    {
+      success = gimp_undo_swap_out (undo, swap_dir, error);
+    }
+
+  gimp_undo_stack_update_memsize (stack, undo);
+
+  return success;
+}
+
 static GimpDirtyMask
 gimp_image_undo_dirty_from_type (GimpUndoType undo_type)
 {
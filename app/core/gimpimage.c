@@ -228,6 +228,10 @@ static void     gimp_image_active_vectors_notify (GimpItemTree      *tree,
                                                   const GParamSpec  *pspec,
                                                   GimpImage         *image);
 
+static gint64   gimp_image_get_xcf_drawable_size (GimpDrawable      *drawable,
+                                                  gboolean           save_mipmaps);
+static gint64   gimp_image_get_xcf_data_size     (GimpImage         *image);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpImage, gimp_image, GIMP_TYPE_VIEWABLE,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_COLOR_MANAGED,
@@ -1054,6 +1058,12 @@ gimp_image_finalize (GObject *object)
       private->sample_points = NULL;
     }
 
+  if (private->undo_compress_idle_id)
+    {
+      g_source_remove (private->undo_compress_idle_id);
+      private->undo_compress_idle_id = 0;
+    }
+
   if (private->undo_stack)
     {
       g_object_unref (private->undo_stack);
@@ -2301,11 +2311,83 @@ gimp_image_get_export_proc (const GimpImage *image)
   return GIMP_IMAGE_GET_PRIVATE (image)->export_proc;
 }
 
+/*  the size of a drawable's pixels in an XCF file, including the
+ *  downscaled levels written if "xcf-save-mipmaps" is set.  The levels
+ *  are halved until they fit into one 64x64 XCF tile, like xcf-save.c
+ *  does.
+ */
+static gint64
+gimp_image_get_xcf_drawable_size (GimpDrawable *drawable,
+                                  gboolean      save_mipmaps)
+{
+  const Babl *format = gimp_drawable_get_format (drawable);
+  gint        bpp    = babl_format_get_bytes_per_pixel (format);
+  gint        width  = gimp_item_get_width  (GIMP_ITEM (drawable));
+  gint        height = gimp_item_get_height (GIMP_ITEM (drawable));
+  gint64      size;
+
+  size = (gint64) width * (gint64) height * bpp;
+
+  if (save_mipmaps && ! babl_format_is_palette (format))
+    {
+      gint w = width;
+      gint h = height;
+
+      while (w > 64 || h > 64)
+        {
+          w /= 2;
+          h /= 2;
+
+          if (w <= 0 || h <= 0)
+            break;
+
+          size += (gint64) w * (gint64) h * bpp;
+        }
+    }
+
+  return size;
+}
+
+static gint64
+gimp_image_get_xcf_data_size (GimpImage *image)
+{
+  GList    *drawables;
+  GList    *list;
+  gboolean  save_mipmaps = image->gimp->config->xcf_save_mipmaps;
+  gint64    size         = 0;
+
+  drawables = g_list_concat (gimp_image_get_layer_list (image),
+                             gimp_image_get_channel_list (image));
+
+  drawables = g_list_prepend (drawables, gimp_image_get_mask (image));
+
+  for (list = drawables; list; list = g_list_next (list))
+    {
+      GimpDrawable *drawable = list->data;
+
+      size += gimp_image_get_xcf_drawable_size (drawable, save_mipmaps);
+
+      if (GIMP_IS_LAYER (drawable) && gimp_layer_get_mask (GIMP_LAYER (drawable)))
+        {
+          GimpDrawable *mask = GIMP_DRAWABLE (gimp_layer_get_mask (GIMP_LAYER (drawable)));
+
+          size += gimp_image_get_xcf_drawable_size (mask, save_mipmaps);
+        }
+    }
+
+  g_list_free (drawables);
+
+  /*  tile compression can make data larger than it was, allow for
+   *  the same 50% overhead the XCF loader is prepared to read
+   */
+  return size + size / 2;
+}
+
 gint
-gimp_image_get_xcf_version (GimpImage    *image,
-                            gboolean      zlib_compression,
-                            gint         *gimp_version,
-                            const gchar **version_string)
+gimp_image_get_xcf_version (GimpImage           *image,
+                            GimpXcfCompression   compression,
+                            gint                *gimp_version,
+                            const gchar        **version_string)
 {
   GList *list;
   gint   version = 0;  /* default to oldest */
@@ -2353,9 +2435,17 @@ gimp_image_get_xcf_version (GimpImage    *image,
     version = MAX (7, version);
 
   /* need version 8 for zlib compression */
-  if (zlib_compression)
+  if (compression == GIMP_XCF_COMPRESSION_ZLIB)
     version = MAX (8, version);
 
+  /* need version 11 for zstd compression */
+  if (compression == GIMP_XCF_COMPRESSION_ZSTD)
+    version = MAX (11, version);
+
+  /* need version 10 for 64 bit offsets, i.e. files larger than 4 GiB */
+  if (gimp_image_get_xcf_data_size (image) > G_MAXUINT32)
+    version = MAX (10, version);
+
   switch (version)
     {
     case 0:
@@ -2376,6 +2466,8 @@ gimp_image_get_xcf_version (GimpImage    *image,
     case 7:
     case 8:
     case 9:
+    case 10:
+    case 11:
       if (gimp_version)   *gimp_version   = 210;
       if (version_string) *version_string = "GIMP 2.10";
       break;
@@ -171,7 +171,7 @@ void            gimp_image_exported              (GimpImage          *image,
                                                   GFile              *file);
 
 gint            gimp_image_get_xcf_version       (GimpImage          *image,
-                                                  gboolean            zlib_compression,
+                                                  GimpXcfCompression  compression,
                                                   gint               *gimp_version,
                                                   const gchar       **version_string);
 
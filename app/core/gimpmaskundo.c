@@ -54,6 +54,9 @@ static void     gimp_mask_undo_pop          (GimpUndo            *undo,
                                              GimpUndoAccumulator *accum);
 static void     gimp_mask_undo_free         (GimpUndo            *undo,
                                              GimpUndoMode         undo_mode);
+static GeglBuffer * gimp_mask_undo_get_buffer (GimpUndo          *undo);
+static void     gimp_mask_undo_set_buffer   (GimpUndo            *undo,
+                                             GeglBuffer          *buffer);
 
 
 G_DEFINE_TYPE (GimpMaskUndo, gimp_mask_undo, GIMP_TYPE_ITEM_UNDO)
@@ -76,6 +79,8 @@ gimp_mask_undo_class_init (GimpMaskUndoClass *klass)
 
   undo_class->pop                = gimp_mask_undo_pop;
   undo_class->free               = gimp_mask_undo_free;
+  undo_class->get_buffer         = gimp_mask_undo_get_buffer;
+  undo_class->set_buffer         = gimp_mask_undo_set_buffer;
 
   g_object_class_install_property (object_class, PROP_CONVERT_FORMAT,
                                    g_param_spec_boolean ("convert-format",
@@ -291,3 +296,24 @@ gimp_mask_undo_free (GimpUndo     *undo,
 
   GIMP_UNDO_CLASS (parent_class)->free (undo, undo_mode);
 }
+
+static GeglBuffer *
+gimp_mask_undo_get_buffer (GimpUndo *undo)
+{
+  return GIMP_MASK_UNDO (undo)->buffer;
+}
+
+static void
+gimp_mask_undo_set_buffer (GimpUndo   *undo,
+                           GeglBuffer *buffer)
+{
+  GimpMaskUndo *mask_undo = GIMP_MASK_UNDO (undo);
+
+  if (buffer)
+    g_object_ref (buffer);
+
+  if (mask_undo->buffer)
+    g_object_unref (mask_undo->buffer);
+
+  mask_undo->buffer = buffer;
+}
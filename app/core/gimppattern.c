@@ -17,6 +17,7 @@
 
 #include "config.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -26,6 +27,7 @@
 
 #include "core-types.h"
 
+#include "gimp-memsize.h"
 #include "gimppattern.h"
 #include "gimppattern-load.h"
 #include "gimptagged.h"
@@ -52,6 +54,11 @@ static gchar       * gimp_pattern_get_description   (GimpViewable         *viewa
 
 static const gchar * gimp_pattern_get_extension     (GimpData             *data);
 static GimpData    * gimp_pattern_duplicate         (GimpData             *data);
+static gchar       * gimp_pattern_get_index         (GimpData             *data);
+static gboolean      gimp_pattern_set_index         (GimpData             *data,
+                                                     const gchar          *index);
+static gboolean      gimp_pattern_load_indexed      (GimpData             *data,
+                                                     GError              **error);
 
 static gchar       * gimp_pattern_get_checksum      (GimpTagged           *tagged);
 
@@ -82,6 +89,9 @@ gimp_pattern_class_init (GimpPatternClass *klass)
 
   data_class->get_extension         = gimp_pattern_get_extension;
   data_class->duplicate             = gimp_pattern_duplicate;
+  data_class->get_index             = gimp_pattern_get_index;
+  data_class->set_index             = gimp_pattern_set_index;
+  data_class->load_indexed          = gimp_pattern_load_indexed;
 }
 
 static void
@@ -107,6 +117,8 @@ gimp_pattern_finalize (GObject *object)
       pattern->mask = NULL;
     }
 
+  g_clear_pointer (&pattern->checksum, g_free);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -118,6 +130,7 @@ gimp_pattern_get_memsize (GimpObject *object,
   gint64       memsize = 0;
 
   memsize += gimp_temp_buf_get_memsize (pattern->mask);
+  memsize += gimp_string_get_memsize (pattern->checksum);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -130,8 +143,16 @@ gimp_pattern_get_size (GimpViewable *viewable,
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
 
-  *width  = gimp_temp_buf_get_width  (pattern->mask);
-  *height = gimp_temp_buf_get_height (pattern->mask);
+  if (! pattern->mask)
+    {
+      *width  = pattern->width;
+      *height = pattern->height;
+    }
+  else
+    {
+      *width  = gimp_temp_buf_get_width  (pattern->mask);
+      *height = gimp_temp_buf_get_height (pattern->mask);
+    }
 
   return TRUE;
 }
@@ -149,6 +170,14 @@ gimp_pattern_get_new_preview (GimpViewable *viewable,
   gint         copy_width;
   gint         copy_height;
 
+  /*  don't load the pattern just to show it in the pattern dialog  */
+  temp_buf = gimp_data_get_index_preview (GIMP_DATA (pattern), width, height);
+
+  if (temp_buf)
+    return temp_buf;
+
+  gimp_data_load (GIMP_DATA (pattern));
+
   copy_width  = MIN (width,  gimp_temp_buf_get_width  (pattern->mask));
   copy_height = MIN (height, gimp_temp_buf_get_height (pattern->mask));
 
@@ -173,11 +202,14 @@ gimp_pattern_get_description (GimpViewable  *viewable,
                               gchar        **tooltip)
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
+  gint         width;
+  gint         height;
+
+  gimp_pattern_get_size (viewable, &width, &height);
 
   return g_strdup_printf ("%s (%d × %d)",
                           gimp_object_get_name (pattern),
-                          gimp_temp_buf_get_width  (pattern->mask),
-                          gimp_temp_buf_get_height (pattern->mask));
+                          width, height);
 }
 
 static const gchar *
@@ -196,12 +228,109 @@ gimp_pattern_duplicate (GimpData *data)
   return GIMP_DATA (pattern);
 }
 
+static gchar *
+gimp_pattern_get_index (GimpData *data)
+{
+  GimpPattern *pattern = GIMP_PATTERN (data);
+  gchar       *checksum;
+  gchar       *index;
+
+  /*  the clipboard pattern can't be reloaded from a file  */
+  if (G_TYPE_FROM_INSTANCE (pattern) != GIMP_TYPE_PATTERN ||
+      ! pattern->mask)
+    return NULL;
+
+  checksum = gimp_pattern_get_checksum (GIMP_TAGGED (pattern));
+
+  index = g_strdup_printf ("%d %d %s",
+                           gimp_temp_buf_get_width  (pattern->mask),
+                           gimp_temp_buf_get_height (pattern->mask),
+                           checksum);
+
+  g_free (checksum);
+
+  return index;
+}
+
+static gboolean
+gimp_pattern_set_index (GimpData    *data,
+                        const gchar *index)
+{
+  GimpPattern *pattern = GIMP_PATTERN (data);
+  gint         width;
+  gint         height;
+  gchar        checksum[33];
+
+  if (sscanf (index, "%d %d %32s", &width, &height, checksum) != 3 ||
+      width <= 0 || height <= 0)
+    return FALSE;
+
+  pattern->width    = width;
+  pattern->height   = height;
+  pattern->checksum = g_strdup (checksum);
+
+  return TRUE;
+}
+
+static gboolean
+gimp_pattern_load_indexed (GimpData  *data,
+                           GError   **error)
+{
+  GimpPattern  *pattern = GIMP_PATTERN (data);
+  GFile        *file    = gimp_data_get_file (data);
+  GList        *list    = NULL;
+  GInputStream *input;
+
+  input = G_INPUT_STREAM (g_file_read (file, NULL, error));
+
+  if (input)
+    {
+      if (! g_strcmp0 (gimp_data_get_mime_type (data), "image/x-gimp-pat"))
+        list = gimp_pattern_load (NULL, file, input, error);
+      else
+        list = gimp_pattern_load_pixbuf (NULL, file, input, error);
+
+      g_object_unref (input);
+    }
+
+  if (list)
+    {
+      GimpPattern *loaded = list->data;
+
+      pattern->mask = loaded->mask;
+      loaded->mask  = NULL;
+
+      g_list_free_full (list, (GDestroyNotify) g_object_unref);
+    }
+  else
+    {
+      /*  keep the pattern usable  */
+      pattern->mask = gimp_temp_buf_new (pattern->width, pattern->height,
+                                         babl_format ("R'G'B' u8"));
+      gimp_temp_buf_data_clear (pattern->mask);
+    }
+
+  g_clear_pointer (&pattern->checksum, g_free);
+
+  /*  the file changed since it was indexed  */
+  if (gimp_temp_buf_get_width  (pattern->mask) != pattern->width ||
+      gimp_temp_buf_get_height (pattern->mask) != pattern->height)
+    {
+      gimp_viewable_size_changed (GIMP_VIEWABLE (pattern));
+    }
+
+  return list != NULL;
+}
+
 static gchar *
 gimp_pattern_get_checksum (GimpTagged *tagged)
 {
   GimpPattern *pattern         = GIMP_PATTERN (tagged);
   gchar       *checksum_string = NULL;
 
+  if (pattern->checksum)
+    return g_strdup (pattern->checksum);
+
   if (pattern->mask)
     {
       GChecksum *checksum = g_checksum_new (G_CHECKSUM_MD5);
@@ -270,6 +399,8 @@ gimp_pattern_get_mask (const GimpPattern *pattern)
 {
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
+  gimp_data_load (GIMP_DATA (pattern));
+
   return pattern->mask;
 }
 
@@ -278,5 +409,7 @@ gimp_pattern_create_buffer (const GimpPattern *pattern)
 {
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
+  gimp_data_load (GIMP_DATA (pattern));
+
   return gimp_temp_buf_create_buffer (pattern->mask);
 }
@@ -37,6 +37,11 @@ struct _GimpPattern
   GimpData     parent_instance;
 
   GimpTempBuf *mask;
+
+  /*  the indexed values, used until the mask is loaded  */
+  gint         width;
+  gint         height;
+  gchar       *checksum;
 };
 
 struct _GimpPatternClass
@@ -0,0 +1,136 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_PICKABLE_CONTIGUOUS_REGION_PRIVATE_H__
+#define __GIMP_PICKABLE_CONTIGUOUS_REGION_PRIVATE_H__
+
+
+/*  The difference of the pixel @col2 to @col1, as the mask value the
+ *  pixel gets.  The vectorized versions must return exactly the same.
+ */
+static inline gfloat
+pixel_difference (const gfloat        *col1,
+                  const gfloat        *col2,
+                  gboolean             antialias,
+                  gfloat               threshold,
+                  gint                 n_components,
+                  gboolean             has_alpha,
+                  gboolean             select_transparent,
+                  GimpSelectCriterion  select_criterion)
+{
+  gfloat max = 0.0;
+
+  /*  if there is an alpha channel, never select transparent regions  */
+  if (! select_transparent && has_alpha && col2[n_components - 1] == 0.0)
+    return 0.0;
+
+  if (select_transparent && has_alpha)
+    {
+      max = fabs (col1[n_components - 1] - col2[n_components - 1]);
+    }
+  else
+    {
+      gfloat diff;
+      gint   b;
+
+      if (has_alpha)
+        n_components--;
+
+      switch (select_criterion)
+        {
+        case GIMP_SELECT_CRITERION_COMPOSITE:
+          for (b = 0; b < n_components; b++)
+            {
+              diff = fabs (col1[b] - col2[b]);
+              if (diff > max)
+                max = diff;
+            }
+          break;
+
+        case GIMP_SELECT_CRITERION_R:
+          max = fabs (col1[0] - col2[0]);
+          break;
+
+        case GIMP_SELECT_CRITERION_G:
+          max = fabs (col1[1] - col2[1]);
+          break;
+
+        case GIMP_SELECT_CRITERION_B:
+          max = fabs (col1[2] - col2[2]);
+          break;
+
+        case GIMP_SELECT_CRITERION_H:
+          {
+            /* wrap around candidates for the actual distance */
+            gfloat dist1 = fabs (col1[0] - col2[0]);
+            gfloat dist2 = fabs (col1[0] - 1.0 - col2[0]);
+            gfloat dist3 = fabs (col1[0] - col2[0] + 1.0);
+
+            max = MIN (dist1, dist2);
+            if (max > dist3)
+              max = dist3;
+          }
+          break;
+
+        case GIMP_SELECT_CRITERION_S:
+          max = fabs (col1[1] - col2[1]);
+          break;
+
+        case GIMP_SELECT_CRITERION_V:
+          max = fabs (col1[2] - col2[2]);
+          break;
+        }
+    }
+
+  if (antialias && threshold > 0.0)
+    {
+      gfloat aa = 1.5 - (max / threshold);
+
+      if (aa <= 0.0)
+        return 0.0;
+      else if (aa < 0.5)
+        return aa * 2.0;
+      else
+        return 1.0;
+    }
+  else
+    {
+      if (max > threshold)
+        return 0.0;
+      else
+        return 1.0;
+    }
+}
+
+
+#if COMPILE_SSE2_INTRINISICS
+
+gsize  gimp_pickable_pixel_difference_row_sse2 (const gfloat        *col,
+                                                const gfloat        *src,
+                                                gfloat              *dest,
+                                                gsize                n_pixels,
+                                                gboolean             antialias,
+                                                gfloat               threshold,
+                                                gint                 n_components,
+                                                gboolean             has_alpha,
+                                                gboolean             select_transparent,
+                                                GimpSelectCriterion  select_criterion);
+
+#endif /* COMPILE_SSE2_INTRINISICS */
+
+
+#endif  /*  __GIMP_PICKABLE_CONTIGUOUS_REGION_PRIVATE_H__  */
@@ -0,0 +1,198 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppickable-contiguous-region-sse2.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "core-types.h"
+
+#include "gimppickable-contiguous-region-private.h"
+
+
+#if COMPILE_SSE2_INTRINISICS
+
+/* SSE2 */
+#include <emmintrin.h>
+
+
+/*  Loads four pixels and returns their first four components in @c,
+ *  one vector per component.  The components beyond @n_components are
+ *  garbage.  Pixels of two or three components are loaded four floats
+ *  at a time, so the last load reads into the pixel after them.
+ */
+static inline void
+load_pixels (const gfloat *src,
+             gint          n_components,
+             __m128        c[4])
+{
+  if (n_components == 1)
+    {
+      c[0] = _mm_loadu_ps (src);
+      c[1] = c[2] = c[3] = c[0];
+    }
+  else
+    {
+      c[0] = _mm_loadu_ps (src);
+      c[1] = _mm_loadu_ps (src + n_components);
+      c[2] = _mm_loadu_ps (src + 2 * n_components);
+      c[3] = _mm_loadu_ps (src + 3 * n_components);
+
+      _MM_TRANSPOSE4_PS (c[0], c[1], c[2], c[3]);
+    }
+}
+
+/*  Does what pixel_difference_row() does for as many blocks of four
+ *  pixels as it can, and returns the number of pixels it handled.
+ *
+ *  The results are exactly those of pixel_difference(): the float
+ *  differences it widens to double for fabs() are exact, it keeps the
+ *  largest difference with the same comparison as _mm_max_ps(), and
+ *  rounding its double expressions of one float operation back to
+ *  float gives the float operation's result.  The hue criterion
+ *  computes two operations in double and is left to the caller.
+ */
+gsize
+gimp_pickable_pixel_difference_row_sse2 (const gfloat        *col,
+                                         const gfloat        *src,
+                                         gfloat              *dest,
+                                         gsize                n_pixels,
+                                         gboolean             antialias,
+                                         gfloat               threshold,
+                                         gint                 n_components,
+                                         gboolean             has_alpha,
+                                         gboolean             select_transparent,
+                                         GimpSelectCriterion  select_criterion)
+{
+  const __m128 sign_mask   = _mm_set1_ps (-0.0f);
+  const __m128 zero        = _mm_setzero_ps ();
+  const __m128 half        = _mm_set1_ps (0.5f);
+  const __m128 one         = _mm_set1_ps (1.0f);
+  const __m128 one_half    = _mm_set1_ps (1.5f);
+  const __m128 two         = _mm_set1_ps (2.0f);
+  const __m128 threshold_v = _mm_set1_ps (threshold);
+  __m128       col_v[4];
+  gboolean     composite = FALSE;
+  gint         alpha     = n_components - 1;
+  gint         first;
+  gint         last;
+  gsize        n_blocks;
+  gsize        i;
+  gint         b;
+
+  if (n_components < 1 || n_components > 4)
+    return 0;
+
+  if (select_transparent && has_alpha)
+    {
+      first = last = alpha;
+    }
+  else
+    {
+      switch (select_criterion)
+        {
+        case GIMP_SELECT_CRITERION_COMPOSITE:
+          composite = TRUE;
+          first     = 0;
+          last      = has_alpha ? n_components - 2 : n_components - 1;
+          break;
+
+        case GIMP_SELECT_CRITERION_R:
+          first = last = 0;
+          break;
+
+        case GIMP_SELECT_CRITERION_G:
+        case GIMP_SELECT_CRITERION_S:
+          first = last = 1;
+          break;
+
+        case GIMP_SELECT_CRITERION_B:
+        case GIMP_SELECT_CRITERION_V:
+          first = last = 2;
+          break;
+
+        default:
+          return 0;
+        }
+    }
+
+  if (last < first || last >= n_components)
+    return 0;
+
+  n_blocks = n_pixels / 4;
+
+  if (n_components == 2 || n_components == 3)
+    n_blocks = n_pixels > 4 ? (n_pixels - 1) / 4 : 0;
+
+  for (b = 0; b < n_components; b++)
+    col_v[b] = _mm_set1_ps (col[b]);
+
+  for (i = 0; i < n_blocks; i++)
+    {
+      __m128 c[4];
+      __m128 max;
+      __m128 result;
+
+      load_pixels (src + i * 4 * n_components, n_components, c);
+
+      if (composite)
+        {
+          max = zero;
+
+          for (b = first; b <= last; b++)
+            {
+              __m128 diff = _mm_andnot_ps (sign_mask,
+                                           _mm_sub_ps (col_v[b], c[b]));
+
+              max = _mm_max_ps (diff, max);
+            }
+        }
+      else
+        {
+          max = _mm_andnot_ps (sign_mask, _mm_sub_ps (col_v[first], c[first]));
+        }
+
+      if (antialias && threshold > 0.0)
+        {
+          __m128 aa   = _mm_sub_ps (one_half, _mm_div_ps (max, threshold_v));
+          __m128 low  = _mm_cmple_ps (aa, zero);
+          __m128 ramp = _mm_cmplt_ps (aa, half);
+
+          result = _mm_or_ps (_mm_and_ps (ramp, _mm_mul_ps (aa, two)),
+                              _mm_andnot_ps (ramp, one));
+          result = _mm_andnot_ps (low, result);
+        }
+      else
+        {
+          result = _mm_andnot_ps (_mm_cmpgt_ps (max, threshold_v), one);
+        }
+
+      /*  if there is an alpha channel, never select transparent regions  */
+      if (! select_transparent && has_alpha)
+        result = _mm_andnot_ps (_mm_cmpeq_ps (c[alpha], zero), result);
+
+      _mm_storeu_ps (dest + i * 4, result);
+    }
+
+  return n_blocks * 4;
+}
+
+#endif /* COMPILE_SSE2_INTRINISICS */
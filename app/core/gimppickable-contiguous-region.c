@@ -23,16 +23,82 @@
 #include <gegl.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+#include "libgimpbase/gimpbase.h"
 #include "libgimpcolor/gimpcolor.h"
 #include "libgimpmath/gimpmath.h"
 
 #include "core-types.h"
 
 #include "gegl/gimp-babl.h"
+#include "gegl/gimptilehandlervalidate.h"
 
+#include "gimp-parallel.h"
 #include "gimp-utils.h" /* GIMP_TIMER */
 #include "gimppickable.h"
 #include "gimppickable-contiguous-region.h"
+#include "gimppickable-contiguous-region-private.h"
+
+
+/*  the source is read and compared in bands of this many rows, and
+ *  this many bands are kept around while filling
+ */
+#define BAND_HEIGHT  64
+#define N_BANDS      4
+
+/*  select by color doesn't split the pickable into parts smaller than
+ *  this many pixels
+ */
+#define MIN_PARALLEL_AREA  (64 * 64 * 4)
+
+
+typedef struct _Span            Span;
+typedef struct _FillData        FillData;
+typedef struct _ColorSelectData ColorSelectData;
+
+struct _Span
+{
+  gint y;
+  gint start;  /*  exclusive  */
+  gint end;    /*  exclusive  */
+};
+
+struct _FillData
+{
+  GeglBuffer          *src_buffer;
+  const Babl          *format;
+  gint                 n_components;
+  gboolean             has_alpha;
+  gboolean             select_transparent;
+  GimpSelectCriterion  select_criterion;
+  gboolean             antialias;
+  gfloat               threshold;
+  const gfloat        *col;
+
+  gint                 width;
+  gint                 height;
+
+  gfloat              *src;                 /*  one band of source pixels  */
+  gfloat              *diff[N_BANDS];       /*  pixel_difference() per pixel  */
+  gint                 band[N_BANDS];
+  guint                band_stamp[N_BANDS];
+  guint                stamp;
+
+  guint8              *visited;             /*  one bit per pixel  */
+};
+
+struct _ColorSelectData
+{
+  GeglBuffer          *src_buffer;
+  GeglBuffer          *mask_buffer;
+  const Babl          *format;
+  gint                 n_components;
+  gboolean             has_alpha;
+  gboolean             select_transparent;
+  GimpSelectCriterion  select_criterion;
+  gboolean             antialias;
+  gfloat               threshold;
+  const gfloat        *col;
+};
 
 
 /*  local function prototypes  */
@@ -41,30 +107,20 @@ static const Babl * choose_format         (GeglBuffer          *buffer,
                                            GimpSelectCriterion  select_criterion,
                                            gint                *n_components,
                                            gboolean            *has_alpha);
-static gfloat   pixel_difference          (const gfloat        *col1,
-                                           const gfloat        *col2,
+static void     pixel_difference_row      (const gfloat        *col,
+                                           const gfloat        *src,
+                                           gfloat              *dest,
+                                           gsize                n_pixels,
                                            gboolean             antialias,
                                            gfloat               threshold,
                                            gint                 n_components,
                                            gboolean             has_alpha,
                                            gboolean             select_transparent,
                                            GimpSelectCriterion  select_criterion);
-static gboolean find_contiguous_segment   (const gfloat        *col,
-                                           GeglBuffer          *src_buffer,
-                                           GeglBuffer          *mask_buffer,
-                                           const Babl          *src_format,
-                                           gint                 n_components,
-                                           gboolean             has_alpha,
-                                           gint                 width,
-                                           gboolean             select_transparent,
-                                           GimpSelectCriterion  select_criterion,
-                                           gboolean             antialias,
-                                           gfloat               threshold,
-                                           gint                 initial_x,
-                                           gint                 initial_y,
-                                           gint                *start,
-                                           gint                *end,
-                                           gfloat              *row);
+static void     select_by_color_area      (const GeglRectangle *area,
+                                           ColorSelectData     *data);
+static const gfloat * fill_data_get_row   (FillData            *data,
+                                           gint                 y);
 static void     find_contiguous_region    (GeglBuffer          *src_buffer,
                                            GeglBuffer          *mask_buffer,
                                            const Babl          *format,
@@ -161,13 +217,14 @@ gimp_pickable_contiguous_region_by_color (GimpPickable        *pickable,
    *  fuzzy_select.  Modify the pickable's mask to reflect the
    *  additional selection
    */
-  GeglBufferIterator *iter;
-  GeglBuffer         *src_buffer;
-  GeglBuffer         *mask_buffer;
-  const Babl         *format;
-  gint                n_components;
-  gboolean            has_alpha;
-  gfloat              start_col[MAX_CHANNELS];
+  ColorSelectData          data;
+  GimpTileHandlerValidate *validate;
+  GeglBuffer              *src_buffer;
+  GeglBuffer              *mask_buffer;
+  const Babl              *format;
+  gint                     n_components;
+  gboolean                 has_alpha;
+  gfloat                   start_col[MAX_CHANNELS];
 
   g_return_val_if_fail (GIMP_IS_PICKABLE (pickable), NULL);
   g_return_val_if_fail (color != NULL, NULL);
@@ -176,6 +233,16 @@ gimp_pickable_contiguous_region_by_color (GimpPickable        *pickable,
 
   src_buffer = gimp_pickable_get_buffer (pickable);
 
+  /*  the buffer of a projection renders its tiles when they are first
+   *  read, which can't happen on several threads at once, so render
+   *  everything before the buffer is read in parallel
+   */
+  validate = gimp_tile_handler_validate_get_assigned (src_buffer);
+
+  if (validate)
+    gimp_tile_handler_validate_validate (validate,
+                                         gegl_buffer_get_extent (src_buffer));
+
   format = choose_format (src_buffer, select_criterion,
                           &n_components, &has_alpha);
 
@@ -199,35 +266,22 @@ gimp_pickable_contiguous_region_by_color (GimpPickable        *pickable,
   mask_buffer = gegl_buffer_new (gegl_buffer_get_extent (src_buffer),
                                  babl_format ("Y float"));
 
-  iter = gegl_buffer_iterator_new (src_buffer,
-                                   NULL, 0, format,
-                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-
-  gegl_buffer_iterator_add (iter, mask_buffer,
-                            NULL, 0, babl_format ("Y float"),
-                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-
-  while (gegl_buffer_iterator_next (iter))
-    {
-      const gfloat *src   = iter->data[0];
-      gfloat       *dest  = iter->data[1];
-      gint          count = iter->length;
-
-      while (count--)
-        {
-          /*  Find how closely the colors match  */
-          *dest = pixel_difference (start_col, src,
-                                    antialias,
-                                    threshold,
-                                    n_components,
-                                    has_alpha,
-                                    select_transparent,
-                                    select_criterion);
-
-          src  += n_components;
-          dest += 1;
-        }
-    }
+  data.src_buffer         = src_buffer;
+  data.mask_buffer        = mask_buffer;
+  data.format             = format;
+  data.n_components       = n_components;
+  data.has_alpha          = has_alpha;
+  data.select_transparent = select_transparent;
+  data.select_criterion   = select_criterion;
+  data.antialias          = antialias;
+  data.threshold          = threshold;
+  data.col                = start_col;
+
+  gimp_parallel_distribute_area (gegl_buffer_get_extent (src_buffer),
+                                 MIN_PARALLEL_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 select_by_color_area,
+                                 &data);
 
   return mask_buffer;
 }
@@ -278,209 +332,165 @@ choose_format (GeglBuffer          *buffer,
   return format;
 }
 
-static gfloat
-pixel_difference (const gfloat        *col1,
-                  const gfloat        *col2,
-                  gboolean             antialias,
-                  gfloat               threshold,
-                  gint                 n_components,
-                  gboolean             has_alpha,
-                  gboolean             select_transparent,
-                  GimpSelectCriterion  select_criterion)
+/*  Calls pixel_difference() for @n_pixels pixels.  There is one loop
+ *  per criterion, so the criterion is a constant inside each of them
+ *  and the compiler can drop the switch from the loop and vectorize
+ *  it, while the results stay exactly those of pixel_difference().
+ *  The pixels the SSE2 version handles are skipped.
+ */
+static void
+pixel_difference_row (const gfloat        *col,
+                      const gfloat        *src,
+                      gfloat              *dest,
+                      gsize                n_pixels,
+                      gboolean             antialias,
+                      gfloat               threshold,
+                      gint                 n_components,
+                      gboolean             has_alpha,
+                      gboolean             select_transparent,
+                      GimpSelectCriterion  select_criterion)
 {
-  gfloat max = 0.0;
-
-  /*  if there is an alpha channel, never select transparent regions  */
-  if (! select_transparent && has_alpha && col2[n_components - 1] == 0.0)
-    return 0.0;
-
-  if (select_transparent && has_alpha)
-    {
-      max = fabs (col1[n_components - 1] - col2[n_components - 1]);
+  gsize i = 0;
+
+#if COMPILE_SSE2_INTRINISICS
+  if (gimp_cpu_accel_get_support () & GIMP_CPU_ACCEL_X86_SSE2)
+    i = gimp_pickable_pixel_difference_row_sse2 (col, src, dest, n_pixels,
+                                                 antialias, threshold,
+                                                 n_components, has_alpha,
+                                                 select_transparent,
+                                                 select_criterion);
+#endif /* COMPILE_SSE2_INTRINISICS */
+
+#define PIXEL_DIFFERENCE_LOOP(criterion)                                  \
+  for (; i < n_pixels; i++)                                               \
+    {                                                                     \
+      dest[i] = pixel_difference (col, src + i * n_components,            \
+                                  antialias, threshold,                   \
+                                  n_components, has_alpha,                \
+                                  select_transparent, criterion);         \
     }
-  else
+
+  switch (select_criterion)
     {
-      gfloat diff;
-      gint   b;
+    case GIMP_SELECT_CRITERION_COMPOSITE:
+      PIXEL_DIFFERENCE_LOOP (GIMP_SELECT_CRITERION_COMPOSITE);
+      break;
 
-      if (has_alpha)
-        n_components--;
+    case GIMP_SELECT_CRITERION_R:
+      PIXEL_DIFFERENCE_LOOP (GIMP_SELECT_CRITERION_R);
+      break;
 
-      switch (select_criterion)
-        {
-        case GIMP_SELECT_CRITERION_COMPOSITE:
-          for (b = 0; b < n_components; b++)
-            {
-              diff = fabs (col1[b] - col2[b]);
-              if (diff > max)
-                max = diff;
-            }
-          break;
-
-        case GIMP_SELECT_CRITERION_R:
-          max = fabs (col1[0] - col2[0]);
-          break;
-
-        case GIMP_SELECT_CRITERION_G:
-          max = fabs (col1[1] - col2[1]);
-          break;
-
-        case GIMP_SELECT_CRITERION_B:
-          max = fabs (col1[2] - col2[2]);
-          break;
-
-        case GIMP_SELECT_CRITERION_H:
-          {
-            /* wrap around candidates for the actual distance */
-            gfloat dist1 = fabs (col1[0] - col2[0]);
-            gfloat dist2 = fabs (col1[0] - 1.0 - col2[0]);
-            gfloat dist3 = fabs (col1[0] - col2[0] + 1.0);
-
-            max = MIN (dist1, dist2);
-            if (max > dist3)
-              max = dist3;
-          }
-          break;
-
-        case GIMP_SELECT_CRITERION_S:
-          max = fabs (col1[1] - col2[1]);
-          break;
-
-        case GIMP_SELECT_CRITERION_V:
-          max = fabs (col1[2] - col2[2]);
-          break;
-        }
-    }
+    case GIMP_SELECT_CRITERION_G:
+      PIXEL_DIFFERENCE_LOOP (GIMP_SELECT_CRITERION_G);
+      break;
 
-  if (antialias && threshold > 0.0)
-    {
-      gfloat aa = 1.5 - (max / threshold);
+    case GIMP_SELECT_CRITERION_B:
+      PIXEL_DIFFERENCE_LOOP (GIMP_SELECT_CRITERION_B);
+      break;
 
-      if (aa <= 0.0)
-        return 0.0;
-      else if (aa < 0.5)
-        return aa * 2.0;
-      else
-        return 1.0;
-    }
-  else
-    {
-      if (max > threshold)
-        return 0.0;
-      else
-        return 1.0;
+    case GIMP_SELECT_CRITERION_H:
+      PIXEL_DIFFERENCE_LOOP (GIMP_SELECT_CRITERION_H);
+      break;
+
+    case GIMP_SELECT_CRITERION_S:
+      PIXEL_DIFFERENCE_LOOP (GIMP_SELECT_CRITERION_S);
+      break;
+
+    case GIMP_SELECT_CRITERION_V:
+      PIXEL_DIFFERENCE_LOOP (GIMP_SELECT_CRITERION_V);
+      break;
     }
+
+#undef PIXEL_DIFFERENCE_LOOP
 }
 
-/* #define FETCH_ROW 1 */
-
-static gboolean
-find_contiguous_segment (const gfloat        *col,
-                         GeglBuffer          *src_buffer,
-                         GeglBuffer          *mask_buffer,
-                         const Babl          *format,
-                         gint                 n_components,
-                         gboolean             has_alpha,
-                         gint                 width,
-                         gboolean             select_transparent,
-                         GimpSelectCriterion  select_criterion,
-                         gboolean             antialias,
-                         gfloat               threshold,
-                         gint                 initial_x,
-                         gint                 initial_y,
-                         gint                *start,
-                         gint                *end,
-                         gfloat              *row)
+/*  Called in parallel for stripes of the pickable, which don't
+ *  overlap, so each thread writes its own part of the mask.
+ */
+static void
+select_by_color_area (const GeglRectangle *area,
+                      ColorSelectData     *data)
 {
-  gfloat *s;
-  gfloat  mask_row[width];
-  gfloat  diff;
-
-#ifdef FETCH_ROW
-  gegl_buffer_get (src_buffer, GEGL_RECTANGLE (0, initial_y, width, 1), 1.0,
-                   format,
-                   row, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-  s = row + initial_x * n_components;
-#else
-  s = g_alloca (n_components * sizeof (gfloat));
-
-  gegl_buffer_sample (src_buffer, initial_x, initial_y, NULL, s, format,
-                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#endif
-
-  diff = pixel_difference (col, s, antialias, threshold,
-                           n_components, has_alpha, select_transparent,
-                           select_criterion);
-
-  /* check the starting pixel */
-  if (! diff)
-    return FALSE;
+  GeglBufferIterator *iter;
 
-  mask_row[initial_x] = diff;
+  iter = gegl_buffer_iterator_new (data->src_buffer,
+                                   area, 0, data->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  *start = initial_x - 1;
-#ifdef FETCH_ROW
-  s = row + *start * n_components;
-#endif
+  gegl_buffer_iterator_add (iter, data->mask_buffer,
+                            area, 0, babl_format ("Y float"),
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  while (*start >= 0 && diff)
+  while (gegl_buffer_iterator_next (iter))
     {
-#ifndef FETCH_ROW
-      gegl_buffer_sample (src_buffer, *start, initial_y, NULL, s, format,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#endif
-
-      diff = pixel_difference (col, s, antialias, threshold,
-                               n_components, has_alpha, select_transparent,
-                               select_criterion);
+      /*  Find how closely the colors match  */
+      pixel_difference_row (data->col, iter->data[0], iter->data[1],
+                            iter->length,
+                            data->antialias,
+                            data->threshold,
+                            data->n_components,
+                            data->has_alpha,
+                            data->select_transparent,
+                            data->select_criterion);
+    }
+}
 
-      mask_row[*start] = diff;
+/*  Returns the pixel differences of row @y, computing the band of
+ *  rows it is in if it's not cached.  The row stays valid until the
+ *  next call.
+ */
+static const gfloat *
+fill_data_get_row (FillData *data,
+                   gint      y)
+{
+  gint band = y / BAND_HEIGHT;
+  gint slot = 0;
+  gint height;
+  gint i;
 
-      if (diff)
+  for (i = 0; i < N_BANDS; i++)
+    {
+      if (data->band[i] == band)
         {
-          (*start)--;
-#ifdef FETCH_ROW
-          s -= n_components;
-#endif
+          data->band_stamp[i] = ++data->stamp;
+
+          return data->diff[i] + (gsize) (y % BAND_HEIGHT) * data->width;
         }
-    }
 
-  diff = 1;
-  *end = initial_x + 1;
-#ifdef FETCH_ROW
-  s = row + *end * n_components;
-#endif
+      if (data->band_stamp[i] < data->band_stamp[slot])
+        slot = i;
+    }
 
-  while (*end < width && diff)
-    {
-#ifndef FETCH_ROW
-      gegl_buffer_sample (src_buffer, *end, initial_y, NULL, s, format,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#endif
+  /*  replace the least recently used band  */
+  height = MIN (BAND_HEIGHT, data->height - band * BAND_HEIGHT);
 
-      diff = pixel_difference (col, s, antialias, threshold,
-                               n_components, has_alpha, select_transparent,
-                               select_criterion);
+  gegl_buffer_get (data->src_buffer,
+                   GEGL_RECTANGLE (0, band * BAND_HEIGHT, data->width, height),
+                   1.0, data->format,
+                   data->src, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-      mask_row[*end] = diff;
+  if (! data->diff[slot])
+    data->diff[slot] = g_new (gfloat, (gsize) data->width * BAND_HEIGHT);
 
-      if (diff)
-        {
-          (*end)++;
-#ifdef FETCH_ROW
-          s += n_components;
-#endif
-        }
-    }
+  pixel_difference_row (data->col, data->src, data->diff[slot],
+                        (gsize) data->width * height,
+                        data->antialias,
+                        data->threshold,
+                        data->n_components,
+                        data->has_alpha,
+                        data->select_transparent,
+                        data->select_criterion);
 
-  gegl_buffer_set (mask_buffer, GEGL_RECTANGLE (*start, initial_y,
-                                                *end - *start, 1),
-                   0, babl_format ("Y float"), &mask_row[*start],
-                   GEGL_AUTO_ROWSTRIDE);
+  data->band[slot]       = band;
+  data->band_stamp[slot] = ++data->stamp;
 
-  return TRUE;
+  return data->diff[slot] + (gsize) (y % BAND_HEIGHT) * data->width;
 }
 
+/*  Scanline flood fill: spans of rows still to be searched are kept
+ *  on a stack, the source is compared band-wise, and a bitmap of the
+ *  pixels already in the region replaces sampling the mask.
+ */
 static void
 find_contiguous_region (GeglBuffer          *src_buffer,
                         GeglBuffer          *mask_buffer,
@@ -495,73 +505,99 @@ find_contiguous_region (GeglBuffer          *src_buffer,
                         gint                 y,
                         const gfloat        *col)
 {
-  gint    start, end;
-  gint    new_start, new_end;
-  GQueue *coord_stack;
-  gfloat *row = NULL;
-
-#ifdef FETCH_ROW
-  row = g_new (gfloat, gegl_buffer_get_width (src_buffer) * n_components);
-#endif
+  FillData  data = { 0, };
+  GArray   *stack;
+  Span      span;
+  gint      i;
+
+  data.src_buffer         = src_buffer;
+  data.format             = format;
+  data.n_components       = n_components;
+  data.has_alpha          = has_alpha;
+  data.select_transparent = select_transparent;
+  data.select_criterion   = select_criterion;
+  data.antialias          = antialias;
+  data.threshold          = threshold;
+  data.col                = col;
+  data.width              = gegl_buffer_get_width (src_buffer);
+  data.height             = gegl_buffer_get_height (src_buffer);
+
+  data.src     = g_new (gfloat, ((gsize) data.width * BAND_HEIGHT *
+                                 n_components));
+  data.visited = g_new0 (guint8, ((gsize) data.width * data.height + 7) / 8);
+
+  for (i = 0; i < N_BANDS; i++)
+    data.band[i] = -1;
+
+  stack = g_array_new (FALSE, FALSE, sizeof (Span));
+
+  span.y     = y;
+  span.start = x - 1;
+  span.end   = x + 1;
+
+  g_array_append_val (stack, span);
+
+  while (stack->len > 0)
+    {
+      const gfloat *diff;
+      gsize         row_offset;
 
-  coord_stack = g_queue_new ();
+      span = g_array_index (stack, Span, stack->len - 1);
+      g_array_set_size (stack, stack->len - 1);
 
-  /* To avoid excessive memory allocation (y, start, end) tuples are
-   * stored in interleaved format:
-   *
-   * [y1] [start1] [end1] [y2] [start2] [end2]
-   */
-  g_queue_push_tail (coord_stack, GINT_TO_POINTER (y));
-  g_queue_push_tail (coord_stack, GINT_TO_POINTER (x - 1));
-  g_queue_push_tail (coord_stack, GINT_TO_POINTER (x + 1));
+      diff       = fill_data_get_row (&data, span.y);
+      row_offset = (gsize) span.y * data.width;
 
-  do
-    {
-      y     = GPOINTER_TO_INT (g_queue_pop_head (coord_stack));
-      start = GPOINTER_TO_INT (g_queue_pop_head (coord_stack));
-      end   = GPOINTER_TO_INT (g_queue_pop_head (coord_stack));
-
-      for (x = start + 1; x < end; x++)
+      for (x = span.start + 1; x < span.end; x++)
         {
-          gfloat val;
+          gsize p = row_offset + x;
+          gint  start;
+          gint  end;
 
-          gegl_buffer_sample (mask_buffer, x, y, NULL, &val,
-                              babl_format ("Y float"),
-                              GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-          if (val != 0.0)
+          if ((data.visited[p / 8] & (1 << (p % 8))) || ! diff[x])
             continue;
 
-          if (! find_contiguous_segment (col, src_buffer, mask_buffer,
-                                         format,
-                                         n_components,
-                                         has_alpha,
-                                         gegl_buffer_get_width (src_buffer),
-                                         select_transparent, select_criterion,
-                                         antialias, threshold, x, y,
-                                         &new_start, &new_end,
-                                         row))
-            continue;
+          start = x - 1;
+          while (start >= 0 && diff[start])
+            start--;
+
+          end = x + 1;
+          while (end < data.width && diff[end])
+            end++;
 
-          if (y + 1 < gegl_buffer_get_height (src_buffer))
+          for (p = row_offset + start + 1; p < row_offset + end; p++)
+            data.visited[p / 8] |= 1 << (p % 8);
+
+          gegl_buffer_set (mask_buffer,
+                           GEGL_RECTANGLE (start + 1, span.y,
+                                           end - start - 1, 1),
+                           0, babl_format ("Y float"), diff + start + 1,
+                           GEGL_AUTO_ROWSTRIDE);
+
+          if (span.y + 1 < data.height)
             {
-              g_queue_push_tail (coord_stack, GINT_TO_POINTER (y + 1));
-              g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_start));
-              g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_end));
+              Span next = { span.y + 1, start, end };
+
+              g_array_append_val (stack, next);
             }
 
-          if (y - 1 >= 0)
+          if (span.y - 1 >= 0)
             {
-              g_queue_push_tail (coord_stack, GINT_TO_POINTER (y - 1));
-              g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_start));
-              g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_end));
+              Span next = { span.y - 1, start, end };
+
+              g_array_append_val (stack, next);
             }
+
+          /*  the pixel at end is not part of the region  */
+          x = end;
         }
     }
-  while (! g_queue_is_empty (coord_stack));
 
-  g_queue_free (coord_stack);
+  g_array_free (stack, TRUE);
+
+  for (i = 0; i < N_BANDS; i++)
+    g_free (data.diff[i]);
 
-#ifdef FETCH_ROW
-  g_free (row);
-#endif
+  g_free (data.src);
+  g_free (data.visited);
 }
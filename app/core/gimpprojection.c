@@ -17,6 +17,7 @@
 
 #include "config.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -44,10 +45,19 @@
 #include "gimp-priorities.h"
 
 
-/*  chunk size for one iteration of the chunk renderer  */
+/*  initial chunk size for one iteration of the chunk renderer  */
 static gint GIMP_PROJECTION_CHUNK_WIDTH  = 256;
 static gint GIMP_PROJECTION_CHUNK_HEIGHT = 128;
 
+/*  whether the chunk size adapts to the measured render cost, turned
+ *  off when the chunk size is set using GIMP_DISPLAY_RENDER_BUF_SIZE
+ */
+static gboolean GIMP_PROJECTION_ADAPTIVE_CHUNK_SIZE = TRUE;
+
+/*  the maximal adaptive chunk size  */
+#define GIMP_PROJECTION_MAX_CHUNK_WIDTH  2048
+#define GIMP_PROJECTION_MAX_CHUNK_HEIGHT 1024
+
 /*  how much time, in seconds, do we allow chunk rendering to take,
  *  aiming for 15fps
  */
@@ -80,6 +90,14 @@ struct _GimpProjectionChunkRender
 
   gint            work_x;
   gint            work_y;
+  gint            work_h;          /*  height of the current row */
+
+  gint            chunk_width;
+  gint            chunk_height;
+
+  gint            tile_width;
+  gint            tile_height;
+  gdouble         pixel_time;      /*  average render time per pixel */
 
   cairo_region_t *update_region;   /*  flushed update region */
 };
@@ -143,6 +161,12 @@ static gboolean    gimp_projection_chunk_render_callback (gpointer         data)
 static void        gimp_projection_chunk_render_init     (GimpProjection  *proj);
 static gboolean    gimp_projection_chunk_render_iteration(GimpProjection  *proj);
 static gboolean    gimp_projection_chunk_render_next_area(GimpProjection  *proj);
+static void        gimp_projection_chunk_render_next_chunk
+                                                         (GimpProjection  *proj,
+                                                          GeglRectangle   *chunk);
+static void        gimp_projection_chunk_render_adapt    (GimpProjection  *proj,
+                                                          gint64           n_pixels,
+                                                          gint64           time);
 static void        gimp_projection_paint_area            (GimpProjection  *proj,
                                                           gboolean         now,
                                                           gint             x,
@@ -218,6 +242,8 @@ gimp_projection_class_init (GimpProjectionClass *klass)
         {
           GIMP_PROJECTION_CHUNK_WIDTH  = width;
           GIMP_PROJECTION_CHUNK_HEIGHT = height;
+
+          GIMP_PROJECTION_ADAPTIVE_CHUNK_SIZE = FALSE;
         }
     }
 }
@@ -228,6 +254,9 @@ gimp_projection_init (GimpProjection *proj)
   proj->priv = G_TYPE_INSTANCE_GET_PRIVATE (proj,
                                             GIMP_TYPE_PROJECTION,
                                             GimpProjectionPrivate);
+
+  proj->priv->chunk_render.chunk_width  = GIMP_PROJECTION_CHUNK_WIDTH;
+  proj->priv->chunk_render.chunk_height = GIMP_PROJECTION_CHUNK_HEIGHT;
 }
 
 static void
@@ -383,6 +412,8 @@ gimp_projection_get_buffer (GimpPickable *pickable)
       const Babl *format;
       gint        width;
       gint        height;
+      gint        tile_width;
+      gint        tile_height;
 
       graph = gimp_projectable_get_graph (proj->priv->projectable);
       format = gimp_projection_get_format (GIMP_PICKABLE (proj));
@@ -391,6 +422,25 @@ gimp_projection_get_buffer (GimpPickable *pickable)
       proj->priv->buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
                                             format);
 
+      g_object_get (proj->priv->buffer,
+                    "tile-width",  &tile_width,
+                    "tile-height", &tile_height,
+                    NULL);
+
+      /*  round the chunk size up to whole tiles, so that no tile is
+       *  rendered in pieces by several chunks
+       */
+      proj->priv->chunk_render.chunk_width =
+        (GIMP_PROJECTION_CHUNK_WIDTH + tile_width - 1) /
+        tile_width * tile_width;
+      proj->priv->chunk_render.chunk_height =
+        (GIMP_PROJECTION_CHUNK_HEIGHT + tile_height - 1) /
+        tile_height * tile_height;
+
+      proj->priv->chunk_render.tile_width  = tile_width;
+      proj->priv->chunk_render.tile_height = tile_height;
+      proj->priv->chunk_render.pixel_time  = 0.0;
+
       proj->priv->validate_handler =
         GIMP_TILE_HANDLER_VALIDATE (gimp_tile_handler_validate_new (graph));
 
@@ -806,50 +856,46 @@ gimp_projection_chunk_render_init (GimpProjection *proj)
  * them into bite-sized chunks which are chewed on in an idle
  * function. This greatly improves responsiveness for many GIMP
  * operations.  -- Adam
+ *
+ * The chunks are rendered one at a time on the main thread: the
+ * projection graph is changed from the main thread, and GEGL can't
+ * process one graph on several threads at once.  The chunk size
+ * adapts so that the idle function returns to the main loop in time.
  */
 static gboolean
 gimp_projection_chunk_render_iteration (GimpProjection *proj)
 {
   GimpProjectionChunkRender *chunk_render = &proj->priv->chunk_render;
-  gint                       work_x       = chunk_render->work_x;
-  gint                       work_y       = chunk_render->work_y;
-  gint                       work_w;
-  gint                       work_h;
+  GeglRectangle              chunk;
+  gint64                     start_time;
 
-  work_w = MIN (GIMP_PROJECTION_CHUNK_WIDTH,
-                chunk_render->x + chunk_render->width - work_x);
+  gimp_projection_chunk_render_next_chunk (proj, &chunk);
 
-  work_h = MIN (GIMP_PROJECTION_CHUNK_HEIGHT,
-                chunk_render->y + chunk_render->height - work_y);
+  start_time = g_get_monotonic_time ();
 
   gimp_projection_paint_area (proj, TRUE /* sic! */,
-                              work_x, work_y, work_w, work_h);
+                              chunk.x, chunk.y, chunk.width, chunk.height);
 
-  chunk_render->work_x += work_w;
+  gimp_projection_chunk_render_adapt (proj,
+                                      (gint64) chunk.width * chunk.height,
+                                      g_get_monotonic_time () - start_time);
 
-  if (chunk_render->work_x >= chunk_render->x + chunk_render->width)
+  if (chunk_render->work_y >= chunk_render->y + chunk_render->height)
     {
-      chunk_render->work_x = chunk_render->x;
-
-      chunk_render->work_y += work_h;
-
-      if (chunk_render->work_y >= chunk_render->y + chunk_render->height)
+      if (! gimp_projection_chunk_render_next_area (proj))
         {
-          if (! gimp_projection_chunk_render_next_area (proj))
+          if (proj->priv->invalidate_preview)
             {
-              if (proj->priv->invalidate_preview)
-                {
-                  /* invalidate the preview here since it is constructed from
-                   * the projection
-                   */
-                  proj->priv->invalidate_preview = FALSE;
-
-                  gimp_projectable_invalidate_preview (proj->priv->projectable);
-                }
-
-              /* FINISHED */
-              return FALSE;
+              /* invalidate the preview here since it is constructed from
+               * the projection
+               */
+              proj->priv->invalidate_preview = FALSE;
+
+              gimp_projectable_invalidate_preview (proj->priv->projectable);
             }
+
+          /* FINISHED */
+          return FALSE;
         }
     }
 
@@ -904,6 +950,106 @@ gimp_projection_chunk_render_next_area (GimpProjection *proj)
   return TRUE;
 }
 
+/*  Takes the next chunk of the current area.  Chunks end on multiples
+ *  of the chunk size, which keeps them aligned to the tiles of the
+ *  projection buffer.  The chunk height is only picked up at the start
+ *  of a row, since all chunks of a row must have the same height.
+ */
+static void
+gimp_projection_chunk_render_next_chunk (GimpProjection *proj,
+                                         GeglRectangle  *chunk)
+{
+  GimpProjectionChunkRender *chunk_render = &proj->priv->chunk_render;
+  gint                       work_x       = chunk_render->work_x;
+  gint                       work_y       = chunk_render->work_y;
+  gint                       work_w;
+  gint                       work_h;
+
+  if (work_x == chunk_render->x)
+    {
+      chunk_render->work_h = MIN (chunk_render->chunk_height -
+                                  work_y % chunk_render->chunk_height,
+                                  chunk_render->y + chunk_render->height -
+                                  work_y);
+    }
+
+  work_w = MIN (chunk_render->chunk_width -
+                work_x % chunk_render->chunk_width,
+                chunk_render->x + chunk_render->width - work_x);
+
+  work_h = chunk_render->work_h;
+
+  chunk->x      = work_x;
+  chunk->y      = work_y;
+  chunk->width  = work_w;
+  chunk->height = work_h;
+
+  chunk_render->work_x += work_w;
+
+  if (chunk_render->work_x >= chunk_render->x + chunk_render->width)
+    {
+      chunk_render->work_x = chunk_render->x;
+
+      chunk_render->work_y += work_h;
+    }
+}
+
+/*  Adjusts the chunk size to the render cost measured for the last
+ *  chunks, so that one iteration takes about a quarter of the time
+ *  budget of the idle handler: cheap projections are rendered in few
+ *  big chunks, and expensive ones don't overrun the frame budget.
+ */
+static void
+gimp_projection_chunk_render_adapt (GimpProjection *proj,
+                                    gint64          n_pixels,
+                                    gint64          time)
+{
+  GimpProjectionChunkRender *chunk_render = &proj->priv->chunk_render;
+  gint                       tile_width   = chunk_render->tile_width;
+  gint                       tile_height  = chunk_render->tile_height;
+  gdouble                    pixel_time;
+  gdouble                    area;
+  gint                       width;
+  gint                       height;
+
+  if (! GIMP_PROJECTION_ADAPTIVE_CHUNK_SIZE || tile_width == 0)
+    return;
+
+  /*  small chunks at the edges of the update areas are dominated by
+   *  per-chunk overhead and would make the chunks shrink needlessly
+   */
+  if (n_pixels < (gint64) tile_width * tile_height)
+    return;
+
+  pixel_time = (gdouble) MAX (time, 1) / G_USEC_PER_SEC / n_pixels;
+
+  if (chunk_render->pixel_time > 0.0)
+    chunk_render->pixel_time = (chunk_render->pixel_time + pixel_time) / 2.0;
+  else
+    chunk_render->pixel_time = pixel_time;
+
+  /*  keep the 2:1 aspect ratio of the default chunk size  */
+  area   = GIMP_PROJECTION_CHUNK_TIME / 4.0 / chunk_render->pixel_time;
+  height = sqrt (area / 2.0);
+  width  = 2 * height;
+
+  width  = CLAMP (width,  tile_width,  GIMP_PROJECTION_MAX_CHUNK_WIDTH);
+  height = CLAMP (height, tile_height, GIMP_PROJECTION_MAX_CHUNK_HEIGHT);
+
+  width  = (width  + tile_width  / 2) / tile_width  * tile_width;
+  height = (height + tile_height / 2) / tile_height * tile_height;
+
+  if (width  != chunk_render->chunk_width ||
+      height != chunk_render->chunk_height)
+    {
+      chunk_render->chunk_width  = width;
+      chunk_render->chunk_height = height;
+
+      GIMP_LOG (PROJECTION, "chunk size %dx%d (%g us per pixel)\n",
+                width, height, chunk_render->pixel_time * G_USEC_PER_SEC);
+    }
+}
+
 static void
 gimp_projection_paint_area (GimpProjection *proj,
                             gboolean        now,
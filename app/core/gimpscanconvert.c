@@ -29,10 +29,14 @@
 
 #include "core-types.h"
 
+#include "gimp-parallel.h"
 #include "gimpbezierdesc.h"
 #include "gimpscanconvert.h"
 
 
+#define RENDER_TILE_SIZE 128
+
+
 struct _GimpScanConvert
 {
   gdouble         ratio_xy;
@@ -55,6 +59,54 @@ struct _GimpScanConvert
   GArray         *path_data;
 };
 
+typedef struct _SubPath    SubPath;
+typedef struct _RenderData RenderData;
+
+struct _SubPath
+{
+  gint start;    /*  index of the subpath's first element in path_data  */
+  gint length;   /*  number of path_data elements                       */
+};
+
+struct _RenderData
+{
+  GimpScanConvert *sc;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  gint             off_x;
+  gint             off_y;
+  gboolean         replace;
+  gboolean         antialias;
+  gdouble          value;
+
+  gint             width;
+  gint             height;
+  gint             n_cols;
+  gint             n_rows;
+
+  GArray          *subpaths;
+  GArray         **bins;      /*  indices of the subpaths touching each tile  */
+  GArray          *tiles;     /*  indices of the tiles with a bin             */
+};
+
+
+static gint   gimp_scan_convert_compare_tiles (const gint    *tile1,
+                                               const gint    *tile2);
+static void   gimp_scan_convert_bin_subpaths  (RenderData    *data);
+static void   gimp_scan_convert_bin_subpath   (RenderData    *data,
+                                               const SubPath *subpath,
+                                               gint           x1,
+                                               gint           y1,
+                                               gint           x2,
+                                               gint           y2);
+static void   gimp_scan_convert_render_tiles  (gsize          offset,
+                                               gsize          size,
+                                               RenderData    *data);
+static void   gimp_scan_convert_render_tile   (RenderData    *data,
+                                               gint           col,
+                                               gint           row,
+                                               guchar        *buf);
+
 
 /*  public functions  */
 
@@ -439,6 +491,9 @@ gimp_scan_convert_compose_value (GimpScanConvert *sc,
  * top of existing content or replacing it completely. The @value
  * specifies the opacity value to be used for the objects in the @sc.
  *
+ * The @buffer is rendered in tiles, in parallel, and each tile only
+ * replays the subpaths which can touch it.
+ *
  * You cannot add additional polygons after this command.
  */
 void
@@ -450,15 +505,10 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
                                gboolean         antialias,
                                gdouble          value)
 {
-  const Babl         *format;
-  GeglBufferIterator *iter;
-  GeglRectangle      *roi;
-  cairo_t            *cr;
-  cairo_surface_t    *surface;
-  cairo_path_t        path;
-  gint                bpp;
-  gint                x, y;
-  gint                width, height;
+  RenderData data;
+  gint       x, y;
+  gint       width, height;
+  gint       i;
 
   g_return_if_fail (sc != NULL);
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
@@ -474,118 +524,284 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
                                               &x, &y, &width, &height))
     return;
 
-  path.status   = CAIRO_STATUS_SUCCESS;
-  path.data     = (cairo_path_data_t *) sc->path_data->data;
-  path.num_data = sc->path_data->len;
+  /*  painting with CAIRO_OPERATOR_SOURCE leaves uncovered pixels
+   *  alone, so replacing is the same as composing on a cleared buffer,
+   *  and only the tiles touched by the path need to be rendered
+   */
+  if (replace)
+    gegl_buffer_clear (buffer, NULL);
+
+  data.sc        = sc;
+  data.buffer    = buffer;
+  data.format    = babl_format ("Y u8");
+  data.off_x     = off_x;
+  data.off_y     = off_y;
+  data.replace   = replace;
+  data.antialias = antialias;
+  data.value     = value;
+  data.width     = gegl_buffer_get_width  (buffer);
+  data.height    = gegl_buffer_get_height (buffer);
+  data.n_cols    = (data.width  + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+  data.n_rows    = (data.height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+  data.subpaths  = g_array_new (FALSE, FALSE, sizeof (SubPath));
+  data.bins      = g_new0 (GArray *, data.n_cols * data.n_rows);
+  data.tiles     = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  gimp_scan_convert_bin_subpaths (&data);
+
+  gimp_parallel_distribute_range (data.tiles->len, 1,
+                                  (GimpParallelDistributeRangeFunc)
+                                  gimp_scan_convert_render_tiles,
+                                  &data);
+
+  for (i = 0; i < data.tiles->len; i++)
+    g_array_free (data.bins[g_array_index (data.tiles, gint, i)], TRUE);
+
+  g_free (data.bins);
+  g_array_free (data.tiles, TRUE);
+  g_array_free (data.subpaths, TRUE);
+}
+
+
+/*  private functions  */
+
+static gint
+gimp_scan_convert_compare_tiles (const gint *tile1,
+                                 const gint *tile2)
+{
+  return *tile1 - *tile2;
+}
+
+/*  Splits the path into its subpaths, and adds each of them to the
+ *  bins of the tiles its rendered shape can touch.  A subpath which
+ *  doesn't touch a tile doesn't change it, neither when filling, since
+ *  fill closes each subpath, nor when stroking, since the dash pattern
+ *  starts over at each subpath.
+ */
+static void
+gimp_scan_convert_bin_subpaths (RenderData *data)
+{
+  GimpScanConvert   *sc        = data->sc;
+  cairo_path_data_t *path_data = (cairo_path_data_t *) sc->path_data->data;
+  gdouble            grow_x    = 1.0;
+  gdouble            grow_y    = 1.0;
+  SubPath            subpath   = { 0, };
+  gdouble            x1, y1, x2, y2;
+  gint               i;
+
+  /*  the shape of a stroke reaches at most half the line width, times
+   *  the miter limit or the diagonal of a square cap, beyond the path;
+   *  and antialiasing at most one pixel beyond the shape
+   */
+  if (sc->do_stroke)
+    {
+      gdouble extent = sc->width / 2.0 * G_SQRT2;
 
-  format = babl_format ("Y u8");
-  bpp    = babl_format_get_bytes_per_pixel (format);
+      if (sc->join == GIMP_JOIN_MITER)
+        extent = MAX (extent, sc->width / 2.0 * sc->miter);
 
-  iter = gegl_buffer_iterator_new (buffer, NULL, 0, format,
-                                   GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
-  roi = &iter->roi[0];
+      grow_x += extent;
+      grow_y += extent * fabs (sc->ratio_xy);
+    }
+
+  x1 = y1 = G_MAXDOUBLE;
+  x2 = y2 = -G_MAXDOUBLE;
 
-  while (gegl_buffer_iterator_next (iter))
+  for (i = 0; i <= sc->path_data->len; i += path_data[i].header.length)
     {
-      guchar     *data    = iter->data[0];
-      guchar     *tmp_buf = NULL;
-      const gint  stride  = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
-                                                           roi->width);
-
-      /*  cairo rowstrides are always multiples of 4, whereas
-       *  maskPR.rowstride can be anything, so to be able to create an
-       *  image surface, we maybe have to create our own temporary
-       *  buffer
-       */
-      if (roi->width * bpp != stride)
+      gint j;
+
+      if (i == sc->path_data->len ||
+          (path_data[i].header.type == CAIRO_PATH_MOVE_TO &&
+           i > subpath.start))
         {
-          tmp_buf = g_alloca (stride * roi->height);
+          subpath.length = i - subpath.start;
 
-          if (! replace)
+          if (subpath.length > 0 && x1 <= x2 && y1 <= y2)
             {
-              const guchar *src  = data;
-              guchar       *dest = tmp_buf;
-              gint          i;
-
-              for (i = 0; i < roi->height; i++)
+              gint bx1 = CLAMP (floor (x1 - grow_x) - data->off_x,
+                                0, data->width);
+              gint by1 = CLAMP (floor (y1 - grow_y) - data->off_y,
+                                0, data->height);
+              gint bx2 = CLAMP (ceil (x2 + grow_x) - data->off_x,
+                                0, data->width);
+              gint by2 = CLAMP (ceil (y2 + grow_y) - data->off_y,
+                                0, data->height);
+
+              if (bx2 > bx1 && by2 > by1)
                 {
-                  memcpy (dest, src, roi->width * bpp);
-
-                  src  += roi->width * bpp;
-                  dest += stride;
+                  gimp_scan_convert_bin_subpath (data, &subpath,
+                                                 bx1, by1, bx2, by2);
                 }
             }
-        }
 
-      surface = cairo_image_surface_create_for_data (tmp_buf ?
-                                                     tmp_buf : data,
-                                                     CAIRO_FORMAT_A8,
-                                                     roi->width, roi->height,
-                                                     stride);
+          if (i == sc->path_data->len)
+            break;
+
+          subpath.start = i;
 
-      cairo_surface_set_device_offset (surface,
-                                       -off_x - roi->x,
-                                       -off_y - roi->y);
-      cr = cairo_create (surface);
-      cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+          x1 = y1 = G_MAXDOUBLE;
+          x2 = y2 = -G_MAXDOUBLE;
+        }
 
-      if (replace)
+      /*  curves lie within the hull of their control points  */
+      for (j = 1; j < path_data[i].header.length; j++)
         {
-          cairo_set_source_rgba (cr, 0, 0, 0, 0);
-          cairo_paint (cr);
+          x1 = MIN (x1, path_data[i + j].point.x);
+          y1 = MIN (y1, path_data[i + j].point.y);
+          x2 = MAX (x2, path_data[i + j].point.x);
+          y2 = MAX (y2, path_data[i + j].point.y);
         }
+    }
 
-      cairo_set_source_rgba (cr, 0, 0, 0, value);
-      cairo_append_path (cr, &path);
+  /*  render the tiles in buffer order  */
+  g_array_sort (data->tiles,
+                (GCompareFunc) gimp_scan_convert_compare_tiles);
+}
 
-      cairo_set_antialias (cr, antialias ?
-                           CAIRO_ANTIALIAS_GRAY : CAIRO_ANTIALIAS_NONE);
-      cairo_set_miter_limit (cr, sc->miter);
+static void
+gimp_scan_convert_bin_subpath (RenderData    *data,
+                               const SubPath *subpath,
+                               gint           x1,
+                               gint           y1,
+                               gint           x2,
+                               gint           y2)
+{
+  gint index = data->subpaths->len;
+  gint col, row;
 
-      if (sc->do_stroke)
-        {
-          cairo_set_line_cap (cr,
-                              sc->cap == GIMP_CAP_BUTT ? CAIRO_LINE_CAP_BUTT :
-                              sc->cap == GIMP_CAP_ROUND ? CAIRO_LINE_CAP_ROUND :
-                              CAIRO_LINE_CAP_SQUARE);
-          cairo_set_line_join (cr,
-                               sc->join == GIMP_JOIN_MITER ? CAIRO_LINE_JOIN_MITER :
-                               sc->join == GIMP_JOIN_ROUND ? CAIRO_LINE_JOIN_ROUND :
-                               CAIRO_LINE_JOIN_BEVEL);
-
-          cairo_set_line_width (cr, sc->width);
-
-          if (sc->dash_info)
-            cairo_set_dash (cr,
-                            (double *) sc->dash_info->data,
-                            sc->dash_info->len,
-                            sc->dash_offset);
-
-          cairo_scale (cr, 1.0, sc->ratio_xy);
-          cairo_stroke (cr);
-        }
-      else
-        {
-          cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
-          cairo_fill (cr);
-        }
+  g_array_append_val (data->subpaths, *subpath);
 
-      cairo_destroy (cr);
-      cairo_surface_destroy (surface);
+  for (row = y1 / RENDER_TILE_SIZE; row <= (y2 - 1) / RENDER_TILE_SIZE; row++)
+    for (col = x1 / RENDER_TILE_SIZE; col <= (x2 - 1) / RENDER_TILE_SIZE; col++)
+      {
+        gint tile = row * data->n_cols + col;
 
-      if (tmp_buf)
-        {
-          const guchar *src  = tmp_buf;
-          guchar       *dest = data;
-          gint          i;
+        if (! data->bins[tile])
+          {
+            data->bins[tile] = g_array_new (FALSE, FALSE, sizeof (gint));
 
-          for (i = 0; i < roi->height; i++)
-            {
-              memcpy (dest, src, roi->width * bpp);
+            g_array_append_val (data->tiles, tile);
+          }
 
-              src  += stride;
-              dest += roi->width * bpp;
-            }
-        }
+        g_array_append_val (data->bins[tile], index);
+      }
+}
+
+static void
+gimp_scan_convert_render_tiles (gsize       offset,
+                                gsize       size,
+                                RenderData *data)
+{
+  const gint  stride = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
+                                                      RENDER_TILE_SIZE);
+  guchar     *buf    = g_malloc (stride * RENDER_TILE_SIZE);
+  gsize       i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      gint tile = g_array_index (data->tiles, gint, i);
+
+      gimp_scan_convert_render_tile (data,
+                                     tile % data->n_cols,
+                                     tile / data->n_cols,
+                                     buf);
     }
+
+  g_free (buf);
+}
+
+static void
+gimp_scan_convert_render_tile (RenderData *data,
+                               gint        col,
+                               gint        row,
+                               guchar     *buf)
+{
+  GimpScanConvert   *sc        = data->sc;
+  cairo_path_data_t *path_data = (cairo_path_data_t *) sc->path_data->data;
+  GArray            *bin       = data->bins[row * data->n_cols + col];
+  cairo_t           *cr;
+  cairo_surface_t   *surface;
+  GeglRectangle      rect;
+  gint               stride;
+  gint               i;
+
+  rect.x      = col * RENDER_TILE_SIZE;
+  rect.y      = row * RENDER_TILE_SIZE;
+  rect.width  = MIN (RENDER_TILE_SIZE, data->width  - rect.x);
+  rect.height = MIN (RENDER_TILE_SIZE, data->height - rect.y);
+
+  /*  cairo rowstrides are always multiples of 4, so let GEGL copy
+   *  the tile with the stride cairo wants
+   */
+  stride = cairo_format_stride_for_width (CAIRO_FORMAT_A8, rect.width);
+
+  if (data->replace)
+    memset (buf, 0, stride * rect.height);
+  else
+    gegl_buffer_get (data->buffer, &rect, 1.0, data->format, buf, stride,
+                     GEGL_ABYSS_NONE);
+
+  surface = cairo_image_surface_create_for_data (buf,
+                                                 CAIRO_FORMAT_A8,
+                                                 rect.width, rect.height,
+                                                 stride);
+
+  cairo_surface_set_device_offset (surface,
+                                   -data->off_x - rect.x,
+                                   -data->off_y - rect.y);
+  cr = cairo_create (surface);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+
+  cairo_set_source_rgba (cr, 0, 0, 0, data->value);
+
+  for (i = 0; i < bin->len; i++)
+    {
+      const SubPath *subpath = &g_array_index (data->subpaths, SubPath,
+                                               g_array_index (bin, gint, i));
+      cairo_path_t   path;
+
+      path.status   = CAIRO_STATUS_SUCCESS;
+      path.data     = path_data + subpath->start;
+      path.num_data = subpath->length;
+
+      cairo_append_path (cr, &path);
+    }
+
+  cairo_set_antialias (cr, data->antialias ?
+                       CAIRO_ANTIALIAS_GRAY : CAIRO_ANTIALIAS_NONE);
+  cairo_set_miter_limit (cr, sc->miter);
+
+  if (sc->do_stroke)
+    {
+      cairo_set_line_cap (cr,
+                          sc->cap == GIMP_CAP_BUTT ? CAIRO_LINE_CAP_BUTT :
+                          sc->cap == GIMP_CAP_ROUND ? CAIRO_LINE_CAP_ROUND :
+                          CAIRO_LINE_CAP_SQUARE);
+      cairo_set_line_join (cr,
+                           sc->join == GIMP_JOIN_MITER ? CAIRO_LINE_JOIN_MITER :
+                           sc->join == GIMP_JOIN_ROUND ? CAIRO_LINE_JOIN_ROUND :
+                           CAIRO_LINE_JOIN_BEVEL);
+
+      cairo_set_line_width (cr, sc->width);
+
+      if (sc->dash_info)
+        cairo_set_dash (cr,
+                        (double *) sc->dash_info->data,
+                        sc->dash_info->len,
+                        sc->dash_offset);
+
+      cairo_scale (cr, 1.0, sc->ratio_xy);
+      cairo_stroke (cr);
+    }
+  else
+    {
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+      cairo_fill (cr);
+    }
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+
+  gegl_buffer_set (data->buffer, &rect, 0, data->format, buf, stride);
 }
@@ -29,6 +29,7 @@
 #include "config/gimpcoreconfig.h"
 
 #include "gimp.h"
+#include "gimpcompressedbuffer.h"
 #include "gimpcontext.h"
 #include "gimpimage.h"
 #include "gimpimage-undo.h"
@@ -89,6 +90,9 @@ static void          gimp_undo_real_pop            (GimpUndo            *undo,
                                                     GimpUndoAccumulator *accum);
 static void          gimp_undo_real_free           (GimpUndo            *undo,
                                                     GimpUndoMode         undo_mode);
+static GeglBuffer  * gimp_undo_real_get_buffer     (GimpUndo            *undo);
+static void          gimp_undo_real_set_buffer     (GimpUndo            *undo,
+                                                    GeglBuffer          *buffer);
 
 static gboolean      gimp_undo_create_preview_idle (gpointer             data);
 static void       gimp_undo_create_preview_private (GimpUndo            *undo,
@@ -143,6 +147,8 @@ gimp_undo_class_init (GimpUndoClass *klass)
 
   klass->pop                        = gimp_undo_real_pop;
   klass->free                       = gimp_undo_real_free;
+  klass->get_buffer                 = gimp_undo_real_get_buffer;
+  klass->set_buffer                 = gimp_undo_real_set_buffer;
 
   g_object_class_install_property (object_class, PROP_IMAGE,
                                    g_param_spec_object ("image", NULL, NULL,
@@ -204,6 +210,12 @@ gimp_undo_finalize (GObject *object)
       undo->preview = NULL;
     }
 
+  if (undo->compressed)
+    {
+      gimp_compressed_buffer_free (undo->compressed);
+      undo->compressed = NULL;
+    }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -273,6 +285,8 @@ gimp_undo_get_memsize (GimpObject *object,
   GimpUndo *undo    = GIMP_UNDO (object);
   gint64    memsize = 0;
 
+  memsize += gimp_compressed_buffer_get_memsize (undo->compressed);
+
   *gui_size += gimp_temp_buf_get_memsize (undo->preview);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
@@ -350,6 +364,18 @@ gimp_undo_real_free (GimpUndo     *undo,
 {
 }
 
+static GeglBuffer *
+gimp_undo_real_get_buffer (GimpUndo *undo)
+{
+  return NULL;
+}
+
+static void
+gimp_undo_real_set_buffer (GimpUndo   *undo,
+                           GeglBuffer *buffer)
+{
+}
+
 void
 gimp_undo_pop (GimpUndo            *undo,
                GimpUndoMode         undo_mode,
@@ -357,6 +383,7 @@ gimp_undo_pop (GimpUndo            *undo,
 {
   g_return_if_fail (GIMP_IS_UNDO (undo));
   g_return_if_fail (accum != NULL);
+  g_return_if_fail (undo->compressed == NULL);
 
   if (undo->dirty_mask != GIMP_DIRTY_NONE)
     {
@@ -384,6 +411,98 @@ gimp_undo_free (GimpUndo     *undo,
   g_signal_emit (undo, undo_signals[FREE], 0, undo_mode);
 }
 
+/*  Starts or continues compressing the undo's buffer in a separate
+ *  thread, and drops the buffer once it is compressed.  Returns FALSE
+ *  if there is nothing (left) to compress.
+ */
+gboolean
+gimp_undo_compress (GimpUndo *undo)
+{
+  GimpUndoClass *klass;
+  GeglBuffer    *buffer;
+
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), FALSE);
+
+  klass = GIMP_UNDO_GET_CLASS (undo);
+
+  /*  the buffer is dropped once it is compressed  */
+  buffer = klass->get_buffer (undo);
+
+  if (! buffer)
+    return FALSE;
+
+  if (! undo->compressed)
+    undo->compressed = gimp_compressed_buffer_new (buffer);
+
+  if (gimp_compressed_buffer_compress (undo->compressed))
+    klass->set_buffer (undo, NULL);
+
+  return TRUE;
+}
+
+/*  Returns the memory used by the undo's compressed buffer, if it is
+ *  completely compressed and not swapped out yet, 0 otherwise.
+ */
+gint64
+gimp_undo_get_compressed_size (GimpUndo *undo)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), 0);
+
+  if (undo->compressed                                       &&
+      gimp_compressed_buffer_is_finished (undo->compressed) &&
+      ! gimp_compressed_buffer_is_swapped (undo->compressed))
+    {
+      return gimp_compressed_buffer_get_memsize (undo->compressed);
+    }
+
+  return 0;
+}
+
+gboolean
+gimp_undo_swap_out (GimpUndo     *undo,
+                    const gchar  *swap_dir,
+                    GError      **error)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), FALSE);
+  g_return_val_if_fail (swap_dir != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (! gimp_undo_get_compressed_size (undo))
+    return TRUE;
+
+  return gimp_compressed_buffer_swap_out (undo->compressed, swap_dir, error);
+}
+
+/*  Restores the undo's buffer, it has to be done before the undo is
+ *  popped.  If the buffer can't be restored, the undo is left as it is
+ *  and @error is set.
+ */
+gboolean
+gimp_undo_uncompress (GimpUndo  *undo,
+                      GError   **error)
+{
+  GeglBuffer *buffer;
+
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (! undo->compressed)
+    return TRUE;
+
+  buffer = gimp_compressed_buffer_restore (undo->compressed, error);
+
+  if (! buffer)
+    return FALSE;
+
+  GIMP_UNDO_GET_CLASS (undo)->set_buffer (undo, buffer);
+  g_object_unref (buffer);
+
+  gimp_compressed_buffer_free (undo->compressed);
+  undo->compressed = NULL;
+
+  return TRUE;
+}
+
 typedef struct _GimpUndoIdle GimpUndoIdle;
 
 struct _GimpUndoIdle
@@ -61,6 +61,10 @@ struct _GimpUndo
 
   GimpTempBuf      *preview;
   guint             preview_idle_id;
+
+  gint64            memsize;        /* memsize as accounted by its stack  */
+
+  GimpCompressedBuffer *compressed; /* the buffer, compressed or swapped */
 };
 
 struct _GimpUndoClass
@@ -72,6 +76,11 @@ struct _GimpUndoClass
                  GimpUndoAccumulator *accum);
   void (* free) (GimpUndo            *undo,
                  GimpUndoMode         undo_mode);
+
+  /*  the buffer which is compressed while the undo is not the newest  */
+  GeglBuffer * (* get_buffer) (GimpUndo   *undo);
+  void         (* set_buffer) (GimpUndo   *undo,
+                               GeglBuffer *buffer);
 };
 
 
@@ -83,6 +92,15 @@ void          gimp_undo_pop             (GimpUndo            *undo,
 void          gimp_undo_free            (GimpUndo            *undo,
                                          GimpUndoMode         undo_mode);
 
+gboolean      gimp_undo_compress        (GimpUndo            *undo);
+gboolean      gimp_undo_uncompress      (GimpUndo            *undo,
+                                         GError             **error);
+gint64        gimp_undo_get_compressed_size
+                                        (GimpUndo            *undo);
+gboolean      gimp_undo_swap_out        (GimpUndo            *undo,
+                                         const gchar         *swap_dir,
+                                         GError             **error);
+
 void          gimp_undo_create_preview  (GimpUndo            *undo,
                                          GimpContext         *context,
                                          gboolean             create_now);
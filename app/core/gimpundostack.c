@@ -22,6 +22,7 @@
 
 #include "core-types.h"
 
+#include "gimp-memsize.h"
 #include "gimpimage.h"
 #include "gimplist.h"
 #include "gimpundo.h"
@@ -39,6 +40,11 @@ static void    gimp_undo_stack_pop         (GimpUndo            *undo,
 static void    gimp_undo_stack_free        (GimpUndo            *undo,
                                             GimpUndoMode         undo_mode);
 
+static gint64  gimp_undo_stack_measure     (GimpUndo            *undo);
+static gint    gimp_undo_stack_compare_type_memsizes
+                                           (gconstpointer        a,
+                                            gconstpointer        b);
+
 
 G_DEFINE_TYPE (GimpUndoStack, gimp_undo_stack, GIMP_TYPE_UNDO)
 
@@ -87,7 +93,13 @@ gimp_undo_stack_get_memsize (GimpObject *object,
   GimpUndoStack *stack   = GIMP_UNDO_STACK (object);
   gint64         memsize = 0;
 
-  memsize += gimp_object_get_memsize (GIMP_OBJECT (stack->undos), gui_size);
+  /*  don't walk the undos, their memsizes are accounted when they are
+   *  added to and removed from the stack
+   */
+  memsize += gimp_g_object_get_memsize (G_OBJECT (stack->undos));
+  memsize += (gimp_container_get_n_children (stack->undos) *
+              sizeof (GList));
+  memsize += stack->undos_memsize;
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -129,6 +141,8 @@ gimp_undo_stack_free (GimpUndo     *undo,
     }
 
   gimp_container_clear (stack->undos);
+
+  stack->undos_memsize = 0;
 }
 
 GimpUndoStack *
@@ -148,7 +162,16 @@ gimp_undo_stack_push_undo (GimpUndoStack *stack,
   g_return_if_fail (GIMP_IS_UNDO_STACK (stack));
   g_return_if_fail (GIMP_IS_UNDO (undo));
 
+  /*  the previous undo is complete now that the next one is pushed,
+   *  and may have changed its size since it was measured, e.g. when
+   *  an added layer was attached after its undo was pushed
+   */
+  gimp_undo_stack_update_top_memsize (stack);
+
   gimp_container_add (stack->undos, GIMP_OBJECT (undo));
+
+  undo->memsize = 0;
+  gimp_undo_stack_update_memsize (stack, undo);
 }
 
 GimpUndo *
@@ -166,6 +189,10 @@ gimp_undo_stack_pop_undo (GimpUndoStack       *stack,
   if (undo)
     {
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+
+      stack->undos_memsize -= undo->memsize;
+      undo->memsize = 0;
+
       gimp_undo_pop (undo, undo_mode, accum);
 
       return undo;
@@ -187,6 +214,10 @@ gimp_undo_stack_free_bottom (GimpUndoStack *stack,
   if (undo)
     {
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+
+      stack->undos_memsize -= undo->memsize;
+      undo->memsize = 0;
+
       gimp_undo_free (undo, undo_mode);
 
       return undo;
@@ -210,3 +241,132 @@ gimp_undo_stack_get_depth (GimpUndoStack *stack)
 
   return gimp_container_get_n_children (stack->undos);
 }
+
+/*  Measures @undo, which must be on @stack, again and updates the
+ *  stack's total.  An undo's memsize can change after it was pushed,
+ *  for example when a removed layer is detached from the image, or
+ *  when more undos are added to an undo group.
+ */
+void
+gimp_undo_stack_update_memsize (GimpUndoStack *stack,
+                                GimpUndo      *undo)
+{
+  gint64 memsize;
+
+  g_return_if_fail (GIMP_IS_UNDO_STACK (stack));
+  g_return_if_fail (GIMP_IS_UNDO (undo));
+
+  memsize = gimp_undo_stack_measure (undo);
+
+  stack->undos_memsize += memsize - undo->memsize;
+  undo->memsize         = memsize;
+}
+
+/*  Measures the newest undo on @stack again, which can still be
+ *  changing its size, all older undos were measured again when the
+ *  next undo was pushed on top of them.
+ */
+void
+gimp_undo_stack_update_top_memsize (GimpUndoStack *stack)
+{
+  GimpUndo *top;
+
+  g_return_if_fail (GIMP_IS_UNDO_STACK (stack));
+
+  top = gimp_undo_stack_peek (stack);
+
+  if (top)
+    gimp_undo_stack_update_memsize (stack, top);
+}
+
+gint64
+gimp_undo_stack_get_undos_memsize (GimpUndoStack *stack)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO_STACK (stack), 0);
+
+  return stack->undos_memsize;
+}
+
+/*  Returns an array of GimpUndoTypeMemsize, one for each undo type on
+ *  @stack, sorted by memsize with the largest first.  Undo groups are
+ *  counted by their group type.
+ */
+GArray *
+gimp_undo_stack_get_type_memsizes (GimpUndoStack *stack)
+{
+  GArray *memsizes;
+  GList  *list;
+
+  g_return_val_if_fail (GIMP_IS_UNDO_STACK (stack), NULL);
+
+  memsizes = g_array_new (FALSE, FALSE, sizeof (GimpUndoTypeMemsize));
+
+  for (list = GIMP_LIST (stack->undos)->list;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo            *undo = list->data;
+      GimpUndoTypeMemsize *type_memsize;
+      gint                 i;
+
+      for (i = 0; i < memsizes->len; i++)
+        {
+          type_memsize = &g_array_index (memsizes, GimpUndoTypeMemsize, i);
+
+          if (type_memsize->undo_type == undo->undo_type)
+            break;
+        }
+
+      if (i == memsizes->len)
+        {
+          GimpUndoTypeMemsize new_memsize = { undo->undo_type, 0 };
+
+          g_array_append_val (memsizes, new_memsize);
+        }
+
+      type_memsize = &g_array_index (memsizes, GimpUndoTypeMemsize, i);
+
+      type_memsize->memsize += undo->memsize;
+    }
+
+  g_array_sort (memsizes, gimp_undo_stack_compare_type_memsizes);
+
+  return memsizes;
+}
+
+
+/*  private functions  */
+
+static gint64
+gimp_undo_stack_measure (GimpUndo *undo)
+{
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GimpUndoStack *stack = GIMP_UNDO_STACK (undo);
+      GList         *list;
+
+      for (list = GIMP_LIST (stack->undos)->list;
+           list;
+           list = g_list_next (list))
+        {
+          gimp_undo_stack_update_memsize (stack, list->data);
+        }
+    }
+
+  return gimp_object_get_memsize (GIMP_OBJECT (undo), NULL);
+}
+
+static gint
+gimp_undo_stack_compare_type_memsizes (gconstpointer a,
+                                       gconstpointer b)
+{
+  const GimpUndoTypeMemsize *memsize_a = a;
+  const GimpUndoTypeMemsize *memsize_b = b;
+
+  if (memsize_a->memsize > memsize_b->memsize)
+    return -1;
+  else if (memsize_a->memsize < memsize_b->memsize)
+    return 1;
+
+  return 0;
+}
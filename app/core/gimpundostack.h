@@ -31,12 +31,14 @@
 
 
 typedef struct _GimpUndoStackClass GimpUndoStackClass;
+typedef struct _GimpUndoTypeMemsize GimpUndoTypeMemsize;
 
 struct _GimpUndoStack
 {
   GimpUndo       parent_instance;
 
   GimpContainer *undos;
+  gint64         undos_memsize;  /* sum of the memsizes of all undos */
 };
 
 struct _GimpUndoStackClass
@@ -44,6 +46,12 @@ struct _GimpUndoStackClass
   GimpUndoClass  parent_class;
 };
 
+struct _GimpUndoTypeMemsize
+{
+  GimpUndoType  undo_type;
+  gint64        memsize;
+};
+
 
 GType           gimp_undo_stack_get_type    (void) G_GNUC_CONST;
 
@@ -60,5 +68,12 @@ GimpUndo      * gimp_undo_stack_free_bottom (GimpUndoStack       *stack,
 GimpUndo      * gimp_undo_stack_peek        (GimpUndoStack       *stack);
 gint            gimp_undo_stack_get_depth   (GimpUndoStack       *stack);
 
+void            gimp_undo_stack_update_memsize    (GimpUndoStack *stack,
+                                                   GimpUndo      *undo);
+void            gimp_undo_stack_update_top_memsize
+                                                  (GimpUndoStack *stack);
+gint64          gimp_undo_stack_get_undos_memsize (GimpUndoStack *stack);
+GArray        * gimp_undo_stack_get_type_memsizes (GimpUndoStack *stack);
+
 
 #endif /* __GIMP_UNDO_STACK_H__ */
@@ -1363,9 +1363,9 @@ prefs_dialog_new (Gimp       *gimp,
                            GTK_CONTAINER (vbox), FALSE);
 
 #ifdef ENABLE_MP
-  table = prefs_table_new (5, GTK_CONTAINER (vbox2));
+  table = prefs_table_new (6, GTK_CONTAINER (vbox2));
 #else
-  table = prefs_table_new (4, GTK_CONTAINER (vbox2));
+  table = prefs_table_new (5, GTK_CONTAINER (vbox2));
 #endif /* ENABLE_MP */
 
   prefs_spin_button_add (object, "undo-levels", 1.0, 5.0, 0,
@@ -1374,19 +1374,26 @@ prefs_dialog_new (Gimp       *gimp,
   prefs_memsize_entry_add (object, "undo-size",
                            _("Maximum undo _memory:"),
                            GTK_TABLE (table), 1, size_group);
+  prefs_memsize_entry_add (object, "undo-compressed-size",
+                           _("Maximum _compressed undo memory:"),
+                           GTK_TABLE (table), 2, size_group);
   prefs_memsize_entry_add (object, "tile-cache-size",
                            _("Tile cache _size:"),
-                           GTK_TABLE (table), 2, size_group);
+                           GTK_TABLE (table), 3, size_group);
   prefs_memsize_entry_add (object, "max-new-image-size",
                            _("Maximum _new image size:"),
-                           GTK_TABLE (table), 3, size_group);
+                           GTK_TABLE (table), 4, size_group);
 
 #ifdef ENABLE_MP
   prefs_spin_button_add (object, "num-processors", 1.0, 4.0, 0,
                          _("Number of _processors to use:"),
-                         GTK_TABLE (table), 4, size_group);
+                         GTK_TABLE (table), 5, size_group);
 #endif /* ENABLE_MP */
 
+  prefs_check_button_add (object, "lazy-data-loading",
+                          _("Load brush and pattern pixels only when they are used"),
+                          GTK_BOX (vbox2));
+
   /*  Hardware Acceleration  */
   vbox2 = prefs_frame_new (_("Hardware Acceleration"), GTK_CONTAINER (vbox),
                            FALSE);
@@ -1408,6 +1415,25 @@ prefs_dialog_new (Gimp       *gimp,
                            _("Maximum _filesize for thumbnailing:"),
                            GTK_TABLE (table), 1, size_group);
 
+  /*  XCF Files  */
+  vbox2 = prefs_frame_new (_("XCF Files"), GTK_CONTAINER (vbox), FALSE);
+
+  table = prefs_table_new (2, GTK_CONTAINER (vbox2));
+
+  prefs_enum_combo_box_add (object, "xcf-compression", 0, 0,
+                            _("Tile _compression:"),
+                            GTK_TABLE (table), 0, size_group);
+  prefs_spin_button_add (object, "xcf-compression-level", 1.0, 3.0, 0,
+                         _("Compression _level:"),
+                         GTK_TABLE (table), 1, size_group);
+
+  prefs_check_button_add (object, "xcf-save-mipmaps",
+                          _("Save downscaled copies for fast thumbnails"),
+                          GTK_BOX (vbox2));
+  prefs_check_button_add (object, "xcf-lazy-loading",
+                          _("Load layer pixels only when they are needed"),
+                          GTK_BOX (vbox2));
+
   g_object_unref (size_group);
   size_group = NULL;
 
@@ -2417,6 +2443,17 @@ prefs_dialog_new (Gimp       *gimp,
                                           _("Use _black point compensation for "
                                             "the display"));
 
+            gtk_table_attach_defaults (GTK_TABLE (table),
+                                       button, 1, 2, row, row + 1);
+            gtk_widget_show (button);
+            row++;
+
+            button =
+              gimp_prop_check_button_new (object,
+                                          "color-transform-lut",
+                                          _("Use a _lookup table for the "
+                                            "display transform"));
+
             gtk_table_attach_defaults (GTK_TABLE (table),
                                        button, 1, 2, row, row + 1);
             gtk_widget_show (button);
@@ -44,6 +44,7 @@ typedef struct _GimpStatusbar            GimpStatusbar;
 typedef struct _GimpToolDialog           GimpToolDialog;
 typedef struct _GimpToolGui              GimpToolGui;
 
+typedef struct _GimpDisplayLut           GimpDisplayLut;
 typedef struct _GimpDisplayXfer          GimpDisplayXfer;
 typedef struct _Selection                Selection;
 
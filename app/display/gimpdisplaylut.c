@@ -0,0 +1,364 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpdisplaylut.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  A GimpDisplayLut is a color transform baked into a 3D lookup table.
+ *  The table is indexed by R'G'B' values, so its nodes are spaced
+ *  perceptually even for images with linear precision, and it is
+ *  applied with tetrahedral interpolation.  When the table is created,
+ *  it is compared against the transform on random colors, and the
+ *  largest difference is kept for the caller to decide if the table
+ *  is good enough.
+ */
+
+#include "config.h"
+
+#include <lcms2.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpcolor/gimpcolor.h"
+
+#include "display-types.h"
+
+#include "gimpdisplaylut.h"
+
+
+/*  the number of nodes along each axis  */
+#define LUT_SIZE   33
+
+#define STRIDE_B   3
+#define STRIDE_G   (LUT_SIZE * STRIDE_B)
+#define STRIDE_R   (LUT_SIZE * STRIDE_G)
+
+/*  the number of random colors used to measure the table's accuracy  */
+#define N_SAMPLES  4096
+
+
+struct _GimpDisplayLut
+{
+  const Babl *input_format;
+  const Babl *output_format;
+  gboolean    output_u8;
+
+  gfloat     *table;       /*  LUT_SIZE³ R'G'B' float triples   */
+  gdouble     max_error;
+};
+
+
+static void   gimp_display_lut_transform (GimpColorTransform  transform,
+                                          const Babl         *src_format,
+                                          const Babl         *dest_format,
+                                          const Babl         *format,
+                                          gfloat             *pixels,
+                                          gint                n_pixels);
+
+
+/*  public functions  */
+
+/*  Bakes @transform, which converts from @src_format to @dest_format,
+ *  into a new table.  The table converts "R'G'B'A float" pixels to
+ *  @output_format, which must be "R'G'B'A u8" or "R'G'B'A float".
+ */
+GimpDisplayLut *
+gimp_display_lut_new (GimpColorTransform  transform,
+                      const Babl         *src_format,
+                      const Babl         *dest_format,
+                      const Babl         *output_format)
+{
+  GimpDisplayLut *lut;
+  gfloat         *pixels;
+  gfloat         *result;
+  GRand          *rand;
+  gint            n_nodes = LUT_SIZE * LUT_SIZE * LUT_SIZE;
+  gint            r, g, b;
+  gint            i;
+
+  g_return_val_if_fail (transform != NULL, NULL);
+  g_return_val_if_fail (src_format != NULL, NULL);
+  g_return_val_if_fail (dest_format != NULL, NULL);
+  g_return_val_if_fail (output_format == babl_format ("R'G'B'A u8") ||
+                        output_format == babl_format ("R'G'B'A float"), NULL);
+
+  lut = g_slice_new0 (GimpDisplayLut);
+
+  lut->input_format  = babl_format ("R'G'B'A float");
+  lut->output_format = output_format;
+  lut->output_u8     = (output_format == babl_format ("R'G'B'A u8"));
+
+  /*  transform the nodes  */
+  pixels = g_new (gfloat, n_nodes * 4);
+
+  for (r = 0, i = 0; r < LUT_SIZE; r++)
+    for (g = 0; g < LUT_SIZE; g++)
+      for (b = 0; b < LUT_SIZE; b++, i += 4)
+        {
+          pixels[i + 0] = (gfloat) r / (LUT_SIZE - 1);
+          pixels[i + 1] = (gfloat) g / (LUT_SIZE - 1);
+          pixels[i + 2] = (gfloat) b / (LUT_SIZE - 1);
+          pixels[i + 3] = 1.0;
+        }
+
+  gimp_display_lut_transform (transform, src_format, dest_format,
+                              lut->input_format, pixels, n_nodes);
+
+  lut->table = g_new (gfloat, n_nodes * 3);
+
+  for (i = 0; i < n_nodes; i++)
+    {
+      lut->table[i * 3 + 0] = pixels[i * 4 + 0];
+      lut->table[i * 3 + 1] = pixels[i * 4 + 1];
+      lut->table[i * 3 + 2] = pixels[i * 4 + 2];
+    }
+
+  g_free (pixels);
+
+  /*  compare the table against the transform  */
+  pixels = g_new (gfloat, N_SAMPLES * 4);
+  result = g_new (gfloat, N_SAMPLES * 4);
+
+  rand = g_rand_new_with_seed (LUT_SIZE);
+
+  for (i = 0; i < N_SAMPLES * 4; i++)
+    pixels[i] = (i % 4 == 3) ? 1.0 : g_rand_double (rand);
+
+  g_rand_free (rand);
+
+  if (lut->output_u8)
+    {
+      lut->output_u8 = FALSE;
+      gimp_display_lut_process (lut, pixels, result, N_SAMPLES);
+      lut->output_u8 = TRUE;
+    }
+  else
+    {
+      gimp_display_lut_process (lut, pixels, result, N_SAMPLES);
+    }
+
+  gimp_display_lut_transform (transform, src_format, dest_format,
+                              lut->input_format, pixels, N_SAMPLES);
+
+  for (i = 0; i < N_SAMPLES * 4; i++)
+    {
+      gdouble error = ABS (CLAMP (pixels[i], 0.0, 1.0) - result[i]);
+
+      lut->max_error = MAX (lut->max_error, error);
+    }
+
+  g_free (result);
+  g_free (pixels);
+
+  return lut;
+}
+
+void
+gimp_display_lut_free (GimpDisplayLut *lut)
+{
+  g_return_if_fail (lut != NULL);
+
+  g_free (lut->table);
+
+  g_slice_free (GimpDisplayLut, lut);
+}
+
+const Babl *
+gimp_display_lut_get_input_format (GimpDisplayLut *lut)
+{
+  g_return_val_if_fail (lut != NULL, NULL);
+
+  return lut->input_format;
+}
+
+const Babl *
+gimp_display_lut_get_output_format (GimpDisplayLut *lut)
+{
+  g_return_val_if_fail (lut != NULL, NULL);
+
+  return lut->output_format;
+}
+
+/*  Returns the largest difference of a component between the table
+ *  and the transform it was made from, in the range [0..1].
+ */
+gdouble
+gimp_display_lut_get_max_error (GimpDisplayLut *lut)
+{
+  g_return_val_if_fail (lut != NULL, 1.0);
+
+  return lut->max_error;
+}
+
+/*  Converts @n_pixels "R'G'B'A float" pixels from @src to the table's
+ *  output format in @dest.  Values outside [0..1] are clipped, alpha
+ *  is copied.
+ */
+void
+gimp_display_lut_process (GimpDisplayLut *lut,
+                          const gfloat   *src,
+                          gpointer        dest,
+                          gint            n_pixels)
+{
+  guchar *dest_u8    = dest;
+  gfloat *dest_float = dest;
+
+  g_return_if_fail (lut != NULL);
+
+  while (n_pixels--)
+    {
+      const gfloat *c0;
+      const gfloat *c1;
+      const gfloat *c2;
+      const gfloat *c3;
+      gint          index[3];
+      gfloat        frac[3];
+      gfloat        f1, f2, f3;
+      gint          s1, s2;
+      gfloat        rgb[3];
+      gfloat        alpha;
+      gint          c;
+
+      for (c = 0; c < 3; c++)
+        {
+          gfloat x = src[c];
+
+          /*  written so that NaN becomes 0.0  */
+          if (! (x > 0.0f))
+            x = 0.0f;
+          else if (x > 1.0f)
+            x = 1.0f;
+
+          x *= LUT_SIZE - 1;
+
+          index[c] = MIN ((gint) x, LUT_SIZE - 2);
+          frac[c]  = x - index[c];
+        }
+
+      /*  pick the tetrahedron containing the color, it is spanned by
+       *  the cube's corners along the path which steps along the axes
+       *  in the order of decreasing fractions
+       */
+      if (frac[0] > frac[1])
+        {
+          if (frac[1] > frac[2])
+            {
+              s1 = STRIDE_R;  s2 = STRIDE_R + STRIDE_G;
+              f1 = frac[0];   f2 = frac[1];   f3 = frac[2];
+            }
+          else if (frac[0] > frac[2])
+            {
+              s1 = STRIDE_R;  s2 = STRIDE_R + STRIDE_B;
+              f1 = frac[0];   f2 = frac[2];   f3 = frac[1];
+            }
+          else
+            {
+              s1 = STRIDE_B;  s2 = STRIDE_B + STRIDE_R;
+              f1 = frac[2];   f2 = frac[0];   f3 = frac[1];
+            }
+        }
+      else
+        {
+          if (frac[2] > frac[1])
+            {
+              s1 = STRIDE_B;  s2 = STRIDE_B + STRIDE_G;
+              f1 = frac[2];   f2 = frac[1];   f3 = frac[0];
+            }
+          else if (frac[2] > frac[0])
+            {
+              s1 = STRIDE_G;  s2 = STRIDE_G + STRIDE_B;
+              f1 = frac[1];   f2 = frac[2];   f3 = frac[0];
+            }
+          else
+            {
+              s1 = STRIDE_G;  s2 = STRIDE_G + STRIDE_R;
+              f1 = frac[1];   f2 = frac[0];   f3 = frac[2];
+            }
+        }
+
+      c0 = lut->table + (index[0] * STRIDE_R +
+                         index[1] * STRIDE_G +
+                         index[2] * STRIDE_B);
+      c1 = c0 + s1;
+      c2 = c0 + s2;
+      c3 = c0 + STRIDE_R + STRIDE_G + STRIDE_B;
+
+      for (c = 0; c < 3; c++)
+        {
+          rgb[c] = (c0[c]                   +
+                    f1 * (c1[c] - c0[c])    +
+                    f2 * (c2[c] - c1[c])    +
+                    f3 * (c3[c] - c2[c]));
+        }
+
+      alpha = src[3];
+
+      if (lut->output_u8)
+        {
+          for (c = 0; c < 3; c++)
+            dest_u8[c] = CLAMP (rgb[c], 0.0f, 1.0f) * 255.0f + 0.5f;
+
+          dest_u8[3] = CLAMP (alpha, 0.0f, 1.0f) * 255.0f + 0.5f;
+
+          dest_u8 += 4;
+        }
+      else
+        {
+          dest_float[0] = rgb[0];
+          dest_float[1] = rgb[1];
+          dest_float[2] = rgb[2];
+          dest_float[3] = alpha;
+
+          dest_float += 4;
+        }
+
+      src += 4;
+    }
+}
+
+
+/*  private functions  */
+
+/*  Runs @transform on @n_pixels pixels of @format, in place  */
+static void
+gimp_display_lut_transform (GimpColorTransform  transform,
+                            const Babl         *src_format,
+                            const Babl         *dest_format,
+                            const Babl         *format,
+                            gfloat             *pixels,
+                            gint                n_pixels)
+{
+  guchar *src;
+  guchar *dest;
+
+  src  = g_malloc (n_pixels * babl_format_get_bytes_per_pixel (src_format));
+  dest = g_malloc (n_pixels * babl_format_get_bytes_per_pixel (dest_format));
+
+  babl_process (babl_fish (format, src_format), pixels, src, n_pixels);
+
+  /*  the transform doesn't touch alpha, so convert the source first,
+   *  like gimp_display_shell_profile_convert_buffer() does
+   */
+  babl_process (babl_fish (src_format, dest_format), src, dest, n_pixels);
+
+  cmsDoTransform (transform, src, dest, n_pixels);
+
+  babl_process (babl_fish (dest_format, format), dest, pixels, n_pixels);
+
+  g_free (dest);
+  g_free (src);
+}
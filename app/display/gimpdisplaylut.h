@@ -0,0 +1,40 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpdisplaylut.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_DISPLAY_LUT_H__
+#define __GIMP_DISPLAY_LUT_H__
+
+
+GimpDisplayLut * gimp_display_lut_new               (GimpColorTransform  transform,
+                                                     const Babl         *src_format,
+                                                     const Babl         *dest_format,
+                                                     const Babl         *output_format);
+void             gimp_display_lut_free              (GimpDisplayLut     *lut);
+
+const Babl     * gimp_display_lut_get_input_format  (GimpDisplayLut     *lut);
+const Babl     * gimp_display_lut_get_output_format (GimpDisplayLut     *lut);
+gdouble          gimp_display_lut_get_max_error     (GimpDisplayLut     *lut);
+
+void             gimp_display_lut_process           (GimpDisplayLut     *lut,
+                                                     const gfloat       *src,
+                                                     gpointer            dest,
+                                                     gint                n_pixels);
+
+
+#endif  /*  __GIMP_DISPLAY_LUT_H__  */
@@ -135,10 +135,11 @@ gimp_display_shell_draw_image (GimpDisplayShell *shell,
                                gint              w,
                                gint              h)
 {
-  gint x1, y1, x2, y2;
-  gint i, j;
-  gint chunk_width;
-  gint chunk_height;
+  GArray *chunks;
+  gint    x1, y1, x2, y2;
+  gint    i, j;
+  gint    chunk_width;
+  gint    chunk_height;
 
   g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
   g_return_if_fail (gimp_display_get_image (shell->display));
@@ -196,16 +197,27 @@ gimp_display_shell_draw_image (GimpDisplayShell *shell,
         chunk_width /= 2;
     }
 
+  chunks = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+
   for (i = y1; i < y2; i += chunk_height)
     {
       for (j = x1; j < x2; j += chunk_width)
         {
-          gint dx, dy;
+          GeglRectangle chunk;
 
-          dx = MIN (x2 - j, chunk_width);
-          dy = MIN (y2 - i, chunk_height);
+          chunk.x      = j;
+          chunk.y      = i;
+          chunk.width  = MIN (x2 - j, chunk_width);
+          chunk.height = MIN (y2 - i, chunk_height);
 
-          gimp_display_shell_render (shell, cr, j, i, dx, dy);
+          g_array_append_val (chunks, chunk);
         }
     }
+
+  /*  the chunks are rendered in parallel  */
+  gimp_display_shell_render (shell, cr,
+                             (const GeglRectangle *) chunks->data,
+                             chunks->len);
+
+  g_array_free (chunks, TRUE);
 }
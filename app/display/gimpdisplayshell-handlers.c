@@ -364,6 +364,10 @@ gimp_display_shell_connect (GimpDisplayShell *shell)
                     "notify",
                     G_CALLBACK (gimp_display_shell_color_config_notify_handler),
                     shell);
+  g_signal_connect (shell->display->config,
+                    "notify::color-transform-lut",
+                    G_CALLBACK (gimp_display_shell_color_config_notify_handler),
+                    shell);
 
   gimp_display_shell_invalidate_preview_handler (image, shell);
   gimp_display_shell_quick_mask_changed_handler (image, shell);
@@ -395,6 +399,9 @@ gimp_display_shell_disconnect (GimpDisplayShell *shell)
   gimp_canvas_layer_boundary_set_layer (GIMP_CANVAS_LAYER_BOUNDARY (shell->layer_boundary),
                                         NULL);
 
+  g_signal_handlers_disconnect_by_func (shell->display->config,
+                                        gimp_display_shell_color_config_notify_handler,
+                                        shell);
   g_signal_handlers_disconnect_by_func (GIMP_CORE_CONFIG (shell->display->config)->color_management,
                                         gimp_display_shell_color_config_notify_handler,
                                         shell);
@@ -30,7 +30,7 @@
 
 #include "display-types.h"
 
-#include "config/gimpcoreconfig.h"
+#include "config/gimpdisplayconfig.h"
 
 #include "gegl/gimp-babl.h"
 
@@ -41,11 +41,25 @@
 #include "gimpdisplayshell.h"
 #include "gimpdisplayshell-filter.h"
 #include "gimpdisplayshell-profile.h"
+#include "gimpdisplaylut.h"
 #include "gimpdisplayxfer.h"
 
+#include "gimp-log.h"
+
 #include "gimp-intl.h"
 
 
+/*  the largest difference to the exact transform at which the
+ *  lookup table is used, one 8 bit step
+ */
+#define LUT_MAX_ERROR (1.0 / 255.0)
+
+
+static GimpDisplayLut * gimp_display_shell_profile_create_lut (GimpDisplayShell *shell,
+                                                               const Babl       *src_format,
+                                                               const Babl       *dest_format);
+
+
 void
 gimp_display_shell_profile_dispose (GimpDisplayShell *shell)
 {
@@ -57,6 +71,12 @@ gimp_display_shell_profile_dispose (GimpDisplayShell *shell)
       shell->profile_dest_format = NULL;
     }
 
+  if (shell->profile_lut)
+    {
+      gimp_display_lut_free (shell->profile_lut);
+      shell->profile_lut = NULL;
+    }
+
   if (shell->profile_buffer)
     {
       g_object_unref (shell->profile_buffer);
@@ -117,6 +137,17 @@ gimp_display_shell_profile_update (GimpDisplayShell *shell)
       gint w = GIMP_DISPLAY_RENDER_BUF_WIDTH  * GIMP_DISPLAY_RENDER_MAX_SCALE;
       gint h = GIMP_DISPLAY_RENDER_BUF_HEIGHT * GIMP_DISPLAY_RENDER_MAX_SCALE;
 
+      if (display_config->color_transform_lut)
+        shell->profile_lut =
+          gimp_display_shell_profile_create_lut (shell,
+                                                 src_format, dest_format);
+
+      if (shell->profile_lut)
+        {
+          src_format  = gimp_display_lut_get_input_format  (shell->profile_lut);
+          dest_format = gimp_display_lut_get_output_format (shell->profile_lut);
+        }
+
       shell->profile_src_format  = src_format;
       shell->profile_dest_format = dest_format;
 
@@ -189,6 +220,14 @@ gimp_display_shell_profile_convert_buffer (GimpDisplayShell *shell,
       gpointer src_data  = iter->data[0];
       gpointer dest_data = iter->data[1];
 
+      if (shell->profile_lut)
+        {
+          gimp_display_lut_process (shell->profile_lut,
+                                    src_data, dest_data,
+                                    iter->length);
+          continue;
+        }
+
       babl_process (fish, src_data, dest_data, iter->length);
 
       cmsDoTransform (shell->profile_transform,
@@ -196,3 +235,67 @@ gimp_display_shell_profile_convert_buffer (GimpDisplayShell *shell,
                       iter->length);
     }
 }
+
+
+/*  private functions  */
+
+/*  Bakes the transform between the formats of the shell's profile
+ *  transform into a lookup table.  The table is made from a float
+ *  version of the transform, so the only loss is from interpolation,
+ *  and it's dropped if that is visible.
+ */
+static GimpDisplayLut *
+gimp_display_shell_profile_create_lut (GimpDisplayShell *shell,
+                                       const Babl       *src_format,
+                                       const Babl       *dest_format)
+{
+  GimpColorConfig    *config;
+  GimpColorTransform  transform;
+  GimpDisplayLut     *lut;
+  const Babl         *output_format;
+  gdouble             max_error;
+
+  config = GIMP_CORE_CONFIG (shell->display->config)->color_management;
+
+  if (dest_format == babl_format ("R'G'B'A u8"))
+    output_format = dest_format;
+  else
+    output_format = babl_format ("R'G'B'A float");
+
+  src_format  = gimp_babl_format (GIMP_RGB,
+                                  gimp_babl_precision (GIMP_COMPONENT_TYPE_FLOAT,
+                                                       gimp_babl_format_get_linear (src_format)),
+                                  TRUE);
+  dest_format = babl_format ("R'G'B'A float");
+
+  transform =
+    gimp_widget_get_color_transform (gtk_widget_get_toplevel (GTK_WIDGET (shell)),
+                                     GIMP_COLOR_MANAGED (shell), config,
+                                     &src_format,
+                                     &dest_format);
+
+  if (! transform)
+    return NULL;
+
+  lut = gimp_display_lut_new (transform, src_format, dest_format,
+                              output_format);
+
+  cmsDeleteTransform (transform);
+
+  max_error = gimp_display_lut_get_max_error (lut);
+
+  GIMP_LOG (COLOR_LUT, "%s -> %s: max error %f (%.2f 8 bit steps)",
+            babl_get_name (src_format), babl_get_name (output_format),
+            max_error, max_error * 255.0);
+
+  if (max_error > LUT_MAX_ERROR)
+    {
+      GIMP_LOG (COLOR_LUT, "not accurate enough, using the transform");
+
+      gimp_display_lut_free (lut);
+
+      return NULL;
+    }
+
+  return lut;
+}
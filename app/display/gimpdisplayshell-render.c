@@ -29,7 +29,9 @@
 #include "config/gimpdisplayconfig.h"
 
 #include "gegl/gimp-gegl-utils.h"
+#include "gegl/gimptilehandlervalidate.h"
 
+#include "core/gimp-parallel.h"
 #include "core/gimpdrawable.h"
 #include "core/gimpimage.h"
 #include "core/gimppickable.h"
@@ -50,48 +52,98 @@
 /* #define GIMP_DISPLAY_RENDER_ENABLE_SCALING 1 */
 
 
-void
-gimp_display_shell_render (GimpDisplayShell *shell,
-                           cairo_t          *cr,
-                           gint              x,
-                           gint              y,
-                           gint              w,
-                           gint              h)
+typedef struct _GimpDisplayShellRenderChunk GimpDisplayShellRenderChunk;
+typedef struct _GimpDisplayShellRenderBatch GimpDisplayShellRenderBatch;
+
+struct _GimpDisplayShellRenderChunk
 {
-  GimpImage       *image;
-  GeglBuffer      *buffer;
-#ifdef USE_NODE_BLIT
-  GeglNode        *node;
-#endif
-  gdouble          scale_x       = 1.0;
-  gdouble          scale_y       = 1.0;
-  gdouble          buffer_scale  = 1.0;
-  gint             viewport_offset_x;
-  gint             viewport_offset_y;
-  gint             viewport_width;
-  gint             viewport_height;
+  gint             x, y, w, h;      /*  in display coordinates           */
+
   gint             scaled_x;
   gint             scaled_y;
   gint             scaled_width;
   gint             scaled_height;
+
   cairo_surface_t *xfer;
   gint             xfer_src_x;
   gint             xfer_src_y;
-  gint             mask_src_x = 0;
-  gint             mask_src_y = 0;
-  gint             cairo_stride;
-  guchar          *cairo_data;
-  GeglBuffer      *cairo_buffer;
 
-  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
-  g_return_if_fail (cr != NULL);
-  g_return_if_fail (w > 0 && h > 0);
+  gint             cell_x;          /*  the chunk's area in the shell's  */
+  gint             cell_y;          /*  profile, filter and mask buffers */
+};
 
-  image  = gimp_display_get_image (shell->display);
-  buffer = gimp_pickable_get_buffer (GIMP_PICKABLE (image));
+struct _GimpDisplayShellRenderBatch
+{
+  GimpDisplayShell            *shell;
+  GeglBuffer                  *buffer;
 #ifdef USE_NODE_BLIT
-  node   = gimp_projectable_get_graph (GIMP_PROJECTABLE (image));
+  GeglNode                    *node;
 #endif
+  gdouble                      buffer_scale;
+  gboolean                     has_filter;
+  gboolean                     can_convert_to_u8;
+
+  GimpDisplayShellRenderChunk *chunks;
+  gint                         n_chunks;
+};
+
+
+static void   gimp_display_shell_render_batch      (GimpDisplayShellRenderBatch *batch,
+                                                    cairo_t                     *cr,
+                                                    gdouble                      scale_x,
+                                                    gdouble                      scale_y);
+static void   gimp_display_shell_render_batch_func (gint                         i,
+                                                    gint                         n,
+                                                    GimpDisplayShellRenderBatch *batch);
+static void   gimp_display_shell_render_chunk      (GimpDisplayShellRenderBatch *batch,
+                                                    GimpDisplayShellRenderChunk *chunk);
+static void   gimp_display_shell_render_paint      (GimpDisplayShell            *shell,
+                                                    cairo_t                     *cr,
+                                                    GimpDisplayShellRenderChunk *chunk,
+                                                    gdouble                      scale_x,
+                                                    gdouble                      scale_y);
+
+
+/*  public functions  */
+
+/*  Renders @n_chunks chunks of the display, each at most
+ *  GIMP_DISPLAY_RENDER_BUF_WIDTH x GIMP_DISPLAY_RENDER_BUF_HEIGHT
+ *  pixels.  The chunks are rendered in parallel, in batches which fit
+ *  into the shell's render buffers, and each batch is painted to @cr
+ *  on the calling thread once all its chunks are done.
+ */
+void
+gimp_display_shell_render (GimpDisplayShell    *shell,
+                           cairo_t             *cr,
+                           const GeglRectangle *chunks,
+                           gint                 n_chunks)
+{
+  GimpImage                   *image;
+  GimpDisplayShellRenderChunk *all_chunks;
+  GimpDisplayShellRenderBatch  batch;
+  gdouble                      scale_x       = 1.0;
+  gdouble                      scale_y       = 1.0;
+  gdouble                      buffer_scale  = 1.0;
+  gint                         viewport_offset_x;
+  gint                         viewport_offset_y;
+  gint                         viewport_width;
+  gint                         viewport_height;
+  gint                         buffer_width;
+  gint                         buffer_height;
+  gint                         cell_width    = 1;
+  gint                         cell_height   = 1;
+  gint                         n_columns;
+  gint                         max_batch;
+  gint                         i;
+
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+  g_return_if_fail (cr != NULL);
+  g_return_if_fail (chunks != NULL || n_chunks == 0);
+
+  if (n_chunks == 0)
+    return;
+
+  image = gimp_display_get_image (shell->display);
 
 #ifdef GIMP_DISPLAY_RENDER_ENABLE_SCALING
   /* if we had this future API, things would look pretty on hires (retina) */
@@ -124,33 +176,226 @@ gimp_display_shell_render (GimpDisplayShell *shell,
                                                  &viewport_width,
                                                  &viewport_height);
 
-  scaled_x      = floor ((x + viewport_offset_x) * scale_x);
-  scaled_y      = floor ((y + viewport_offset_y) * scale_y);
-  scaled_width  = ceil (w * scale_x);
-  scaled_height = ceil (h * scale_y);
+  batch.shell        = shell;
+  batch.buffer       = gimp_pickable_get_buffer (GIMP_PICKABLE (image));
+#ifdef USE_NODE_BLIT
+  batch.node         = gimp_projectable_get_graph (GIMP_PROJECTABLE (image));
+#endif
+  batch.buffer_scale = buffer_scale;
+  batch.has_filter   = gimp_display_shell_has_filter (shell);
 
-  if (shell->rotate_transform)
+  batch.can_convert_to_u8 =
+    gimp_display_shell_profile_can_convert_to_u8 (shell);
+
+  buffer_width  = GIMP_DISPLAY_RENDER_BUF_WIDTH  * GIMP_DISPLAY_RENDER_MAX_SCALE;
+  buffer_height = GIMP_DISPLAY_RENDER_BUF_HEIGHT * GIMP_DISPLAY_RENDER_MAX_SCALE;
+
+  /*  create the filter buffer if we have filters
+   */
+  if ((shell->profile_transform || batch.has_filter) &&
+      (batch.has_filter || ! batch.can_convert_to_u8) &&
+      ! shell->filter_buffer)
     {
-      xfer = cairo_surface_create_similar_image (cairo_get_target (cr),
-                                                 CAIRO_FORMAT_ARGB32,
-                                                 scaled_width,
-                                                 scaled_height);
-      cairo_surface_mark_dirty (xfer);
-      xfer_src_x = 0;
-      xfer_src_y = 0;
+      shell->filter_data =
+        gegl_malloc (buffer_width * buffer_height *
+                     babl_format_get_bytes_per_pixel (shell->filter_format));
+
+      shell->filter_stride =
+        buffer_width * babl_format_get_bytes_per_pixel (shell->filter_format);
+
+      shell->filter_buffer =
+        gegl_buffer_linear_new_from_data (shell->filter_data,
+                                          shell->filter_format,
+                                          GEGL_RECTANGLE (0, 0,
+                                                          buffer_width,
+                                                          buffer_height),
+                                          GEGL_AUTO_ROWSTRIDE,
+                                          (GDestroyNotify) gegl_free,
+                                          shell->filter_data);
     }
-  else
+
+  if (shell->mask && ! shell->mask_surface)
+    {
+      shell->mask_surface =
+        cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                    buffer_width, buffer_height);
+    }
+
+  all_chunks = g_new (GimpDisplayShellRenderChunk, n_chunks);
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      GimpDisplayShellRenderChunk *chunk = &all_chunks[i];
+
+      chunk->x = chunks[i].x;
+      chunk->y = chunks[i].y;
+      chunk->w = chunks[i].width;
+      chunk->h = chunks[i].height;
+
+      chunk->scaled_x      = floor ((chunk->x + viewport_offset_x) * scale_x);
+      chunk->scaled_y      = floor ((chunk->y + viewport_offset_y) * scale_y);
+      chunk->scaled_width  = ceil (chunk->w * scale_x);
+      chunk->scaled_height = ceil (chunk->h * scale_y);
+
+      cell_width  = MAX (cell_width,  chunk->scaled_width);
+      cell_height = MAX (cell_height, chunk->scaled_height);
+    }
+
+  /*  each chunk of a batch gets its own cell of the render buffers.
+   *  A batch covers at most half of the buffers, so that its chunks
+   *  always fit into the xfer surfaces, which are the same size and
+   *  hold two pages: a page is only reused when the other one fills
+   *  up, and none of the current batch's chunks can be on it then
+   */
+  n_columns = MAX (buffer_width / cell_width, 1);
+  max_batch = MAX (n_columns * (buffer_height / cell_height) / 2, 1);
+
+  for (i = 0; i < n_chunks; i += max_batch)
+    {
+      gint j;
+
+      batch.n_chunks = MIN (n_chunks - i, max_batch);
+
+      for (j = 0; j < batch.n_chunks; j++)
+        {
+          GimpDisplayShellRenderChunk *chunk = &all_chunks[i + j];
+
+          chunk->cell_x = (j % n_columns) * cell_width;
+          chunk->cell_y = (j / n_columns) * cell_height;
+
+          if (shell->rotate_transform)
+            {
+              chunk->xfer =
+                cairo_surface_create_similar_image (cairo_get_target (cr),
+                                                    CAIRO_FORMAT_ARGB32,
+                                                    chunk->scaled_width,
+                                                    chunk->scaled_height);
+              cairo_surface_mark_dirty (chunk->xfer);
+              chunk->xfer_src_x = 0;
+              chunk->xfer_src_y = 0;
+            }
+          else
+            {
+              chunk->xfer =
+                gimp_display_xfer_get_surface (shell->xfer,
+                                               chunk->scaled_width,
+                                               chunk->scaled_height,
+                                               &chunk->xfer_src_x,
+                                               &chunk->xfer_src_y);
+            }
+        }
+
+      batch.chunks = all_chunks + i;
+
+      gimp_display_shell_render_batch (&batch, cr, scale_x, scale_y);
+    }
+
+  g_free (all_chunks);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_display_shell_render_batch (GimpDisplayShellRenderBatch *batch,
+                                 cairo_t                     *cr,
+                                 gdouble                      scale_x,
+                                 gdouble                      scale_y)
+{
+  GimpDisplayShell *shell = batch->shell;
+  gint              max_n = batch->n_chunks;
+  gint              i;
+
+  /*  display filters are loadable modules which are not known to be
+   *  thread safe, and neither is blitting the projection graph
+   */
+#ifdef USE_NODE_BLIT
+  max_n = 1;
+#else
+  if (batch->has_filter)
+    max_n = 1;
+
+  /*  reading the projection at full resolution renders its invalid
+   *  parts, which can't happen on several threads at once, so render
+   *  them here first.  lower resolutions are only read from the tile
+   *  pyramid
+   */
+  if (max_n > 1 && batch->buffer_scale > 0.5)
     {
-      xfer = gimp_display_xfer_get_surface (shell->xfer,
-                                            scaled_width,
-                                            scaled_height,
-                                            &xfer_src_x,
-                                            &xfer_src_y);
+      GimpTileHandlerValidate *validate;
+
+      validate = gimp_tile_handler_validate_get_assigned (batch->buffer);
+
+      if (validate)
+        {
+          GeglRectangle area = { 0, };
+
+          for (i = 0; i < batch->n_chunks; i++)
+            {
+              GimpDisplayShellRenderChunk *chunk = &batch->chunks[i];
+              GeglRectangle                rect;
+
+              rect.x      = floor (chunk->scaled_x / batch->buffer_scale);
+              rect.y      = floor (chunk->scaled_y / batch->buffer_scale);
+              rect.width  = ceil ((chunk->scaled_x + chunk->scaled_width) /
+                                  batch->buffer_scale) - rect.x + 1;
+              rect.height = ceil ((chunk->scaled_y + chunk->scaled_height) /
+                                  batch->buffer_scale) - rect.y + 1;
+
+              gegl_rectangle_bounding_box (&area, &area, &rect);
+            }
+
+          gimp_tile_handler_validate_validate (validate, &area);
+        }
     }
+#endif
 
-  cairo_stride = cairo_image_surface_get_stride (xfer);
-  cairo_data   = cairo_image_surface_get_data (xfer) +
-                 xfer_src_y * cairo_stride + xfer_src_x * 4;
+  gimp_parallel_distribute (max_n,
+                            (GimpParallelDistributeFunc)
+                            gimp_display_shell_render_batch_func,
+                            batch);
+
+  if (shell->mask)
+    cairo_surface_mark_dirty (shell->mask_surface);
+
+  for (i = 0; i < batch->n_chunks; i++)
+    {
+      gimp_display_shell_render_paint (shell, cr, &batch->chunks[i],
+                                       scale_x, scale_y);
+    }
+}
+
+static void
+gimp_display_shell_render_batch_func (gint                         i,
+                                      gint                         n,
+                                      GimpDisplayShellRenderBatch *batch)
+{
+  gint c;
+
+  for (c = i; c < batch->n_chunks; c += n)
+    gimp_display_shell_render_chunk (batch, &batch->chunks[c]);
+}
+
+/*  Renders @chunk into its xfer surface and mask cell.  This runs in a
+ *  worker thread, so it must only touch the chunk's own cells of the
+ *  shell's buffers, wrapping them in buffers of its own.
+ */
+static void
+gimp_display_shell_render_chunk (GimpDisplayShellRenderBatch *batch,
+                                 GimpDisplayShellRenderChunk *chunk)
+{
+  GimpDisplayShell *shell         = batch->shell;
+  gint              scaled_x      = chunk->scaled_x;
+  gint              scaled_y      = chunk->scaled_y;
+  gint              scaled_width  = chunk->scaled_width;
+  gint              scaled_height = chunk->scaled_height;
+  gint              cairo_stride;
+  guchar           *cairo_data;
+  GeglBuffer       *cairo_buffer;
+
+  cairo_stride = cairo_image_surface_get_stride (chunk->xfer);
+  cairo_data   = cairo_image_surface_get_data (chunk->xfer) +
+                 chunk->xfer_src_y * cairo_stride + chunk->xfer_src_x * 4;
 
   cairo_buffer = gegl_buffer_linear_new_from_data (cairo_data,
                                                    babl_format ("cairo-ARGB32"),
@@ -160,93 +405,91 @@ gimp_display_shell_render (GimpDisplayShell *shell,
                                                    cairo_stride,
                                                    NULL, NULL);
 
-  if (shell->profile_transform ||
-      gimp_display_shell_has_filter (shell))
+  if (shell->profile_transform || batch->has_filter)
     {
-      gboolean can_convert_to_u8;
+      gboolean    use_filter_buffer;
+      guchar     *filter_data   = NULL;
+      GeglBuffer *filter_buffer = NULL;
 
       /*  if there is a profile transform or a display filter, we need
        *  to use temp buffers
        */
 
-      can_convert_to_u8 = gimp_display_shell_profile_can_convert_to_u8 (shell);
+      use_filter_buffer = batch->has_filter || ! batch->can_convert_to_u8;
 
-      /*  create the filter buffer if we have filters
-       */
-      if ((gimp_display_shell_has_filter (shell) || ! can_convert_to_u8) &&
-          ! shell->filter_buffer)
+      if (use_filter_buffer)
         {
-          gint w = GIMP_DISPLAY_RENDER_BUF_WIDTH  * GIMP_DISPLAY_RENDER_MAX_SCALE;
-          gint h = GIMP_DISPLAY_RENDER_BUF_HEIGHT * GIMP_DISPLAY_RENDER_MAX_SCALE;
+          filter_data = (shell->filter_data                    +
+                         chunk->cell_y * shell->filter_stride  +
+                         chunk->cell_x *
+                         babl_format_get_bytes_per_pixel (shell->filter_format));
 
-          shell->filter_data =
-            gegl_malloc (w * h * babl_format_get_bytes_per_pixel (shell->filter_format));
-
-          shell->filter_stride =
-            w * babl_format_get_bytes_per_pixel (shell->filter_format);
-
-          shell->filter_buffer =
-            gegl_buffer_linear_new_from_data (shell->filter_data,
+          filter_buffer =
+            gegl_buffer_linear_new_from_data (filter_data,
                                               shell->filter_format,
-                                              GEGL_RECTANGLE (0, 0, w, h),
-                                              GEGL_AUTO_ROWSTRIDE,
-                                              (GDestroyNotify) gegl_free,
-                                              shell->filter_data);
+                                              GEGL_RECTANGLE (0, 0,
+                                                              scaled_width,
+                                                              scaled_height),
+                                              shell->filter_stride,
+                                              NULL, NULL);
         }
 
       if (shell->profile_transform)
         {
+          guchar     *profile_data;
+          GeglBuffer *profile_buffer;
+
+          profile_data = (shell->profile_data                    +
+                          chunk->cell_y * shell->profile_stride  +
+                          chunk->cell_x *
+                          babl_format_get_bytes_per_pixel (shell->profile_src_format));
+
           /*  if there is a profile transform, load the projection
            *  pixels into the profile_buffer
            */
 #ifndef USE_NODE_BLIT
-          gegl_buffer_get (buffer,
+          gegl_buffer_get (batch->buffer,
                            GEGL_RECTANGLE (scaled_x, scaled_y,
                                            scaled_width, scaled_height),
-                           buffer_scale,
+                           batch->buffer_scale,
                            shell->profile_src_format,
-                           shell->profile_data, shell->profile_stride,
+                           profile_data, shell->profile_stride,
                            GEGL_ABYSS_CLAMP);
 #else
-          gegl_node_blit (node,
-                          buffer_scale,
+          gegl_node_blit (batch->node,
+                          batch->buffer_scale,
                           GEGL_RECTANGLE (scaled_x, scaled_y,
                                           scaled_width, scaled_height),
                           shell->profile_src_format,
-                          shell->profile_data, shell->profile_stride,
+                          profile_data, shell->profile_stride,
                           GEGL_BLIT_CACHE);
 #endif
 
-          if (gimp_display_shell_has_filter (shell) || ! can_convert_to_u8)
-            {
-              /*  if there are filters, convert the pixels from the
-               *  profile_buffer to the filter_buffer
-               */
-              gimp_display_shell_profile_convert_buffer (shell,
-                                                         shell->profile_buffer,
-                                                         GEGL_RECTANGLE (0, 0,
-                                                                         scaled_width,
-                                                                         scaled_height),
-                                                         shell->filter_buffer,
-                                                         GEGL_RECTANGLE (0, 0,
-                                                                         scaled_width,
-                                                                         scaled_height));
-            }
-          else
-            {
-              /*  otherwise, convert the profile_buffer directly into
-               *  the cairo_buffer
-               */
-              gimp_display_shell_profile_convert_buffer (shell,
-                                                         shell->profile_buffer,
-                                                         GEGL_RECTANGLE (0, 0,
-                                                                         scaled_width,
-                                                                         scaled_height),
-                                                         cairo_buffer,
-                                                         GEGL_RECTANGLE (0, 0,
-                                                                         scaled_width,
-                                                                         scaled_height));
-            }
+          profile_buffer =
+            gegl_buffer_linear_new_from_data (profile_data,
+                                              shell->profile_src_format,
+                                              GEGL_RECTANGLE (0, 0,
+                                                              scaled_width,
+                                                              scaled_height),
+                                              shell->profile_stride,
+                                              NULL, NULL);
+
+          /*  if there are filters, convert the pixels from the
+           *  profile_buffer to the filter_buffer, otherwise convert
+           *  the profile_buffer directly into the cairo_buffer
+           */
+          gimp_display_shell_profile_convert_buffer (shell,
+                                                     profile_buffer,
+                                                     GEGL_RECTANGLE (0, 0,
+                                                                     scaled_width,
+                                                                     scaled_height),
+                                                     use_filter_buffer ?
+                                                     filter_buffer : cairo_buffer,
+                                                     GEGL_RECTANGLE (0, 0,
+                                                                     scaled_width,
+                                                                     scaled_height));
+
+          g_object_unref (profile_buffer);
         }
       else
         {
@@ -254,40 +497,40 @@ gimp_display_shell_render (GimpDisplayShell *shell,
            *  filter_buffer
            */
 #ifndef USE_NODE_BLIT
-          gegl_buffer_get (buffer,
+          gegl_buffer_get (batch->buffer,
                            GEGL_RECTANGLE (scaled_x, scaled_y,
                                            scaled_width, scaled_height),
-                           buffer_scale,
+                           batch->buffer_scale,
                            shell->filter_format,
-                           shell->filter_data, shell->filter_stride,
+                           filter_data, shell->filter_stride,
                            GEGL_ABYSS_CLAMP);
 #else
-          gegl_node_blit (node,
-                          buffer_scale,
+          gegl_node_blit (batch->node,
+                          batch->buffer_scale,
                           GEGL_RECTANGLE (scaled_x, scaled_y,
                                           scaled_width, scaled_height),
                           shell->filter_format,
-                          shell->filter_data, shell->filter_stride,
+                          filter_data, shell->filter_stride,
                           GEGL_BLIT_CACHE);
 #endif
         }
 
-      if (gimp_display_shell_has_filter (shell))
+      if (batch->has_filter)
         {
           /*  convert the filter_buffer in place
            */
           gimp_color_display_stack_convert_buffer (shell->filter_stack,
-                                                   shell->filter_buffer,
+                                                   filter_buffer,
                                                    GEGL_RECTANGLE (0, 0,
                                                                    scaled_width,
                                                                    scaled_height));
         }
 
-      if (gimp_display_shell_has_filter (shell) || ! can_convert_to_u8)
+      if (use_filter_buffer)
         {
           /*  finally, copy the filter buffer to the cairo-ARGB32 buffer
            */
-          gegl_buffer_get (shell->filter_buffer,
+          gegl_buffer_get (filter_buffer,
                            GEGL_RECTANGLE (0, 0,
                                            scaled_width,
                                            scaled_height),
@@ -295,6 +538,8 @@ gimp_display_shell_render (GimpDisplayShell *shell,
                            babl_format ("cairo-ARGB32"),
                            cairo_data, cairo_stride,
                            GEGL_ABYSS_CLAMP);
+
+          g_object_unref (filter_buffer);
         }
     }
   else
@@ -303,16 +548,16 @@ gimp_display_shell_render (GimpDisplayShell *shell,
        *  cairo-ARGB32 buffer
        */
 #ifndef USE_NODE_BLIT
-      gegl_buffer_get (buffer,
+      gegl_buffer_get (batch->buffer,
                        GEGL_RECTANGLE (scaled_x, scaled_y,
                                        scaled_width, scaled_height),
-                       buffer_scale,
+                       batch->buffer_scale,
                        babl_format ("cairo-ARGB32"),
                        cairo_data, cairo_stride,
                        GEGL_ABYSS_CLAMP);
 #else
-      gegl_node_blit (node,
-                      buffer_scale,
+      gegl_node_blit (batch->node,
+                      batch->buffer_scale,
                       GEGL_RECTANGLE (scaled_x, scaled_y,
                                       scaled_width, scaled_height),
                       babl_format ("cairo-ARGB32"),
@@ -325,26 +570,14 @@ gimp_display_shell_render (GimpDisplayShell *shell,
 
   if (shell->mask)
     {
-      if (! shell->mask_surface)
-        {
-          shell->mask_surface =
-            cairo_image_surface_create (CAIRO_FORMAT_A8,
-                                        GIMP_DISPLAY_RENDER_BUF_WIDTH  *
-                                        GIMP_DISPLAY_RENDER_MAX_SCALE,
-                                        GIMP_DISPLAY_RENDER_BUF_HEIGHT *
-                                        GIMP_DISPLAY_RENDER_MAX_SCALE);
-        }
-
-      cairo_surface_mark_dirty (shell->mask_surface);
-
       cairo_stride = cairo_image_surface_get_stride (shell->mask_surface);
       cairo_data   = cairo_image_surface_get_data (shell->mask_surface) +
-                     mask_src_y * cairo_stride + mask_src_x * 4;
+                     chunk->cell_y * cairo_stride + chunk->cell_x;
 
       gegl_buffer_get (shell->mask,
                        GEGL_RECTANGLE (scaled_x, scaled_y,
                                        scaled_width, scaled_height),
-                       buffer_scale,
+                       batch->buffer_scale,
                        babl_format ("Y u8"),
                        cairo_data, cairo_stride,
                        GEGL_ABYSS_CLAMP);
@@ -369,17 +602,28 @@ gimp_display_shell_render (GimpDisplayShell *shell,
             }
         }
     }
+}
+
+static void
+gimp_display_shell_render_paint (GimpDisplayShell            *shell,
+                                 cairo_t                     *cr,
+                                 GimpDisplayShellRenderChunk *chunk,
+                                 gdouble                      scale_x,
+                                 gdouble                      scale_y)
+{
+  gint x = chunk->x;
+  gint y = chunk->y;
 
   /*  put it to the screen  */
   cairo_save (cr);
 
-  cairo_rectangle (cr, x, y, w, h);
+  cairo_rectangle (cr, x, y, chunk->w, chunk->h);
 
   cairo_scale (cr, 1.0 / scale_x, 1.0 / scale_y);
 
-  cairo_set_source_surface (cr, xfer,
-                            x * scale_x - xfer_src_x,
-                            y * scale_y - xfer_src_y);
+  cairo_set_source_surface (cr, chunk->xfer,
+                            x * scale_x - chunk->xfer_src_x,
+                            y * scale_y - chunk->xfer_src_y);
 
   if (shell->rotate_transform)
     {
@@ -391,7 +635,7 @@ gimp_display_shell_render (GimpDisplayShell *shell,
       cairo_set_line_width (cr, 1.0);
       cairo_stroke_preserve (cr);
 
-      cairo_surface_destroy (xfer);
+      cairo_surface_destroy (chunk->xfer);
     }
 
   cairo_clip (cr);
@@ -401,8 +645,8 @@ gimp_display_shell_render (GimpDisplayShell *shell,
     {
       gimp_cairo_set_source_rgba (cr, &shell->mask_color);
       cairo_mask_surface (cr, shell->mask_surface,
-                          (x - mask_src_x) * scale_x,
-                          (y - mask_src_y) * scale_y);
+                          x * scale_x - chunk->cell_x,
+                          y * scale_y - chunk->cell_y);
     }
 
   cairo_restore (cr);
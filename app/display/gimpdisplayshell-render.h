@@ -18,11 +18,9 @@
 #ifndef __GIMP_DISPLAY_SHELL_RENDER_H__
 #define __GIMP_DISPLAY_SHELL_RENDER_H__
 
-void  gimp_display_shell_render (GimpDisplayShell *shell,
-                                 cairo_t          *cr,
-                                 gint              x,
-                                 gint              y,
-                                 gint              w,
-                                 gint              h);
+void  gimp_display_shell_render (GimpDisplayShell    *shell,
+                                 cairo_t             *cr,
+                                 const GeglRectangle *chunks,
+                                 gint                 n_chunks);
 
 #endif  /*  __GIMP_DISPLAY_SHELL_RENDER_H__  */
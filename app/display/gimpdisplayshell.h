@@ -150,6 +150,7 @@ struct _GimpDisplayShell
   GimpColorTransform profile_transform;
   const Babl        *profile_src_format;
   const Babl        *profile_dest_format;
+  GimpDisplayLut    *profile_lut;      /*  profile_transform as a 3D LUT      */
 
   GeglBuffer        *profile_buffer;   /*  buffer for profile transform       */
   guchar            *profile_data;     /*  profile_buffer's pixels            */
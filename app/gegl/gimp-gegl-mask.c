@@ -17,6 +17,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gegl.h>
 
 #include "gimp-gegl-types.h"
@@ -158,3 +160,355 @@ gimp_gegl_mask_is_empty (GeglBuffer *buffer)
 
   return TRUE;
 }
+
+
+/*  GimpMaskSummary keeps the state and the bounding box of each tile of
+ *  a mask, so bounds and emptiness can be computed from the tiles
+ *  instead of from the pixels.  Only the tiles which have been
+ *  invalidated since they were last looked at are scanned again.
+ */
+
+#define SUMMARY_TILE_SIZE 128
+
+typedef enum
+{
+  MASK_TILE_UNKNOWN,
+  MASK_TILE_EMPTY,
+  MASK_TILE_FULL,
+  MASK_TILE_MIXED
+} MaskTileState;
+
+typedef struct _MaskTile MaskTile;
+
+struct _MaskTile
+{
+  MaskTileState state;
+  gint          x1, y1;   /*  bounding box of the tile's non-zero pixels  */
+  gint          x2, y2;
+};
+
+struct _GimpMaskSummary
+{
+  GeglBuffer *buffer;
+  gint        width;
+  gint        height;
+
+  gint        n_cols;
+  gint        n_rows;
+  MaskTile   *tiles;
+};
+
+
+static void   gimp_mask_summary_reset     (GimpMaskSummary *summary,
+                                           GeglBuffer      *buffer);
+static void   gimp_mask_summary_scan_tile (GimpMaskSummary *summary,
+                                           GeglBuffer      *buffer,
+                                           gint             col,
+                                           gint             row);
+
+
+GimpMaskSummary *
+gimp_mask_summary_new (void)
+{
+  return g_slice_new0 (GimpMaskSummary);
+}
+
+void
+gimp_mask_summary_free (GimpMaskSummary *summary)
+{
+  g_return_if_fail (summary != NULL);
+
+  g_free (summary->tiles);
+
+  g_slice_free (GimpMaskSummary, summary);
+}
+
+/*  Forgets the state of the tiles touching @rect, or of all tiles if
+ *  @rect is NULL.  Must be called whenever the mask's pixels change.
+ */
+void
+gimp_mask_summary_invalidate (GimpMaskSummary     *summary,
+                              const GeglRectangle *rect)
+{
+  gint col1, row1, col2, row2;
+  gint col, row;
+
+  g_return_if_fail (summary != NULL);
+
+  if (! summary->tiles)
+    return;
+
+  if (! rect)
+    {
+      memset (summary->tiles, 0,
+              summary->n_cols * summary->n_rows * sizeof (MaskTile));
+      return;
+    }
+
+  col1 = MAX (rect->x, 0);
+  row1 = MAX (rect->y, 0);
+  col2 = MIN (rect->x + rect->width,  summary->width);
+  row2 = MIN (rect->y + rect->height, summary->height);
+
+  if (col2 <= col1 || row2 <= row1)
+    return;
+
+  col1 = col1 / SUMMARY_TILE_SIZE;
+  row1 = row1 / SUMMARY_TILE_SIZE;
+  col2 = (col2 - 1) / SUMMARY_TILE_SIZE;
+  row2 = (row2 - 1) / SUMMARY_TILE_SIZE;
+
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      summary->tiles[row * summary->n_cols + col].state = MASK_TILE_UNKNOWN;
+}
+
+/*  Sets all tiles to empty or full, for after the whole mask has been
+ *  cleared or filled, so the next query doesn't need to scan it.
+ */
+void
+gimp_mask_summary_fill (GimpMaskSummary *summary,
+                        GeglBuffer      *buffer,
+                        gboolean         full)
+{
+  gint row, col;
+
+  g_return_if_fail (summary != NULL);
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+
+  gimp_mask_summary_reset (summary, buffer);
+
+  for (row = 0; row < summary->n_rows; row++)
+    for (col = 0; col < summary->n_cols; col++)
+      {
+        MaskTile *tile = &summary->tiles[row * summary->n_cols + col];
+
+        tile->state = full ? MASK_TILE_FULL : MASK_TILE_EMPTY;
+        tile->x1    = col * SUMMARY_TILE_SIZE;
+        tile->y1    = row * SUMMARY_TILE_SIZE;
+        tile->x2    = MIN (tile->x1 + SUMMARY_TILE_SIZE, summary->width);
+        tile->y2    = MIN (tile->y1 + SUMMARY_TILE_SIZE, summary->height);
+      }
+}
+
+/*  Same as gimp_gegl_mask_bounds(), but only scans the tiles which
+ *  changed since the last call.
+ */
+gboolean
+gimp_mask_summary_bounds (GimpMaskSummary *summary,
+                          GeglBuffer      *buffer,
+                          gint            *x1,
+                          gint            *y1,
+                          gint            *x2,
+                          gint            *y2)
+{
+  gint tx1, ty1, tx2, ty2;
+  gint row, col;
+
+  g_return_val_if_fail (summary != NULL, FALSE);
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (x1 != NULL, FALSE);
+  g_return_val_if_fail (y1 != NULL, FALSE);
+  g_return_val_if_fail (x2 != NULL, FALSE);
+  g_return_val_if_fail (y2 != NULL, FALSE);
+
+  gimp_mask_summary_reset (summary, buffer);
+
+  tx1 = summary->width;
+  ty1 = summary->height;
+  tx2 = 0;
+  ty2 = 0;
+
+  for (row = 0; row < summary->n_rows; row++)
+    for (col = 0; col < summary->n_cols; col++)
+      {
+        MaskTile *tile = &summary->tiles[row * summary->n_cols + col];
+
+        if (tile->state == MASK_TILE_UNKNOWN)
+          gimp_mask_summary_scan_tile (summary, buffer, col, row);
+
+        if (tile->state != MASK_TILE_EMPTY)
+          {
+            tx1 = MIN (tx1, tile->x1);
+            ty1 = MIN (ty1, tile->y1);
+            tx2 = MAX (tx2, tile->x2);
+            ty2 = MAX (ty2, tile->y2);
+          }
+      }
+
+  if (tx2 <= tx1 || ty2 <= ty1)
+    {
+      *x1 = 0;
+      *y1 = 0;
+      *x2 = summary->width;
+      *y2 = summary->height;
+
+      return FALSE;
+    }
+
+  *x1 = tx1;
+  *y1 = ty1;
+  *x2 = tx2;
+  *y2 = ty2;
+
+  return TRUE;
+}
+
+/*  Same as gimp_gegl_mask_is_empty(), but looks at the known tiles
+ *  first, and only scans changed tiles until a non-empty one is found.
+ */
+gboolean
+gimp_mask_summary_is_empty (GimpMaskSummary *summary,
+                            GeglBuffer      *buffer)
+{
+  gint n_tiles;
+  gint i;
+
+  g_return_val_if_fail (summary != NULL, FALSE);
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
+
+  gimp_mask_summary_reset (summary, buffer);
+
+  n_tiles = summary->n_cols * summary->n_rows;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      if (summary->tiles[i].state == MASK_TILE_FULL ||
+          summary->tiles[i].state == MASK_TILE_MIXED)
+        return FALSE;
+    }
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      if (summary->tiles[i].state == MASK_TILE_UNKNOWN)
+        {
+          gimp_mask_summary_scan_tile (summary, buffer,
+                                       i % summary->n_cols,
+                                       i / summary->n_cols);
+
+          if (summary->tiles[i].state != MASK_TILE_EMPTY)
+            return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+gint64
+gimp_mask_summary_get_memsize (GimpMaskSummary *summary)
+{
+  g_return_val_if_fail (summary != NULL, 0);
+
+  return (sizeof (GimpMaskSummary) +
+          summary->n_cols * summary->n_rows * sizeof (MaskTile));
+}
+
+
+/*  private functions  */
+
+/*  Forgets everything if @buffer is not the buffer the summary was
+ *  made for, or if its size changed.
+ */
+static void
+gimp_mask_summary_reset (GimpMaskSummary *summary,
+                         GeglBuffer      *buffer)
+{
+  gint width  = gegl_buffer_get_width  (buffer);
+  gint height = gegl_buffer_get_height (buffer);
+
+  if (summary->tiles           &&
+      summary->buffer == buffer &&
+      summary->width  == width  &&
+      summary->height == height)
+    return;
+
+  g_free (summary->tiles);
+
+  summary->buffer = buffer;
+  summary->width  = width;
+  summary->height = height;
+  summary->n_cols = (width  + SUMMARY_TILE_SIZE - 1) / SUMMARY_TILE_SIZE;
+  summary->n_rows = (height + SUMMARY_TILE_SIZE - 1) / SUMMARY_TILE_SIZE;
+  summary->tiles  = g_new0 (MaskTile, summary->n_cols * summary->n_rows);
+}
+
+static void
+gimp_mask_summary_scan_tile (GimpMaskSummary *summary,
+                             GeglBuffer      *buffer,
+                             gint             col,
+                             gint             row)
+{
+  MaskTile           *tile = &summary->tiles[row * summary->n_cols + col];
+  GeglBufferIterator *iter;
+  GeglRectangle      *roi;
+  GeglRectangle       rect;
+  gboolean            full = TRUE;
+  gint                tx1, ty1, tx2, ty2;
+
+  rect.x      = col * SUMMARY_TILE_SIZE;
+  rect.y      = row * SUMMARY_TILE_SIZE;
+  rect.width  = MIN (SUMMARY_TILE_SIZE, summary->width  - rect.x);
+  rect.height = MIN (SUMMARY_TILE_SIZE, summary->height - rect.y);
+
+  tx1 = rect.x + rect.width;
+  ty1 = rect.y + rect.height;
+  tx2 = rect.x;
+  ty2 = rect.y;
+
+  iter = gegl_buffer_iterator_new (buffer, &rect, 0, babl_format ("Y float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  roi = &iter->roi[0];
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *data = iter->data[0];
+      gint          y;
+
+      for (y = roi->y; y < roi->y + roi->height; y++, data += roi->width)
+        {
+          gint start = 0;
+          gint end   = roi->width;
+          gint x;
+
+          while (start < end && ! data[start])
+            start++;
+
+          if (start == end)
+            {
+              full = FALSE;
+              continue;
+            }
+
+          while (! data[end - 1])
+            end--;
+
+          if (full)
+            {
+              if (start > 0 || end < roi->width)
+                full = FALSE;
+
+              for (x = start; full && x < end; x++)
+                if (! data[x])
+                  full = FALSE;
+            }
+
+          tx1 = MIN (tx1, roi->x + start);
+          tx2 = MAX (tx2, roi->x + end);
+          ty1 = MIN (ty1, y);
+          ty2 = MAX (ty2, y + 1);
+        }
+    }
+
+  if (tx2 <= tx1)
+    {
+      tile->state = MASK_TILE_EMPTY;
+    }
+  else
+    {
+      tile->state = full ? MASK_TILE_FULL : MASK_TILE_MIXED;
+      tile->x1    = tx1;
+      tile->y1    = ty1;
+      tile->x2    = tx2;
+      tile->y2    = ty2;
+    }
+}
@@ -27,4 +27,25 @@ gboolean   gimp_gegl_mask_bounds   (GeglBuffer *buffer,
 gboolean   gimp_gegl_mask_is_empty (GeglBuffer *buffer);
 
 
+GimpMaskSummary * gimp_mask_summary_new         (void);
+void              gimp_mask_summary_free        (GimpMaskSummary     *summary);
+
+void              gimp_mask_summary_invalidate  (GimpMaskSummary     *summary,
+                                                 const GeglRectangle *rect);
+void              gimp_mask_summary_fill        (GimpMaskSummary     *summary,
+                                                 GeglBuffer          *buffer,
+                                                 gboolean             full);
+
+gboolean          gimp_mask_summary_bounds      (GimpMaskSummary     *summary,
+                                                 GeglBuffer          *buffer,
+                                                 gint                *x1,
+                                                 gint                *y1,
+                                                 gint                *x2,
+                                                 gint                *y2);
+gboolean          gimp_mask_summary_is_empty    (GimpMaskSummary     *summary,
+                                                 GeglBuffer          *buffer);
+
+gint64            gimp_mask_summary_get_memsize (GimpMaskSummary     *summary);
+
+
 #endif /* __GIMP_GEGL_MASK_H__ */
@@ -28,7 +28,8 @@
 #include "operations/operations-types.h"
 
 
-typedef struct _GimpApplicator GimpApplicator;
+typedef struct _GimpApplicator  GimpApplicator;
+typedef struct _GimpMaskSummary GimpMaskSummary;
 
 
 #endif /* __GIMP_GEGL_TYPES_H__ */
@@ -322,7 +322,11 @@ gimp_tile_handler_validate_command (GeglTileSource  *source,
   GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (source);
   gpointer                 retval;
 
-  validate->max_z = MAX (validate->max_z, z);
+  /*  only write when needed, tiles at z == 0 can be read from
+   *  several threads once they are validated
+   */
+  if (z > validate->max_z)
+    validate->max_z = z;
 
   retval = gegl_tile_handler_source_command (source, command, x, y, z, data);
 
@@ -363,6 +367,84 @@ gimp_tile_handler_validate_assign (GimpTileHandlerValidate *validate,
                 "tile-width",  &validate->tile_width,
                 "tile-height", &validate->tile_height,
                 NULL);
+
+  g_object_set_data (G_OBJECT (buffer),
+                     "gimp-tile-handler-validate", validate);
+}
+
+GimpTileHandlerValidate *
+gimp_tile_handler_validate_get_assigned (GeglBuffer *buffer)
+{
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+
+  return g_object_get_data (G_OBJECT (buffer),
+                            "gimp-tile-handler-validate");
+}
+
+/*  Renders all invalid parts of @rect right away.  Reading tiles
+ *  through the handler renders them and changes the dirty region, so
+ *  a buffer must be validated before it can be read from several
+ *  threads.
+ */
+void
+gimp_tile_handler_validate_validate (GimpTileHandlerValidate *validate,
+                                     const GeglRectangle     *rect)
+{
+  GeglTileSource        *source = GEGL_TILE_SOURCE (validate);
+  cairo_region_t        *region;
+  cairo_rectangle_int_t  area;
+  gint                   n_rects;
+  gint                   i;
+
+  g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
+  g_return_if_fail (rect != NULL);
+
+  if (cairo_region_is_empty (validate->dirty_region))
+    return;
+
+  area.x      = rect->x;
+  area.y      = rect->y;
+  area.width  = rect->width;
+  area.height = rect->height;
+
+  region = cairo_region_copy (validate->dirty_region);
+
+  cairo_region_intersect_rectangle (region, &area);
+
+  n_rects = cairo_region_num_rectangles (region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t dirty_rect;
+      gint                  tile_x1;
+      gint                  tile_y1;
+      gint                  tile_x2;
+      gint                  tile_y2;
+      gint                  tile_x;
+      gint                  tile_y;
+
+      cairo_region_get_rectangle (region, i, &dirty_rect);
+
+      tile_x1 = dirty_rect.x / validate->tile_width;
+      tile_y1 = dirty_rect.y / validate->tile_height;
+      tile_x2 = ((dirty_rect.x + dirty_rect.width  - 1) /
+                 validate->tile_width + 1);
+      tile_y2 = ((dirty_rect.y + dirty_rect.height - 1) /
+                 validate->tile_height + 1);
+
+      /*  getting a tile validates it, and keeps it in the cache  */
+      for (tile_y = tile_y1; tile_y < tile_y2; tile_y++)
+        for (tile_x = tile_x1; tile_x < tile_x2; tile_x++)
+          {
+            GeglTile *tile = gegl_tile_source_get_tile (source,
+                                                        tile_x, tile_y, 0);
+
+            if (tile)
+              gegl_tile_unref (tile);
+          }
+    }
+
+  cairo_region_destroy (region);
 }
 
 void
@@ -69,6 +69,12 @@ GeglTileHandler * gimp_tile_handler_validate_new        (GeglNode
 
 void              gimp_tile_handler_validate_assign     (GimpTileHandlerValidate *validate,
                                                          GeglBuffer                *buffer);
+GimpTileHandlerValidate *
+                  gimp_tile_handler_validate_get_assigned
+                                                        (GeglBuffer              *buffer);
+
+void              gimp_tile_handler_validate_validate   (GimpTileHandlerValidate *validate,
+                                                         const GeglRectangle     *rect);
 
 void              gimp_tile_handler_validate_invalidate (GimpTileHandlerValidate *validate,
                                                          gint                     x,
@@ -41,7 +41,8 @@ typedef enum
   GIMP_LOG_RECTANGLE_TOOL     = 1 << 17,
   GIMP_LOG_BRUSH_CACHE        = 1 << 18,
   GIMP_LOG_PROJECTION         = 1 << 19,
-  GIMP_LOG_XCF                = 1 << 20
+  GIMP_LOG_XCF                = 1 << 20,
+  GIMP_LOG_COLOR_LUT          = 1 << 21
 } GimpLogFlags;
 
 
@@ -103,6 +104,7 @@ void   gimp_logv     (GimpLogFlags  flags,
 #define BRUSH_CACHE        GIMP_LOG_BRUSH_CACHE
 #define PROJECTION         GIMP_LOG_PROJECTION
 #define XCF                GIMP_LOG_XCF
+#define COLOR_LUT          GIMP_LOG_COLOR_LUT
 
 #if 0 /* last resort */
 #  define GIMP_LOG /* nothing => no varargs, no log */
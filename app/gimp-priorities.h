@@ -39,5 +39,8 @@
 
 /* #define G_PRIORITY_LOW 300 */
 
+/*  compressing old undo steps can wait for everything else  */
+#define GIMP_PRIORITY_UNDO_COMPRESS_IDLE (G_PRIORITY_LOW + 1)
+
 
 #endif /* __GIMP_PRIORITIES_H__ */
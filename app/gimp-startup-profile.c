@@ -0,0 +1,378 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Records the wall-clock and CPU time spent in the phases of startup,
+ *  and the number and size of the files they read, and writes them to
+ *  a JSON file at exit.  Phases nest, and the numbers of a phase
+ *  include the ones of its sub-phases.  Enabled by --profile-startup,
+ *  all functions do nothing otherwise.  Only use from the main thread.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#ifdef G_OS_WIN32
+#define STRICT
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#include "gimp-startup-profile.h"
+
+
+typedef struct _Phase Phase;
+
+struct _Phase
+{
+  gchar     *name;
+
+  gint64     wall_start;
+  gint64     cpu_start;
+
+  gint64     wall_time;   /*  microseconds  */
+  gint64     cpu_time;    /*  microseconds  */
+
+  guint64    n_files;
+  guint64    n_bytes;
+
+  GPtrArray *children;
+};
+
+
+static gint64  gimp_startup_profile_get_cpu_time (void);
+static void    gimp_startup_profile_append_json_string
+                                                (GString     *string,
+                                                 const gchar *str);
+
+static Phase * gimp_startup_profile_phase_new   (const gchar *name);
+static void    gimp_startup_profile_phase_free  (Phase       *phase);
+static void    gimp_startup_profile_phase_end   (Phase       *phase);
+static void    gimp_startup_profile_phase_write (Phase       *phase,
+                                                 GString     *string,
+                                                 gint         depth);
+
+
+static gchar  *profile_filename = NULL;
+static Phase  *profile_root     = NULL;
+static GSList *profile_stack    = NULL;
+
+
+/*  public functions  */
+
+void
+gimp_startup_profile_init (const gchar *filename)
+{
+  g_return_if_fail (profile_root == NULL);
+
+  if (! filename)
+    return;
+
+  profile_filename = g_strdup (filename);
+  profile_root     = gimp_startup_profile_phase_new (NULL);
+  profile_stack    = g_slist_prepend (NULL, profile_root);
+}
+
+/*  Writes the report and stops profiling.  Phases which are still
+ *  running are ended first.
+ */
+void
+gimp_startup_profile_exit (void)
+{
+  GString *string;
+  GError  *error = NULL;
+
+  if (! profile_root)
+    return;
+
+  while (profile_stack->data != profile_root)
+    gimp_startup_profile_end ();
+
+  string = g_string_new ("{\n");
+
+  g_string_append_printf (string, "  \"version\": \"%s\",\n", GIMP_VERSION);
+  g_string_append (string, "  \"phases\": [");
+
+  gimp_startup_profile_phase_write (profile_root, string, 0);
+
+  g_string_append (string, "\n}\n");
+
+  if (! g_file_set_contents (profile_filename, string->str, string->len,
+                             &error))
+    {
+      g_printerr ("Could not write startup profile: %s\n", error->message);
+      g_clear_error (&error);
+    }
+
+  g_string_free (string, TRUE);
+
+  g_slist_free (profile_stack);
+  profile_stack = NULL;
+
+  gimp_startup_profile_phase_free (profile_root);
+  profile_root = NULL;
+
+  g_free (profile_filename);
+  profile_filename = NULL;
+}
+
+/*  Starts a new phase inside the current one  */
+void
+gimp_startup_profile_begin (const gchar *name)
+{
+  Phase *parent;
+  Phase *phase;
+
+  g_return_if_fail (name != NULL);
+
+  if (! profile_root)
+    return;
+
+  parent = profile_stack->data;
+  phase  = gimp_startup_profile_phase_new (name);
+
+  g_ptr_array_add (parent->children, phase);
+
+  profile_stack = g_slist_prepend (profile_stack, phase);
+}
+
+/*  Ends the phase started by the last unmatched
+ *  gimp_startup_profile_begin()
+ */
+void
+gimp_startup_profile_end (void)
+{
+  Phase *phase;
+
+  if (! profile_root)
+    return;
+
+  phase = profile_stack->data;
+
+  g_return_if_fail (phase != profile_root);
+
+  gimp_startup_profile_phase_end (phase);
+
+  profile_stack = g_slist_delete_link (profile_stack, profile_stack);
+}
+
+/*  Counts a file of @size bytes as read by all running phases  */
+void
+gimp_startup_profile_add_file (guint64 size)
+{
+  GSList *list;
+
+  if (! profile_root)
+    return;
+
+  for (list = profile_stack; list; list = g_slist_next (list))
+    {
+      Phase *phase = list->data;
+
+      phase->n_files++;
+      phase->n_bytes += size;
+    }
+}
+
+
+/*  private functions  */
+
+/*  Returns the user and system CPU time used by the process so far, in
+ *  microseconds.  clock() can't be used, it returns the wall-clock time
+ *  on Windows.
+ */
+static gint64
+gimp_startup_profile_get_cpu_time (void)
+{
+#ifdef G_OS_WIN32
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+
+  if (! GetProcessTimes (GetCurrentProcess (),
+                         &creation_time, &exit_time,
+                         &kernel_time, &user_time))
+    return 0;
+
+  /*  FILETIMEs count 100 nanosecond intervals  */
+  return ((((gint64) kernel_time.dwHighDateTime << 32) +
+           kernel_time.dwLowDateTime +
+           ((gint64) user_time.dwHighDateTime << 32) +
+           user_time.dwLowDateTime) / 10);
+#else
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+  return ((gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+          G_USEC_PER_SEC +
+          usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+/*  Appends @str as a quoted JSON string.  Bytes which are not valid
+ *  UTF-8 are replaced by U+FFFD.
+ */
+static void
+gimp_startup_profile_append_json_string (GString     *string,
+                                         const gchar *str)
+{
+  const gchar *p = str;
+
+  g_string_append_c (string, '"');
+
+  while (*p)
+    {
+      gunichar c = g_utf8_get_char_validated (p, -1);
+
+      if (c == (gunichar) -1 || c == (gunichar) -2)
+        {
+          g_string_append (string, "\\ufffd");
+          p++;
+
+          continue;
+        }
+
+      switch (c)
+        {
+        case '"':  g_string_append (string, "\\\""); break;
+        case '\\': g_string_append (string, "\\\\"); break;
+        case '\b': g_string_append (string, "\\b");  break;
+        case '\f': g_string_append (string, "\\f");  break;
+        case '\n': g_string_append (string, "\\n");  break;
+        case '\r': g_string_append (string, "\\r");  break;
+        case '\t': g_string_append (string, "\\t");  break;
+
+        default:
+          if (c < 0x20)
+            g_string_append_printf (string, "\\u%04x", c);
+          else
+            g_string_append_unichar (string, c);
+          break;
+        }
+
+      p = g_utf8_next_char (p);
+    }
+
+  g_string_append_c (string, '"');
+}
+
+static Phase *
+gimp_startup_profile_phase_new (const gchar *name)
+{
+  Phase *phase = g_slice_new0 (Phase);
+
+  phase->name       = g_strdup (name);
+  phase->wall_start = g_get_monotonic_time ();
+  phase->cpu_start  = gimp_startup_profile_get_cpu_time ();
+  phase->children   = g_ptr_array_new_with_free_func ((GDestroyNotify)
+                                                      gimp_startup_profile_phase_free);
+
+  return phase;
+}
+
+static void
+gimp_startup_profile_phase_free (Phase *phase)
+{
+  g_free (phase->name);
+  g_ptr_array_free (phase->children, TRUE);
+
+  g_slice_free (Phase, phase);
+}
+
+static void
+gimp_startup_profile_phase_end (Phase *phase)
+{
+  phase->wall_time = g_get_monotonic_time () - phase->wall_start;
+  phase->cpu_time  = gimp_startup_profile_get_cpu_time () - phase->cpu_start;
+}
+
+static void
+gimp_startup_profile_phase_write (Phase   *phase,
+                                  GString *string,
+                                  gint     depth)
+{
+  gint i;
+
+  /*  the root phase only holds the list of top-level phases  */
+  if (phase->name)
+    {
+      gchar *indent = g_strnfill (depth * 2, ' ');
+      gchar  wall_time[G_ASCII_DTOSTR_BUF_SIZE];
+      gchar  cpu_time[G_ASCII_DTOSTR_BUF_SIZE];
+
+      /*  the report must not depend on the locale  */
+      g_ascii_formatd (wall_time, sizeof (wall_time), "%.6f",
+                       (gdouble) phase->wall_time / G_USEC_PER_SEC);
+      g_ascii_formatd (cpu_time, sizeof (cpu_time), "%.6f",
+                       (gdouble) phase->cpu_time / G_USEC_PER_SEC);
+
+      g_string_append_printf (string,
+                              "%s{\n"
+                              "%s  \"name\": ",
+                              indent,
+                              indent);
+
+      gimp_startup_profile_append_json_string (string, phase->name);
+
+      g_string_append_printf (string,
+                              ",\n"
+                              "%s  \"wall-time\": %s,\n"
+                              "%s  \"cpu-time\": %s,\n"
+                              "%s  \"files\": %" G_GUINT64_FORMAT ",\n"
+                              "%s  \"bytes\": %" G_GUINT64_FORMAT ",\n"
+                              "%s  \"phases\": [",
+                              indent, wall_time,
+                              indent, cpu_time,
+                              indent, phase->n_files,
+                              indent, phase->n_bytes,
+                              indent);
+
+      g_free (indent);
+    }
+
+  for (i = 0; i < phase->children->len; i++)
+    {
+      g_string_append (string, i == 0 ? "\n" : ",\n");
+
+      gimp_startup_profile_phase_write (g_ptr_array_index (phase->children, i),
+                                        string, depth + 2);
+    }
+
+  if (phase->children->len > 0)
+    {
+      gchar *indent = g_strnfill (depth * 2 + 2, ' ');
+
+      g_string_append_printf (string, "\n%s]", indent);
+
+      g_free (indent);
+    }
+  else
+    {
+      g_string_append (string, "]");
+    }
+
+  if (phase->name)
+    {
+      gchar *indent = g_strnfill (depth * 2, ' ');
+
+      g_string_append_printf (string, "\n%s}", indent);
+
+      g_free (indent);
+    }
+}
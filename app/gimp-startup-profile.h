@@ -0,0 +1,31 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_STARTUP_PROFILE_H__
+#define __GIMP_STARTUP_PROFILE_H__
+
+
+void   gimp_startup_profile_init     (const gchar *filename);
+void   gimp_startup_profile_exit     (void);
+
+void   gimp_startup_profile_begin    (const gchar *name);
+void   gimp_startup_profile_end      (void);
+
+void   gimp_startup_profile_add_file (guint64      size);
+
+
+#endif /* __GIMP_STARTUP_PROFILE_H__ */
@@ -73,6 +73,7 @@
 #endif
 
 #include "gimp-log.h"
+#include "gimp-startup-profile.h"
 #include "gimp-intl.h"
 
 
@@ -131,6 +132,7 @@ static gboolean            use_shm           = FALSE;
 static gboolean            use_cpu_accel     = TRUE;
 static gboolean            console_messages  = FALSE;
 static gboolean            use_debug_handler = FALSE;
+static const gchar        *profile_startup   = NULL;
 
 #ifdef GIMP_UNSTABLE
 static gboolean            show_playground   = TRUE;
@@ -246,6 +248,11 @@ static const GOptionEntry main_entries[] =
     G_OPTION_ARG_NONE, &use_debug_handler,
     N_("Enable non-fatal debugging signal handlers"), NULL
   },
+  {
+    "profile-startup", 0, 0,
+    G_OPTION_ARG_FILENAME, &profile_startup,
+    N_("Write a report about the time spent starting up"), "<filename>"
+  },
   {
     "g-fatal-warnings", 0, G_OPTION_FLAG_NO_ARG,
     G_OPTION_ARG_CALLBACK, gimp_option_fatal_warnings,
@@ -490,6 +497,8 @@ main (int    argc,
   if (user_gimprc)
     user_gimprc_file = g_file_new_for_commandline_arg (user_gimprc);
 
+  gimp_startup_profile_init (profile_startup);
+
   app_run (argv[0],
            filenames,
            system_gimprc_file,
@@ -0,0 +1,291 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationpointlayermode-sse.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Vectorized versions of the separable point layer modes, which all
+ *  share the compositing code of their _core () functions and only
+ *  differ in how a layer pixel is combined with an input pixel.
+ *
+ *  This file is included by gimpoperationpointlayermode-sse2.c and
+ *  gimpoperationpointlayermode-sse4.c, which define:
+ *
+ *  GIMP_LAYER_MODE_SSE_SELECT (mask, a, b):
+ *    picks @a where @mask is set, and @b elsewhere
+ *  GIMP_LAYER_MODE_SSE_FUNCTION (name):
+ *    the name of the process_pixels function of the mode @name
+ */
+
+#ifndef GIMP_LAYER_MODE_SSE_SELECT
+#error "gimpoperationpointlayermode-sse.h must not be included directly"
+#endif
+
+
+typedef __v4sf (* GimpLayerModeSSEFunc) (__v4sf in,
+                                         __v4sf layer);
+
+
+/*  _mm_min_ps (a, b) and _mm_max_ps (a, b) return @b if either operand
+ *  is NaN, just like MIN (a, b) and MAX (a, b).  The operands are
+ *  ordered so that NaN passes through like it does in CLAMP (), and an
+ *  undefined result, like burning 1.0 with 0.0, matches the _core ()
+ *  functions.
+ */
+static inline __v4sf
+gimp_layer_mode_sse_clamp (__v4sf x)
+{
+  return _mm_max_ps (_mm_setzero_ps (), _mm_min_ps (_mm_set1_ps (1.0f), x));
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_multiply (__v4sf in,
+                              __v4sf layer)
+{
+  return gimp_layer_mode_sse_clamp (layer * in);
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_screen (__v4sf in,
+                            __v4sf layer)
+{
+  const __v4sf one = _mm_set1_ps (1.0f);
+
+  return one - (one - in) * (one - layer);
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_overlay (__v4sf in,
+                             __v4sf layer)
+{
+  const __v4sf one  = _mm_set1_ps (1.0f);
+  const __v4sf half = _mm_set1_ps (0.5f);
+  const __v4sf two  = _mm_set1_ps (2.0f);
+
+  return GIMP_LAYER_MODE_SSE_SELECT (_mm_cmplt_ps (in, half),
+                                     two * in * layer,
+                                     one - two * (one - layer) * (one - in));
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_difference (__v4sf in,
+                                __v4sf layer)
+{
+  return _mm_andnot_ps (_mm_set1_ps (-0.0f), in - layer);
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_addition (__v4sf in,
+                              __v4sf layer)
+{
+  return gimp_layer_mode_sse_clamp (in + layer);
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_subtract (__v4sf in,
+                              __v4sf layer)
+{
+  return _mm_max_ps (_mm_setzero_ps (), in - layer);
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_darken_only (__v4sf in,
+                                 __v4sf layer)
+{
+  return _mm_min_ps (in, layer);
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_lighten_only (__v4sf in,
+                                  __v4sf layer)
+{
+  return _mm_max_ps (layer, in);
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_divide (__v4sf in,
+                            __v4sf layer)
+{
+  const __v4sf scale = _mm_set1_ps (4294967296.0 / 4294967295.0);
+  const __v4sf eps   = _mm_set1_ps (1.0 / 4294967295.0);
+
+  return gimp_layer_mode_sse_clamp ((scale * in) / (eps + layer));
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_dodge (__v4sf in,
+                           __v4sf layer)
+{
+  const __v4sf one = _mm_set1_ps (1.0f);
+
+  return _mm_min_ps (in / (one - layer), one);
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_burn (__v4sf in,
+                          __v4sf layer)
+{
+  const __v4sf one = _mm_set1_ps (1.0f);
+
+  return gimp_layer_mode_sse_clamp (one - (one - in) / layer);
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_hardlight (__v4sf in,
+                               __v4sf layer)
+{
+  const __v4sf one  = _mm_set1_ps (1.0f);
+  const __v4sf half = _mm_set1_ps (0.5f);
+  const __v4sf two  = _mm_set1_ps (2.0f);
+
+  return GIMP_LAYER_MODE_SSE_SELECT (_mm_cmpgt_ps (layer, half),
+                                     _mm_min_ps (one - (one - in) *
+                                                 (one - (layer - half) * two),
+                                                 one),
+                                     _mm_min_ps (in * (layer * two), one));
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_softlight (__v4sf in,
+                               __v4sf layer)
+{
+  const __v4sf one      = _mm_set1_ps (1.0f);
+  const __v4sf multiply = in * layer;
+  const __v4sf screen   = one - (one - in) * (one - layer);
+
+  return (one - in) * multiply + in * screen;
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_grain_extract (__v4sf in,
+                                   __v4sf layer)
+{
+  return gimp_layer_mode_sse_clamp (in - layer + _mm_set1_ps (0.5f));
+}
+
+static inline __v4sf
+gimp_layer_mode_sse_grain_merge (__v4sf in,
+                                 __v4sf layer)
+{
+  return gimp_layer_mode_sse_clamp (in + layer - _mm_set1_ps (0.5f));
+}
+
+static inline __attribute__ ((always_inline)) gboolean
+gimp_layer_mode_sse_process_pixels (gfloat                *in,
+                                    gfloat                *layer,
+                                    gfloat                *mask,
+                                    gfloat                *out,
+                                    gfloat                 opacity,
+                                    glong                  samples,
+                                    const GeglRectangle   *roi,
+                                    gint                   level,
+                                    GimpLayerModeSSEFunc   blend_func,
+                                    GimpLayerModeFunction  core_func)
+{
+  /* check alignment */
+  if ((((uintptr_t) in) | ((uintptr_t) layer) | ((uintptr_t) out)) & 0x0F)
+    {
+      return core_func (in, layer, mask, out, opacity, samples, roi, level);
+    }
+  else
+    {
+      const __v4sf *v_in    = (const __v4sf *) in;
+      const __v4sf *v_layer = (const __v4sf *) layer;
+            __v4sf *v_out   = (      __v4sf *) out;
+
+      const __v4sf one        = _mm_set1_ps (1.0f);
+      const __v4sf zero       = _mm_setzero_ps ();
+      const __v4sf v_opacity  = _mm_set1_ps (opacity);
+      const __v4sf alpha_mask = (__v4sf) _mm_set_epi32 (-1, 0, 0, 0);
+
+      while (samples--)
+        {
+          __v4sf rgba_in, rgba_layer;
+          __v4sf in_alpha, comp_alpha, new_alpha, ratio;
+          __v4sf comp, out_pixel, composited;
+
+          rgba_in    = *v_in++;
+          rgba_layer = *v_layer++;
+
+          /* expand alpha */
+          in_alpha   = _mm_shuffle_ps (rgba_in, rgba_in,
+                                       _MM_SHUFFLE (3, 3, 3, 3));
+          comp_alpha = _mm_shuffle_ps (rgba_layer, rgba_layer,
+                                       _MM_SHUFFLE (3, 3, 3, 3));
+
+          comp_alpha = _mm_min_ps (in_alpha, comp_alpha) * v_opacity;
+
+          if (mask)
+            comp_alpha = comp_alpha * _mm_set1_ps (*mask++);
+
+          new_alpha = in_alpha + (one - in_alpha) * comp_alpha;
+
+          ratio = comp_alpha / new_alpha;
+
+          comp = blend_func (rgba_in, rgba_layer);
+
+          out_pixel = comp * ratio + rgba_in * (one - ratio);
+
+          /* keep the input pixel where nothing is composited, and
+           * always keep the input's alpha
+           */
+          composited = _mm_and_ps (_mm_cmpneq_ps (comp_alpha, zero),
+                                   _mm_cmpneq_ps (new_alpha,  zero));
+          composited = _mm_andnot_ps (alpha_mask, composited);
+
+          *v_out++ = GIMP_LAYER_MODE_SSE_SELECT (composited,
+                                                 out_pixel, rgba_in);
+        }
+    }
+
+  return TRUE;
+}
+
+
+#define GIMP_LAYER_MODE_SSE_DEFINE(name)                                    \
+gboolean                                                                    \
+GIMP_LAYER_MODE_SSE_FUNCTION (name) (gfloat              *in,               \
+                                     gfloat              *layer,            \
+                                     gfloat              *mask,             \
+                                     gfloat              *out,              \
+                                     gfloat               opacity,          \
+                                     glong                samples,          \
+                                     const GeglRectangle *roi,              \
+                                     gint                 level)            \
+{                                                                           \
+  return gimp_layer_mode_sse_process_pixels                                 \
+    (in, layer, mask, out, opacity, samples, roi, level,                    \
+     gimp_layer_mode_sse_##name,                                            \
+     gimp_operation_##name##_mode_process_pixels_core);                     \
+}
+
+GIMP_LAYER_MODE_SSE_DEFINE (multiply)
+GIMP_LAYER_MODE_SSE_DEFINE (screen)
+GIMP_LAYER_MODE_SSE_DEFINE (overlay)
+GIMP_LAYER_MODE_SSE_DEFINE (difference)
+GIMP_LAYER_MODE_SSE_DEFINE (addition)
+GIMP_LAYER_MODE_SSE_DEFINE (subtract)
+GIMP_LAYER_MODE_SSE_DEFINE (darken_only)
+GIMP_LAYER_MODE_SSE_DEFINE (lighten_only)
+GIMP_LAYER_MODE_SSE_DEFINE (divide)
+GIMP_LAYER_MODE_SSE_DEFINE (dodge)
+GIMP_LAYER_MODE_SSE_DEFINE (burn)
+GIMP_LAYER_MODE_SSE_DEFINE (hardlight)
+GIMP_LAYER_MODE_SSE_DEFINE (softlight)
+GIMP_LAYER_MODE_SSE_DEFINE (grain_extract)
+GIMP_LAYER_MODE_SSE_DEFINE (grain_merge)
+
+#undef GIMP_LAYER_MODE_SSE_DEFINE
@@ -0,0 +1,400 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Measures the throughput of all gimp:*-mode operations and of the
+ *  point filters, at several buffer sizes and formats.
+ *
+ *  The results are printed as tab separated values, one line per
+ *  measurement, so that the output of two builds can be compared with
+ *  standard tools:
+ *
+ *    operation  format  size  mask  opacity  mpixels-per-second
+ *
+ *  Lines starting with '#' are comments.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "operations/operations-types.h"
+
+#include "operations/gimp-operations.h"
+#include "operations/gimpcolorizeconfig.h"
+#include "operations/gimpcurvesconfig.h"
+#include "operations/gimphuesaturationconfig.h"
+#include "operations/gimplevelsconfig.h"
+#include "operations/gimpthresholdconfig.h"
+
+
+typedef struct
+{
+  const gchar *operation;
+  GType      (*config_type) (void);
+} PointFilter;
+
+
+static const PointFilter point_filters[] =
+{
+  { "gimp:curves",         gimp_curves_config_get_type         },
+  { "gimp:levels",         gimp_levels_config_get_type         },
+  { "gimp:hue-saturation", gimp_hue_saturation_config_get_type },
+  { "gimp:colorize",       gimp_colorize_config_get_type       },
+  { "gimp:threshold",      gimp_threshold_config_get_type      }
+};
+
+static const gchar *formats[] =
+{
+  "R'G'B'A u8",
+  "RGBA u16",
+  "RGBA float"
+};
+
+static const gint sizes[] =
+{
+  64,
+  512,
+  2048
+};
+
+
+static gdouble  min_time  = 0.5;
+static gchar   *filter    = NULL;
+
+static const GOptionEntry entries[] =
+{
+  {
+    "time", 't', 0,
+    G_OPTION_ARG_DOUBLE, &min_time,
+    "Minimal time in seconds for each measurement (default 0.5)", "SECONDS"
+  },
+  {
+    "filter", 'f', 0,
+    G_OPTION_ARG_STRING, &filter,
+    "Only run operations whose name contains STRING", "STRING"
+  },
+  { NULL }
+};
+
+
+static GeglBuffer *
+create_buffer (const Babl *format,
+               gint        size,
+               guint32     seed)
+{
+  GeglBuffer         *buffer;
+  GeglBufferIterator *iter;
+  GRand              *rand;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, size, size),
+                            babl_format ("RGBA float"));
+
+  rand = g_rand_new_with_seed (seed);
+
+  iter = gegl_buffer_iterator_new (buffer, NULL, 0, NULL,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gfloat *data = iter->data[0];
+      gint    n    = iter->length * 4;
+
+      while (n--)
+        *data++ = g_rand_double (rand);
+    }
+
+  g_rand_free (rand);
+
+  if (format != babl_format ("RGBA float"))
+    {
+      GeglBuffer *converted;
+
+      converted = gegl_buffer_new (GEGL_RECTANGLE (0, 0, size, size), format);
+      gegl_buffer_copy (buffer, NULL, GEGL_ABYSS_NONE, converted, NULL);
+
+      g_object_unref (buffer);
+      buffer = converted;
+    }
+
+  return buffer;
+}
+
+static GeglNode *
+add_source (GeglNode   *graph,
+            GeglBuffer *buffer)
+{
+  return gegl_node_new_child (graph,
+                              "operation",  "gegl:buffer-source",
+                              "buffer",     buffer,
+                              "dont-cache", TRUE,
+                              NULL);
+}
+
+/*  Returns the throughput of @node in Mpixels/s  */
+static gdouble
+measure (GeglNode   *node,
+         GeglBuffer *output)
+{
+  const GeglRectangle *rect = gegl_buffer_get_extent (output);
+  GTimer              *timer;
+  gint                 n_runs = 0;
+  gdouble              elapsed;
+
+  /*  warm up, this also creates the operation's lookup tables  */
+  gegl_node_blit_buffer (node, output, rect);
+
+  timer = g_timer_new ();
+
+  do
+    {
+      gegl_node_blit_buffer (node, output, rect);
+      n_runs++;
+
+      elapsed = g_timer_elapsed (timer, NULL);
+    }
+  while (elapsed < min_time);
+
+  g_timer_destroy (timer);
+
+  return (gdouble) rect->width * rect->height * n_runs / elapsed / 1e6;
+}
+
+static void
+report (const gchar *operation,
+        const gchar *format,
+        gint         size,
+        const gchar *mask,
+        const gchar *opacity,
+        gdouble      mpixels)
+{
+  g_print ("%s\t%s\t%dx%d\t%s\t%s\t%.2f\n",
+           operation, format, size, size, mask, opacity, mpixels);
+}
+
+static void
+benchmark_layer_mode (const gchar *operation,
+                      const gchar *format_name,
+                      gint         size)
+{
+  const Babl *format = babl_format (format_name);
+  GeglBuffer *input  = create_buffer (format, size, 1);
+  GeglBuffer *layer  = create_buffer (format, size, 2);
+  GeglBuffer *mask   = create_buffer (babl_format ("Y float"), size, 3);
+  GeglBuffer *output;
+  GeglNode   *graph;
+  GeglNode   *node;
+  gint        use_mask;
+
+  output = gegl_buffer_new (gegl_buffer_get_extent (input), format);
+
+  graph = gegl_node_new ();
+
+  node = gegl_node_new_child (graph,
+                              "operation",  operation,
+                              "dont-cache", TRUE,
+                              NULL);
+
+  gegl_node_connect_to (add_source (graph, input), "output", node, "input");
+  gegl_node_connect_to (add_source (graph, layer), "output", node, "aux");
+
+  for (use_mask = FALSE; use_mask <= TRUE; use_mask++)
+    {
+      if (use_mask)
+        gegl_node_connect_to (add_source (graph, mask), "output",
+                              node, "aux2");
+
+      gegl_node_set (node, "opacity", 1.0, NULL);
+      report (operation, format_name, size,
+              use_mask ? "mask" : "-", "1.0",
+              measure (node, output));
+
+      gegl_node_set (node, "opacity", 0.5, NULL);
+      report (operation, format_name, size,
+              use_mask ? "mask" : "-", "0.5",
+              measure (node, output));
+    }
+
+  g_object_unref (graph);
+  g_object_unref (output);
+  g_object_unref (mask);
+  g_object_unref (layer);
+  g_object_unref (input);
+}
+
+static void
+benchmark_point_filter (const PointFilter *filter,
+                        const gchar       *format_name,
+                        gint               size)
+{
+  const Babl *format = babl_format (format_name);
+  GeglBuffer *input  = create_buffer (format, size, 1);
+  GeglBuffer *output;
+  GeglNode   *graph;
+  GeglNode   *node;
+  GObject    *config;
+
+  output = gegl_buffer_new (gegl_buffer_get_extent (input), format);
+
+  /*  use settings which are not the identity, in case an operation
+   *  special cases them
+   */
+  if (filter->config_type == gimp_curves_config_get_type)
+    {
+      gdouble samples[256];
+      gint    i;
+
+      for (i = 0; i < G_N_ELEMENTS (samples); i++)
+        {
+          gdouble x = (gdouble) i / (G_N_ELEMENTS (samples) - 1);
+
+          samples[i] = x * (2.0 - x);
+        }
+
+      config = gimp_curves_config_new_explicit (GIMP_HISTOGRAM_VALUE,
+                                                samples,
+                                                G_N_ELEMENTS (samples));
+    }
+  else
+    {
+      config = g_object_new (filter->config_type (), NULL);
+    }
+
+  if (GIMP_IS_LEVELS_CONFIG (config))
+    g_object_set (config, "gamma", 1.5, NULL);
+  else if (GIMP_IS_HUE_SATURATION_CONFIG (config))
+    g_object_set (config, "hue", 0.2, "saturation", 0.3, NULL);
+  else if (GIMP_IS_COLORIZE_CONFIG (config))
+    g_object_set (config,
+                  "hue",        0.7,
+                  "saturation", 0.8,
+                  "lightness",  0.2,
+                  NULL);
+  else if (GIMP_IS_THRESHOLD_CONFIG (config))
+    g_object_set (config, "low", 0.3, "high", 0.7, NULL);
+
+  graph = gegl_node_new ();
+
+  node = gegl_node_new_child (graph,
+                              "operation",  filter->operation,
+                              "config",     config,
+                              "dont-cache", TRUE,
+                              NULL);
+
+  gegl_node_connect_to (add_source (graph, input), "output", node, "input");
+
+  report (filter->operation, format_name, size, "-", "-",
+          measure (node, output));
+
+  g_object_unref (graph);
+  g_object_unref (config);
+  g_object_unref (output);
+  g_object_unref (input);
+}
+
+static gint
+compare_strings (gconstpointer a,
+                 gconstpointer b)
+{
+  return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GOptionContext  *context;
+  GError          *error = NULL;
+  gchar          **operations;
+  guint            n_operations;
+  GPtrArray       *layer_modes;
+  gint             i, j, k;
+
+  context = g_option_context_new (NULL);
+  g_option_context_set_summary (context,
+                                "Measures the throughput of the layer modes "
+                                "and point filters in Mpixels/s.");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, gegl_get_option_group ());
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+
+      return 1;
+    }
+
+  g_option_context_free (context);
+
+  gegl_init (&argc, &argv);
+  gimp_operations_init ();
+
+  layer_modes = g_ptr_array_new ();
+
+  operations = gegl_list_operations (&n_operations);
+
+  for (i = 0; i < n_operations; i++)
+    {
+      if (g_str_has_prefix (operations[i], "gimp:") &&
+          g_str_has_suffix (operations[i], "-mode"))
+        {
+          g_ptr_array_add (layer_modes, operations[i]);
+        }
+    }
+
+  g_ptr_array_sort (layer_modes, compare_strings);
+
+  g_print ("# GIMP %s, GEGL %d.%d.%d, babl %d.%d.%d\n",
+           GIMP_VERSION,
+           GEGL_MAJOR_VERSION, GEGL_MINOR_VERSION, GEGL_MICRO_VERSION,
+           BABL_MAJOR_VERSION, BABL_MINOR_VERSION, BABL_MICRO_VERSION);
+  g_print ("# operation\tformat\tsize\tmask\topacity\tmpixels-per-second\n");
+
+  for (i = 0; i < layer_modes->len; i++)
+    {
+      const gchar *operation = g_ptr_array_index (layer_modes, i);
+
+      if (filter && ! strstr (operation, filter))
+        continue;
+
+      for (j = 0; j < G_N_ELEMENTS (formats); j++)
+        for (k = 0; k < G_N_ELEMENTS (sizes); k++)
+          benchmark_layer_mode (operation, formats[j], sizes[k]);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (point_filters); i++)
+    {
+      if (filter && ! strstr (point_filters[i].operation, filter))
+        continue;
+
+      for (j = 0; j < G_N_ELEMENTS (formats); j++)
+        for (k = 0; k < G_N_ELEMENTS (sizes); k++)
+          benchmark_point_filter (&point_filters[i], formats[j], sizes[k]);
+    }
+
+  g_ptr_array_free (layer_modes, TRUE);
+  g_free (operations);
+
+  gegl_exit ();
+
+  return 0;
+}
@@ -0,0 +1,219 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Checks the vectorized layer mode functions against the scalar
+ *  _core () versions.
+ */
+
+#include "config.h"
+
+#include <math.h>
+
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "operations/operations-types.h"
+
+#include "operations/gimpoperationmultiplymode.h"
+#include "operations/gimpoperationscreenmode.h"
+#include "operations/gimpoperationoverlaymode.h"
+#include "operations/gimpoperationdifferencemode.h"
+#include "operations/gimpoperationadditionmode.h"
+#include "operations/gimpoperationsubtractmode.h"
+#include "operations/gimpoperationdarkenonlymode.h"
+#include "operations/gimpoperationlightenonlymode.h"
+#include "operations/gimpoperationdividemode.h"
+#include "operations/gimpoperationdodgemode.h"
+#include "operations/gimpoperationburnmode.h"
+#include "operations/gimpoperationhardlightmode.h"
+#include "operations/gimpoperationsoftlightmode.h"
+#include "operations/gimpoperationgrainextractmode.h"
+#include "operations/gimpoperationgrainmergemode.h"
+
+
+#define N_PIXELS  4099
+#define EPSILON   1e-5
+
+
+typedef struct
+{
+  const gchar           *name;
+  GimpLayerModeFunction  core;
+  GimpLayerModeFunction  sse2;
+  GimpLayerModeFunction  sse4;
+} LayerMode;
+
+#if COMPILE_SSE2_INTRINISICS
+#define SSE2_FUNC(name) gimp_operation_##name##_mode_process_pixels_sse2
+#else
+#define SSE2_FUNC(name) NULL
+#endif
+
+#if COMPILE_SSE4_1_INTRINISICS
+#define SSE4_FUNC(name) gimp_operation_##name##_mode_process_pixels_sse4
+#else
+#define SSE4_FUNC(name) NULL
+#endif
+
+#define LAYER_MODE(name)                                  \
+  { #name,                                                \
+    gimp_operation_##name##_mode_process_pixels_core,     \
+    SSE2_FUNC (name),                                     \
+    SSE4_FUNC (name) }
+
+static const LayerMode layer_modes[] =
+{
+  LAYER_MODE (multiply),
+  LAYER_MODE (screen),
+  LAYER_MODE (overlay),
+  LAYER_MODE (difference),
+  LAYER_MODE (addition),
+  LAYER_MODE (subtract),
+  LAYER_MODE (darken_only),
+  LAYER_MODE (lighten_only),
+  LAYER_MODE (divide),
+  LAYER_MODE (dodge),
+  LAYER_MODE (burn),
+  LAYER_MODE (hardlight),
+  LAYER_MODE (softlight),
+  LAYER_MODE (grain_extract),
+  LAYER_MODE (grain_merge)
+};
+
+
+static gfloat *
+random_pixels (GRand *rand,
+               gint   n_values)
+{
+  gfloat *pixels = g_malloc (n_values * sizeof (gfloat));
+  gint    i;
+
+  for (i = 0; i < n_values; i++)
+    {
+      /*  include the edge values, they are special cased by some modes  */
+      switch (g_rand_int_range (rand, 0, 8))
+        {
+        case 0:  pixels[i] = 0.0; break;
+        case 1:  pixels[i] = 1.0; break;
+        case 2:  pixels[i] = 0.5; break;
+        default: pixels[i] = g_rand_double (rand); break;
+        }
+    }
+
+  return pixels;
+}
+
+static void
+compare_layer_mode (GimpLayerModeFunction  core,
+                    GimpLayerModeFunction  simd,
+                    gboolean               use_mask,
+                    gfloat                 opacity)
+{
+  GRand  *rand  = g_rand_new_with_seed (4711);
+  gfloat *in    = random_pixels (rand, N_PIXELS * 4);
+  gfloat *layer = random_pixels (rand, N_PIXELS * 4);
+  gfloat *mask  = use_mask ? random_pixels (rand, N_PIXELS) : NULL;
+  gfloat *out1  = g_new (gfloat, N_PIXELS * 4);
+  gfloat *out2  = g_new (gfloat, N_PIXELS * 4);
+  gint    i;
+
+  core (in, layer, mask, out1, opacity, N_PIXELS,
+        GEGL_RECTANGLE (0, 0, N_PIXELS, 1), 0);
+  simd (in, layer, mask, out2, opacity, N_PIXELS,
+        GEGL_RECTANGLE (0, 0, N_PIXELS, 1), 0);
+
+  for (i = 0; i < N_PIXELS * 4; i++)
+    {
+      gboolean equal;
+
+      /*  some undefined inputs, like burning 1.0 with 0.0, produce NaN,
+       *  the vectorized code must not clamp those to a number
+       */
+      if (isnan (out1[i]) || isnan (out2[i]))
+        equal = isnan (out1[i]) && isnan (out2[i]);
+      else
+        equal = fabs (out1[i] - out2[i]) <= EPSILON;
+
+      if (! equal)
+        {
+          g_error ("pixel %d, component %d: expected %f, got %f "
+                   "(in %f, layer %f)",
+                   i / 4, i % 4, out1[i], out2[i], in[i], layer[i]);
+        }
+    }
+
+  g_free (out2);
+  g_free (out1);
+  g_free (mask);
+  g_free (layer);
+  g_free (in);
+  g_rand_free (rand);
+}
+
+static void
+test_layer_mode (gconstpointer data)
+{
+  const LayerMode       *mode = data;
+  GimpCpuAccelFlags      accel;
+  GimpLayerModeFunction  funcs[2];
+  gint                   n_funcs = 0;
+  gint                   i;
+
+  accel = gimp_cpu_accel_get_support ();
+
+  if (mode->sse2 && (accel & GIMP_CPU_ACCEL_X86_SSE2))
+    funcs[n_funcs++] = mode->sse2;
+
+  if (mode->sse4 && (accel & GIMP_CPU_ACCEL_X86_SSE4_1))
+    funcs[n_funcs++] = mode->sse4;
+
+  if (n_funcs == 0)
+    {
+      g_test_message ("no vectorized layer modes on this CPU, skipping");
+      return;
+    }
+
+  for (i = 0; i < n_funcs; i++)
+    {
+      compare_layer_mode (mode->core, funcs[i], FALSE, 1.0);
+      compare_layer_mode (mode->core, funcs[i], FALSE, 0.3);
+      compare_layer_mode (mode->core, funcs[i], TRUE,  1.0);
+      compare_layer_mode (mode->core, funcs[i], TRUE,  0.7);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gint i;
+
+  g_test_init (&argc, &argv, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (layer_modes); i++)
+    {
+      gchar *path = g_strdup_printf ("/layer-modes/%s", layer_modes[i].name);
+
+      g_test_add_data_func (path, &layer_modes[i], test_layer_mode);
+
+      g_free (path);
+    }
+
+  return g_test_run ();
+}
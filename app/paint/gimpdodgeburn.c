@@ -118,6 +118,7 @@ gimp_dodge_burn_motion (GimpPaintCore    *paint_core,
   GeglBuffer           *paint_buffer;
   gint                  paint_buffer_x;
   gint                  paint_buffer_y;
+  GeglRectangle         paint_rect;
   gdouble               fade_point;
   gdouble               opacity;
   gdouble               force;
@@ -140,12 +141,15 @@ gimp_dodge_burn_motion (GimpPaintCore    *paint_core,
   if (! paint_buffer)
     return;
 
+  paint_rect = *GEGL_RECTANGLE (paint_buffer_x,
+                                paint_buffer_y,
+                                gegl_buffer_get_width  (paint_buffer),
+                                gegl_buffer_get_height (paint_buffer));
+
   /*  DodgeBurn the region  */
-  gimp_gegl_dodgeburn (gimp_paint_core_get_orig_image (paint_core),
-                       GEGL_RECTANGLE (paint_buffer_x,
-                                       paint_buffer_y,
-                                       gegl_buffer_get_width  (paint_buffer),
-                                       gegl_buffer_get_height (paint_buffer)),
+  gimp_gegl_dodgeburn (gimp_paint_core_get_orig_image (paint_core, drawable,
+                                                       &paint_rect),
+                       &paint_rect,
                        paint_buffer,
                        GEGL_RECTANGLE (0, 0, 0, 0),
                        options->exposure / 100.0,
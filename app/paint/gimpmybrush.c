@@ -239,6 +239,9 @@ gimp_mybrush_motion (GimpPaintCore    *paint_core,
 
       src = mypaint_gegl_tiled_surface_get_buffer (mybrush->private->surface);
 
+      gimp_paint_core_save_orig (paint_core, drawable,
+                                 (GeglRectangle *) &rect);
+
       gegl_buffer_copy (src,
                         (GeglRectangle *) &rect,
                         GEGL_ABYSS_NONE,
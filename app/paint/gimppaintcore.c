@@ -109,6 +109,17 @@ static GimpUndo* gimp_paint_core_real_push_undo      (GimpPaintCore    *core,
                                                       GimpImage        *image,
                                                       const gchar      *undo_desc);
 
+static void      gimp_paint_core_get_tile_grid  (GeglBuffer          *buffer,
+                                                 gint                *tile_width,
+                                                 gint                *tile_height,
+                                                 gint                *n_tiles_x,
+                                                 gint                *n_tiles_y);
+static guint8  * gimp_paint_core_tiles_new      (GeglBuffer          *buffer);
+static void      gimp_paint_core_save_tiles     (GeglBuffer          *src_buffer,
+                                                 GeglBuffer          *dest_buffer,
+                                                 guint8              *tiles,
+                                                 const GeglRectangle *area);
+
 
 G_DEFINE_TYPE (GimpPaintCore, gimp_paint_core, GIMP_TYPE_OBJECT)
 
@@ -366,11 +377,21 @@ gimp_paint_core_start (GimpPaintCore     *core,
       return FALSE;
     }
 
-  /*  Allocate the undo structure  */
+  /*  Allocate the undo structure, its tiles are copied from the
+   *  drawable only when they are about to be modified, see
+   *  gimp_paint_core_save_orig()
+   */
   if (core->undo_buffer)
     g_object_unref (core->undo_buffer);
 
-  core->undo_buffer = gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
+  core->undo_buffer =
+    gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                     gimp_item_get_width  (item),
+                                     gimp_item_get_height (item)),
+                     gimp_drawable_get_format (drawable));
+
+  g_free (core->undo_tiles);
+  core->undo_tiles = gimp_paint_core_tiles_new (core->undo_buffer);
 
   /*  Allocate the saved proj structure  */
   if (core->saved_proj_buffer)
@@ -379,11 +400,19 @@ gimp_paint_core_start (GimpPaintCore     *core,
       core->saved_proj_buffer = NULL;
     }
 
+  g_free (core->saved_proj_tiles);
+  core->saved_proj_tiles = NULL;
+
   if (core->use_saved_proj)
     {
       GeglBuffer *buffer = gimp_pickable_get_buffer (GIMP_PICKABLE (image));
 
-      core->saved_proj_buffer = gegl_buffer_dup (buffer);
+      core->saved_proj_buffer =
+        gegl_buffer_new (gegl_buffer_get_extent (buffer),
+                         gegl_buffer_get_format (buffer));
+
+      core->saved_proj_tiles =
+        gimp_paint_core_tiles_new (core->saved_proj_buffer);
     }
 
   /*  Allocate the canvas blocks structure  */
@@ -543,6 +572,11 @@ gimp_paint_core_finish (GimpPaintCore *core,
       buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
                                 gimp_drawable_get_format (drawable));
 
+      /*  the tiles which were not saved are still unmodified  */
+      gimp_paint_core_save_tiles (gimp_drawable_get_buffer (drawable),
+                                  core->undo_buffer, core->undo_tiles,
+                                  GEGL_RECTANGLE (x, y, width, height));
+
       gegl_buffer_copy (core->undo_buffer,
                         GEGL_RECTANGLE (x, y, width, height),
                         GEGL_ABYSS_NONE,
@@ -560,12 +594,18 @@ gimp_paint_core_finish (GimpPaintCore *core,
   g_object_unref (core->undo_buffer);
   core->undo_buffer = NULL;
 
+  g_free (core->undo_tiles);
+  core->undo_tiles = NULL;
+
   if (core->saved_proj_buffer)
     {
       g_object_unref (core->saved_proj_buffer);
       core->saved_proj_buffer = NULL;
     }
 
+  g_free (core->saved_proj_tiles);
+  core->saved_proj_tiles = NULL;
+
   gimp_viewable_preview_thaw (GIMP_VIEWABLE (drawable));
 }
 
@@ -594,6 +634,10 @@ gimp_paint_core_cancel (GimpPaintCore *core,
                                 gimp_item_get_height (GIMP_ITEM (drawable)),
                                 &x, &y, &width, &height))
     {
+      gimp_paint_core_save_tiles (gimp_drawable_get_buffer (drawable),
+                                  core->undo_buffer, core->undo_tiles,
+                                  GEGL_RECTANGLE (x, y, width, height));
+
       gegl_buffer_copy (core->undo_buffer,
                         GEGL_RECTANGLE (x, y, width, height),
                         GEGL_ABYSS_NONE,
@@ -604,12 +648,18 @@ gimp_paint_core_cancel (GimpPaintCore *core,
   g_object_unref (core->undo_buffer);
   core->undo_buffer = NULL;
 
+  g_free (core->undo_tiles);
+  core->undo_tiles = NULL;
+
   if (core->saved_proj_buffer)
     {
       g_object_unref (core->saved_proj_buffer);
       core->saved_proj_buffer = NULL;
     }
 
+  g_free (core->saved_proj_tiles);
+  core->saved_proj_tiles = NULL;
+
   gimp_drawable_update (drawable, x, y, width, height);
 
   gimp_viewable_preview_thaw (GIMP_VIEWABLE (drawable));
@@ -626,12 +676,18 @@ gimp_paint_core_cleanup (GimpPaintCore *core)
       core->undo_buffer = NULL;
     }
 
+  g_free (core->undo_tiles);
+  core->undo_tiles = NULL;
+
   if (core->saved_proj_buffer)
     {
       g_object_unref (core->saved_proj_buffer);
       core->saved_proj_buffer = NULL;
     }
 
+  g_free (core->saved_proj_tiles);
+  core->saved_proj_tiles = NULL;
+
   if (core->canvas_buffer)
     {
       g_object_unref (core->canvas_buffer);
@@ -774,24 +830,87 @@ gimp_paint_core_get_paint_buffer (GimpPaintCore    *core,
   return paint_buffer;
 }
 
+/*  Returns the drawable's pixels as they were when the stroke started.
+ *  Only @area (in drawable coordinates, or everything if %NULL) is
+ *  guaranteed to be valid in the returned buffer.
+ */
 GeglBuffer *
-gimp_paint_core_get_orig_image (GimpPaintCore *core)
+gimp_paint_core_get_orig_image (GimpPaintCore       *core,
+                                GimpDrawable        *drawable,
+                                const GeglRectangle *area)
 {
   g_return_val_if_fail (GIMP_IS_PAINT_CORE (core), NULL);
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
   g_return_val_if_fail (core->undo_buffer != NULL, NULL);
 
+  gimp_paint_core_save_tiles (gimp_drawable_get_buffer (drawable),
+                              core->undo_buffer, core->undo_tiles,
+                              area);
+
   return core->undo_buffer;
 }
 
+/*  Same as above for the image projection, @area is in image
+ *  coordinates.
+ */
 GeglBuffer *
-gimp_paint_core_get_orig_proj (GimpPaintCore *core)
+gimp_paint_core_get_orig_proj (GimpPaintCore       *core,
+                               GimpDrawable        *drawable,
+                               const GeglRectangle *area)
 {
+  GimpImage *image;
+
   g_return_val_if_fail (GIMP_IS_PAINT_CORE (core), NULL);
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
   g_return_val_if_fail (core->saved_proj_buffer != NULL, NULL);
 
+  image = gimp_item_get_image (GIMP_ITEM (drawable));
+
+  gimp_paint_core_save_tiles (gimp_pickable_get_buffer (GIMP_PICKABLE (image)),
+                              core->saved_proj_buffer, core->saved_proj_tiles,
+                              area);
+
   return core->saved_proj_buffer;
 }
 
+/*  Must be called before @area of the drawable is modified during a
+ *  stroke, it saves the drawable's and the projection's tiles under
+ *  @area for undo, unless they were saved before.
+ */
+void
+gimp_paint_core_save_orig (GimpPaintCore       *core,
+                           GimpDrawable        *drawable,
+                           const GeglRectangle *area)
+{
+  g_return_if_fail (GIMP_IS_PAINT_CORE (core));
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+  g_return_if_fail (core->undo_buffer != NULL);
+  g_return_if_fail (area != NULL);
+
+  gimp_paint_core_save_tiles (gimp_drawable_get_buffer (drawable),
+                              core->undo_buffer, core->undo_tiles,
+                              area);
+
+  if (core->saved_proj_buffer)
+    {
+      GimpImage     *image = gimp_item_get_image (GIMP_ITEM (drawable));
+      GeglRectangle  proj_area;
+      gint           offset_x;
+      gint           offset_y;
+
+      gimp_item_get_offset (GIMP_ITEM (drawable), &offset_x, &offset_y);
+
+      proj_area    = *area;
+      proj_area.x += offset_x;
+      proj_area.y += offset_y;
+
+      gimp_paint_core_save_tiles (gimp_pickable_get_buffer (GIMP_PICKABLE (image)),
+                                  core->saved_proj_buffer,
+                                  core->saved_proj_tiles,
+                                  &proj_area);
+    }
+}
+
 void
 gimp_paint_core_paste (GimpPaintCore            *core,
                        const GimpTempBuf        *paint_mask,
@@ -806,6 +925,11 @@ gimp_paint_core_paste (GimpPaintCore            *core,
   gint width  = gegl_buffer_get_width  (core->paint_buffer);
   gint height = gegl_buffer_get_height (core->paint_buffer);
 
+  gimp_paint_core_save_orig (core, drawable,
+                             GEGL_RECTANGLE (core->paint_buffer_x,
+                                             core->paint_buffer_y,
+                                             width, height));
+
   if (core->applicator)
     {
       /*  If the mode is CONSTANT:
@@ -1015,6 +1139,11 @@ gimp_paint_core_replace (GimpPaintCore            *core,
   width  = gegl_buffer_get_width  (core->paint_buffer);
   height = gegl_buffer_get_height (core->paint_buffer);
 
+  gimp_paint_core_save_orig (core, drawable,
+                             GEGL_RECTANGLE (core->paint_buffer_x,
+                                             core->paint_buffer_y,
+                                             width, height));
+
   if (mode == GIMP_PAINT_CONSTANT &&
 
       /* Some tools (ink) paint the mask to paint_core->canvas_buffer
@@ -1161,3 +1290,111 @@ gimp_paint_core_smooth_coords (GimpPaintCore    *core,
         }
     }
 }
+
+
+/*  private functions  */
+
+static void
+gimp_paint_core_get_tile_grid (GeglBuffer *buffer,
+                               gint       *tile_width,
+                               gint       *tile_height,
+                               gint       *n_tiles_x,
+                               gint       *n_tiles_y)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (buffer);
+
+  g_object_get (buffer,
+                "tile-width",  tile_width,
+                "tile-height", tile_height,
+                NULL);
+
+  *n_tiles_x = (extent->width  + *tile_width  - 1) / *tile_width;
+  *n_tiles_y = (extent->height + *tile_height - 1) / *tile_height;
+}
+
+static guint8 *
+gimp_paint_core_tiles_new (GeglBuffer *buffer)
+{
+  gint tile_width;
+  gint tile_height;
+  gint n_tiles_x;
+  gint n_tiles_y;
+
+  gimp_paint_core_get_tile_grid (buffer,
+                                 &tile_width, &tile_height,
+                                 &n_tiles_x, &n_tiles_y);
+
+  return g_new0 (guint8, MAX (n_tiles_x * n_tiles_y, 1));
+}
+
+/*  Copies the tiles of @src_buffer which intersect @area, and are not
+ *  marked in @tiles yet, to @dest_buffer, and marks them.  Runs of
+ *  adjacent tiles are copied at once.  When both buffers use the same
+ *  tile size, gegl_buffer_copy() shares the tiles copy-on-write
+ *  instead of copying their pixels.
+ */
+static void
+gimp_paint_core_save_tiles (GeglBuffer          *src_buffer,
+                            GeglBuffer          *dest_buffer,
+                            guint8              *tiles,
+                            const GeglRectangle *area)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (dest_buffer);
+  GeglRectangle        rect;
+  gint                 tile_width;
+  gint                 tile_height;
+  gint                 n_tiles_x;
+  gint                 n_tiles_y;
+  gint                 tx1, ty1;
+  gint                 tx2, ty2;
+  gint                 tx, ty;
+
+  if (! area)
+    area = extent;
+
+  if (! gegl_rectangle_intersect (&rect, area, extent))
+    return;
+
+  gimp_paint_core_get_tile_grid (dest_buffer,
+                                 &tile_width, &tile_height,
+                                 &n_tiles_x, &n_tiles_y);
+
+  tx1 = (rect.x - extent->x) / tile_width;
+  ty1 = (rect.y - extent->y) / tile_height;
+  tx2 = (rect.x - extent->x + rect.width  - 1) / tile_width;
+  ty2 = (rect.y - extent->y + rect.height - 1) / tile_height;
+
+  for (ty = ty1; ty <= ty2; ty++)
+    {
+      guint8 *row = tiles + ty * n_tiles_x;
+
+      tx = tx1;
+
+      while (tx <= tx2)
+        {
+          GeglRectangle run_rect;
+          gint          end;
+
+          if (row[tx])
+            {
+              tx++;
+              continue;
+            }
+
+          for (end = tx; end <= tx2 && ! row[end]; end++)
+            row[end] = TRUE;
+
+          run_rect.x      = extent->x + tx * tile_width;
+          run_rect.y      = extent->y + ty * tile_height;
+          run_rect.width  = (end - tx) * tile_width;
+          run_rect.height = tile_height;
+
+          gegl_rectangle_intersect (&run_rect, &run_rect, extent);
+
+          gegl_buffer_copy (src_buffer, &run_rect, GEGL_ABYSS_NONE,
+                            dest_buffer, &run_rect);
+
+          tx = end;
+        }
+    }
+}
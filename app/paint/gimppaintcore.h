@@ -57,6 +57,8 @@ struct _GimpPaintCore
 
   GeglBuffer  *undo_buffer;       /*  pixels which have been modified     */
   GeglBuffer  *saved_proj_buffer; /*  proj tiles which have been modified */
+  guint8      *undo_tiles;        /*  valid tiles of undo_buffer          */
+  guint8      *saved_proj_tiles;  /*  valid tiles of saved_proj_buffer    */
   GeglBuffer  *canvas_buffer;     /*  the buffer to paint the mask to     */
   GeglBuffer  *comp_buffer;       /*  scratch buffer used when masking components */
   gboolean     linear_mode;       /*  if painting to a linear surface     */
@@ -170,8 +172,16 @@ GeglBuffer * gimp_paint_core_get_paint_buffer       (GimpPaintCore    *core,
                                                      gint             *paint_buffer_x,
                                                      gint             *paint_buffer_y);
 
-GeglBuffer * gimp_paint_core_get_orig_image         (GimpPaintCore    *core);
-GeglBuffer * gimp_paint_core_get_orig_proj          (GimpPaintCore    *core);
+GeglBuffer * gimp_paint_core_get_orig_image         (GimpPaintCore       *core,
+                                                     GimpDrawable        *drawable,
+                                                     const GeglRectangle *area);
+GeglBuffer * gimp_paint_core_get_orig_proj          (GimpPaintCore       *core,
+                                                     GimpDrawable        *drawable,
+                                                     const GeglRectangle *area);
+
+void         gimp_paint_core_save_orig              (GimpPaintCore       *core,
+                                                     GimpDrawable        *drawable,
+                                                     const GeglRectangle *area);
 
 void      gimp_paint_core_paste             (GimpPaintCore            *core,
                                              const GimpTempBuf        *paint_mask,
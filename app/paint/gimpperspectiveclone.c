@@ -200,10 +200,17 @@ gimp_perspective_clone_paint (GimpPaintCore    *paint_core,
                   }
                 else
                   {
+                    /*  the source area is only known after the
+                     *  transform, so save all of it
+                     */
                     if (options->sample_merged)
-                      orig_buffer = gimp_paint_core_get_orig_proj (paint_core);
+                      orig_buffer = gimp_paint_core_get_orig_proj (paint_core,
+                                                                   drawable,
+                                                                   NULL);
                     else
-                      orig_buffer = gimp_paint_core_get_orig_image (paint_core);
+                      orig_buffer = gimp_paint_core_get_orig_image (paint_core,
+                                                                    drawable,
+                                                                    NULL);
                   }
               }
               break;
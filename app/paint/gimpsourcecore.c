@@ -529,9 +529,15 @@ gimp_source_core_real_get_source (GimpSourceCore   *source_core,
     {
       /*  get the original image  */
       if (options->sample_merged)
-        dest_buffer = gimp_paint_core_get_orig_proj (GIMP_PAINT_CORE (source_core));
+        dest_buffer =
+          gimp_paint_core_get_orig_proj (GIMP_PAINT_CORE (source_core),
+                                         drawable,
+                                         GEGL_RECTANGLE (x, y, width, height));
       else
-        dest_buffer = gimp_paint_core_get_orig_image (GIMP_PAINT_CORE (source_core));
+        dest_buffer =
+          gimp_paint_core_get_orig_image (GIMP_PAINT_CORE (source_core),
+                                          drawable,
+                                          GEGL_RECTANGLE (x, y, width, height));
     }
 
   *paint_area_offset_x = x - (paint_buffer_x + src_offset_x);
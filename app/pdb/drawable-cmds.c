@@ -685,6 +685,11 @@ drawable_set_pixel_invoker (GimpProcedure         *procedure,
           gegl_buffer_set (gimp_drawable_get_buffer (drawable),
                            GEGL_RECTANGLE (x_coord, y_coord, 1, 1),
                            0, format, pixel, GEGL_AUTO_ROWSTRIDE);
+
+          /*  let the drawable forget what it knows about the old pixel,
+           *  like a channel's cached bounds and boundary
+           */
+          gimp_drawable_update (drawable, x_coord, y_coord, 1, 1);
         }
       else
         success = FALSE;
@@ -31,6 +31,8 @@
 #include "core/gimpimage-undo.h"
 #include "core/gimpimage.h"
 #include "core/gimpparamspecs.h"
+#include "core/gimpundo.h"
+#include "core/gimpundostack.h"
 #include "plug-in/gimpplugin-cleanup.h"
 #include "plug-in/gimpplugin.h"
 #include "plug-in/gimppluginmanager.h"
@@ -279,6 +281,85 @@ image_undo_thaw_invoker (GimpProcedure         *procedure,
   return return_vals;
 }
 
+static GimpValueArray *
+image_undo_get_memsize_invoker (GimpProcedure         *procedure,
+                                Gimp                  *gimp,
+                                GimpContext           *context,
+                                GimpProgress          *progress,
+                                const GimpValueArray  *args,
+                                GError               **error)
+{
+  gboolean success = TRUE;
+  GimpValueArray *return_vals;
+  GimpImage *image;
+  gdouble undo_memsize = 0.0;
+  gdouble redo_memsize = 0.0;
+  gint32 num_undo_types = 0;
+  gchar **undo_types = NULL;
+  gint32 num_type_memsizes = 0;
+  gdouble *type_memsizes = NULL;
+
+  image = gimp_value_get_image (gimp_value_array_index (args, 0), gimp);
+
+  if (success)
+    {
+      GimpUndoStack *undo_stack = gimp_image_get_undo_stack (image);
+      GimpUndoStack *redo_stack = gimp_image_get_redo_stack (image);
+      GArray        *memsizes;
+      gint           i;
+
+      /*  the newest undo steps can have changed their size  */
+      gimp_undo_stack_update_top_memsize (undo_stack);
+      gimp_undo_stack_update_top_memsize (redo_stack);
+
+      undo_memsize = gimp_undo_stack_get_undos_memsize (undo_stack);
+      redo_memsize = gimp_undo_stack_get_undos_memsize (redo_stack);
+
+      memsizes = gimp_undo_stack_get_type_memsizes (undo_stack);
+
+      num_undo_types    = memsizes->len;
+      num_type_memsizes = memsizes->len;
+
+      if (memsizes->len > 0)
+        {
+          undo_types    = g_new (gchar *, memsizes->len);
+          type_memsizes = g_new (gdouble, memsizes->len);
+
+          for (i = 0; i < memsizes->len; i++)
+            {
+              GimpUndoTypeMemsize *memsize;
+              const gchar         *nick;
+
+              memsize = &g_array_index (memsizes, GimpUndoTypeMemsize, i);
+
+              /*  the nick, the translated names are no use to scripts  */
+              gimp_enum_get_value (GIMP_TYPE_UNDO_TYPE, memsize->undo_type,
+                                   NULL, &nick, NULL, NULL);
+
+              undo_types[i]    = g_strdup (nick);
+              type_memsizes[i] = memsize->memsize;
+            }
+        }
+
+      g_array_free (memsizes, TRUE);
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, success,
+                                                  error ? *error : NULL);
+
+  if (success)
+    {
+      g_value_set_double (gimp_value_array_index (return_vals, 1), undo_memsize);
+      g_value_set_double (gimp_value_array_index (return_vals, 2), redo_memsize);
+      g_value_set_int (gimp_value_array_index (return_vals, 3), num_undo_types);
+      gimp_value_take_stringarray (gimp_value_array_index (return_vals, 4), undo_types, num_undo_types);
+      g_value_set_int (gimp_value_array_index (return_vals, 5), num_type_memsizes);
+      gimp_value_take_floatarray (gimp_value_array_index (return_vals, 6), type_memsizes, num_type_memsizes);
+    }
+
+  return return_vals;
+}
+
 void
 register_image_undo_procs (GimpPDB *pdb)
 {
@@ -474,4 +555,61 @@ register_image_undo_procs (GimpPDB *pdb)
                                                          GIMP_PARAM_READWRITE));
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
+
+  /*
+   * gimp-image-undo-get-memsize
+   */
+  procedure = gimp_procedure_new (image_undo_get_memsize_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-image-undo-get-memsize");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-image-undo-get-memsize",
+                                     "Returns the memory used by the image's undo and redo steps.",
+                                     "This procedure returns the number of bytes used by the image's undo and redo stacks, and how the memory of the undo stack is distributed over the different kinds of undo steps. The undo types are sorted by the memory they use, largest first.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "1995-1996",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_image_id ("image",
+                                                         "image",
+                                                         "The image",
+                                                         pdb->gimp, FALSE,
+                                                         GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("undo-memsize",
+                                                        "undo memsize",
+                                                        "The memory used by the undo steps, in bytes",
+                                                        -G_MAXDOUBLE, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("redo-memsize",
+                                                        "redo memsize",
+                                                        "The memory used by the redo steps, in bytes",
+                                                        -G_MAXDOUBLE, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("num-undo-types",
+                                                          "num undo types",
+                                                          "The number of undo types",
+                                                          0, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_string_array ("undo-types",
+                                                                 "undo types",
+                                                                 "The nicks of the undo types on the undo stack",
+                                                                 GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("num-type-memsizes",
+                                                          "num type memsizes",
+                                                          "The number of undo types",
+                                                          0, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_float_array ("type-memsizes",
+                                                                "type memsizes",
+                                                                "The memory used by each undo type, in bytes",
+                                                                GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
 }
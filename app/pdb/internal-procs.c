@@ -28,7 +28,7 @@
 #include "internal-procs.h"
 
 
-/* 762 procedures registered total */
+/* 763 procedures registered total */
 
 void
 internal_procs_init (GimpPDB *pdb)
@@ -63,6 +63,8 @@ static void gimp_plug_in_handle_tile_put         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
 static void gimp_plug_in_handle_tile_get         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
+static void gimp_plug_in_handle_tile_batch       (GimpPlugIn      *plug_in,
+                                                  GPTileBatch     *batch);
 static void gimp_plug_in_handle_proc_run         (GimpPlugIn      *plug_in,
                                                   GPProcRun       *proc_run);
 static void gimp_plug_in_handle_proc_return      (GimpPlugIn      *plug_in,
@@ -160,6 +162,10 @@ gimp_plug_in_handle_message (GimpPlugIn      *plug_in,
     case GP_HAS_INIT:
       gimp_plug_in_handle_has_init (plug_in);
       break;
+
+    case GP_TILE_BATCH:
+      gimp_plug_in_handle_tile_batch (plug_in, msg->data);
+      break;
     }
 }
 
@@ -333,6 +339,15 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
                        GEGL_AUTO_ROWSTRIDE);
     }
 
+  /*  the drawable's own pixels changed, let it forget what it knows
+   *  about them, like a channel's cached bounds and boundary.  The
+   *  shadow buffer is merged later, which updates the drawable.
+   */
+  if (! tile_info->shadow)
+    gimp_drawable_update (drawable,
+                          tile_rect.x, tile_rect.y,
+                          tile_rect.width, tile_rect.height);
+
   gimp_wire_destroy (&msg);
 
   if (! gp_tile_ack_write (plug_in->my_write, plug_in))
@@ -469,6 +484,203 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
   gimp_wire_destroy (&msg);
 }
 
+static void
+gimp_plug_in_handle_tile_batch (GimpPlugIn  *plug_in,
+                                GPTileBatch *batch)
+{
+  GimpPlugInShm   *shm = plug_in->manager->shm;
+  GimpWireMessage  msg;
+  GimpDrawable    *drawable;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  GeglRectangle    tile_rects[GP_TILE_BATCH_MAX_TILES];
+  gint             i;
+
+  /*  the batch is NULL if it couldn't be read  */
+  if (! shm || ! batch ||
+      batch->n_tiles > gimp_plug_in_shm_get_n_tiles (shm))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-In \"%s\"\n(%s)\n\n"
+                    "requested more tiles than fit into shared memory "
+                    "(killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  drawable = (GimpDrawable *) gimp_item_get_by_ID (plug_in->manager->gimp,
+                                                   batch->drawable_ID);
+
+  if (! GIMP_IS_DRAWABLE (drawable))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-In \"%s\"\n(%s)\n\n"
+                    "tried accessing invalid drawable %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    batch->drawable_ID);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-In \"%s\"\n(%s)\n\n"
+                    "tried accessing drawable %d which was removed "
+                    "from the image (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    batch->drawable_ID);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (batch->shadow)
+    {
+      /*  see gimp_plug_in_handle_tile_put()  */
+      buffer = gimp_drawable_get_shadow_buffer (drawable);
+
+      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
+    }
+  else
+    {
+      if (batch->put &&
+          gimp_item_is_content_locked (GIMP_ITEM (drawable)))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-In \"%s\"\n(%s)\n\n"
+                        "tried writing to a locked drawable %d (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        batch->drawable_ID);
+          gimp_plug_in_close (plug_in, TRUE);
+          return;
+        }
+      else if (batch->put &&
+               gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-In \"%s\"\n(%s)\n\n"
+                        "tried writing to a group layer %d (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        batch->drawable_ID);
+          gimp_plug_in_close (plug_in, TRUE);
+          return;
+        }
+
+      buffer = gimp_drawable_get_buffer (drawable);
+    }
+
+  format = gegl_buffer_get_format (buffer);
+
+  if (! gimp_plug_in_precision_enabled (plug_in))
+    {
+      format = gimp_babl_compat_u8_format (format);
+    }
+
+  /*  the slots are sized for the drawable's tiles, the plug-in must
+   *  agree on their size
+   */
+  if (batch->bpp != babl_format_get_bytes_per_pixel (format))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-In \"%s\"\n(%s)\n\n"
+                    "tried accessing drawable %d with a wrong number "
+                    "of bytes per pixel (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    batch->drawable_ID);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  for (i = 0; i < batch->n_tiles; i++)
+    {
+      if (! gimp_gegl_buffer_get_tile_rect (buffer,
+                                            GIMP_PLUG_IN_TILE_WIDTH,
+                                            GIMP_PLUG_IN_TILE_HEIGHT,
+                                            batch->tile_nums[i],
+                                            &tile_rects[i]))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-In \"%s\"\n(%s)\n\n"
+                        "requested invalid tile (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file));
+          gimp_plug_in_close (plug_in, TRUE);
+          return;
+        }
+    }
+
+  /*  the shared memory is used by all plug-ins, so like
+   *  gimp_plug_in_handle_tile_get() and gimp_plug_in_handle_tile_put()
+   *  we don't return before the plug-in is done with it
+   */
+  if (! batch->put)
+    {
+      for (i = 0; i < batch->n_tiles; i++)
+        gegl_buffer_get (buffer, &tile_rects[i], 1.0, format,
+                         gimp_plug_in_shm_get_tile_addr (shm, i),
+                         GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  /*  sending the batch back hands the tiles to the plug-in, or grants
+   *  it the slots to fill
+   */
+  if (! gp_tile_batch_write (plug_in->my_write, batch, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (msg.type != GP_TILE_ACK)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "expected tile ack and received: %d", msg.type);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  gimp_wire_destroy (&msg);
+
+  if (batch->put)
+    {
+      for (i = 0; i < batch->n_tiles; i++)
+        {
+          gegl_buffer_set (buffer, &tile_rects[i], 0, format,
+                           gimp_plug_in_shm_get_tile_addr (shm, i),
+                           GEGL_AUTO_ROWSTRIDE);
+
+          /*  see gimp_plug_in_handle_tile_put()  */
+          if (! batch->shadow)
+            gimp_drawable_update (drawable,
+                                  tile_rects[i].x, tile_rects[i].y,
+                                  tile_rects[i].width, tile_rects[i].height);
+        }
+
+      if (! gp_tile_ack_write (plug_in->my_write, plug_in))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "%s: ERROR", G_STRFUNC);
+          gimp_plug_in_close (plug_in, TRUE);
+          return;
+        }
+    }
+}
+
 static void
 gimp_plug_in_handle_proc_error (GimpPlugIn          *plug_in,
                                 GimpPlugInProcFrame *proc_frame,
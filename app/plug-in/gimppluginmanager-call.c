@@ -91,6 +91,141 @@ gimp_plug_in_manager_call_query (GimpPlugInManager *manager,
     }
 }
 
+void
+gimp_plug_in_manager_call_query_all (GimpPlugInManager   *manager,
+                                     GimpContext         *context,
+                                     GSList              *plug_in_defs,
+                                     gint                 max_running,
+                                     GimpPlugInQueryFunc  callback,
+                                     gpointer             user_data)
+{
+  GimpPlugIn **running;
+  gint64      *start_times;
+  GPollFD     *fds;
+  gint         n_running = 0;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
+  g_return_if_fail (callback != NULL);
+
+#ifdef G_OS_WIN32
+  /*  g_poll() can't wait for pipes on Windows  */
+  max_running = 1;
+#endif
+
+  max_running = MAX (max_running, 1);
+
+  running     = g_new (GimpPlugIn *, max_running);
+  start_times = g_new (gint64, max_running);
+  fds         = g_new (GPollFD, max_running);
+
+  while (plug_in_defs || n_running > 0)
+    {
+      gint i;
+
+      /*  start queries until the pool is full  */
+      while (plug_in_defs && n_running < max_running)
+        {
+          GimpPlugInDef *plug_in_def = plug_in_defs->data;
+          GimpPlugIn    *plug_in;
+          gint64         start_time  = g_get_monotonic_time ();
+
+          plug_in_defs = g_slist_next (plug_in_defs);
+
+          plug_in = gimp_plug_in_new (manager, context, NULL,
+                                      NULL, plug_in_def->file);
+
+          if (plug_in)
+            {
+              plug_in->plug_in_def = plug_in_def;
+
+              if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_QUERY, TRUE))
+                {
+                  running[n_running]     = plug_in;
+                  start_times[n_running] = start_time;
+                  n_running++;
+
+                  continue;
+                }
+
+              g_object_unref (plug_in);
+            }
+
+          callback (plug_in_def,
+                    (g_get_monotonic_time () - start_time) / 1000000.0,
+                    user_data);
+        }
+
+      if (n_running == 0)
+        break;
+
+      /*  wait until one of the plug-ins sends a message, there is no
+       *  need to poll a single one, reading just blocks then
+       */
+      if (n_running > 1)
+        {
+          for (i = 0; i < n_running; i++)
+            {
+              fds[i].fd      = g_io_channel_unix_get_fd (running[i]->my_read);
+              fds[i].events  = G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP;
+              fds[i].revents = 0;
+            }
+
+          if (g_poll (fds, n_running, -1) < 0)
+            continue;
+        }
+      else
+        {
+          fds[0].revents = G_IO_IN;
+        }
+
+      /*  handle one message of each plug-in that is ready, messages
+       *  are read completely, so this only blocks while a plug-in is
+       *  in the middle of sending one
+       */
+      for (i = n_running - 1; i >= 0; i--)
+        {
+          GimpPlugIn      *plug_in = running[i];
+          GimpWireMessage  msg;
+
+          if (! fds[i].revents)
+            continue;
+
+          if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+            {
+              gimp_plug_in_close (plug_in, TRUE);
+            }
+          else
+            {
+              gimp_plug_in_handle_message (plug_in, &msg);
+              gimp_wire_destroy (&msg);
+            }
+
+          if (! plug_in->open)
+            {
+              callback (plug_in->plug_in_def,
+                        (g_get_monotonic_time () - start_times[i]) / 1000000.0,
+                        user_data);
+
+              g_object_unref (plug_in);
+
+              /*  the slots above i are already handled, so the last
+               *  one can be moved here
+               */
+              n_running--;
+
+              running[i]     = running[n_running];
+              start_times[i] = start_times[n_running];
+              fds[i]         = fds[n_running];
+            }
+        }
+    }
+
+  g_free (fds);
+  g_free (start_times);
+  g_free (running);
+}
+
 void
 gimp_plug_in_manager_call_init (GimpPlugInManager *manager,
                                 GimpContext       *context,
@@ -194,7 +329,8 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
                                  gui_config->show_help_button);
       config.use_cpu_accel    = manager->gimp->use_cpu_accel;
       config.use_opencl       = gegl_config->use_opencl;
-      config.gimp_reserved_6  = 0;
+      config.shm_n_tiles      = (manager->shm ?
+                                 gimp_plug_in_shm_get_n_tiles (manager->shm) : 0);
       config.gimp_reserved_7  = 0;
       config.gimp_reserved_8  = 0;
       config.install_cmap     = FALSE;
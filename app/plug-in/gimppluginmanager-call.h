@@ -25,35 +25,53 @@
 #endif
 
 
+/*  Called when the query of @plug_in_def is done, @seconds is the time
+ *  it took
+ */
+typedef void (* GimpPlugInQueryFunc) (GimpPlugInDef *plug_in_def,
+                                      gdouble        seconds,
+                                      gpointer       user_data);
+
+
 /*  Call the plug-in's query() function
  */
-void             gimp_plug_in_manager_call_query    (GimpPlugInManager      *manager,
-                                                     GimpContext            *context,
-                                                     GimpPlugInDef          *plug_in_def);
+void             gimp_plug_in_manager_call_query     (GimpPlugInManager      *manager,
+                                                      GimpContext            *context,
+                                                      GimpPlugInDef          *plug_in_def);
+
+/*  Call the query() functions of all @plug_in_defs, running up to
+ *  @max_running plug-ins at the same time
+ */
+void             gimp_plug_in_manager_call_query_all (GimpPlugInManager      *manager,
+                                                      GimpContext            *context,
+                                                      GSList                 *plug_in_defs,
+                                                      gint                    max_running,
+                                                      GimpPlugInQueryFunc     callback,
+                                                      gpointer                user_data);
 
 /*  Call the plug-in's init() function
  */
-void             gimp_plug_in_manager_call_init     (GimpPlugInManager      *manager,
-                                                     GimpContext            *context,
-                                                     GimpPlugInDef          *plug_in_def);
+void             gimp_plug_in_manager_call_init      (GimpPlugInManager      *manager,
+                                                      GimpContext            *context,
+                                                      GimpPlugInDef          *plug_in_def);
 
 /*  Run a plug-in as if it were a procedure database procedure
  */
-GimpValueArray * gimp_plug_in_manager_call_run      (GimpPlugInManager      *manager,
-                                                     GimpContext            *context,
-                                                     GimpProgress           *progress,
-                                                     GimpPlugInProcedure    *procedure,
-                                                     GimpValueArray         *args,
-                                                     gboolean                synchronous,
-                                                     GimpObject             *display);
+GimpValueArray * gimp_plug_in_manager_call_run       (GimpPlugInManager      *manager,
+                                                      GimpContext            *context,
+                                                      GimpProgress           *progress,
+                                                      GimpPlugInProcedure    *procedure,
+                                                      GimpValueArray         *args,
+                                                      gboolean                synchronous,
+                                                      GimpObject             *display);
 
 /*  Run a temp plug-in proc as if it were a procedure database procedure
  */
-GimpValueArray * gimp_plug_in_manager_call_run_temp (GimpPlugInManager      *manager,
-                                                     GimpContext            *context,
-                                                     GimpProgress           *progress,
-                                                     GimpTemporaryProcedure *procedure,
-                                                     GimpValueArray         *args);
+GimpValueArray * gimp_plug_in_manager_call_run_temp  (GimpPlugInManager      *manager,
+                                                      GimpContext            *context,
+                                                      GimpProgress           *progress,
+                                                      GimpTemporaryProcedure *procedure,
+                                                      GimpValueArray         *args);
 
 
 #endif /* __GIMP_PLUG_IN_MANAGER_CALL_H__ */
@@ -51,6 +51,15 @@
 #include "gimp-intl.h"
 
 
+typedef struct
+{
+  GimpPlugInManager  *manager;
+  GimpInitStatusFunc  status_callback;
+  gint                n_plugins;
+  gint                n_done;
+} GimpPlugInQueryData;
+
+
 static void    gimp_plug_in_manager_search            (GimpPlugInManager    *manager,
                                                        GimpInitStatusFunc    status_callback);
 static void    gimp_plug_in_manager_search_directory  (GimpPlugInManager    *manager,
@@ -62,6 +71,9 @@ static void    gimp_plug_in_manager_read_pluginrc     (GimpPlugInManager    *man
 static void    gimp_plug_in_manager_query_new         (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
+static void    gimp_plug_in_manager_query_done        (GimpPlugInDef        *plug_in_def,
+                                                       gdouble               seconds,
+                                                       GimpPlugInQueryData  *data);
 static void    gimp_plug_in_manager_init_plug_ins     (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
@@ -364,49 +376,72 @@ gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
                                 GimpContext        *context,
                                 GimpInitStatusFunc  status_callback)
 {
-  GSList *list;
-  gint    n_plugins;
+  GimpPlugInQueryData  data;
+  GSList              *list;
+  GSList              *query_defs = NULL;
 
   status_callback (_("Querying new Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
       if (plug_in_def->needs_query)
-        n_plugins++;
+        {
+          if (manager->gimp->be_verbose)
+            g_print ("Querying plug-in: '%s'\n",
+                     gimp_file_get_utf8_name (plug_in_def->file));
+
+          query_defs = g_slist_prepend (query_defs, plug_in_def);
+        }
     }
 
-  if (n_plugins)
+  if (query_defs)
     {
-      gint nth;
+      GimpCoreConfig *config = manager->gimp->config;
 
       manager->write_pluginrc = TRUE;
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
+      query_defs = g_slist_reverse (query_defs);
+
+      data.manager         = manager;
+      data.status_callback = status_callback;
+      data.n_plugins       = g_slist_length (query_defs);
+      data.n_done          = 0;
+
+      /*  the plug-ins are queried in parallel, but each one only adds
+       *  to its own GimpPlugInDef, and pluginrc is written in the order
+       *  of manager->plug_in_defs, so the result doesn't depend on the
+       *  order in which the queries finish
+       */
+      gimp_plug_in_manager_call_query_all (manager, context, query_defs,
+                                           GIMP_GEGL_CONFIG (config)->num_processors,
+                                           (GimpPlugInQueryFunc)
+                                           gimp_plug_in_manager_query_done,
+                                           &data);
+
+      g_slist_free (query_defs);
+    }
 
-          if (plug_in_def->needs_query)
-            {
-              gchar *basename;
+  status_callback (NULL, "", 1.0);
+}
 
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+static void
+gimp_plug_in_manager_query_done (GimpPlugInDef       *plug_in_def,
+                                 gdouble              seconds,
+                                 GimpPlugInQueryData *data)
+{
+  gchar *basename;
 
-              if (manager->gimp->be_verbose)
-                g_print ("Querying plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
+  basename = g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
 
-              gimp_plug_in_manager_call_query (manager, context, plug_in_def);
-            }
-        }
-    }
+  data->status_callback (NULL, basename,
+                         (gdouble) ++data->n_done / (gdouble) data->n_plugins);
 
-  status_callback (NULL, "", 1.0);
+  if (data->manager->gimp->be_verbose)
+    g_print ("Queried plug-in '%s' in %.3f seconds\n", basename, seconds);
+
+  g_free (basename);
 }
 
 /* initialize the plug-ins */
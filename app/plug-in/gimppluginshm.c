@@ -73,6 +73,12 @@
 
 #define TILE_MAP_SIZE (GIMP_PLUG_IN_TILE_WIDTH * GIMP_PLUG_IN_TILE_HEIGHT * 32)
 
+/*  the segment holds this many tiles, so plug-ins can transfer
+ *  several tiles per round trip using GP_TILE_BATCH
+ */
+#define SHM_N_TILES   16
+#define SHM_SIZE      (TILE_MAP_SIZE * SHM_N_TILES)
+
 #define ERRMSG_SHM_DISABLE "Disabling shared memory tile transport"
 
 
@@ -103,7 +109,7 @@ gimp_plug_in_shm_new (void)
 
   /* Use SysV shared memory mechanisms for transferring tile data. */
   {
-    shm->shm_ID = shmget (IPC_PRIVATE, TILE_MAP_SIZE, IPC_CREAT | 0600);
+    shm->shm_ID = shmget (IPC_PRIVATE, SHM_SIZE, IPC_CREAT | 0600);
 
     if (shm->shm_ID != -1)
       {
@@ -145,7 +151,7 @@ gimp_plug_in_shm_new (void)
     /* Create the file mapping into paging space */
     shm->shm_handle = CreateFileMapping (INVALID_HANDLE_VALUE, NULL,
                                          PAGE_READWRITE, 0,
-                                         TILE_MAP_SIZE,
+                                         SHM_SIZE,
                                          fileMapName);
 
     if (shm->shm_handle)
@@ -153,7 +159,7 @@ gimp_plug_in_shm_new (void)
         /* Map the shared memory into our address space for use */
         shm->shm_addr = (guchar *) MapViewOfFile (shm->shm_handle,
                                                   FILE_MAP_ALL_ACCESS,
-                                                  0, 0, TILE_MAP_SIZE);
+                                                  0, 0, SHM_SIZE);
 
         /* Verify that we mapped our view */
         if (shm->shm_addr)
@@ -192,10 +198,10 @@ gimp_plug_in_shm_new (void)
 
     if (shm_fd != -1)
       {
-        if (ftruncate (shm_fd, TILE_MAP_SIZE) != -1)
+        if (ftruncate (shm_fd, SHM_SIZE) != -1)
           {
             /* Map the shared memory into our address space for use */
-            shm->shm_addr = (guchar *) mmap (NULL, TILE_MAP_SIZE,
+            shm->shm_addr = (guchar *) mmap (NULL, SHM_SIZE,
                                              PROT_READ | PROT_WRITE, MAP_SHARED,
                                              shm_fd, 0);
 
@@ -269,7 +275,7 @@ gimp_plug_in_shm_free (GimpPlugInShm *shm)
 
       gchar shm_handle[32];
 
-      munmap (shm->shm_addr, TILE_MAP_SIZE);
+      munmap (shm->shm_addr, SHM_SIZE);
 
       g_snprintf (shm_handle, sizeof (shm_handle), "/gimp-shm-%d",
                   shm->shm_ID);
@@ -299,3 +305,23 @@ gimp_plug_in_shm_get_addr (GimpPlugInShm *shm)
 
   return shm->shm_addr;
 }
+
+/*  Returns the number of tile sized slots in the segment  */
+gint
+gimp_plug_in_shm_get_n_tiles (GimpPlugInShm *shm)
+{
+  g_return_val_if_fail (shm != NULL, 0);
+
+  return SHM_N_TILES;
+}
+
+/*  Returns the address of the @n-th tile sized slot  */
+guchar *
+gimp_plug_in_shm_get_tile_addr (GimpPlugInShm *shm,
+                                gint           n)
+{
+  g_return_val_if_fail (shm != NULL, NULL);
+  g_return_val_if_fail (n >= 0 && n < SHM_N_TILES, NULL);
+
+  return shm->shm_addr + (gsize) n * TILE_MAP_SIZE;
+}
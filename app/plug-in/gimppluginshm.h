@@ -21,11 +21,15 @@
 #define __GIMP_PLUG_IN_SHM_H__
 
 
-GimpPlugInShm * gimp_plug_in_shm_new      (void);
-void            gimp_plug_in_shm_free     (GimpPlugInShm *shm);
+GimpPlugInShm * gimp_plug_in_shm_new           (void);
+void            gimp_plug_in_shm_free          (GimpPlugInShm *shm);
 
-gint            gimp_plug_in_shm_get_ID   (GimpPlugInShm *shm);
-guchar        * gimp_plug_in_shm_get_addr (GimpPlugInShm *shm);
+gint            gimp_plug_in_shm_get_ID        (GimpPlugInShm *shm);
+guchar        * gimp_plug_in_shm_get_addr      (GimpPlugInShm *shm);
+
+gint            gimp_plug_in_shm_get_n_tiles   (GimpPlugInShm *shm);
+guchar        * gimp_plug_in_shm_get_tile_addr (GimpPlugInShm *shm,
+                                                gint           n);
 
 
 #endif /* __GIMP_PLUG_IN_SHM_H__ */
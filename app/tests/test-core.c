@@ -0,0 +1,606 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "widgets/widgets-types.h"
+
+#include "widgets/gimpuimanager.h"
+
+#include "core/gimp.h"
+#include "core/gimpboundary.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+#include "core/gimplayer-new.h"
+#include "core/gimppickable.h"
+#include "core/gimppickable-contiguous-region.h"
+#include "core/gimppickable-contiguous-region-private.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define GIMP_TEST_FILL_WIDTH  300
+#define GIMP_TEST_FILL_HEIGHT 200
+
+#define ADD_IMAGE_TEST(function) \
+  g_test_add ("/gimp-core/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_test_image_setup, \
+              function, \
+              gimp_test_image_teardown);
+
+
+typedef struct
+{
+  GimpImage *image;
+} GimpTestFixture;
+
+
+static void gimp_test_image_setup    (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+static void gimp_test_image_teardown (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+
+static gint gimp_test_seg_compare    (gconstpointer    a,
+                                      gconstpointer    b);
+static void gimp_test_fill_rect      (GeglBuffer      *buffer,
+                                      gint             x,
+                                      gint             y,
+                                      gint             width,
+                                      gint             height,
+                                      gfloat           value);
+static void gimp_test_check_boundary (GimpBoundaryCache *cache,
+                                      GeglBuffer        *buffer,
+                                      gint               x1,
+                                      gint               y1,
+                                      gint               x2,
+                                      gint               y2);
+
+
+/**
+ * gimp_test_image_setup:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture setup for a single image.
+ **/
+static void
+gimp_test_image_setup (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  Gimp *gimp = GIMP (data);
+
+  fixture->image = gimp_image_new (gimp,
+                                   GIMP_TEST_FILL_WIDTH,
+                                   GIMP_TEST_FILL_HEIGHT,
+                                   GIMP_RGB,
+                                   GIMP_PRECISION_FLOAT_LINEAR);
+}
+
+/**
+ * gimp_test_image_teardown:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture teardown for a single image.
+ **/
+static void
+gimp_test_image_teardown (GimpTestFixture *fixture,
+                          gconstpointer    data)
+{
+  g_object_unref (fixture->image);
+}
+
+/**
+ * contiguous_region_by_seed:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the scanline fill of fuzzy select and bucket fill finds
+ * the same region as a plain pixel-by-pixel flood fill, on a maze
+ * whose walls cross tile and band boundaries.
+ **/
+static void
+contiguous_region_by_seed (GimpTestFixture *fixture,
+                           gconstpointer    data)
+{
+  GimpImage  *image = fixture->image;
+  GimpLayer  *layer;
+  GeglBuffer *mask;
+  guchar     *pixels;
+  gboolean   *expected;
+  gfloat     *result;
+  GQueue     *queue;
+  gint        n_selected = 0;
+  gint        x, y;
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_FILL_WIDTH,
+                          GIMP_TEST_FILL_HEIGHT,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          1.0,
+                          GIMP_NORMAL_MODE);
+
+  gimp_image_add_layer (image,
+                        layer,
+                        GIMP_IMAGE_ACTIVE_PARENT,
+                        0,
+                        FALSE);
+
+  pixels = g_new (guchar, GIMP_TEST_FILL_WIDTH * GIMP_TEST_FILL_HEIGHT * 4);
+
+  for (y = 0; y < GIMP_TEST_FILL_HEIGHT; y++)
+    for (x = 0; x < GIMP_TEST_FILL_WIDTH; x++)
+      {
+        guchar   *p    = pixels + (y * GIMP_TEST_FILL_WIDTH + x) * 4;
+        gboolean  wall = ((x % 37 == 0 && y % 50 != 25) ||
+                          (y % 29 == 0 && x % 61 != 30) ||
+                          (x + y) % 97 == 0);
+
+        p[0] = p[1] = p[2] = wall ? 0 : 255;
+        p[3] = 255;
+      }
+
+  gegl_buffer_set (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                   GEGL_RECTANGLE (0, 0,
+                                   GIMP_TEST_FILL_WIDTH,
+                                   GIMP_TEST_FILL_HEIGHT),
+                   0, babl_format ("R'G'B'A u8"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  mask = gimp_pickable_contiguous_region_by_seed (GIMP_PICKABLE (layer),
+                                                  FALSE, 0.5, FALSE,
+                                                  GIMP_SELECT_CRITERION_COMPOSITE,
+                                                  1, 1);
+
+  /*  the reference fill  */
+  expected = g_new0 (gboolean, GIMP_TEST_FILL_WIDTH * GIMP_TEST_FILL_HEIGHT);
+  queue    = g_queue_new ();
+
+  expected[GIMP_TEST_FILL_WIDTH + 1] = TRUE;
+  g_queue_push_tail (queue, GINT_TO_POINTER (GIMP_TEST_FILL_WIDTH + 1));
+
+  while (! g_queue_is_empty (queue))
+    {
+      gint p = GPOINTER_TO_INT (g_queue_pop_head (queue));
+      gint neighbors[4];
+      gint i;
+
+      x = p % GIMP_TEST_FILL_WIDTH;
+      y = p / GIMP_TEST_FILL_WIDTH;
+
+      neighbors[0] = x > 0                          ? p - 1 : -1;
+      neighbors[1] = x < GIMP_TEST_FILL_WIDTH - 1   ? p + 1 : -1;
+      neighbors[2] = y > 0                          ? p - GIMP_TEST_FILL_WIDTH : -1;
+      neighbors[3] = y < GIMP_TEST_FILL_HEIGHT - 1  ? p + GIMP_TEST_FILL_WIDTH : -1;
+
+      for (i = 0; i < 4; i++)
+        {
+          gint n = neighbors[i];
+
+          if (n >= 0 && ! expected[n] && pixels[n * 4] == pixels[p * 4])
+            {
+              expected[n] = TRUE;
+              g_queue_push_tail (queue, GINT_TO_POINTER (n));
+            }
+        }
+    }
+
+  g_queue_free (queue);
+
+  result = g_new (gfloat, GIMP_TEST_FILL_WIDTH * GIMP_TEST_FILL_HEIGHT);
+
+  gegl_buffer_get (mask,
+                   GEGL_RECTANGLE (0, 0,
+                                   GIMP_TEST_FILL_WIDTH,
+                                   GIMP_TEST_FILL_HEIGHT),
+                   1.0, babl_format ("Y float"),
+                   result, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < GIMP_TEST_FILL_HEIGHT; y++)
+    for (x = 0; x < GIMP_TEST_FILL_WIDTH; x++)
+      {
+        gint p = y * GIMP_TEST_FILL_WIDTH + x;
+
+        g_assert_cmpfloat (result[p], ==, expected[p] ? 1.0 : 0.0);
+
+        if (expected[p])
+          n_selected++;
+      }
+
+  /*  the seed's cell spans more than one band of rows  */
+  g_assert_cmpint (n_selected, >, 64 * 30);
+
+  g_free (result);
+  g_free (expected);
+  g_free (pixels);
+  g_object_unref (mask);
+}
+
+/**
+ * boundary_cache_find:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the boundary cache returns the same segments as a scan
+ * of the whole mask, for shapes which cross the cache's tile edges,
+ * and again after parts of the mask were changed and invalidated.
+ **/
+static void
+boundary_cache_find (GimpTestFixture *fixture,
+                     gconstpointer    data)
+{
+  GimpBoundaryCache *cache;
+  GeglBuffer        *buffer;
+  gfloat            *pixels;
+  gint               x, y;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                            GIMP_TEST_FILL_WIDTH,
+                                            GIMP_TEST_FILL_HEIGHT),
+                            babl_format ("Y float"));
+
+  pixels = g_new (gfloat, GIMP_TEST_FILL_WIDTH * GIMP_TEST_FILL_HEIGHT);
+
+  /*  a disc around the corner of four tiles, a ring crossing the
+   *  right tile edge, and stripes which end right on the edges
+   */
+  for (y = 0; y < GIMP_TEST_FILL_HEIGHT; y++)
+    for (x = 0; x < GIMP_TEST_FILL_WIDTH; x++)
+      {
+        gint     d1 = (x - 128) * (x - 128) + (y - 128) * (y - 128);
+        gint     d2 = (x - 250) * (x - 250) + (y - 60)  * (y - 60);
+        gboolean on = (d1 < 50 * 50                    ||
+                       (d2 < 40 * 40 && d2 > 20 * 20)  ||
+                       (y % 16 == 3 && x >= 64 && x < 128) ||
+                       (x % 16 == 5 && y >= 128 && y < 192) ||
+                       x == 127 || x == 128);
+
+        pixels[y * GIMP_TEST_FILL_WIDTH + x] = on ? 1.0 : 0.0;
+      }
+
+  gegl_buffer_set (buffer,
+                   GEGL_RECTANGLE (0, 0,
+                                   GIMP_TEST_FILL_WIDTH,
+                                   GIMP_TEST_FILL_HEIGHT),
+                   0, babl_format ("Y float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (pixels);
+
+  cache = gimp_boundary_cache_new ();
+
+  gimp_test_check_boundary (cache, buffer,
+                            0, 0,
+                            GIMP_TEST_FILL_WIDTH, GIMP_TEST_FILL_HEIGHT);
+
+  /*  the second time, all segments come from the cache  */
+  gimp_test_check_boundary (cache, buffer,
+                            0, 0,
+                            GIMP_TEST_FILL_WIDTH, GIMP_TEST_FILL_HEIGHT);
+
+  /*  edits across tile edges, each invalidated on its own  */
+  gimp_test_fill_rect (buffer, 120, 120, 16, 16, 0.0);
+  gimp_test_fill_rect (buffer, 240, 100, 40, 60, 1.0);
+  gimp_test_fill_rect (buffer, 0, 127, GIMP_TEST_FILL_WIDTH, 2, 1.0);
+
+  gimp_boundary_cache_invalidate (cache, GEGL_RECTANGLE (120, 120, 16, 16));
+  gimp_boundary_cache_invalidate (cache, GEGL_RECTANGLE (240, 100, 40, 60));
+  gimp_boundary_cache_invalidate (cache,
+                                  GEGL_RECTANGLE (0, 127,
+                                                  GIMP_TEST_FILL_WIDTH, 2));
+
+  gimp_test_check_boundary (cache, buffer,
+                            0, 0,
+                            GIMP_TEST_FILL_WIDTH, GIMP_TEST_FILL_HEIGHT);
+
+  /*  an edit right next to a tile edge changes the tile beyond it  */
+  gimp_test_fill_rect (buffer, 127, 40, 1, 30, 0.0);
+  gimp_test_fill_rect (buffer, 100, 127, 20, 1, 0.0);
+
+  gimp_boundary_cache_invalidate (cache, GEGL_RECTANGLE (127, 40, 1, 30));
+  gimp_boundary_cache_invalidate (cache, GEGL_RECTANGLE (100, 127, 20, 1));
+
+  gimp_test_check_boundary (cache, buffer,
+                            0, 0,
+                            GIMP_TEST_FILL_WIDTH, GIMP_TEST_FILL_HEIGHT);
+
+  /*  bounds which cut through the shapes  */
+  gimp_test_check_boundary (cache, buffer, 100, 30, 270, 150);
+
+  gimp_test_fill_rect (buffer, 200, 30, 70, 10, 0.0);
+  gimp_boundary_cache_invalidate (cache, GEGL_RECTANGLE (200, 30, 70, 10));
+
+  gimp_test_check_boundary (cache, buffer, 100, 30, 270, 150);
+
+  /*  and everything at once  */
+  gimp_test_fill_rect (buffer, 0, 0,
+                       GIMP_TEST_FILL_WIDTH, GIMP_TEST_FILL_HEIGHT / 2, 1.0);
+  gimp_boundary_cache_invalidate (cache, NULL);
+
+  gimp_test_check_boundary (cache, buffer,
+                            0, 0,
+                            GIMP_TEST_FILL_WIDTH, GIMP_TEST_FILL_HEIGHT);
+
+  gimp_boundary_cache_free (cache);
+  g_object_unref (buffer);
+}
+
+static gint
+gimp_test_seg_compare (gconstpointer a,
+                       gconstpointer b)
+{
+  const GimpBoundSeg *seg_a = a;
+  const GimpBoundSeg *seg_b = b;
+
+  if (seg_a->y1 != seg_b->y1)
+    return seg_a->y1 - seg_b->y1;
+
+  if (seg_a->x1 != seg_b->x1)
+    return seg_a->x1 - seg_b->x1;
+
+  if (seg_a->y2 != seg_b->y2)
+    return seg_a->y2 - seg_b->y2;
+
+  if (seg_a->x2 != seg_b->x2)
+    return seg_a->x2 - seg_b->x2;
+
+  return (gint) seg_a->open - (gint) seg_b->open;
+}
+
+static void
+gimp_test_fill_rect (GeglBuffer *buffer,
+                     gint        x,
+                     gint        y,
+                     gint        width,
+                     gint        height,
+                     gfloat      value)
+{
+  GeglColor *color = gegl_color_new (NULL);
+
+  gegl_color_set_rgba (color, value, value, value, 1.0);
+
+  gegl_buffer_set_color (buffer, GEGL_RECTANGLE (x, y, width, height),
+                         color);
+
+  g_object_unref (color);
+}
+
+static void
+gimp_test_check_boundary (GimpBoundaryCache *cache,
+                          GeglBuffer        *buffer,
+                          gint               x1,
+                          gint               y1,
+                          gint               x2,
+                          gint               y2)
+{
+  GimpBoundSeg *expected;
+  GimpBoundSeg *result;
+  gint          n_expected;
+  gint          n_result;
+  gint          i;
+
+  expected = gimp_boundary_find (buffer, NULL,
+                                 babl_format ("Y float"),
+                                 GIMP_BOUNDARY_WITHIN_BOUNDS,
+                                 x1, y1, x2, y2,
+                                 GIMP_BOUNDARY_HALF_WAY,
+                                 &n_expected);
+
+  result = gimp_boundary_cache_find (cache, buffer, NULL,
+                                     babl_format ("Y float"),
+                                     x1, y1, x2, y2,
+                                     GIMP_BOUNDARY_HALF_WAY,
+                                     &n_result);
+
+  g_assert_cmpint (n_expected, >, 0);
+  g_assert_cmpint (n_result, ==, n_expected);
+
+  qsort (expected, n_expected, sizeof (GimpBoundSeg), gimp_test_seg_compare);
+  qsort (result,   n_result,   sizeof (GimpBoundSeg), gimp_test_seg_compare);
+
+  for (i = 0; i < n_expected; i++)
+    {
+      g_assert_cmpint (result[i].x1,   ==, expected[i].x1);
+      g_assert_cmpint (result[i].y1,   ==, expected[i].y1);
+      g_assert_cmpint (result[i].x2,   ==, expected[i].x2);
+      g_assert_cmpint (result[i].y2,   ==, expected[i].y2);
+      g_assert_cmpint (result[i].open, ==, expected[i].open);
+    }
+
+  g_free (expected);
+  g_free (result);
+}
+
+/**
+ * pixel_difference_row_sse2:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the SSE2 version of the fuzzy select pixel difference
+ * gives exactly the results of pixel_difference(), for all the
+ * criteria it handles, with and without antialiasing and alpha.
+ **/
+static void
+pixel_difference_row_sse2 (GimpTestFixture *fixture,
+                           gconstpointer    data)
+{
+#if COMPILE_SSE2_INTRINISICS
+  const GimpSelectCriterion criteria[] =
+  {
+    GIMP_SELECT_CRITERION_COMPOSITE,
+    GIMP_SELECT_CRITERION_R,
+    GIMP_SELECT_CRITERION_G,
+    GIMP_SELECT_CRITERION_B,
+    GIMP_SELECT_CRITERION_S,
+    GIMP_SELECT_CRITERION_V
+  };
+  const gfloat thresholds[] = { 0.0, 0.1, 15.0 / 255.0, 0.5, 1.0 };
+  const gint   n_pixels     = 67;
+  GRand       *rand;
+  gfloat       src[67 * 4];
+  gfloat       dest[67];
+  gfloat       col[4];
+  gint         n_checked    = 0;
+  gint         c, t, i;
+
+  if (! (gimp_cpu_accel_get_support () & GIMP_CPU_ACCEL_X86_SSE2))
+    return;
+
+  rand = g_rand_new_with_seed (42);
+
+  for (c = 0; c < G_N_ELEMENTS (criteria); c++)
+    for (t = 0; t < G_N_ELEMENTS (thresholds); t++)
+      {
+        gint n_components;
+
+        /*  only the composite criterion is used with gray and RGB
+         *  formats, the others always get four components
+         */
+        for (n_components = 1; n_components <= 4; n_components++)
+          {
+            gint variant;
+
+            if (criteria[c] != GIMP_SELECT_CRITERION_COMPOSITE &&
+                n_components != 4)
+              continue;
+
+            /*  antialias, has_alpha and select_transparent  */
+            for (variant = 0; variant < 8; variant++)
+              {
+                gboolean antialias          = (variant & 1) != 0;
+                gboolean has_alpha          = (variant & 2) != 0;
+                gboolean select_transparent = (variant & 4) != 0;
+                gsize    n_done;
+
+                if (has_alpha && n_components == 1)
+                  continue;
+
+                /*  exact hits of the seed color, of 0 and 1 and of
+                 *  the threshold's edges are the interesting cases
+                 */
+                for (i = 0; i < n_components; i++)
+                  col[i] = g_rand_int_range (rand, 0, 256) / 255.0;
+
+                for (i = 0; i < n_pixels * n_components; i++)
+                  {
+                    switch (g_rand_int_range (rand, 0, 6))
+                      {
+                      case 0:
+                        src[i] = col[i % n_components];
+                        break;
+
+                      case 1:
+                        src[i] = 0.0;
+                        break;
+
+                      case 2:
+                        src[i] = 1.0;
+                        break;
+
+                      case 3:
+                        src[i] = col[i % n_components] + thresholds[t];
+                        break;
+
+                      default:
+                        src[i] = g_rand_double_range (rand, -0.1, 1.1);
+                        break;
+                      }
+                  }
+
+                n_done = gimp_pickable_pixel_difference_row_sse2 (col, src, dest,
+                                                                  n_pixels,
+                                                                  antialias,
+                                                                  thresholds[t],
+                                                                  n_components,
+                                                                  has_alpha,
+                                                                  select_transparent,
+                                                                  criteria[c]);
+
+                g_assert_cmpint (n_done, >=, n_pixels - 4);
+                g_assert_cmpint (n_done, <=, n_pixels);
+
+                for (i = 0; i < n_done; i++)
+                  {
+                    gfloat expected;
+
+                    expected = pixel_difference (col, src + i * n_components,
+                                                 antialias, thresholds[t],
+                                                 n_components, has_alpha,
+                                                 select_transparent,
+                                                 criteria[c]);
+
+                    g_assert_cmpint (memcmp (&dest[i], &expected,
+                                             sizeof (gfloat)), ==, 0);
+
+                    n_checked++;
+                  }
+              }
+          }
+      }
+
+  g_assert_cmpint (n_checked, >, 0);
+
+  g_rand_free (rand);
+#endif /* COMPILE_SSE2_INTRINISICS */
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_IMAGE_TEST (contiguous_region_by_seed);
+  ADD_IMAGE_TEST (boundary_cache_find);
+  ADD_IMAGE_TEST (pixel_difference_row_sse2);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -506,10 +506,11 @@ gimp_file_dialog_set_save_image (GimpFileDialog *dialog,
 
   if (! export)
     {
-      gint         rle_version;
-      gint         zlib_version;
-      const gchar *version_string;
-      gchar       *tooltip;
+      GimpXcfCompression  compression;
+      gint                rle_version;
+      gint                compressed_version;
+      const gchar        *version_string;
+      gchar              *tooltip;
 
       /*
        * Priority of default paths for Save:
@@ -580,10 +581,14 @@ gimp_file_dialog_set_save_image (GimpFileDialog *dialog,
       else
         ext_file = g_file_new_for_uri ("file:///we/only/care/about/extension.xcf");
 
-      gimp_image_get_xcf_version (image, FALSE, &rle_version,  &version_string);
-      gimp_image_get_xcf_version (image, TRUE,  &zlib_version, NULL);
+      compression = image->gimp->config->xcf_compression;
 
-      if (rle_version == zlib_version)
+      gimp_image_get_xcf_version (image, GIMP_XCF_COMPRESSION_RLE,
+                                  &rle_version, &version_string);
+      gimp_image_get_xcf_version (image, compression,
+                                  &compressed_version, NULL);
+
+      if (rle_version == compressed_version)
         {
           gtk_widget_set_sensitive (dialog->compat_toggle, FALSE);
 
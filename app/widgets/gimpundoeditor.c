@@ -30,6 +30,7 @@
 #include "core/gimplist.h"
 #include "core/gimpimage.h"
 #include "core/gimpimage-undo.h"
+#include "core/gimpundo.h"
 #include "core/gimpundostack.h"
 
 #include "gimpcontainertreeview.h"
@@ -65,6 +66,7 @@ static void   gimp_undo_editor_set_context    (GimpDocked        *docked,
 
 static void   gimp_undo_editor_fill           (GimpUndoEditor    *editor);
 static void   gimp_undo_editor_clear          (GimpUndoEditor    *editor);
+static void   gimp_undo_editor_update_memsize (GimpUndoEditor    *editor);
 
 static void   gimp_undo_editor_undo_event     (GimpImage         *image,
                                                GimpUndoEvent      event,
@@ -137,6 +139,15 @@ gimp_undo_editor_constructed (GObject *object)
   gtk_box_pack_start (GTK_BOX (undo_editor), undo_editor->view, TRUE, TRUE, 0);
   gtk_widget_show (undo_editor->view);
 
+  undo_editor->memsize_label = gtk_label_new (NULL);
+  gtk_misc_set_alignment (GTK_MISC (undo_editor->memsize_label), 0.0, 0.5);
+  gimp_label_set_attributes (GTK_LABEL (undo_editor->memsize_label),
+                             PANGO_ATTR_SCALE, PANGO_SCALE_SMALL,
+                             -1);
+  gtk_box_pack_start (GTK_BOX (undo_editor), undo_editor->memsize_label,
+                      FALSE, FALSE, 0);
+  gtk_widget_show (undo_editor->memsize_label);
+
   g_signal_connect (undo_editor->view, "select-item",
                     G_CALLBACK (gimp_undo_editor_select_item),
                     undo_editor);
@@ -319,6 +330,8 @@ gimp_undo_editor_fill (GimpUndoEditor *editor)
   g_signal_handlers_unblock_by_func (editor->view,
                                      gimp_undo_editor_select_item,
                                      editor);
+
+  gimp_undo_editor_update_memsize (editor);
 }
 
 static void
@@ -337,6 +350,64 @@ gimp_undo_editor_clear (GimpUndoEditor *editor)
       g_object_unref (editor->base_item);
       editor->base_item = NULL;
     }
+
+  gtk_label_set_text (GTK_LABEL (editor->memsize_label), NULL);
+  gimp_help_set_help_data (editor->memsize_label, NULL, NULL);
+}
+
+static void
+gimp_undo_editor_update_memsize (GimpUndoEditor *editor)
+{
+  GimpImage     *image      = GIMP_IMAGE_EDITOR (editor)->image;
+  GimpUndoStack *undo_stack = gimp_image_get_undo_stack (image);
+  GimpUndoStack *redo_stack = gimp_image_get_redo_stack (image);
+  GArray        *memsizes;
+  GString       *tooltip;
+  gchar         *undo_size;
+  gchar         *redo_size;
+  gchar         *text;
+  gint           i;
+
+  gimp_undo_stack_update_top_memsize (undo_stack);
+  gimp_undo_stack_update_top_memsize (redo_stack);
+
+  undo_size = g_format_size (gimp_undo_stack_get_undos_memsize (undo_stack));
+  redo_size = g_format_size (gimp_undo_stack_get_undos_memsize (redo_stack));
+
+  text = g_strdup_printf (_("Undo: %s, Redo: %s"), undo_size, redo_size);
+  gtk_label_set_text (GTK_LABEL (editor->memsize_label), text);
+  g_free (text);
+
+  g_free (undo_size);
+  g_free (redo_size);
+
+  /*  list the memory used by each kind of undo step in the tooltip  */
+  memsizes = gimp_undo_stack_get_type_memsizes (undo_stack);
+  tooltip  = g_string_new (NULL);
+
+  for (i = 0; i < memsizes->len; i++)
+    {
+      GimpUndoTypeMemsize *memsize;
+      gchar               *size;
+
+      memsize = &g_array_index (memsizes, GimpUndoTypeMemsize, i);
+      size    = g_format_size (memsize->memsize);
+
+      if (i > 0)
+        g_string_append_c (tooltip, '\n');
+
+      g_string_append_printf (tooltip, "%s: %s",
+                              gimp_undo_type_to_name (memsize->undo_type),
+                              size);
+
+      g_free (size);
+    }
+
+  gimp_help_set_help_data (editor->memsize_label,
+                           tooltip->len ? tooltip->str : NULL, NULL);
+
+  g_string_free (tooltip, TRUE);
+  g_array_free (memsizes, TRUE);
 }
 
 static void
@@ -407,6 +478,9 @@ gimp_undo_editor_undo_event (GimpImage      *image,
       gimp_undo_editor_fill (editor);
       break;
     }
+
+  if (editor->container)
+    gimp_undo_editor_update_memsize (editor);
 }
 
 static void
@@ -40,6 +40,7 @@ struct _GimpUndoEditor
   GimpContainer   *container;
   GtkWidget       *view;
   GimpViewSize     view_size;
+  GtkWidget       *memsize_label;
 
   GimpUndo        *base_item;
 
@@ -19,6 +19,7 @@
 
 #include <string.h>
 #include <zlib.h>
+#include <zstd.h>
 
 #include <cairo.h>
 #include <gegl.h>
@@ -26,14 +27,15 @@
 
 #include "libgimpbase/gimpbase.h"
 #include "libgimpcolor/gimpcolor.h"
+#include "libgimpconfig/gimpconfig.h"
+#include "libgimpmath/gimpmath.h"
 
 #include "core/core-types.h"
 
 #include "config/gimpcoreconfig.h"
 
-#include "gegl/gimp-gegl-tile-compat.h"
-
 #include "core/gimp.h"
+#include "core/gimp-parallel.h"
 #include "core/gimpcontainer.h"
 #include "core/gimpdrawable-private.h" /* eek */
 #include "core/gimpgrid.h"
@@ -68,6 +70,7 @@
 #include "xcf-load.h"
 #include "xcf-read.h"
 #include "xcf-seek.h"
+#include "xcf-tile-backend.h"
 
 #include "gimp-log.h"
 #include "gimp-intl.h"
@@ -75,9 +78,30 @@
 
 #define MAX_XCF_PARASITE_DATA_LEN (256L * 1024 * 1024)
 
+/* the number of tiles which are decoded in parallel at a time */
+#define XCF_LOAD_BATCH_SIZE 64
+
 /* #define GIMP_XCF_PATH_DEBUG */
 
 
+typedef struct
+{
+  GeglRectangle  rect;
+  guchar        *xcfdata;      /* the tile's data as read from the file */
+  gint           data_length;
+  guchar        *data;         /* the decoded pixels                    */
+  gboolean       success;
+} XcfLoadTile;
+
+typedef struct
+{
+  XcfCompressionType  compression;
+  gint                bpp;
+  XcfLoadTile        *tiles;
+  gint                n_tiles;
+} XcfLoadTileBatch;
+
+
 static void            xcf_load_add_masks     (GimpImage     *image);
 static gboolean        xcf_load_image_props   (XcfInfo       *info,
                                                GimpImage     *image);
@@ -104,23 +128,56 @@ static GimpChannel   * xcf_load_channel       (XcfInfo       *info,
 static GimpLayerMask * xcf_load_layer_mask    (XcfInfo       *info,
                                                GimpImage     *image);
 static gboolean        xcf_load_buffer        (XcfInfo       *info,
-                                               GeglBuffer    *buffer);
+                                               GimpDrawable  *drawable);
+static gboolean        xcf_load_buffer_level  (XcfInfo       *info,
+                                               GeglBuffer    *buffer,
+                                               gint           width,
+                                               gint           height);
+static gboolean        xcf_load_level_is_stored
+                                              (XcfInfo       *info,
+                                               goffset        offset);
+static goffset       * xcf_load_level_offsets (XcfInfo       *info,
+                                               gint           width,
+                                               gint           height,
+                                               gint          *n_tiles,
+                                               gboolean      *success);
 static gboolean        xcf_load_level         (XcfInfo       *info,
                                                GeglBuffer    *buffer);
-static gboolean        xcf_load_tile          (XcfInfo       *info,
+static gboolean        xcf_load_level_scaled  (XcfInfo       *info,
                                                GeglBuffer    *buffer,
-                                               GeglRectangle *tile_rect,
-                                               const Babl    *format);
-static gboolean        xcf_load_tile_rle      (XcfInfo       *info,
-                                               GeglBuffer    *buffer,
-                                               GeglRectangle *tile_rect,
-                                               const Babl    *format,
-                                               gint           data_length);
-static gboolean        xcf_load_tile_zlib     (XcfInfo       *info,
-                                               GeglBuffer    *buffer,
-                                               GeglRectangle *tile_rect,
+                                               gint           width,
+                                               gint           height,
+                                               gint           shift);
+static void            xcf_load_scale_tile    (GeglBuffer    *buffer,
+                                               const GeglRectangle *rect,
+                                               const guchar  *data,
                                                const Babl    *format,
+                                               gint           shift);
+static gboolean        xcf_load_level_lazy    (XcfInfo       *info,
+                                               GimpDrawable  *drawable);
+static gint            xcf_load_tile_data     (XcfInfo       *info,
+                                               guchar        *xcfdata,
                                                gint           data_length);
+static void            xcf_load_decode_tiles  (gint              i,
+                                               gint              n,
+                                               XcfLoadTileBatch *batch);
+static gboolean        xcf_load_tile          (const guchar  *xcfdata,
+                                               gint           data_length,
+                                               guchar        *tile_data,
+                                               gint           tile_size);
+static gboolean        xcf_load_tile_rle      (const guchar  *xcfdata,
+                                               gint           data_length,
+                                               guchar        *tile_data,
+                                               gint           bpp,
+                                               gint           n_pixels);
+static gboolean        xcf_load_tile_zlib     (const guchar  *xcfdata,
+                                               gint           data_length,
+                                               guchar        *tile_data,
+                                               gint           tile_size);
+static gboolean        xcf_load_tile_zstd     (const guchar  *xcfdata,
+                                               gint           data_length,
+                                               guchar        *tile_data,
+                                               gint           tile_size);
 static GimpParasite  * xcf_load_parasite      (XcfInfo       *info);
 static gboolean        xcf_load_old_paths     (XcfInfo       *info,
                                                GimpImage     *image);
@@ -134,6 +191,11 @@ static gboolean        xcf_load_vector        (XcfInfo       *info,
 static gboolean        xcf_skip_unknown_prop  (XcfInfo       *info,
                                                gsize          size);
 
+static gint            xcf_load_scale_size    (XcfInfo       *info,
+                                               gint           size);
+static gint            xcf_load_scale_offset  (XcfInfo       *info,
+                                               gint           offset);
+
 
 #define xcf_progress_update(info) G_STMT_START  \
   {                                             \
@@ -150,8 +212,8 @@ xcf_load_image (Gimp     *gimp,
   GimpImage          *image = NULL;
   const GimpParasite *parasite;
   gboolean            has_metadata = FALSE;
-  guint32             saved_pos;
-  guint32             offset;
+  goffset             saved_pos;
+  goffset             offset;
   gint                width;
   gint                height;
   gint                image_type;
@@ -213,6 +275,27 @@ xcf_load_image (Gimp     *gimp,
   GIMP_LOG (XCF, "version=%d, width=%d, height=%d, image_type=%d, precision=%d",
             info->file_version, width, height, image_type, precision);
 
+  info->image_width  = width;
+  info->image_height = height;
+
+  /* for thumbnails, pick the smallest mipmap level which is not
+   * smaller than the thumbnail, indexed pixels can't be downscaled
+   */
+  if (info->thumbnail_size > 0 && image_type != GIMP_INDEXED)
+    {
+      while ((MAX (width, height) >> (info->level + 1)) >=
+             info->thumbnail_size)
+        {
+          info->level++;
+        }
+
+      width  = xcf_load_scale_size (info, width);
+      height = xcf_load_scale_size (info, height);
+
+      GIMP_LOG (XCF, "loading level %d, width=%d, height=%d",
+                info->level, width, height);
+    }
+
   image = gimp_create_image (gimp, width, height, image_type, precision,
                              FALSE);
 
@@ -371,7 +454,8 @@ xcf_load_image (Gimp     *gimp,
       GList     *item_path = NULL;
 
       /* read in the offset of the next layer */
-      info->cp += xcf_read_int32 (info->input, &offset, 1);
+      info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                                   &offset, 1);
 
       /* if the offset is 0 then we are at the end
        *  of the layer list.
@@ -455,7 +539,8 @@ xcf_load_image (Gimp     *gimp,
       GimpChannel *channel;
 
       /* read in the offset of the next channel */
-      info->cp += xcf_read_int32 (info->input, &offset, 1);
+      info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                                   &offset, 1);
 
       /* if the offset is 0 then we are at the end
        *  of the channel list.
@@ -662,6 +747,7 @@ xcf_load_image_props (XcfInfo   *info,
             if ((compression != COMPRESS_NONE) &&
                 (compression != COMPRESS_RLE) &&
                 (compression != COMPRESS_ZLIB) &&
+                (compression != COMPRESS_ZSTD) &&
                 (compression != COMPRESS_FRACTAL))
               {
                 gimp_message (info->gimp, G_OBJECT (info->progress),
@@ -692,8 +778,10 @@ xcf_load_image_props (XcfInfo   *info,
                 info->cp += xcf_read_int8 (info->input,
                                            (guint8 *) &orientation, 1);
 
-                /*  skip -1 guides from old XCFs  */
-                if (position < 0)
+                /*  skip -1 guides from old XCFs, and all guides
+                 *  of thumbnails
+                 */
+                if (position < 0 || info->level > 0)
                   continue;
 
                 GIMP_LOG (XCF, "prop guide orientation=%d position=%d",
@@ -738,7 +826,8 @@ xcf_load_image_props (XcfInfo   *info,
 
                 GIMP_LOG (XCF, "prop sample point x=%d y=%d", x, y);
 
-                gimp_image_add_sample_point_at_pos (image, x, y, FALSE);
+                if (info->level == 0)
+                  gimp_image_add_sample_point_at_pos (image, x, y, FALSE);
               }
           }
           break;
@@ -778,7 +867,7 @@ xcf_load_image_props (XcfInfo   *info,
 
         case PROP_PARASITES:
           {
-            glong base = info->cp;
+            goffset base = info->cp;
 
             while (info->cp - base < prop_size)
               {
@@ -889,14 +978,14 @@ xcf_load_image_props (XcfInfo   *info,
 
         case PROP_VECTORS:
           {
-            guint32 base = info->cp;
+            goffset base = info->cp;
 
             if (xcf_load_vectors (info, image))
               {
                 if (base + prop_size != info->cp)
                   {
                     g_printerr ("Mismatch in PROP_VECTORS size: "
-                                "skipping %d bytes.\n",
+                                "skipping %" G_GOFFSET_FORMAT " bytes.\n",
                                 base + prop_size - info->cp);
                     xcf_seek_pos (info, base + prop_size, NULL);
                   }
@@ -956,8 +1045,8 @@ xcf_load_layer_props (XcfInfo    *info,
         case PROP_FLOATING_SELECTION:
           info->floating_sel = *layer;
           info->cp +=
-            xcf_read_int32 (info->input,
-                            (guint32 *) &info->floating_sel_offset, 1);
+            xcf_read_offset (info->input, info->bytes_per_offset,
+                             &info->floating_sel_offset, 1);
           break;
 
         case PROP_OPACITY:
@@ -1042,7 +1131,9 @@ xcf_load_layer_props (XcfInfo    *info,
             info->cp += xcf_read_int32 (info->input, &offset_x, 1);
             info->cp += xcf_read_int32 (info->input, &offset_y, 1);
 
-            gimp_item_set_offset (GIMP_ITEM (*layer), offset_x, offset_y);
+            gimp_item_set_offset (GIMP_ITEM (*layer),
+                                  xcf_load_scale_offset (info, offset_x),
+                                  xcf_load_scale_offset (info, offset_y));
           }
           break;
 
@@ -1070,7 +1161,7 @@ xcf_load_layer_props (XcfInfo    *info,
 
         case PROP_PARASITES:
           {
-            glong base = info->cp;
+            goffset base = info->cp;
 
             while (info->cp - base < prop_size)
               {
@@ -1124,8 +1215,8 @@ xcf_load_layer_props (XcfInfo    *info,
 
         case PROP_ITEM_PATH:
           {
-            glong  base = info->cp;
-            GList *path = NULL;
+            goffset  base = info->cp;
+            GList   *path = NULL;
 
             while (info->cp - base < prop_size)
               {
@@ -1284,7 +1375,7 @@ xcf_load_channel_props (XcfInfo      *info,
 
         case PROP_PARASITES:
           {
-            glong base = info->cp;
+            goffset base = info->cp;
 
             while ((info->cp - base) < prop_size)
               {
@@ -1357,8 +1448,8 @@ xcf_load_layer (XcfInfo    *info,
 {
   GimpLayer         *layer;
   GimpLayerMask     *layer_mask;
-  guint32            hierarchy_offset;
-  guint32            layer_mask_offset;
+  goffset            hierarchy_offset;
+  goffset            layer_mask_offset;
   gboolean           apply_mask = TRUE;
   gboolean           edit_mask  = FALSE;
   gboolean           show_mask  = FALSE;
@@ -1428,6 +1519,9 @@ xcf_load_layer (XcfInfo    *info,
   if (width <= 0 || height <= 0)
     return NULL;
 
+  width  = xcf_load_scale_size (info, width);
+  height = xcf_load_scale_size (info, height);
+
   /* do not use gimp_image_get_layer_format() because it might
    * be the floating selection of a channel or mask
    */
@@ -1452,11 +1546,13 @@ xcf_load_layer (XcfInfo    *info,
 
   xcf_progress_update (info);
 
-  /* call the evil text layer hack that might change our layer pointer */
+  /* call the evil text layer hack that might change our layer pointer,
+   * not for thumbnails, the text would be rendered at full size
+   */
   active   = (info->active_layer == layer);
   floating = (info->floating_sel == layer);
 
-  if (gimp_text_layer_xcf_load_hack (&layer))
+  if (info->level == 0 && gimp_text_layer_xcf_load_hack (&layer))
     {
       gimp_text_layer_set_xcf_flags (GIMP_TEXT_LAYER (layer),
                                      text_layer_flags);
@@ -1468,8 +1564,10 @@ xcf_load_layer (XcfInfo    *info,
     }
 
   /* read the hierarchy and layer mask offsets */
-  info->cp += xcf_read_int32 (info->input, &hierarchy_offset, 1);
-  info->cp += xcf_read_int32 (info->input, &layer_mask_offset, 1);
+  info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                               &hierarchy_offset, 1);
+  info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                               &layer_mask_offset, 1);
 
   /* read in the hierarchy (ignore it for group layers, both as an
    * optimization and because the hierarchy's extents don't match
@@ -1482,8 +1580,7 @@ xcf_load_layer (XcfInfo    *info,
 
       GIMP_LOG (XCF, "loading buffer");
 
-      if (! xcf_load_buffer (info,
-                             gimp_drawable_get_buffer (GIMP_DRAWABLE (layer))))
+      if (! xcf_load_buffer (info, GIMP_DRAWABLE (layer)))
         goto error;
 
       GIMP_LOG (XCF, "buffer loaded");
@@ -1540,7 +1637,7 @@ xcf_load_channel (XcfInfo   *info,
                   GimpImage *image)
 {
   GimpChannel *channel;
-  guint32      hierarchy_offset;
+  goffset      hierarchy_offset;
   gint         width;
   gint         height;
   gboolean     is_fs_drawable;
@@ -1558,6 +1655,9 @@ xcf_load_channel (XcfInfo   *info,
   if (width <= 0 || height <= 0)
     return NULL;
 
+  width  = xcf_load_scale_size (info, width);
+  height = xcf_load_scale_size (info, height);
+
   info->cp += xcf_read_string (info->input, &name, 1);
 
   /* create a new channel */
@@ -1573,14 +1673,14 @@ xcf_load_channel (XcfInfo   *info,
   xcf_progress_update (info);
 
   /* read the hierarchy and layer mask offsets */
-  info->cp += xcf_read_int32 (info->input, &hierarchy_offset, 1);
+  info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                               &hierarchy_offset, 1);
 
   /* read in the hierarchy */
   if (!xcf_seek_pos (info, hierarchy_offset, NULL))
     goto error;
 
-  if (!xcf_load_buffer (info,
-                        gimp_drawable_get_buffer (GIMP_DRAWABLE (channel))))
+  if (!xcf_load_buffer (info, GIMP_DRAWABLE (channel)))
     goto error;
 
   xcf_progress_update (info);
@@ -1601,7 +1701,7 @@ xcf_load_layer_mask (XcfInfo   *info,
 {
   GimpLayerMask *layer_mask;
   GimpChannel   *channel;
-  guint32        hierarchy_offset;
+  goffset        hierarchy_offset;
   gint           width;
   gint           height;
   gboolean       is_fs_drawable;
@@ -1619,6 +1719,9 @@ xcf_load_layer_mask (XcfInfo   *info,
   if (width <= 0 || height <= 0)
     return NULL;
 
+  width  = xcf_load_scale_size (info, width);
+  height = xcf_load_scale_size (info, height);
+
   info->cp += xcf_read_string (info->input, &name, 1);
 
   /* create a new layer mask */
@@ -1635,14 +1738,14 @@ xcf_load_layer_mask (XcfInfo   *info,
   xcf_progress_update (info);
 
   /* read the hierarchy and layer mask offsets */
-  info->cp += xcf_read_int32 (info->input, &hierarchy_offset, 1);
+  info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                               &hierarchy_offset, 1);
 
   /* read in the hierarchy */
   if (! xcf_seek_pos (info, hierarchy_offset, NULL))
     goto error;
 
-  if (!xcf_load_buffer (info,
-                        gimp_drawable_get_buffer (GIMP_DRAWABLE (layer_mask))))
+  if (!xcf_load_buffer (info, GIMP_DRAWABLE (layer_mask)))
     goto error;
 
   xcf_progress_update (info);
@@ -1659,11 +1762,12 @@ xcf_load_layer_mask (XcfInfo   *info,
 }
 
 static gboolean
-xcf_load_buffer (XcfInfo    *info,
-                 GeglBuffer *buffer)
+xcf_load_buffer (XcfInfo      *info,
+                 GimpDrawable *drawable)
 {
+  GeglBuffer *buffer = gimp_drawable_get_buffer (drawable);
   const Babl *format;
-  guint32     offset;
+  goffset     offset;
   gint        width;
   gint        height;
   gint        bpp;
@@ -1677,20 +1781,35 @@ xcf_load_buffer (XcfInfo    *info,
   /* make sure the values in the file correspond to the values
    *  calculated when the TileManager was created.
    */
-  if (width  != gegl_buffer_get_width (buffer)  ||
-      height != gegl_buffer_get_height (buffer) ||
-      bpp    != babl_format_get_bytes_per_pixel (format))
+  if (xcf_load_scale_size (info, width)  != gegl_buffer_get_width (buffer)  ||
+      xcf_load_scale_size (info, height) != gegl_buffer_get_height (buffer) ||
+      bpp != babl_format_get_bytes_per_pixel (format))
     return FALSE;
 
-  info->cp += xcf_read_int32 (info->input, &offset, 1); /* top level */
+  if (info->level > 0)
+    return xcf_load_buffer_level (info, buffer, width, height);
+
+  info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                               &offset, 1); /* top level */
 
   /* seek to the level offset */
   if (!xcf_seek_pos (info, offset, NULL))
     return FALSE;
 
-  /* read in the level */
-  if (!xcf_load_level (info, buffer))
-    return FALSE;
+  /* read in the level, only layers and layer masks are loaded
+   * lazily, the selection's buffer is swapped around while loading
+   */
+  if (info->lazy_input &&
+      (GIMP_IS_LAYER (drawable) || GIMP_IS_LAYER_MASK (drawable)))
+    {
+      if (!xcf_load_level_lazy (info, drawable))
+        return FALSE;
+    }
+  else
+    {
+      if (!xcf_load_level (info, buffer))
+        return FALSE;
+    }
 
   /* discard levels below first.
    */
@@ -1698,202 +1817,577 @@ xcf_load_buffer (XcfInfo    *info,
   return TRUE;
 }
 
+/* loads a thumbnail-sized buffer from the mipmap levels of a
+ * hierarchy.  the smallest stored level which is not smaller than
+ * info->level is loaded and, if needed, downscaled to the buffer's
+ * size tile by tile, so files without mipmaps still load without
+ * creating a full-size buffer.
+ */
+static gboolean
+xcf_load_buffer_level (XcfInfo    *info,
+                       GeglBuffer *buffer,
+                       gint        width,
+                       gint        height)
+{
+  goffset *level_offsets;
+  gint     n_levels = 0;
+  gint     level;
+
+  level_offsets = g_new0 (goffset, info->level + 1);
+
+  for (level = 0; level <= info->level; level++)
+    {
+      info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                                   &level_offsets[level], 1);
+
+      if (level_offsets[level] == 0)
+        break;
+
+      n_levels++;
+    }
+
+  for (level = n_levels - 1; level > 0; level--)
+    {
+      if (xcf_load_level_is_stored (info, level_offsets[level]))
+        break;
+    }
+
+  if (n_levels == 0 || ! xcf_seek_pos (info, level_offsets[level], NULL))
+    {
+      g_free (level_offsets);
+      return FALSE;
+    }
+
+  g_free (level_offsets);
 
+  GIMP_LOG (XCF, "loading level %d of %d, wanted %d",
+            level, n_levels, info->level);
+
+  /* each stored level is half the size of the previous one */
+  return xcf_load_level_scaled (info, buffer,
+                                width >> level, height >> level,
+                                info->level - level);
+}
+
+/* levels which were not saved as mipmaps only have an empty tile
+ * offset table
+ */
 static gboolean
-xcf_load_level (XcfInfo    *info,
-                GeglBuffer *buffer)
+xcf_load_level_is_stored (XcfInfo *info,
+                          goffset  offset)
 {
-  const Babl *format;
-  gint        bpp;
-  guint32     saved_pos;
-  guint32     offset, offset2;
-  gint        n_tile_rows;
-  gint        n_tile_cols;
-  guint       ntiles;
-  gint        width;
-  gint        height;
-  gint        i;
-  gint        fail;
+  gint    width;
+  gint    height;
+  goffset tile_offset;
 
-  format = gegl_buffer_get_format (buffer);
-  bpp    = babl_format_get_bytes_per_pixel (format);
+  if (! xcf_seek_pos (info, offset, NULL))
+    return FALSE;
 
   info->cp += xcf_read_int32 (info->input, (guint32 *) &width, 1);
   info->cp += xcf_read_int32 (info->input, (guint32 *) &height, 1);
+  info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                               &tile_offset, 1);
 
-  if (width  != gegl_buffer_get_width (buffer) ||
-      height != gegl_buffer_get_height (buffer))
-    return FALSE;
+  return width > 0 && height > 0 && tile_offset != 0;
+}
+
+/* reads a level's tile offset table, returns NULL if the level is
+ * empty or on error, in which case 'success' is set to FALSE.  the
+ * returned table has ntiles + 1 entries, the last one being 0.
+ */
+static goffset *
+xcf_load_level_offsets (XcfInfo  *info,
+                        gint      width,
+                        gint      height,
+                        gint     *n_tiles,
+                        gboolean *success)
+{
+  goffset *offsets;
+  gint     n_tile_rows;
+  gint     n_tile_cols;
+  gint     ntiles;
+  gint     level_width;
+  gint     level_height;
+  gint     i;
+
+  *success = FALSE;
+
+  info->cp += xcf_read_int32 (info->input, (guint32 *) &level_width, 1);
+  info->cp += xcf_read_int32 (info->input, (guint32 *) &level_height, 1);
+
+  if (level_width != width || level_height != height)
+    return NULL;
+
+  n_tile_rows = (height + XCF_TILE_HEIGHT - 1) / XCF_TILE_HEIGHT;
+  n_tile_cols = (width  + XCF_TILE_WIDTH  - 1) / XCF_TILE_WIDTH;
+
+  ntiles = n_tile_rows * n_tile_cols;
+
+  offsets = g_new0 (goffset, ntiles + 1);
 
   /* read in the first tile offset.
    *  if it is '0', then this tile level is empty
    *  and we can simply return.
    */
-  info->cp += xcf_read_int32 (info->input, &offset, 1);
-  if (offset == 0)
-    return TRUE;
+  info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                               offsets, 1);
+  if (offsets[0] == 0)
+    {
+      g_free (offsets);
+      *success = TRUE;
+      return NULL;
+    }
 
-  n_tile_rows = gimp_gegl_buffer_get_n_tile_rows (buffer, XCF_TILE_HEIGHT);
-  n_tile_cols = gimp_gegl_buffer_get_n_tile_cols (buffer, XCF_TILE_WIDTH);
+  /* read in the rest of the table, so the tiles' data can be
+   * read without seeking back and forth
+   */
+  info->cp += xcf_read_offset (info->input, info->bytes_per_offset,
+                               offsets + 1, ntiles);
 
-  ntiles = n_tile_rows * n_tile_cols;
   for (i = 0; i < ntiles; i++)
     {
-      GeglRectangle rect;
-
-      fail = FALSE;
-
-      if (offset == 0)
+      if (offsets[i] == 0)
         {
           gimp_message_literal (info->gimp, G_OBJECT (info->progress),
                                 GIMP_MESSAGE_ERROR,
                                 "not enough tiles found in level");
-          return FALSE;
+          g_free (offsets);
+          return NULL;
         }
+    }
 
-      /* save the current position as it is where the
-       *  next tile offset is stored.
-       */
-      saved_pos = info->cp;
+  if (offsets[ntiles] != 0)
+    {
+      gimp_message (info->gimp, G_OBJECT (info->progress), GIMP_MESSAGE_ERROR,
+                    "encountered garbage after reading level: %"
+                    G_GOFFSET_FORMAT, offsets[ntiles]);
+      g_free (offsets);
+      return NULL;
+    }
 
-      /* read in the offset of the next tile so we can calculate the amount
-         of data needed for this tile*/
-      info->cp += xcf_read_int32 (info->input, &offset2, 1);
+  *n_tiles = ntiles;
+  *success = TRUE;
 
-      /* if the offset is 0 then we need to read in the maximum possible
-         allowing for negative compression */
-      if (offset2 == 0)
-        offset2 = offset + XCF_TILE_WIDTH * XCF_TILE_WIDTH * bpp * 1.5;
-                                        /* 1.5 is probably more
-                                           than we need to allow */
+  return offsets;
+}
 
-      /* seek to the tile offset */
-      if (! xcf_seek_pos (info, offset, NULL))
-        return FALSE;
+static gboolean
+xcf_load_level (XcfInfo    *info,
+                GeglBuffer *buffer)
+{
+  return xcf_load_level_scaled (info, buffer,
+                                gegl_buffer_get_width (buffer),
+                                gegl_buffer_get_height (buffer),
+                                0);
+}
+
+/* loads a level of 'width' x 'height' pixels into 'buffer', which is
+ * smaller by a factor of 2^shift in both directions.  when
+ * downscaling, each tile is averaged into the buffer as soon as it is
+ * decoded, and tiles which don't contribute to any pixel of the buffer
+ * are not even read.
+ */
+static gboolean
+xcf_load_level_scaled (XcfInfo    *info,
+                       GeglBuffer *buffer,
+                       gint        width,
+                       gint        height,
+                       gint        shift)
+{
+  const Babl       *format;
+  XcfLoadTileBatch  batch;
+  goffset          *offsets;
+  guchar           *tile_data;
+  gint              bpp;
+  gint              max_tile_size;
+  gint              n_tile_cols;
+  gint              ntiles;
+  gint              i;
+  gboolean          success;
+
+  format = gegl_buffer_get_format (buffer);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  offsets = xcf_load_level_offsets (info, width, height, &ntiles, &success);
+  if (! offsets)
+    return success;
+
+  n_tile_cols = (width + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH;
+
+  max_tile_size = XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp;
+
+  batch.compression = info->compression;
+  batch.bpp         = bpp;
+  batch.tiles       = g_new0 (XcfLoadTile, XCF_LOAD_BATCH_SIZE);
+
+  tile_data = g_malloc (XCF_LOAD_BATCH_SIZE * max_tile_size);
+
+  for (i = 0; i < XCF_LOAD_BATCH_SIZE; i++)
+    batch.tiles[i].data = tile_data + i * max_tile_size;
 
-      /* get the tile from the tile manager */
-      gimp_gegl_buffer_get_tile_rect (buffer,
-                                      XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
-                                      i, &rect);
+  for (i = 0; success && i < ntiles; i += batch.n_tiles)
+    {
+      gint j;
 
-      GIMP_LOG (XCF, "loading tile %d/%d", i + 1, ntiles);
+      batch.n_tiles = MIN (ntiles - i, XCF_LOAD_BATCH_SIZE);
 
-      /* read in the tile */
-      switch (info->compression)
+      /* read the batch's tile data, in file order */
+      for (j = 0; j < batch.n_tiles; j++)
         {
-        case COMPRESS_NONE:
-          if (!xcf_load_tile (info, buffer, &rect, format))
-            fail = TRUE;
-          break;
-        case COMPRESS_RLE:
-          if (!xcf_load_tile_rle (info, buffer, &rect, format,
-                                  offset2 - offset))
-            fail = TRUE;
-          break;
-        case COMPRESS_ZLIB:
-          if (!xcf_load_tile_zlib (info, buffer, &rect, format,
-                                   offset2 - offset))
-            fail = TRUE;
-          break;
-        case COMPRESS_FRACTAL:
-          g_printerr ("xcf: fractal compression unimplemented. "
-                      "Possibly corrupt XCF file.");
-          fail = TRUE;
-          break;
-        default:
-          g_printerr ("xcf: unknown compression. "
-                      "Possibly corrupt XCF file.");
-          fail = TRUE;
-          break;
+          XcfLoadTile *tile   = &batch.tiles[j];
+          goffset      offset = offsets[i + j];
+          goffset      offset2;
+
+          tile->rect.x      = ((i + j) % n_tile_cols) * XCF_TILE_WIDTH;
+          tile->rect.y      = ((i + j) / n_tile_cols) * XCF_TILE_HEIGHT;
+          tile->rect.width  = MIN (XCF_TILE_WIDTH,  width  - tile->rect.x);
+          tile->rect.height = MIN (XCF_TILE_HEIGHT, height - tile->rect.y);
+
+          tile->xcfdata     = NULL;
+          tile->data_length = 0;
+          tile->success     = TRUE;
+
+          /* when downscaling by more than a tile's size, only the
+           * tiles at the top left of each downscaled pixel are
+           * sampled, and the pixels beyond the last whole downscaled
+           * pixel are dropped
+           */
+          if (shift > 0 &&
+              ((tile->rect.x & ((1 << shift) - 1)) != 0                   ||
+               (tile->rect.y & ((1 << shift) - 1)) != 0                   ||
+               (tile->rect.x >> shift) >= gegl_buffer_get_width  (buffer) ||
+               (tile->rect.y >> shift) >= gegl_buffer_get_height (buffer)))
+            continue;
+
+          GIMP_LOG (XCF, "loading tile %d/%d", i + j + 1, ntiles);
+
+          if (info->compression == COMPRESS_NONE)
+            {
+              offset2 = offset + (tile->rect.width * tile->rect.height * bpp);
+            }
+          else
+            {
+              /* the offset of the next tile gives the amount of data
+               * needed for this tile. if it is 0 then we need to read
+               * in the maximum possible allowing for negative
+               * compression
+               */
+              offset2 = offsets[i + j + 1];
+
+              if (offset2 == 0)
+                offset2 = offset + XCF_TILE_MAX_DATA_LENGTH (bpp);
+            }
+
+          /* Workaround for bug #357809: avoid crashing on g_malloc()
+           * and skip this tile (without storing data) as if it did
+           * not contain any data.  It is better than failing, which
+           * would skip the whole hierarchy while there may still be
+           * some valid tiles in the file.
+           */
+          if (offset2 - offset <= 0)
+            continue;
+
+          /* the offsets come from the file, never read more than a
+           * tile can take
+           */
+          tile->data_length = MIN (offset2 - offset,
+                                   XCF_TILE_MAX_DATA_LENGTH (bpp));
+
+          /* seek to the tile offset */
+          if (! xcf_seek_pos (info, offset, NULL))
+            {
+              success = FALSE;
+              break;
+            }
+
+          tile->xcfdata = g_try_malloc (tile->data_length);
+
+          if (! tile->xcfdata)
+            {
+              success = FALSE;
+              break;
+            }
+
+          tile->data_length = xcf_load_tile_data (info, tile->xcfdata,
+                                                  tile->data_length);
         }
 
-      if (fail)
-        return FALSE;
+      if (success)
+        {
+          /* decode the batch's tiles in parallel */
+          gimp_parallel_distribute (batch.n_tiles,
+                                    (GimpParallelDistributeFunc) xcf_load_decode_tiles,
+                                    &batch);
 
-      GIMP_LOG (XCF, "loaded tile %d/%d", i + 1, ntiles);
+          /* and store them in the buffer */
+          for (j = 0; j < batch.n_tiles; j++)
+            {
+              XcfLoadTile *tile = &batch.tiles[j];
 
-      /* restore the saved position so we'll be ready to
-       *  read the next offset.
-       */
-      if (!xcf_seek_pos (info, saved_pos, NULL))
-        return FALSE;
+              if (! tile->success)
+                {
+                  success = FALSE;
+                  break;
+                }
 
-      /* read in the offset of the next tile */
-      info->cp += xcf_read_int32 (info->input, &offset, 1);
-    }
+              if (tile->data_length == 0)
+                continue;
 
-  if (offset != 0)
-    {
-      gimp_message (info->gimp, G_OBJECT (info->progress), GIMP_MESSAGE_ERROR,
-                    "encountered garbage after reading level: %d", offset);
-      return FALSE;
+              if (shift > 0)
+                xcf_load_scale_tile (buffer, &tile->rect, tile->data,
+                                     format, shift);
+              else
+                gegl_buffer_set (buffer, &tile->rect, 0, format, tile->data,
+                                 GEGL_AUTO_ROWSTRIDE);
+
+              GIMP_LOG (XCF, "loaded tile %d/%d", i + j + 1, ntiles);
+            }
+        }
+
+      for (j = 0; j < batch.n_tiles; j++)
+        g_clear_pointer (&batch.tiles[j].xcfdata, g_free);
     }
 
-  return TRUE;
+  g_free (tile_data);
+  g_free (batch.tiles);
+  g_free (offsets);
+
+  return success;
 }
 
-static gboolean
-xcf_load_tile (XcfInfo       *info,
-               GeglBuffer    *buffer,
-               GeglRectangle *tile_rect,
-               const Babl    *format)
+/* averages the decoded pixels of the level's tile at 'rect' into the
+ * pixels of 'buffer' they fall on, each of which covers 2^shift x
+ * 2^shift pixels of the level
+ */
+static void
+xcf_load_scale_tile (GeglBuffer          *buffer,
+                     const GeglRectangle *rect,
+                     const guchar        *data,
+                     const Babl          *format,
+                     gint                 shift)
 {
-  gint    bpp       = babl_format_get_bytes_per_pixel (format);
-  gint    tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar *tile_data = g_alloca (tile_size);
+  const Babl    *float_format = babl_format ("RaGaBaA float");
+  GeglRectangle  dest;
+  gfloat        *src;
+  gfloat        *sums;
+  gint          *counts;
+  gint           x, y;
+  gint           i;
+
+  dest.x      = rect->x >> shift;
+  dest.y      = rect->y >> shift;
+  dest.width  = MIN ((rect->x + rect->width - 1) >> shift,
+                     gegl_buffer_get_width (buffer) - 1) - dest.x + 1;
+  dest.height = MIN ((rect->y + rect->height - 1) >> shift,
+                     gegl_buffer_get_height (buffer) - 1) - dest.y + 1;
+
+  src    = g_new  (gfloat, rect->width * rect->height * 4);
+  sums   = g_new0 (gfloat, dest.width * dest.height * 4);
+  counts = g_new0 (gint,   dest.width * dest.height);
+
+  babl_process (babl_fish (format, float_format),
+                data, src, rect->width * rect->height);
+
+  for (y = 0; y < rect->height; y++)
+    {
+      gint dy = ((rect->y + y) >> shift) - dest.y;
+
+      if (dy >= dest.height)
+        break;
+
+      for (x = 0; x < rect->width; x++)
+        {
+          gint          dx = ((rect->x + x) >> shift) - dest.x;
+          const gfloat *s  = src + (y * rect->width + x) * 4;
+          gfloat       *d;
 
-  info->cp += xcf_read_int8 (info->input, tile_data, tile_size);
+          if (dx >= dest.width)
+            break;
 
-  gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE);
+          d = sums + (dy * dest.width + dx) * 4;
 
-  return TRUE;
+          d[0] += s[0];
+          d[1] += s[1];
+          d[2] += s[2];
+          d[3] += s[3];
+
+          counts[dy * dest.width + dx]++;
+        }
+    }
+
+  for (i = 0; i < dest.width * dest.height; i++)
+    {
+      sums[i * 4 + 0] /= counts[i];
+      sums[i * 4 + 1] /= counts[i];
+      sums[i * 4 + 2] /= counts[i];
+      sums[i * 4 + 3] /= counts[i];
+    }
+
+  gegl_buffer_set (buffer, &dest, 0, float_format, sums, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (counts);
+  g_free (sums);
+  g_free (src);
 }
 
 static gboolean
-xcf_load_tile_rle (XcfInfo       *info,
-                   GeglBuffer    *buffer,
-                   GeglRectangle *tile_rect,
-                   const Babl    *format,
-                   gint           data_length)
+xcf_load_level_lazy (XcfInfo      *info,
+                     GimpDrawable *drawable)
 {
-  gint    bpp       = babl_format_get_bytes_per_pixel (format);
-  gint    tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar *tile_data = g_alloca (tile_size);
-  gint    i;
-  gsize   nmemb_read_successfully;
-  guchar *xcfdata;
-  guchar *xcfodata;
-  guchar *xcfdatalimit;
-
-  /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
-   * this tile (return TRUE without storing data) as if it did not
-   * contain any data.  It is better than returning FALSE, which would
-   * skip the whole hierarchy while there may still be some valid
-   * tiles in the file.
-   */
-  if (data_length <= 0)
-    return TRUE;
+  GeglBuffer      *buffer = gimp_drawable_get_buffer (drawable);
+  GimpGeglConfig  *gegl_config = GIMP_GEGL_CONFIG (info->gimp->config);
+  GeglTileBackend *backend;
+  GeglBuffer      *lazy_buffer;
+  goffset         *offsets;
+  gchar           *swap_dir;
+  gint             ntiles;
+  gboolean         success;
+
+  offsets = xcf_load_level_offsets (info,
+                                    gegl_buffer_get_width (buffer),
+                                    gegl_buffer_get_height (buffer),
+                                    &ntiles, &success);
+  if (! offsets)
+    return success;
+
+  /*  written tiles go where the undo steps are swapped to  */
+  swap_dir = gimp_config_path_expand (gegl_config->swap_path ?
+                                      gegl_config->swap_path :
+                                      gegl_config->temp_path,
+                                      TRUE, NULL);
+
+  backend = xcf_tile_backend_new (info->lazy_input,
+                                  info->compression,
+                                  gegl_buffer_get_format (buffer),
+                                  gegl_buffer_get_width (buffer),
+                                  gegl_buffer_get_height (buffer),
+                                  offsets, swap_dir);
+  g_free (swap_dir);
+
+  lazy_buffer = gegl_buffer_new_for_backend (NULL, backend);
+  g_object_unref (backend);
+
+  gimp_drawable_set_buffer (drawable, FALSE, NULL, lazy_buffer);
+  g_object_unref (lazy_buffer);
+
+  GIMP_LOG (XCF, "deferred loading of %d tiles", ntiles);
+
+  return TRUE;
+}
 
-  xcfdata = xcfodata = g_alloca (data_length);
+/* reads up to 'data_length' bytes of a tile's compressed data and
+ * returns the number of bytes actually read
+ */
+static gint
+xcf_load_tile_data (XcfInfo *info,
+                    guchar  *xcfdata,
+                    gint     data_length)
+{
+  gsize bytes_read;
 
   /* we have to read directly instead of xcf_read_* because we may be
    * reading past the end of the file here
    */
   g_input_stream_read_all (info->input, xcfdata, data_length,
-                           &nmemb_read_successfully, NULL, NULL);
+                           &bytes_read, NULL, NULL);
+
+  info->cp += bytes_read;
+
+  return bytes_read;
+}
+
+static void
+xcf_load_decode_tiles (gint              i,
+                       gint              n,
+                       XcfLoadTileBatch *batch)
+{
+  /* runs in parallel, every thread decodes every n-th tile */
+  for (; i < batch->n_tiles; i += n)
+    {
+      XcfLoadTile *tile = &batch->tiles[i];
+
+      /* a tile without data is skipped, see bug #357809 */
+      if (tile->data_length > 0)
+        tile->success = xcf_load_decode_tile (batch->compression,
+                                              tile->xcfdata,
+                                              tile->data_length,
+                                              tile->data,
+                                              batch->bpp,
+                                              tile->rect.width *
+                                              tile->rect.height);
+    }
+}
 
-  if (nmemb_read_successfully == 0)
-    return TRUE;
+gboolean
+xcf_load_decode_tile (XcfCompressionType  compression,
+                      const guchar       *xcfdata,
+                      gint                data_length,
+                      guchar             *tile_data,
+                      gint                bpp,
+                      gint                n_pixels)
+{
+  switch (compression)
+    {
+    case COMPRESS_NONE:
+      return xcf_load_tile (xcfdata, data_length,
+                            tile_data, n_pixels * bpp);
+
+    case COMPRESS_RLE:
+      return xcf_load_tile_rle (xcfdata, data_length,
+                                tile_data, bpp, n_pixels);
+
+    case COMPRESS_ZLIB:
+      return xcf_load_tile_zlib (xcfdata, data_length,
+                                 tile_data, n_pixels * bpp);
+
+    case COMPRESS_ZSTD:
+      return xcf_load_tile_zstd (xcfdata, data_length,
+                                 tile_data, n_pixels * bpp);
+
+    case COMPRESS_FRACTAL:
+      g_printerr ("xcf: fractal compression unimplemented. "
+                  "Possibly corrupt XCF file.\n");
+      break;
+
+    default:
+      g_printerr ("xcf: unknown compression. "
+                  "Possibly corrupt XCF file.\n");
+      break;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+xcf_load_tile (const guchar *xcfdata,
+               gint          data_length,
+               guchar       *tile_data,
+               gint          tile_size)
+{
+  memcpy (tile_data, xcfdata, MIN (data_length, tile_size));
+
+  if (data_length < tile_size)
+    memset (tile_data + data_length, 0, tile_size - data_length);
+
+  return TRUE;
+}
 
-  info->cp += nmemb_read_successfully;
+static gboolean
+xcf_load_tile_rle (const guchar *xcfdata,
+                   gint          data_length,
+                   guchar       *tile_data,
+                   gint          bpp,
+                   gint          n_pixels)
+{
+  const guchar *xcfdatalimit;
+  gint          i;
 
-  xcfdatalimit = &xcfodata[nmemb_read_successfully - 1];
+  xcfdatalimit = &xcfdata[data_length - 1];
 
   for (i = 0; i < bpp; i++)
     {
       guchar *data  = tile_data + i;
-      gint    size  = tile_rect->width * tile_rect->height;
+      gint    size  = n_pixels;
       gint    count = 0;
       guchar  val;
       gint    length;
@@ -1980,9 +2474,6 @@ xcf_load_tile_rle (XcfInfo       *info,
         }
     }
 
-  gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE);
-
   return TRUE;
 
  bogus_rle:
@@ -1990,42 +2481,14 @@ xcf_load_tile_rle (XcfInfo       *info,
 }
 
 static gboolean
-xcf_load_tile_zlib (XcfInfo       *info,
-                    GeglBuffer    *buffer,
-                    GeglRectangle *tile_rect,
-                    const Babl    *format,
-                    gint           data_length)
+xcf_load_tile_zlib (const guchar *xcfdata,
+                    gint          data_length,
+                    guchar       *tile_data,
+                    gint          tile_size)
 {
   z_stream  strm;
   int       action;
   int       status;
-  gint      bpp       = babl_format_get_bytes_per_pixel (format);
-  gint      tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar   *tile_data = g_alloca (tile_size);
-  gsize     bytes_read;
-  guchar   *xcfdata;
-
-  /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
-   * this tile (return TRUE without storing data) as if it did not
-   * contain any data.  It is better than returning FALSE, which would
-   * skip the whole hierarchy while there may still be some valid
-   * tiles in the file.
-   */
-  if (data_length <= 0)
-    return TRUE;
-
-  xcfdata = g_alloca (data_length);
-
-  /* we have to read directly instead of xcf_read_* because we may be
-   * reading past the end of the file here
-   */
-  g_input_stream_read_all (info->input, xcfdata, data_length,
-                           &bytes_read, NULL, NULL);
-
-  if (bytes_read == 0)
-    return TRUE;
-
-  info->cp      += bytes_read;
 
   strm.next_out  = tile_data;
   strm.avail_out = tile_size;
@@ -2033,8 +2496,8 @@ xcf_load_tile_zlib (XcfInfo       *info,
   strm.zalloc    = Z_NULL;
   strm.zfree     = Z_NULL;
   strm.opaque    = Z_NULL;
-  strm.next_in   = xcfdata;
-  strm.avail_in  = bytes_read;
+  strm.next_in   = (Bytef *) xcfdata;
+  strm.avail_in  = data_length;
 
   /* Initialize the stream decompression. */
   status = inflateInit (&strm);
@@ -2059,25 +2522,80 @@ xcf_load_tile_zlib (XcfInfo       *info,
         }
       else if (status == Z_BUF_ERROR)
         {
-          g_printerr ("xcf: decompressed tile bigger than the expected size.");
+          g_printerr ("xcf: decompressed tile bigger than the expected size.\n");
           inflateEnd (&strm);
           return FALSE;
         }
       else if (status != Z_OK)
         {
-          g_printerr ("xcf: tile decompression failed: %s", zError (status));
+          g_printerr ("xcf: tile decompression failed: %s\n", zError (status));
           inflateEnd (&strm);
           return FALSE;
         }
     }
 
-  gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE);
-
   inflateEnd (&strm);
   return TRUE;
 }
 
+static gboolean
+xcf_load_tile_zstd (const guchar *xcfdata,
+                    gint          data_length,
+                    guchar       *tile_data,
+                    gint          tile_size)
+{
+  ZSTD_DStream   *stream;
+  ZSTD_inBuffer   in;
+  ZSTD_outBuffer  out;
+  gsize           status;
+
+  /* 'xcfdata' may contain more than the tile's frame when it is the
+   * level's last tile, so decode as a stream which stops at the end
+   * of the first frame
+   */
+  stream = ZSTD_createDStream ();
+  if (! stream)
+    return FALSE;
+
+  status = ZSTD_initDStream (stream);
+
+  in.src   = xcfdata;
+  in.size  = data_length;
+  in.pos   = 0;
+
+  out.dst  = tile_data;
+  out.size = tile_size;
+  out.pos  = 0;
+
+  while (! ZSTD_isError (status) && status != 0)
+    {
+      gsize in_pos  = in.pos;
+      gsize out_pos = out.pos;
+
+      status = ZSTD_decompressStream (stream, &out, &in);
+
+      if (! ZSTD_isError (status) && status != 0 &&
+          in.pos == in_pos && out.pos == out_pos)
+        {
+          g_printerr ("xcf: decompressed tile size doesn't match the "
+                      "expected size.\n");
+          ZSTD_freeDStream (stream);
+          return FALSE;
+        }
+    }
+
+  ZSTD_freeDStream (stream);
+
+  if (ZSTD_isError (status))
+    {
+      g_printerr ("xcf: tile decompression failed: %s\n",
+                  ZSTD_getErrorName (status));
+      return FALSE;
+    }
+
+  return out.pos == tile_size;
+}
+
 static GimpParasite *
 xcf_load_parasite (XcfInfo *info)
 {
@@ -2276,7 +2794,8 @@ xcf_load_vectors (XcfInfo   *info,
     gimp_image_set_active_vectors (image, active_vectors);
 
 #ifdef GIMP_XCF_PATH_DEBUG
-  g_printerr ("xcf_load_vectors: loaded %d bytes\n", info->cp - base);
+  g_printerr ("xcf_load_vectors: loaded %" G_GOFFSET_FORMAT " bytes\n",
+              info->cp - base);
 #endif
   return TRUE;
 }
@@ -2463,3 +2982,18 @@ xcf_skip_unknown_prop (XcfInfo *info,
 
   return TRUE;
 }
+
+/* the size of an item at the mipmap level being loaded */
+static gint
+xcf_load_scale_size (XcfInfo *info,
+                     gint     size)
+{
+  return MAX (1, size >> info->level);
+}
+
+static gint
+xcf_load_scale_offset (XcfInfo *info,
+                       gint     offset)
+{
+  return floor ((gdouble) offset / (1 << info->level));
+}
@@ -22,6 +22,12 @@
 #define XCF_TILE_WIDTH  64
 #define XCF_TILE_HEIGHT 64
 
+/* the most data a compressed tile can take, allowing for negative
+ * compression, 1.5 is probably more than we need to allow
+ */
+#define XCF_TILE_MAX_DATA_LENGTH(bpp) \
+  (XCF_TILE_WIDTH * XCF_TILE_HEIGHT * (bpp) * 3 / 2)
+
 typedef enum
 {
   PROP_END                =  0,
@@ -63,8 +69,9 @@ typedef enum
 {
   COMPRESS_NONE              =  0,
   COMPRESS_RLE               =  1,
-  COMPRESS_ZLIB              =  2,  /* unused */
-  COMPRESS_FRACTAL           =  3   /* unused */
+  COMPRESS_ZLIB              =  2,
+  COMPRESS_FRACTAL           =  3,  /* unused */
+  COMPRESS_ZSTD              =  4
 } XcfCompressionType;
 
 typedef enum
@@ -93,16 +100,24 @@ struct _XcfInfo
   GInputStream       *input;
   GOutputStream      *output;
   GSeekable          *seekable;
-  guint               cp;
+  goffset             cp;
+  gint                bytes_per_offset;
   const gchar        *filename;
   GimpTattoo          tattoo_state;
   GimpLayer          *active_layer;
   GimpChannel        *active_channel;
   GimpDrawable       *floating_sel_drawable;
   GimpLayer          *floating_sel;
-  guint               floating_sel_offset;
+  goffset             floating_sel_offset;
   XcfCompressionType  compression;
+  gint                compression_level;
+  gboolean            save_mipmaps;
   gint                file_version;
+  GInputStream       *lazy_input;
+  gint                thumbnail_size;
+  gint                level;
+  gint                image_width;
+  gint                image_height;
 };
 
 
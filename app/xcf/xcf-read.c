@@ -50,6 +50,41 @@ xcf_read_int32 (GInputStream *input,
   return total;
 }
 
+guint
+xcf_read_offset (GInputStream *input,
+                 gint          bytes_per_offset,
+                 goffset      *data,
+                 gint          count)
+{
+  guint total = 0;
+
+  if (bytes_per_offset == 4)
+    {
+      while (count--)
+        {
+          guint32 offset;
+
+          total += xcf_read_int32 (input, &offset, 1);
+          *data++ = offset;
+        }
+    }
+  else
+    {
+      while (count--)
+        {
+          guint32 offset[2];
+
+          /*  64 bit offsets are stored as two big-endian 32 bit
+           *  values, the most significant one first
+           */
+          total += xcf_read_int32 (input, offset, 2);
+          *data++ = ((goffset) offset[0] << 32) | offset[1];
+        }
+    }
+
+  return total;
+}
+
 guint
 xcf_read_float (GInputStream *input,
                 gfloat       *data,
@@ -19,6 +19,7 @@
 
 #include <string.h>
 #include <zlib.h>
+#include <zstd.h>
 
 #include <cairo.h>
 #include <gegl.h>
@@ -33,6 +34,7 @@
 #include "gegl/gimp-gegl-tile-compat.h"
 
 #include "core/gimp.h"
+#include "core/gimp-parallel.h"
 #include "core/gimpcontainer.h"
 #include "core/gimpchannel.h"
 #include "core/gimpdrawable.h"
@@ -69,6 +71,29 @@
 #include "gimp-intl.h"
 
 
+/* the number of tiles which are encoded in parallel at a time */
+#define XCF_SAVE_BATCH_SIZE 64
+
+
+typedef struct
+{
+  GeglRectangle  rect;
+  guchar        *data;  /* the tile's pixels           */
+  guchar        *out;   /* the encoded tile            */
+  gint           size;  /* encoded size, -1 on failure */
+} XcfSaveTile;
+
+typedef struct
+{
+  XcfCompressionType  compression;
+  gint                compression_level;
+  gint                bpp;
+  XcfSaveTile        *tiles;
+  gint                n_tiles;
+  gint                out_size;
+} XcfSaveTileBatch;
+
+
 static gboolean xcf_save_image_props   (XcfInfo           *info,
                                         GimpImage         *image,
                                         GError           **error);
@@ -96,25 +121,34 @@ static gboolean xcf_save_channel       (XcfInfo           *info,
 static gboolean xcf_save_buffer        (XcfInfo           *info,
                                         GeglBuffer        *buffer,
                                         GError           **error);
-static gboolean xcf_save_level         (XcfInfo           *info,
-                                        GeglBuffer        *buffer,
-                                        GError           **error);
-static gboolean xcf_save_tile          (XcfInfo           *info,
-                                        GeglBuffer        *buffer,
-                                        GeglRectangle     *tile_rect,
-                                        const Babl        *format,
-                                        GError           **error);
-static gboolean xcf_save_tile_rle      (XcfInfo           *info,
+static gboolean xcf_save_hierarchy     (XcfInfo           *info,
                                         GeglBuffer        *buffer,
-                                        GeglRectangle     *tile_rect,
-                                        const Babl        *format,
-                                        guchar            *rlebuf,
+                                        GeglBuffer       **level_buffer,
                                         GError           **error);
-static gboolean xcf_save_tile_zlib     (XcfInfo           *info,
+static GeglBuffer * xcf_save_downscale_buffer
+                                       (GeglBuffer        *buffer,
+                                        gint               width,
+                                        gint               height);
+static gboolean xcf_save_level         (XcfInfo           *info,
                                         GeglBuffer        *buffer,
-                                        GeglRectangle     *tile_rect,
-                                        const Babl        *format,
                                         GError           **error);
+static void     xcf_save_encode_tiles  (gint               i,
+                                        gint               n,
+                                        XcfSaveTileBatch  *batch);
+static gint     xcf_save_tile_rle      (const guchar      *tile_data,
+                                        gint               bpp,
+                                        gint               n_pixels,
+                                        guchar            *rlebuf);
+static gint     xcf_save_tile_zlib     (const guchar      *tile_data,
+                                        gint               tile_size,
+                                        guchar            *buf,
+                                        gint               buf_size,
+                                        gint               level);
+static gint     xcf_save_tile_zstd     (const guchar      *tile_data,
+                                        gint               tile_size,
+                                        guchar            *buf,
+                                        gint               buf_size,
+                                        gint               level);
 static gboolean xcf_save_parasite      (XcfInfo           *info,
                                         GimpParasite      *parasite,
                                         GError           **error);
@@ -148,6 +182,27 @@ static gboolean xcf_save_vectors       (XcfInfo           *info,
     }                                                                 \
   } G_STMT_END
 
+#define xcf_write_offset_check_error(info, data, count) G_STMT_START { \
+  info->cp += xcf_write_offset (info->output, info->bytes_per_offset,  \
+                                data, count, &tmp_error);              \
+  if (tmp_error)                                                       \
+    {                                                                  \
+      g_propagate_error (error, tmp_error);                            \
+      return FALSE;                                                    \
+    }                                                                  \
+  } G_STMT_END
+
+#define xcf_write_zero_offset_check_error(info, count) G_STMT_START { \
+  info->cp += xcf_write_zero_offset (info->output,                    \
+                                     info->bytes_per_offset,          \
+                                     count, &tmp_error);              \
+  if (tmp_error)                                                      \
+    {                                                                 \
+      g_propagate_error (error, tmp_error);                           \
+      return FALSE;                                                   \
+    }                                                                 \
+  } G_STMT_END
+
 #define xcf_write_int8_check_error(info, data, count) G_STMT_START {  \
   info->cp += xcf_write_int8 (info->output, data, count, &tmp_error); \
   if (tmp_error)                                                      \
@@ -202,8 +257,8 @@ xcf_save_image (XcfInfo    *info,
   GList   *all_layers;
   GList   *all_channels;
   GList   *list;
-  guint32  saved_pos;
-  guint32  offset;
+  goffset  saved_pos;
+  goffset  offset;
   guint32  value;
   guint    n_layers;
   guint    n_channels;
@@ -268,7 +323,7 @@ xcf_save_image (XcfInfo    *info,
   saved_pos = info->cp;
 
   /* write an empty offset table */
-  xcf_write_zero_int32_check_error (info, n_layers + n_channels + 2);
+  xcf_write_zero_offset_check_error (info, n_layers + n_channels + 2);
 
   /* 'offset' is where we will write the next layer or channel */
   offset = info->cp;
@@ -281,7 +336,7 @@ xcf_save_image (XcfInfo    *info,
        * offset of the layer
        */
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-      xcf_write_int32_check_error (info, &offset, 1);
+      xcf_write_offset_check_error (info, &offset, 1);
 
       /* remember the next slot in the offset table */
       saved_pos = info->cp;
@@ -299,7 +354,7 @@ xcf_save_image (XcfInfo    *info,
   /* skip a '0' in the offset table to indicate the end of the layer
    * offsets
    */
-  saved_pos += 4;
+  saved_pos += info->bytes_per_offset;
 
   for (list = all_channels; list; list = g_list_next (list))
     {
@@ -309,7 +364,7 @@ xcf_save_image (XcfInfo    *info,
        * offset of the channel
        */
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-      xcf_write_int32_check_error (info, &offset, 1);
+      xcf_write_offset_check_error (info, &offset, 1);
 
       /* remember the next slot in the offset table */
       saved_pos = info->cp;
@@ -647,15 +702,12 @@ xcf_save_prop (XcfInfo    *info,
 
     case PROP_FLOATING_SELECTION:
       {
-        guint32 dummy;
-
-        dummy = 0;
-        size = 4;
+        size = info->bytes_per_offset;
 
         xcf_write_prop_type_check_error (info, prop_type);
         xcf_write_int32_check_error (info, &size, 1);
         info->floating_sel_offset = info->cp;
-        xcf_write_int32_check_error (info, &dummy, 1);
+        xcf_write_zero_offset_check_error (info, 1);
       }
       break;
 
@@ -957,8 +1009,9 @@ xcf_save_prop (XcfInfo    *info,
 
         if (gimp_parasite_list_persistent_length (list) > 0)
           {
-            guint32 base, length = 0;
-            long    pos;
+            goffset base;
+            goffset pos;
+            guint32 length = 0;
 
             xcf_write_prop_type_check_error (info, prop_type);
 
@@ -998,8 +1051,9 @@ xcf_save_prop (XcfInfo    *info,
 
     case PROP_PATHS:
       {
-        guint32 base, length = 0;
-        glong   pos;
+        goffset base;
+        goffset pos;
+        guint32 length = 0;
 
         xcf_write_prop_type_check_error (info, prop_type);
 
@@ -1059,8 +1113,9 @@ xcf_save_prop (XcfInfo    *info,
 
     case PROP_VECTORS:
       {
-        guint32 base, length = 0;
-        glong   pos;
+        goffset base;
+        goffset pos;
+        guint32 length = 0;
 
         xcf_write_prop_type_check_error (info, prop_type);
 
@@ -1143,8 +1198,8 @@ xcf_save_layer (XcfInfo    *info,
                 GimpLayer  *layer,
                 GError    **error)
 {
-  guint32      saved_pos;
-  guint32      offset;
+  goffset      saved_pos;
+  goffset      offset;
   guint32      value;
   const gchar *string;
   GError      *tmp_error = NULL;
@@ -1156,7 +1211,7 @@ xcf_save_layer (XcfInfo    *info,
     {
       saved_pos = info->cp;
       xcf_check_error (xcf_seek_pos (info, info->floating_sel_offset, error));
-      xcf_write_int32_check_error (info, &saved_pos, 1);
+      xcf_write_offset_check_error (info, &saved_pos, 1);
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
     }
 
@@ -1178,13 +1233,13 @@ xcf_save_layer (XcfInfo    *info,
   xcf_save_layer_props (info, image, layer, error);
 
   /* write out the layer tile hierarchy */
-  offset = info->cp + 8;
-  xcf_write_int32_check_error (info, &offset, 1);
+  offset = info->cp + 2 * info->bytes_per_offset;
+  xcf_write_offset_check_error (info, &offset, 1);
 
   saved_pos = info->cp;
 
   /* write a zero layer mask offset */
-  xcf_write_zero_int32_check_error (info, 1);
+  xcf_write_zero_offset_check_error (info, 1);
 
   xcf_check_error (xcf_save_buffer (info,
                                     gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
@@ -1198,7 +1253,7 @@ xcf_save_layer (XcfInfo    *info,
       GimpLayerMask *mask = gimp_layer_get_mask (layer);
 
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-      xcf_write_int32_check_error (info, &offset, 1);
+      xcf_write_offset_check_error (info, &offset, 1);
 
       xcf_check_error (xcf_seek_pos (info, offset, error));
       xcf_check_error (xcf_save_channel (info, image, GIMP_CHANNEL (mask),
@@ -1214,8 +1269,8 @@ xcf_save_channel (XcfInfo      *info,
                   GimpChannel  *channel,
                   GError      **error)
 {
-  guint32      saved_pos;
-  guint32      offset;
+  goffset      saved_pos;
+  goffset      offset;
   guint32      value;
   const gchar *string;
   GError      *tmp_error = NULL;
@@ -1227,7 +1282,7 @@ xcf_save_channel (XcfInfo      *info,
     {
       saved_pos = info->cp;
       xcf_check_error (xcf_seek_pos (info, info->floating_sel_offset, error));
-      xcf_write_int32_check_error (info, &saved_pos, 1);
+      xcf_write_offset_check_error (info, &saved_pos, 1);
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
     }
 
@@ -1246,8 +1301,8 @@ xcf_save_channel (XcfInfo      *info,
   xcf_save_channel_props (info, image, channel, error);
 
   /* write out the channel tile hierarchy */
-  offset = info->cp + 4;
-  xcf_write_int32_check_error (info, &offset, 1);
+  offset = info->cp + info->bytes_per_offset;
+  xcf_write_offset_check_error (info, &offset, 1);
 
   xcf_check_error (xcf_save_buffer (info,
                                     gimp_drawable_get_buffer (GIMP_DRAWABLE (channel)),
@@ -1277,10 +1332,35 @@ static gboolean
 xcf_save_buffer (XcfInfo     *info,
                  GeglBuffer  *buffer,
                  GError     **error)
+{
+  GeglBuffer *level_buffer = NULL;
+  gboolean    success;
+
+  /* the lower levels are only written as mipmaps if requested, and
+   * indexed pixels can't be downscaled
+   */
+  if (info->save_mipmaps &&
+      ! babl_format_is_palette (gegl_buffer_get_format (buffer)))
+    {
+      level_buffer = g_object_ref (buffer);
+    }
+
+  success = xcf_save_hierarchy (info, buffer, &level_buffer, error);
+
+  g_clear_object (&level_buffer);
+
+  return success;
+}
+
+static gboolean
+xcf_save_hierarchy (XcfInfo     *info,
+                    GeglBuffer  *buffer,
+                    GeglBuffer **level_buffer,
+                    GError     **error)
 {
   const Babl *format;
-  guint32     saved_pos;
-  guint32     offset;
+  goffset     saved_pos;
+  goffset     offset;
   guint32     width;
   guint32     height;
   guint32     bpp;
@@ -1309,7 +1389,7 @@ xcf_save_buffer (XcfInfo     *info,
   saved_pos = info->cp;
 
   /* write an empty offset table */
-  xcf_write_zero_int32_check_error (info, nlevels + 1);
+  xcf_write_zero_offset_check_error (info, nlevels + 1);
 
   /* 'offset' is where we will write the next level */
   offset = info->cp;
@@ -1320,7 +1400,7 @@ xcf_save_buffer (XcfInfo     *info,
        * offset of the level
        */
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-      xcf_write_int32_check_error (info, &offset, 1);
+      xcf_write_offset_check_error (info, &offset, 1);
 
       /* remember the next slot in the offset table */
       saved_pos = info->cp;
@@ -1335,13 +1415,30 @@ xcf_save_buffer (XcfInfo     *info,
         }
       else
         {
-          /* fake an empty level */
-          tmp1 = 0;
           width  /= 2;
           height /= 2;
-          xcf_write_int32_check_error (info, (guint32 *) &width,  1);
-          xcf_write_int32_check_error (info, (guint32 *) &height, 1);
-          xcf_write_int32_check_error (info, (guint32 *) &tmp1,   1);
+
+          if (*level_buffer)
+            {
+              GeglBuffer *next_buffer;
+
+              /* downscale the previous level and write it out */
+              next_buffer = xcf_save_downscale_buffer (*level_buffer,
+                                                       width, height);
+              g_object_unref (*level_buffer);
+              *level_buffer = next_buffer;
+
+              if (*level_buffer)
+                xcf_check_error (xcf_save_level (info, *level_buffer, error));
+            }
+
+          if (! *level_buffer)
+            {
+              /* fake an empty level */
+              xcf_write_int32_check_error (info, (guint32 *) &width,  1);
+              xcf_write_int32_check_error (info, (guint32 *) &height, 1);
+              xcf_write_zero_offset_check_error (info, 1);
+            }
         }
 
       /* the next level's offset if after the level we just wrote */
@@ -1355,25 +1452,76 @@ xcf_save_buffer (XcfInfo     *info,
   return TRUE;
 }
 
+/* returns a copy of 'buffer' downscaled to 'width' x 'height', or
+ * NULL if that would be empty
+ */
+static GeglBuffer *
+xcf_save_downscale_buffer (GeglBuffer *buffer,
+                           gint        width,
+                           gint        height)
+{
+  const Babl *format = gegl_buffer_get_format (buffer);
+  GeglBuffer *level_buffer;
+  guchar     *data;
+  gdouble     scale;
+  gint        y;
+
+  if (width <= 0 || height <= 0)
+    return NULL;
+
+  level_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                                  format);
+
+  scale = (gdouble) width / gegl_buffer_get_width (buffer);
+
+  data = g_malloc (width * XCF_TILE_HEIGHT *
+                   babl_format_get_bytes_per_pixel (format));
+
+  /* downscale one row of tiles at a time */
+  for (y = 0; y < height; y += XCF_TILE_HEIGHT)
+    {
+      GeglRectangle rect = { 0, y, width, MIN (XCF_TILE_HEIGHT, height - y) };
+
+      gegl_buffer_get (buffer, &rect, scale, format, data,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      gegl_buffer_set (level_buffer, &rect, 0, format, data,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (data);
+
+  return level_buffer;
+}
+
 static gboolean
 xcf_save_level (XcfInfo     *info,
                 GeglBuffer  *buffer,
                 GError     **error)
 {
-  const Babl *format;
-  guint32    *offset_table;
-  guint32    *next_offset;
-  guint32     saved_pos;
-  guint32     offset;
-  guint32     width;
-  guint32     height;
-  gint        bpp;
-  gint        n_tile_rows;
-  gint        n_tile_cols;
-  guint       ntiles;
-  gint        i;
-  guchar     *rlebuf    = NULL;
-  GError     *tmp_error = NULL;
+  const Babl       *format;
+  XcfSaveTileBatch  batch;
+  guchar           *tile_data;
+  guchar           *out_data;
+  goffset          *offset_table;
+  goffset          *next_offset;
+  goffset           saved_pos;
+  goffset           offset;
+  guint32           width;
+  guint32           height;
+  gint              bpp;
+  gint              max_tile_size;
+  gint              n_tile_rows;
+  gint              n_tile_cols;
+  guint             ntiles;
+  gint              i;
+  gboolean          success   = TRUE;
+  GError           *tmp_error = NULL;
+
+  if (info->compression == COMPRESS_FRACTAL)
+    {
+      g_warning ("xcf: fractal compression unimplemented");
+      return FALSE;
+    }
 
   format = gegl_buffer_get_format (buffer);
 
@@ -1384,118 +1532,194 @@ xcf_save_level (XcfInfo     *info,
   xcf_write_int32_check_error (info, (guint32 *) &width, 1);
   xcf_write_int32_check_error (info, (guint32 *) &height, 1);
 
-  saved_pos = info->cp;
-
-  /* allocate a temporary buffer to store the rle data before it is
-   * written to disk
-   */
-  if (info->compression == COMPRESS_RLE)
-    rlebuf = g_alloca (XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp * 1.5);
-
   n_tile_rows = gimp_gegl_buffer_get_n_tile_rows (buffer, XCF_TILE_HEIGHT);
   n_tile_cols = gimp_gegl_buffer_get_n_tile_cols (buffer, XCF_TILE_WIDTH);
 
   ntiles = n_tile_rows * n_tile_cols;
 
-  /* allocate an offset table so we don't have to seek back after each
-   * tile, see bug #686862. allocate ntiles + 1 slots because a zero
-   * offset indicates the offset table's end.
-   */
-  offset_table = g_alloca ((ntiles + 1) * sizeof (gint32));
-  memset (offset_table, 0, (ntiles + 1) * sizeof (gint32));
-  next_offset = offset_table;
-
   /* 'saved_pos' is the offset of the tile offset table  */
   saved_pos = info->cp;
 
   /* write an empty offset table */
-  xcf_write_zero_int32_check_error (info, ntiles + 1);
+  xcf_write_zero_offset_check_error (info, ntiles + 1);
 
   /* 'offset' is where we will write the next tile */
   offset = info->cp;
 
-  for (i = 0; i < ntiles; i++)
+  /* allocate an offset table so we don't have to seek back after each
+   * tile, see bug #686862. allocate ntiles + 1 slots because a zero
+   * offset indicates the offset table's end.
+   */
+  offset_table = g_new0 (goffset, ntiles + 1);
+  next_offset  = offset_table;
+
+  /* allocate room for a batch of tiles and their encoded data, the
+   * encoded data can be larger than the tile, allow for the same
+   * worst case the loader allows for
+   */
+  max_tile_size = XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp;
+
+  batch.compression       = info->compression;
+  batch.compression_level = info->compression_level;
+  batch.bpp               = bpp;
+  batch.out_size          = MAX (max_tile_size * 3 / 2,
+                                 MAX (compressBound (max_tile_size),
+                                      ZSTD_compressBound (max_tile_size)));
+  batch.tiles             = g_new (XcfSaveTile, XCF_SAVE_BATCH_SIZE);
+
+  tile_data = g_malloc (XCF_SAVE_BATCH_SIZE * max_tile_size);
+  out_data  = g_malloc (XCF_SAVE_BATCH_SIZE * batch.out_size);
+
+  for (i = 0; i < XCF_SAVE_BATCH_SIZE; i++)
     {
-      GeglRectangle rect;
+      batch.tiles[i].data = tile_data + i * max_tile_size;
+      batch.tiles[i].out  = out_data  + i * batch.out_size;
+    }
 
-      /* store the offset in the table and increment the next pointer */
-      *next_offset++ = offset;
+  for (i = 0; success && i < ntiles; i += batch.n_tiles)
+    {
+      gint j;
 
-      gimp_gegl_buffer_get_tile_rect (buffer,
-                                      XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
-                                      i, &rect);
+      batch.n_tiles = MIN (ntiles - i, XCF_SAVE_BATCH_SIZE);
 
-      /* write out the tile. */
-      switch (info->compression)
+      /* read the batch's pixels, the buffer is only accessed from
+       * this thread
+       */
+      for (j = 0; j < batch.n_tiles; j++)
         {
-        case COMPRESS_NONE:
-          xcf_check_error (xcf_save_tile (info, buffer, &rect, format,
-                                          error));
-          break;
-        case COMPRESS_RLE:
-          xcf_check_error (xcf_save_tile_rle (info, buffer, &rect, format,
-                                              rlebuf, error));
-          break;
-        case COMPRESS_ZLIB:
-          xcf_check_error (xcf_save_tile_zlib (info, buffer, &rect, format,
-                                               error));
-          break;
-        case COMPRESS_FRACTAL:
-          g_warning ("xcf: fractal compression unimplemented");
-          return FALSE;
+          XcfSaveTile *tile = &batch.tiles[j];
+
+          gimp_gegl_buffer_get_tile_rect (buffer,
+                                          XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
+                                          i + j, &tile->rect);
+
+          gegl_buffer_get (buffer, &tile->rect, 1.0, format, tile->data,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
         }
 
-      /* the next tile's offset is after the tile we just wrote */
-      offset = info->cp;
+      /* encode the batch's tiles in parallel */
+      gimp_parallel_distribute (batch.n_tiles,
+                                (GimpParallelDistributeFunc) xcf_save_encode_tiles,
+                                &batch);
+
+      /* write out the encoded tiles in order */
+      for (j = 0; j < batch.n_tiles; j++)
+        {
+          XcfSaveTile  *tile = &batch.tiles[j];
+          const guchar *data;
+
+          if (tile->size < 0)
+            {
+              g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                                   _("Error writing XCF: "
+                                     "tile compression failed"));
+              success = FALSE;
+              break;
+            }
+
+          if (batch.compression == COMPRESS_NONE)
+            data = tile->data;
+          else
+            data = tile->out;
+
+          /* store the offset in the table and increment the next pointer */
+          *next_offset++ = offset;
+
+          info->cp += xcf_write_int8 (info->output, data, tile->size,
+                                      &tmp_error);
+
+          if (tmp_error)
+            {
+              g_propagate_error (error, tmp_error);
+              success = FALSE;
+              break;
+            }
+
+          /* the next tile's offset is after the tile we just wrote */
+          offset = info->cp;
+        }
+    }
+
+  g_free (out_data);
+  g_free (tile_data);
+  g_free (batch.tiles);
+
+  if (success)
+    {
+      /* seek back to the offset table and write it  */
+      success = xcf_seek_pos (info, saved_pos, error);
+
+      if (success)
+        {
+          info->cp += xcf_write_offset (info->output, info->bytes_per_offset,
+                                        offset_table, ntiles + 1, &tmp_error);
+
+          if (tmp_error)
+            {
+              g_propagate_error (error, tmp_error);
+              success = FALSE;
+            }
+        }
     }
 
-  /* seek back to the offset table and write it  */
-  xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-  xcf_write_int32_check_error (info, offset_table, ntiles + 1);
+  g_free (offset_table);
 
   /* seek to the end of the file */
-  xcf_check_error (xcf_seek_pos (info, offset, error));
+  if (success)
+    success = xcf_seek_pos (info, offset, error);
 
-  return TRUE;
+  return success;
 }
 
-static gboolean
-xcf_save_tile (XcfInfo        *info,
-               GeglBuffer     *buffer,
-               GeglRectangle  *tile_rect,
-               const Babl     *format,
-               GError        **error)
+static void
+xcf_save_encode_tiles (gint              i,
+                       gint              n,
+                       XcfSaveTileBatch *batch)
 {
-  gint    bpp       = babl_format_get_bytes_per_pixel (format);
-  gint    tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar *tile_data = g_alloca (tile_size);
-  GError *tmp_error = NULL;
+  /* runs in parallel, every thread encodes every n-th tile */
+  for (; i < batch->n_tiles; i += n)
+    {
+      XcfSaveTile *tile     = &batch->tiles[i];
+      gint         n_pixels = tile->rect.width * tile->rect.height;
 
-  gegl_buffer_get (buffer, tile_rect, 1.0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      switch (batch->compression)
+        {
+        case COMPRESS_NONE:
+          tile->size = n_pixels * batch->bpp;
+          break;
 
-  xcf_write_int8_check_error (info, tile_data, tile_size);
+        case COMPRESS_RLE:
+          tile->size = xcf_save_tile_rle (tile->data, batch->bpp, n_pixels,
+                                          tile->out);
+          break;
 
-  return TRUE;
+        case COMPRESS_ZLIB:
+          tile->size = xcf_save_tile_zlib (tile->data, n_pixels * batch->bpp,
+                                           tile->out, batch->out_size,
+                                           batch->compression_level);
+          break;
+
+        case COMPRESS_ZSTD:
+          tile->size = xcf_save_tile_zstd (tile->data, n_pixels * batch->bpp,
+                                           tile->out, batch->out_size,
+                                           batch->compression_level);
+          break;
+
+        default:
+          tile->size = -1;
+          break;
+        }
+    }
 }
 
-static gboolean
-xcf_save_tile_rle (XcfInfo        *info,
-                   GeglBuffer     *buffer,
-                   GeglRectangle  *tile_rect,
-                   const Babl     *format,
-                   guchar         *rlebuf,
-                   GError        **error)
+static gint
+xcf_save_tile_rle (const guchar *tile_data,
+                   gint          bpp,
+                   gint          n_pixels,
+                   guchar       *rlebuf)
 {
-  gint    bpp       = babl_format_get_bytes_per_pixel (format);
-  gint    tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar *tile_data = g_alloca (tile_size);
-  gint    len       = 0;
-  gint    i, j;
-  GError *tmp_error  = NULL;
-
-  gegl_buffer_get (buffer, tile_rect, 1.0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gint len = 0;
+  gint i, j;
 
   for (i = 0; i < bpp; i++)
     {
@@ -1503,7 +1727,7 @@ xcf_save_tile_rle (XcfInfo        *info,
       gint          state  = 0;
       gint          length = 0;
       gint          count  = 0;
-      gint          size   = tile_rect->width * tile_rect->height;
+      gint          size   = n_pixels;
       guint         last   = -1;
 
       while (size > 0)
@@ -1589,81 +1813,74 @@ xcf_save_tile_rle (XcfInfo        *info,
             }
         }
 
-      if (count != (tile_rect->width * tile_rect->height))
-        g_message ("xcf: uh oh! xcf rle tile saving error: %d", count);
+      if (count != n_pixels)
+        g_printerr ("xcf: uh oh! xcf rle tile saving error: %d\n", count);
     }
 
-  xcf_write_int8_check_error (info, rlebuf, len);
-
-  return TRUE;
+  return len;
 }
 
-static gboolean
-xcf_save_tile_zlib (XcfInfo        *info,
-                    GeglBuffer     *buffer,
-                    GeglRectangle  *tile_rect,
-                    const Babl     *format,
-                    GError        **error)
+static gint
+xcf_save_tile_zlib (const guchar *tile_data,
+                    gint          tile_size,
+                    guchar       *buf,
+                    gint          buf_size,
+                    gint          level)
 {
-  gint      bpp       = babl_format_get_bytes_per_pixel (format);
-  gint      tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar   *tile_data = g_alloca (tile_size);
-  /* The buffer for compressed data. */
-  guchar   *buf       = g_alloca (tile_size);
-  GError   *tmp_error = NULL;
-  z_stream  strm;
-  int       action;
-  int       status;
-
-  gegl_buffer_get (buffer, tile_rect, 1.0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  z_stream strm;
+  int      status;
 
   /* allocate deflate state */
   strm.zalloc = Z_NULL;
   strm.zfree  = Z_NULL;
   strm.opaque = Z_NULL;
 
-  status = deflateInit (&strm, Z_DEFAULT_COMPRESSION);
+  status = deflateInit (&strm, level > 0 ? level : Z_DEFAULT_COMPRESSION);
   if (status != Z_OK)
-    return FALSE;
+    return -1;
 
-  strm.next_in   = tile_data;
+  strm.next_in   = (Bytef *) tile_data;
   strm.avail_in  = tile_size;
   strm.next_out  = buf;
-  strm.avail_out = tile_size;
+  strm.avail_out = buf_size;
 
-  action = Z_NO_FLUSH;
+  /* 'buf' is at least compressBound (tile_size) bytes large, so the
+   * tile is always encoded in one go
+   */
+  status = deflate (&strm, Z_FINISH);
 
-  while (status == Z_OK || status == Z_BUF_ERROR)
+  deflateEnd (&strm);
+
+  if (status != Z_STREAM_END)
     {
-      if (strm.avail_in == 0)
-        {
-          /* Finish the encoding. */
-          action = Z_FINISH;
-        }
+      g_printerr ("xcf: tile compression failed: %s\n", zError (status));
+      return -1;
+    }
 
-      status = deflate (&strm, action);
+  return buf_size - strm.avail_out;
+}
 
-      if (status == Z_STREAM_END || status == Z_BUF_ERROR)
-        {
-          size_t write_size = tile_size - strm.avail_out;
+static gint
+xcf_save_tile_zstd (const guchar *tile_data,
+                    gint          tile_size,
+                    guchar       *buf,
+                    gint          buf_size,
+                    gint          level)
+{
+  gsize size;
 
-          xcf_write_int8_check_error (info, buf, write_size);
+  /* zstd's own default level is 3, levels up to 9 are still fast */
+  size = ZSTD_compress (buf, buf_size, tile_data, tile_size,
+                        level > 0 ? level : 3);
 
-          /* Reset next_out and avail_out. */
-          strm.next_out  = buf;
-          strm.avail_out = tile_size;
-        }
-      else if (status != Z_OK)
-        {
-          g_printerr ("xcf: tile compression failed: %s", zError (status));
-          deflateEnd (&strm);
-          return FALSE;
-        }
+  if (ZSTD_isError (size))
+    {
+      g_printerr ("xcf: tile compression failed: %s\n",
+                  ZSTD_getErrorName (size));
+      return -1;
     }
 
-  deflateEnd (&strm);
-  return TRUE;
+  return size;
 }
 
 static gboolean
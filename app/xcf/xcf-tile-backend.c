@@ -0,0 +1,796 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <gegl.h>
+#include <glib/gstdio.h>
+
+#include "core/core-types.h"
+
+#include "xcf-private.h"
+#include "xcf-load.h"
+#include "xcf-tile-backend.h"
+
+
+static void       xcf_tile_backend_finalize (GObject         *object);
+
+static gpointer   xcf_tile_backend_command  (GeglTileSource  *source,
+                                             GeglTileCommand  command,
+                                             gint             x,
+                                             gint             y,
+                                             gint             z,
+                                             gpointer         data);
+
+static GeglTile * xcf_tile_backend_get_tile (XcfTileBackend  *backend,
+                                             gint             x,
+                                             gint             y);
+static void       xcf_tile_backend_set_tile (XcfTileBackend  *backend,
+                                             gint             x,
+                                             gint             y,
+                                             GeglTile        *tile);
+static void       xcf_tile_backend_void_tile (XcfTileBackend *backend,
+                                             gint             x,
+                                             gint             y);
+
+static guchar   * xcf_tile_backend_read     (XcfTileBackend  *backend,
+                                             gint             x,
+                                             gint             y,
+                                             gint            *length);
+static gboolean   xcf_tile_backend_decode   (XcfTileBackend  *backend,
+                                             gint             x,
+                                             gint             y,
+                                             const guchar    *xcfdata,
+                                             gint             length,
+                                             guchar          *dest);
+static void       xcf_tile_backend_materialize
+                                            (XcfTileBackend  *backend);
+
+static void       xcf_tile_backend_store    (XcfTileBackend  *backend,
+                                             gint             index,
+                                             const guchar    *data);
+static gboolean   xcf_tile_backend_swap_open
+                                            (XcfTileBackend  *backend);
+static gboolean   xcf_tile_backend_swap_read
+                                            (XcfTileBackend  *backend,
+                                             gint             index,
+                                             guchar          *dest);
+
+static gchar    * xcf_tile_backend_get_file_id
+                                            (GFileInfo       *info);
+
+
+G_DEFINE_TYPE (XcfTileBackend, xcf_tile_backend, GEGL_TYPE_TILE_BACKEND)
+
+#define parent_class xcf_tile_backend_parent_class
+
+
+/*  all backends of an image share one input stream, so reading from
+ *  it is serialized across backends
+ */
+static GMutex xcf_tile_backend_read_mutex;
+
+/*  all existing backends, so they can be detached from their file
+ *  before it is overwritten
+ */
+static GList  *xcf_tile_backends = NULL;
+static GMutex  xcf_tile_backends_mutex;
+
+
+static void
+xcf_tile_backend_class_init (XcfTileBackendClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = xcf_tile_backend_finalize;
+}
+
+static void
+xcf_tile_backend_init (XcfTileBackend *backend)
+{
+  GeglTileSource *source = GEGL_TILE_SOURCE (backend);
+
+  source->command = xcf_tile_backend_command;
+
+  /*  tiles which couldn't be swapped out, a stored NULL means the
+   *  tile was voided
+   */
+  backend->stored_tiles = g_hash_table_new_full (g_direct_hash,
+                                                 g_direct_equal,
+                                                 NULL,
+                                                 (GDestroyNotify) g_free);
+
+  g_mutex_init (&backend->mutex);
+}
+
+static void
+xcf_tile_backend_finalize (GObject *object)
+{
+  XcfTileBackend *backend = XCF_TILE_BACKEND (object);
+
+  g_mutex_lock (&xcf_tile_backends_mutex);
+  xcf_tile_backends = g_list_remove (xcf_tile_backends, backend);
+  g_mutex_unlock (&xcf_tile_backends_mutex);
+
+  g_clear_object (&backend->input);
+  g_clear_pointer (&backend->file_id, g_free);
+  g_clear_pointer (&backend->offsets, g_free);
+  g_clear_pointer (&backend->stored_tiles, g_hash_table_unref);
+  g_clear_pointer (&backend->swap_offsets, g_free);
+  g_clear_pointer (&backend->swap_dir, g_free);
+  g_clear_object (&backend->swap);
+
+  if (backend->swap_file)
+    {
+      g_unlink (backend->swap_file);
+      g_free (backend->swap_file);
+    }
+
+  g_mutex_clear (&backend->mutex);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gpointer
+xcf_tile_backend_command (GeglTileSource  *source,
+                          GeglTileCommand  command,
+                          gint             x,
+                          gint             y,
+                          gint             z,
+                          gpointer         data)
+{
+  XcfTileBackend *backend = XCF_TILE_BACKEND (source);
+
+  /*  only the full resolution level is stored in the backend,
+   *  GEGL creates the lower levels from it
+   */
+  if (z != 0                        ||
+      x < 0 || x >= backend->n_tile_cols ||
+      y < 0 || y >= backend->n_tile_rows)
+    return NULL;
+
+  switch (command)
+    {
+    case GEGL_TILE_GET:
+      return xcf_tile_backend_get_tile (backend, x, y);
+
+    case GEGL_TILE_SET:
+      xcf_tile_backend_set_tile (backend, x, y, data);
+      gegl_tile_mark_as_stored (data);
+      break;
+
+    case GEGL_TILE_VOID:
+      xcf_tile_backend_void_tile (backend, x, y);
+      break;
+
+    case GEGL_TILE_EXIST:
+      return GINT_TO_POINTER (TRUE);
+
+    default:
+      g_assert (command < GEGL_TILE_LAST_COMMAND && command >= 0);
+    }
+
+  return NULL;
+}
+
+static GeglTile *
+xcf_tile_backend_get_tile (XcfTileBackend *backend,
+                           gint            x,
+                           gint            y)
+{
+  GeglTile *tile;
+  gint      index = y * backend->n_tile_cols + x;
+  gpointer  key   = GINT_TO_POINTER (index);
+  gpointer  stored;
+  gint      tile_size;
+  guchar   *xcfdata;
+  gint      length;
+
+  tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (backend));
+
+  /*  the lookup and the read happen in one go, so the backend can't
+   *  be detached from the file in between
+   */
+  g_mutex_lock (&backend->mutex);
+
+  if (g_hash_table_lookup_extended (backend->stored_tiles, key,
+                                    NULL, &stored))
+    {
+      tile = NULL;
+
+      if (stored)
+        {
+          tile = gegl_tile_new (tile_size);
+          memcpy (gegl_tile_get_data (tile), stored, tile_size);
+        }
+
+      g_mutex_unlock (&backend->mutex);
+
+      return tile;
+    }
+
+  if (backend->swap_offsets[index] >= 0)
+    {
+      tile = gegl_tile_new (tile_size);
+
+      if (! xcf_tile_backend_swap_read (backend, index,
+                                        gegl_tile_get_data (tile)))
+        {
+          gegl_tile_unref (tile);
+          tile = NULL;
+        }
+
+      g_mutex_unlock (&backend->mutex);
+
+      return tile;
+    }
+
+  xcfdata = xcf_tile_backend_read (backend, x, y, &length);
+
+  g_mutex_unlock (&backend->mutex);
+
+  if (! xcfdata)
+    return NULL;
+
+  tile = gegl_tile_new (tile_size);
+
+  if (! xcf_tile_backend_decode (backend, x, y, xcfdata, length,
+                                 gegl_tile_get_data (tile)))
+    {
+      gegl_tile_unref (tile);
+      tile = NULL;
+    }
+
+  g_free (xcfdata);
+
+  return tile;
+}
+
+static void
+xcf_tile_backend_set_tile (XcfTileBackend *backend,
+                           gint            x,
+                           gint            y,
+                           GeglTile       *tile)
+{
+  g_mutex_lock (&backend->mutex);
+
+  xcf_tile_backend_store (backend, y * backend->n_tile_cols + x,
+                          gegl_tile_get_data (tile));
+
+  g_mutex_unlock (&backend->mutex);
+}
+
+static void
+xcf_tile_backend_void_tile (XcfTileBackend *backend,
+                            gint            x,
+                            gint            y)
+{
+  g_mutex_lock (&backend->mutex);
+
+  g_hash_table_replace (backend->stored_tiles,
+                        GINT_TO_POINTER (y * backend->n_tile_cols + x),
+                        NULL);
+
+  g_mutex_unlock (&backend->mutex);
+}
+
+
+/*  reads a tile's data from the file, returns NULL if the tile has no
+ *  data or can't be read, which leaves it empty.  must be called with
+ *  the backend's mutex held.
+ */
+static guchar *
+xcf_tile_backend_read (XcfTileBackend *backend,
+                       gint            x,
+                       gint            y,
+                       gint           *length)
+{
+  gint     index = y * backend->n_tile_cols + x;
+  gint     tile_width;
+  gint     tile_height;
+  goffset  offset;
+  goffset  offset2;
+  goffset  max_length;
+  guchar  *xcfdata;
+  gsize    bytes_read;
+
+  if (! backend->input)
+    return NULL;
+
+  /*  the XCF tiles at the right and bottom edges only store the part
+   *  inside the level, the GEGL tiles are always complete
+   */
+  tile_width  = MIN (XCF_TILE_WIDTH,  backend->width  - x * XCF_TILE_WIDTH);
+  tile_height = MIN (XCF_TILE_HEIGHT, backend->height - y * XCF_TILE_HEIGHT);
+
+  offset = backend->offsets[index];
+
+  if (backend->compression == COMPRESS_NONE)
+    {
+      max_length = tile_width * tile_height * backend->bpp;
+      offset2    = offset + max_length;
+    }
+  else
+    {
+      max_length = XCF_TILE_MAX_DATA_LENGTH (backend->bpp);
+      offset2    = backend->offsets[index + 1];
+
+      if (offset2 == 0)
+        offset2 = offset + max_length;
+    }
+
+  /*  see bug #357809, a tile without data is left empty  */
+  if (offset2 - offset <= 0)
+    return NULL;
+
+  /*  the offsets come from the file, never read more than a tile can
+   *  take
+   */
+  *length = MIN (offset2 - offset, max_length);
+
+  xcfdata = g_try_malloc (*length);
+
+  if (! xcfdata)
+    {
+      g_printerr ("xcf: failed to allocate %d bytes for tile %d "
+                  "of lazily loaded level\n", *length, index);
+      return NULL;
+    }
+
+  g_mutex_lock (&xcf_tile_backend_read_mutex);
+
+  if (g_seekable_seek (G_SEEKABLE (backend->input), offset, G_SEEK_SET,
+                       NULL, NULL))
+    {
+      g_input_stream_read_all (backend->input, xcfdata, *length,
+                               &bytes_read, NULL, NULL);
+    }
+  else
+    {
+      bytes_read = 0;
+    }
+
+  g_mutex_unlock (&xcf_tile_backend_read_mutex);
+
+  if (bytes_read == 0)
+    {
+      g_free (xcfdata);
+      return NULL;
+    }
+
+  *length = bytes_read;
+
+  return xcfdata;
+}
+
+/*  decodes a tile's data into 'dest', which has the size of a GEGL
+ *  tile
+ */
+static gboolean
+xcf_tile_backend_decode (XcfTileBackend *backend,
+                         gint            x,
+                         gint            y,
+                         const guchar   *xcfdata,
+                         gint            length,
+                         guchar         *dest)
+{
+  gint      tile_size;
+  gint      tile_width;
+  gint      tile_height;
+  guchar   *tile_data;
+  gboolean  success;
+
+  tile_size   = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (backend));
+  tile_width  = MIN (XCF_TILE_WIDTH,  backend->width  - x * XCF_TILE_WIDTH);
+  tile_height = MIN (XCF_TILE_HEIGHT, backend->height - y * XCF_TILE_HEIGHT);
+
+  tile_data = g_malloc (tile_width * tile_height * backend->bpp);
+
+  success = xcf_load_decode_tile (backend->compression,
+                                  xcfdata, length,
+                                  tile_data, backend->bpp,
+                                  tile_width * tile_height);
+
+  if (! success)
+    {
+      g_printerr ("xcf: failed to decode tile %d of lazily loaded level\n",
+                  y * backend->n_tile_cols + x);
+      g_free (tile_data);
+      return FALSE;
+    }
+
+  if (tile_width  == XCF_TILE_WIDTH &&
+      tile_height == XCF_TILE_HEIGHT)
+    {
+      memcpy (dest, tile_data, tile_size);
+    }
+  else
+    {
+      gint stride = XCF_TILE_WIDTH * backend->bpp;
+      gint row;
+
+      memset (dest, 0, tile_size);
+
+      for (row = 0; row < tile_height; row++)
+        memcpy (dest + row * stride,
+                tile_data + row * tile_width * backend->bpp,
+                tile_width * backend->bpp);
+    }
+
+  g_free (tile_data);
+
+  return TRUE;
+}
+
+/*  moves all tiles which are still only in the file to the swap file,
+ *  and then closes the file
+ */
+static void
+xcf_tile_backend_materialize (XcfTileBackend *backend)
+{
+  gint tile_size;
+  gint x, y;
+
+  tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (backend));
+
+  for (y = 0; y < backend->n_tile_rows; y++)
+    for (x = 0; x < backend->n_tile_cols; x++)
+      {
+        gint      index = y * backend->n_tile_cols + x;
+        gpointer  key   = GINT_TO_POINTER (index);
+        guchar   *xcfdata;
+        guchar   *data = NULL;
+        gint      length;
+
+        g_mutex_lock (&backend->mutex);
+
+        if (! g_hash_table_contains (backend->stored_tiles, key) &&
+            backend->swap_offsets[index] < 0)
+          {
+            xcfdata = xcf_tile_backend_read (backend, x, y, &length);
+
+            if (xcfdata)
+              {
+                data = g_malloc (tile_size);
+
+                if (! xcf_tile_backend_decode (backend, x, y,
+                                               xcfdata, length, data))
+                  g_clear_pointer (&data, g_free);
+
+                g_free (xcfdata);
+              }
+
+            /*  an empty tile is stored as a voided one  */
+            if (data)
+              xcf_tile_backend_store (backend, index, data);
+            else
+              g_hash_table_insert (backend->stored_tiles, key, NULL);
+
+            g_free (data);
+          }
+
+        g_mutex_unlock (&backend->mutex);
+      }
+
+  g_mutex_lock (&backend->mutex);
+  g_clear_object (&backend->input);
+  g_mutex_unlock (&backend->mutex);
+}
+
+/*  stores a written tile in the swap file, or in memory if there is no
+ *  swap file.  must be called with the backend's mutex held.
+ */
+static void
+xcf_tile_backend_store (XcfTileBackend *backend,
+                        gint            index,
+                        const guchar   *data)
+{
+  gpointer key = GINT_TO_POINTER (index);
+  gint     tile_size;
+
+  tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (backend));
+
+  if (xcf_tile_backend_swap_open (backend))
+    {
+      GOutputStream *output;
+      goffset        offset = backend->swap_offsets[index];
+      gsize          bytes_written = 0;
+
+      /*  a tile keeps its place in the swap file once it has one  */
+      if (offset < 0)
+        offset = backend->swap_size;
+
+      output = g_io_stream_get_output_stream (G_IO_STREAM (backend->swap));
+
+      if (g_seekable_seek (G_SEEKABLE (backend->swap), offset, G_SEEK_SET,
+                           NULL, NULL))
+        {
+          g_output_stream_write_all (output, data, tile_size,
+                                     &bytes_written, NULL, NULL);
+        }
+
+      if (bytes_written == (gsize) tile_size)
+        {
+          if (backend->swap_offsets[index] < 0)
+            {
+              backend->swap_offsets[index] = offset;
+              backend->swap_size += tile_size;
+            }
+
+          g_hash_table_remove (backend->stored_tiles, key);
+
+          return;
+        }
+
+      g_printerr ("xcf: failed to write tile %d of lazily loaded level "
+                  "to the swap file, keeping it in memory\n", index);
+    }
+
+  g_hash_table_replace (backend->stored_tiles, key,
+                        g_memdup (data, tile_size));
+}
+
+/*  creates the swap file on the first write.  returns FALSE if there
+ *  is no swap folder or the file can't be created, then written tiles
+ *  are kept in memory.  must be called with the backend's mutex held.
+ */
+static gboolean
+xcf_tile_backend_swap_open (XcfTileBackend *backend)
+{
+  GFile  *file;
+  GError *error = NULL;
+  gchar  *filename;
+  gint    fd;
+
+  if (backend->swap)
+    return TRUE;
+
+  if (! backend->swap_dir)
+    return FALSE;
+
+  filename = g_build_filename (backend->swap_dir, "gimp-xcf-XXXXXX", NULL);
+
+  /*  don't try again after a failure  */
+  g_clear_pointer (&backend->swap_dir, g_free);
+
+  fd = g_mkstemp (filename);
+
+  if (fd == -1)
+    {
+      g_printerr ("xcf: could not create swap file '%s': %s\n",
+                  filename, g_strerror (errno));
+      g_free (filename);
+
+      return FALSE;
+    }
+
+  g_close (fd, NULL);
+
+  file = g_file_new_for_path (filename);
+
+  backend->swap = g_file_open_readwrite (file, NULL, &error);
+
+  g_object_unref (file);
+
+  if (! backend->swap)
+    {
+      g_printerr ("xcf: could not open swap file '%s': %s\n",
+                  filename, error->message);
+      g_clear_error (&error);
+
+      g_unlink (filename);
+      g_free (filename);
+
+      return FALSE;
+    }
+
+  backend->swap_file = filename;
+
+  return TRUE;
+}
+
+/*  reads a tile back from the swap file.  must be called with the
+ *  backend's mutex held.
+ */
+static gboolean
+xcf_tile_backend_swap_read (XcfTileBackend *backend,
+                            gint            index,
+                            guchar         *dest)
+{
+  GInputStream *input;
+  gint          tile_size;
+  gsize         bytes_read = 0;
+
+  tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (backend));
+
+  input = g_io_stream_get_input_stream (G_IO_STREAM (backend->swap));
+
+  if (g_seekable_seek (G_SEEKABLE (backend->swap),
+                       backend->swap_offsets[index], G_SEEK_SET,
+                       NULL, NULL))
+    {
+      g_input_stream_read_all (input, dest, tile_size,
+                               &bytes_read, NULL, NULL);
+    }
+
+  if (bytes_read != (gsize) tile_size)
+    {
+      g_printerr ("xcf: failed to read tile %d of lazily loaded level "
+                  "from the swap file\n", index);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gchar *
+xcf_tile_backend_get_file_id (GFileInfo *info)
+{
+  const gchar *id = NULL;
+
+  if (info)
+    id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILE);
+
+  return g_strdup (id);
+}
+
+/*  public functions  */
+
+/**
+ * xcf_tile_backend_new:
+ * @input:       the XCF file's input stream, must be seekable
+ * @compression: the XCF file's tile compression
+ * @format:      the level's pixel format
+ * @width:       the level's width
+ * @height:      the level's height
+ * @offsets:     the level's tile offset table, the backend takes
+ *               ownership of it
+ * @swap_dir:    the folder to keep written tiles in, or %NULL to keep
+ *               them in memory
+ *
+ * Returns: a new backend which reads the level's tiles on demand.
+ **/
+GeglTileBackend *
+xcf_tile_backend_new (GInputStream       *input,
+                      XcfCompressionType  compression,
+                      const Babl         *format,
+                      gint                width,
+                      gint                height,
+                      goffset            *offsets,
+                      const gchar        *swap_dir)
+{
+  GeglTileBackend *backend;
+  XcfTileBackend  *xcf_backend;
+  gint             n_tiles;
+  gint             i;
+
+  g_return_val_if_fail (G_IS_SEEKABLE (input), NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (offsets != NULL, NULL);
+
+  backend = g_object_new (XCF_TYPE_TILE_BACKEND,
+                          "tile-width",  XCF_TILE_WIDTH,
+                          "tile-height", XCF_TILE_HEIGHT,
+                          "format",      format,
+                          NULL);
+
+  xcf_backend = XCF_TILE_BACKEND (backend);
+
+  xcf_backend->input       = g_object_ref (input);
+  xcf_backend->compression = compression;
+  xcf_backend->width       = width;
+  xcf_backend->height      = height;
+  xcf_backend->bpp         = babl_format_get_bytes_per_pixel (format);
+  xcf_backend->n_tile_cols = (width  + XCF_TILE_WIDTH  - 1) / XCF_TILE_WIDTH;
+  xcf_backend->n_tile_rows = (height + XCF_TILE_HEIGHT - 1) / XCF_TILE_HEIGHT;
+  xcf_backend->offsets     = offsets;
+  xcf_backend->swap_dir    = g_strdup (swap_dir);
+
+  n_tiles = xcf_backend->n_tile_cols * xcf_backend->n_tile_rows;
+
+  xcf_backend->swap_offsets = g_new (goffset, n_tiles);
+
+  for (i = 0; i < n_tiles; i++)
+    xcf_backend->swap_offsets[i] = -1;
+
+  gegl_tile_backend_set_extent (backend,
+                                GEGL_RECTANGLE (0, 0, width, height));
+
+  /*  the file's identity, which is the same for hard and symbolic
+   *  links to it
+   */
+  if (G_IS_FILE_INPUT_STREAM (input))
+    {
+      GFileInfo *info;
+
+      info = g_file_input_stream_query_info (G_FILE_INPUT_STREAM (input),
+                                             G_FILE_ATTRIBUTE_ID_FILE,
+                                             NULL, NULL);
+
+      xcf_backend->file_id = xcf_tile_backend_get_file_id (info);
+
+      if (info)
+        g_object_unref (info);
+    }
+
+  g_mutex_lock (&xcf_tile_backends_mutex);
+  xcf_tile_backends = g_list_prepend (xcf_tile_backends, xcf_backend);
+  g_mutex_unlock (&xcf_tile_backends_mutex);
+
+  return backend;
+}
+
+/**
+ * xcf_tile_backend_detach:
+ * @file: the file which is about to be overwritten
+ *
+ * Moves the tiles of all backends which read from @file to their swap
+ * files, and closes the file, so that overwriting it doesn't change the
+ * images loaded from it, and doesn't fail because it is still open.
+ * If the identity of a file can't be determined, its backends are
+ * detached too.
+ **/
+void
+xcf_tile_backend_detach (GFile *file)
+{
+  GFileInfo *info;
+  GError    *error = NULL;
+  gchar     *file_id;
+  GList     *list;
+
+  g_return_if_fail (G_IS_FILE (file));
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_ID_FILE,
+                            G_FILE_QUERY_INFO_NONE, NULL, &error);
+
+  /*  nothing can be read from a file which doesn't exist yet  */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+    {
+      g_clear_error (&error);
+      return;
+    }
+
+  g_clear_error (&error);
+
+  file_id = xcf_tile_backend_get_file_id (info);
+
+  if (info)
+    g_object_unref (info);
+
+  /*  keep the list locked, so no backend is finalized while it is
+   *  being detached
+   */
+  g_mutex_lock (&xcf_tile_backends_mutex);
+
+  for (list = xcf_tile_backends; list; list = g_list_next (list))
+    {
+      XcfTileBackend *backend = list->data;
+
+      if (! file_id || ! backend->file_id ||
+          ! strcmp (file_id, backend->file_id))
+        {
+          xcf_tile_backend_materialize (backend);
+        }
+    }
+
+  g_mutex_unlock (&xcf_tile_backends_mutex);
+
+  g_free (file_id);
+}
@@ -0,0 +1,84 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __XCF_TILE_BACKEND_H__
+#define __XCF_TILE_BACKEND_H__
+
+#include <gegl-buffer-backend.h>
+
+/***
+ * XcfTileBackend is a GeglTileBackend which reads and decodes the
+ * tiles of an XCF level when they are first accessed.  Tiles which
+ * are written are kept in a swap file from then on, like GEGL's own
+ * backends do, and only in memory if there is no swap file.  Before
+ * the XCF file is overwritten, xcf_tile_backend_detach() moves all
+ * remaining tiles to the swap file and closes the XCF file.
+ */
+
+#define XCF_TYPE_TILE_BACKEND            (xcf_tile_backend_get_type ())
+#define XCF_TILE_BACKEND(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), XCF_TYPE_TILE_BACKEND, XcfTileBackend))
+#define XCF_TILE_BACKEND_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  XCF_TYPE_TILE_BACKEND, XcfTileBackendClass))
+#define XCF_IS_TILE_BACKEND(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), XCF_TYPE_TILE_BACKEND))
+#define XCF_IS_TILE_BACKEND_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  XCF_TYPE_TILE_BACKEND))
+#define XCF_TILE_BACKEND_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  XCF_TYPE_TILE_BACKEND, XcfTileBackendClass))
+
+
+typedef struct _XcfTileBackend      XcfTileBackend;
+typedef struct _XcfTileBackendClass XcfTileBackendClass;
+
+struct _XcfTileBackend
+{
+  GeglTileBackend     parent_instance;
+
+  GInputStream       *input;      /*  NULL once detached from the file  */
+  gchar              *file_id;
+  XcfCompressionType  compression;
+  gint                width;
+  gint                height;
+  gint                bpp;
+  gint                n_tile_cols;
+  gint                n_tile_rows;
+  goffset            *offsets;
+  GHashTable         *stored_tiles;
+  gchar              *swap_dir;   /*  NULL once the swap file is created  */
+  gchar              *swap_file;
+  GFileIOStream      *swap;
+  goffset            *swap_offsets;
+  goffset             swap_size;
+  GMutex              mutex;
+};
+
+struct _XcfTileBackendClass
+{
+  GeglTileBackendClass  parent_class;
+};
+
+
+GType             xcf_tile_backend_get_type (void) G_GNUC_CONST;
+
+GeglTileBackend * xcf_tile_backend_new      (GInputStream       *input,
+                                             XcfCompressionType  compression,
+                                             const Babl         *format,
+                                             gint                width,
+                                             gint                height,
+                                             goffset            *offsets,
+                                             const gchar        *swap_dir);
+
+void              xcf_tile_backend_detach   (GFile              *file);
+
+
+#endif /* __XCF_TILE_BACKEND_H__ */
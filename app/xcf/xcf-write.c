@@ -72,6 +72,64 @@ xcf_write_zero_int32 (GOutputStream  *output,
   return 0;
 }
 
+guint
+xcf_write_offset (GOutputStream  *output,
+                  gint            bytes_per_offset,
+                  const goffset  *data,
+                  gint            count,
+                  GError        **error)
+{
+  GError *tmp_error = NULL;
+  guint   total     = 0;
+  gint    i;
+
+  for (i = 0; i < count; i++)
+    {
+      if (bytes_per_offset == 4)
+        {
+          guint32 tmp;
+
+          if (data[i] > G_MAXUINT32)
+            {
+              g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                                   _("Error writing XCF: file too large for "
+                                     "32 bit offsets"));
+              return total;
+            }
+
+          tmp = data[i];
+
+          total += xcf_write_int32 (output, &tmp, 1, &tmp_error);
+        }
+      else
+        {
+          guint32 tmp[2];
+
+          tmp[0] = (guint64) data[i] >> 32;
+          tmp[1] = (guint64) data[i] & 0xffffffff;
+
+          total += xcf_write_int32 (output, tmp, 2, &tmp_error);
+        }
+
+      if (tmp_error)
+        {
+          g_propagate_error (error, tmp_error);
+          return total;
+        }
+    }
+
+  return total;
+}
+
+guint
+xcf_write_zero_offset (GOutputStream  *output,
+                       gint            bytes_per_offset,
+                       gint            count,
+                       GError        **error)
+{
+  return xcf_write_zero_int32 (output, count * bytes_per_offset / 4, error);
+}
+
 guint
 xcf_write_float (GOutputStream  *output,
                  const gfloat   *data,
@@ -29,6 +29,8 @@
 
 #include "core/core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "core/gimp.h"
 #include "core/gimpimage.h"
 #include "core/gimpparamspecs.h"
@@ -42,6 +44,7 @@
 #include "xcf-load.h"
 #include "xcf-read.h"
 #include "xcf-save.h"
+#include "xcf-tile-backend.h"
 
 #include "gimp-intl.h"
 
@@ -51,12 +54,25 @@ typedef GimpImage * GimpXcfLoaderFunc (Gimp     *gimp,
                                        GError  **error);
 
 
+static GimpImage      * xcf_load_file    (Gimp                  *gimp,
+                                          GimpProgress          *progress,
+                                          GFile                 *file,
+                                          XcfInfo               *info,
+                                          GError               **error);
+
 static GimpValueArray * xcf_load_invoker (GimpProcedure         *procedure,
                                           Gimp                  *gimp,
                                           GimpContext           *context,
                                           GimpProgress          *progress,
                                           const GimpValueArray  *args,
                                           GError               **error);
+static GimpValueArray * xcf_load_thumb_invoker
+                                         (GimpProcedure         *procedure,
+                                          Gimp                  *gimp,
+                                          GimpContext           *context,
+                                          GimpProgress          *progress,
+                                          const GimpValueArray  *args,
+                                          GError               **error);
 static GimpValueArray * xcf_save_invoker (GimpProcedure         *procedure,
                                           Gimp                  *gimp,
                                           GimpContext           *context,
@@ -76,7 +92,9 @@ static GimpXcfLoaderFunc * const xcf_loaders[] =
   xcf_load_image,   /* version 6 */
   xcf_load_image,   /* version 7 */
   xcf_load_image,   /* version 8 */
-  xcf_load_image    /* version 9 */
+  xcf_load_image,   /* version 9 */
+  xcf_load_image,   /* version 10 */
+  xcf_load_image    /* version 11 */
 };
 
 
@@ -167,6 +185,28 @@ xcf_init (Gimp *gimp)
                                                        FALSE, FALSE, TRUE,
                                                        NULL,
                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("compression",
+                                                      "Compression",
+                                                      "The tile compression "
+                                                      "{ RLE (0), zlib (1), "
+                                                      "Zstandard (2) }, or -1 "
+                                                      "to use the preference",
+                                                      -1,
+                                                      GIMP_XCF_COMPRESSION_ZSTD,
+                                                      -1,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("compression-level",
+                                                      "Compression level",
+                                                      "The zlib or Zstandard "
+                                                      "compression level "
+                                                      "(1 - 9, 0 for the "
+                                                      "codec's default), or "
+                                                      "-1 to use the "
+                                                      "preference",
+                                                      -1, 9, -1,
+                                                      GIMP_PARAM_READWRITE));
   gimp_plug_in_manager_add_procedure (gimp->plug_in_manager, proc);
   g_object_unref (procedure);
 
@@ -188,6 +228,7 @@ xcf_init (Gimp *gimp)
                                         "0,string,gimp\\040xcf\\040");
   gimp_plug_in_procedure_set_mime_type (proc, "image/xcf");
   gimp_plug_in_procedure_set_handles_uri (proc);
+  gimp_plug_in_procedure_set_thumb_loader (proc, "gimp-xcf-load-thumb");
 
   gimp_object_set_static_name (GIMP_OBJECT (procedure), "gimp-xcf-load");
   gimp_procedure_set_static_strings (procedure,
@@ -236,6 +277,86 @@ xcf_init (Gimp *gimp)
                                                              GIMP_PARAM_READWRITE));
   gimp_plug_in_manager_add_procedure (gimp->plug_in_manager, proc);
   g_object_unref (procedure);
+
+  /*  gimp-xcf-load-thumb  */
+  file = g_file_new_for_path ("gimp-xcf-load-thumb");
+  procedure = gimp_plug_in_procedure_new (GIMP_PLUGIN, file);
+  g_object_unref (file);
+
+  procedure->proc_type    = GIMP_INTERNAL;
+  procedure->marshal_func = xcf_load_thumb_invoker;
+
+  proc = GIMP_PLUG_IN_PROCEDURE (procedure);
+
+  gimp_object_set_static_name (GIMP_OBJECT (procedure), "gimp-xcf-load-thumb");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-xcf-load-thumb",
+                                     "Loads a thumbnail of an .xcf file",
+                                     "Loads the image at a reduced size, "
+                                     "using the smallest mipmap level "
+                                     "stored in the file which is not "
+                                     "smaller than the requested size.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "1995-1996",
+                                     NULL);
+
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string ("filename",
+                                                       "Filename",
+                                                       "The name of the file "
+                                                       "to load",
+                                                       TRUE, FALSE, TRUE,
+                                                       NULL,
+                                                       GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("thumb-size",
+                                                      "Thumb size",
+                                                      "Preferred thumbnail "
+                                                      "size",
+                                                      1, GIMP_MAX_IMAGE_SIZE,
+                                                      128,
+                                                      GIMP_PARAM_READWRITE));
+
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_image_id ("image",
+                                                             "Image",
+                                                             "Thumbnail image",
+                                                             gimp, FALSE,
+                                                             GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("image-width",
+                                                          "Image width",
+                                                          "Width of the full-sized "
+                                                          "image",
+                                                          1, GIMP_MAX_IMAGE_SIZE,
+                                                          1,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("image-height",
+                                                          "Image height",
+                                                          "Height of the full-sized "
+                                                          "image",
+                                                          1, GIMP_MAX_IMAGE_SIZE,
+                                                          1,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("image-type",
+                                                          "Image type",
+                                                          "Type of the image",
+                                                          GIMP_RGB_IMAGE,
+                                                          GIMP_INDEXEDA_IMAGE,
+                                                          GIMP_RGB_IMAGE,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("num-layers",
+                                                          "Num layers",
+                                                          "Number of layers in "
+                                                          "the image",
+                                                          0, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_plug_in_manager_add_procedure (gimp->plug_in_manager, proc);
+  g_object_unref (procedure);
 }
 
 void
@@ -244,46 +365,45 @@ xcf_exit (Gimp *gimp)
   g_return_if_fail (GIMP_IS_GIMP (gimp));
 }
 
-static GimpValueArray *
-xcf_load_invoker (GimpProcedure         *procedure,
-                  Gimp                  *gimp,
-                  GimpContext           *context,
-                  GimpProgress          *progress,
-                  const GimpValueArray  *args,
-                  GError               **error)
+static GimpImage *
+xcf_load_file (Gimp          *gimp,
+               GimpProgress  *progress,
+               GFile         *file,
+               XcfInfo       *info,
+               GError       **error)
 {
-  XcfInfo         info = { 0, };
-  GimpValueArray *return_vals;
-  GimpImage      *image   = NULL;
-  const gchar    *uri;
-  gchar          *filename;
-  GFile          *file;
-  gboolean        success = FALSE;
-  gchar           id[14];
-  GError         *my_error = NULL;
-
-  gimp_set_busy (gimp);
+  GimpImage *image = NULL;
+  gchar     *filename;
+  gchar      id[14];
+  GError    *my_error = NULL;
 
-  uri      = g_value_get_string (gimp_value_array_index (args, 1));
-  file     = g_file_new_for_uri (uri);
   filename = g_file_get_parse_name (file);
 
-  info.input = G_INPUT_STREAM (g_file_read (file, NULL, &my_error));
+  info->input = G_INPUT_STREAM (g_file_read (file, NULL, &my_error));
 
-  if (info.input)
+  if (info->input)
     {
-      info.gimp        = gimp;
-      info.seekable    = G_SEEKABLE (info.input);
-      info.progress    = progress;
-      info.filename    = filename;
-      info.compression = COMPRESS_NONE;
+      gboolean success = TRUE;
+
+      info->gimp        = gimp;
+      info->seekable    = G_SEEKABLE (info->input);
+      info->progress    = progress;
+      info->filename    = filename;
+      info->compression = COMPRESS_NONE;
+
+      /*  layers which are loaded lazily read their tiles from a
+       *  separate stream, so they don't disturb the loader's position,
+       *  only do it for local files where seeking is cheap
+       */
+      if (info->thumbnail_size == 0    &&
+          gimp->config->xcf_lazy_loading &&
+          g_file_is_native (file))
+        info->lazy_input = G_INPUT_STREAM (g_file_read (file, NULL, NULL));
 
       if (progress)
         gimp_progress_start (progress, FALSE, _("Opening '%s'"), filename);
 
-      success = TRUE;
-
-      info.cp += xcf_read_int8 (info.input, (guint8 *) id, 14);
+      info->cp += xcf_read_int8 (info->input, (guint8 *) id, 14);
 
       if (! g_str_has_prefix (id, "gimp xcf "))
         {
@@ -291,11 +411,11 @@ xcf_load_invoker (GimpProcedure         *procedure,
         }
       else if (strcmp (id + 9, "file") == 0)
         {
-          info.file_version = 0;
+          info->file_version = 0;
         }
       else if (id[9] == 'v')
         {
-          info.file_version = atoi (id + 10);
+          info->file_version = atoi (id + 10);
         }
       else
         {
@@ -304,24 +424,27 @@ xcf_load_invoker (GimpProcedure         *procedure,
 
       if (success)
         {
-          if (info.file_version >= 0 &&
-              info.file_version < G_N_ELEMENTS (xcf_loaders))
+          if (info->file_version >= 0 &&
+              info->file_version < G_N_ELEMENTS (xcf_loaders))
             {
-              image = (*(xcf_loaders[info.file_version])) (gimp, &info, error);
+              /* version 10 switched to 64 bit offsets */
+              if (info->file_version >= 10)
+                info->bytes_per_offset = 8;
+              else
+                info->bytes_per_offset = 4;
 
-              if (! image)
-                success = FALSE;
+              image = (*(xcf_loaders[info->file_version])) (gimp, info, error);
             }
           else
             {
               g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                            _("XCF error: unsupported XCF file version %d "
-                             "encountered"), info.file_version);
-              success = FALSE;
+                             "encountered"), info->file_version);
             }
         }
 
-      g_object_unref (info.input);
+      g_clear_object (&info->input);
+      g_clear_object (&info->lazy_input);
 
       if (progress)
         gimp_progress_end (progress);
@@ -333,13 +456,39 @@ xcf_load_invoker (GimpProcedure         *procedure,
                                   filename);
     }
 
+  info->filename = NULL;
   g_free (filename);
+
+  return image;
+}
+
+static GimpValueArray *
+xcf_load_invoker (GimpProcedure         *procedure,
+                  Gimp                  *gimp,
+                  GimpContext           *context,
+                  GimpProgress          *progress,
+                  const GimpValueArray  *args,
+                  GError               **error)
+{
+  XcfInfo         info = { 0, };
+  GimpValueArray *return_vals;
+  GimpImage      *image;
+  const gchar    *uri;
+  GFile          *file;
+
+  gimp_set_busy (gimp);
+
+  uri  = g_value_get_string (gimp_value_array_index (args, 1));
+  file = g_file_new_for_uri (uri);
+
+  image = xcf_load_file (gimp, progress, file, &info, error);
+
   g_object_unref (file);
 
-  return_vals = gimp_procedure_get_return_values (procedure, success,
+  return_vals = gimp_procedure_get_return_values (procedure, image != NULL,
                                                   error ? *error : NULL);
 
-  if (success)
+  if (image)
     gimp_value_set_image (gimp_value_array_index (return_vals, 1), image);
 
   gimp_unset_busy (gimp);
@@ -347,6 +496,65 @@ xcf_load_invoker (GimpProcedure         *procedure,
   return return_vals;
 }
 
+static GimpValueArray *
+xcf_load_thumb_invoker (GimpProcedure         *procedure,
+                        Gimp                  *gimp,
+                        GimpContext           *context,
+                        GimpProgress          *progress,
+                        const GimpValueArray  *args,
+                        GError               **error)
+{
+  XcfInfo         info = { 0, };
+  GimpValueArray *return_vals;
+  GimpImage      *image;
+  const gchar    *uri;
+  GFile          *file;
+
+  uri  = g_value_get_string (gimp_value_array_index (args, 0));
+  file = g_file_new_for_uri (uri);
+
+  info.thumbnail_size = g_value_get_int (gimp_value_array_index (args, 1));
+
+  image = xcf_load_file (gimp, NULL, file, &info, error);
+
+  g_object_unref (file);
+
+  return_vals = gimp_procedure_get_return_values (procedure, image != NULL,
+                                                  error ? *error : NULL);
+
+  if (image)
+    {
+      GimpImageType type      = GIMP_RGB_IMAGE;
+      gboolean      has_alpha = gimp_image_has_alpha (image);
+
+      switch (gimp_image_get_base_type (image))
+        {
+        case GIMP_RGB:
+          type = has_alpha ? GIMP_RGBA_IMAGE : GIMP_RGB_IMAGE;
+          break;
+
+        case GIMP_GRAY:
+          type = has_alpha ? GIMP_GRAYA_IMAGE : GIMP_GRAY_IMAGE;
+          break;
+
+        case GIMP_INDEXED:
+          type = has_alpha ? GIMP_INDEXEDA_IMAGE : GIMP_INDEXED_IMAGE;
+          break;
+        }
+
+      gimp_value_set_image (gimp_value_array_index (return_vals, 1), image);
+      g_value_set_int (gimp_value_array_index (return_vals, 2),
+                       info.image_width);
+      g_value_set_int (gimp_value_array_index (return_vals, 3),
+                       info.image_height);
+      g_value_set_int (gimp_value_array_index (return_vals, 4), type);
+      g_value_set_int (gimp_value_array_index (return_vals, 5),
+                       gimp_image_get_n_layers (image));
+    }
+
+  return return_vals;
+}
+
 static GimpValueArray *
 xcf_save_invoker (GimpProcedure         *procedure,
                   Gimp                  *gimp,
@@ -355,14 +563,16 @@ xcf_save_invoker (GimpProcedure         *procedure,
                   const GimpValueArray  *args,
                   GError               **error)
 {
-  XcfInfo         info = { 0, };
-  GimpValueArray *return_vals;
-  GimpImage      *image;
-  const gchar    *uri;
-  gchar          *filename;
-  GFile          *file;
-  gboolean        success  = FALSE;
-  GError         *my_error = NULL;
+  XcfInfo             info = { 0, };
+  GimpValueArray     *return_vals;
+  GimpImage          *image;
+  const gchar        *uri;
+  gchar              *filename;
+  GFile              *file;
+  GimpXcfCompression  compression;
+  gint                compression_level;
+  gboolean            success  = FALSE;
+  GError             *my_error = NULL;
 
   gimp_set_busy (gimp);
 
@@ -371,29 +581,64 @@ xcf_save_invoker (GimpProcedure         *procedure,
   file     = g_file_new_for_uri (uri);
   filename = g_file_get_parse_name (file);
 
+  compression       = gimp->config->xcf_compression;
+  compression_level = gimp->config->xcf_compression_level;
+
+  /*  the compression arguments are optional, older callers don't
+   *  pass them
+   */
+  if (gimp_value_array_length (args) > 5 &&
+      g_value_get_int (gimp_value_array_index (args, 5)) >= 0)
+    compression = g_value_get_int (gimp_value_array_index (args, 5));
+
+  if (gimp_value_array_length (args) > 6 &&
+      g_value_get_int (gimp_value_array_index (args, 6)) >= 0)
+    compression_level = g_value_get_int (gimp_value_array_index (args, 6));
+
+  if (gimp_image_get_xcf_compat_mode (image))
+    compression = GIMP_XCF_COMPRESSION_RLE;
+
+  /*  layers loaded lazily from the file we are about to overwrite
+   *  still read their tiles from it
+   */
+  xcf_tile_backend_detach (file);
+
   info.output = G_OUTPUT_STREAM (g_file_replace (file,
                                                  NULL, FALSE, G_FILE_CREATE_NONE,
                                                  NULL, &my_error));
 
   if (info.output)
     {
-      gboolean compat_mode = gimp_image_get_xcf_compat_mode (image);
+      info.gimp              = gimp;
+      info.seekable          = G_SEEKABLE (info.output);
+      info.progress          = progress;
+      info.filename          = filename;
+      info.compression_level = compression_level;
+      info.save_mipmaps      = gimp->config->xcf_save_mipmaps;
+
+      switch (compression)
+        {
+        case GIMP_XCF_COMPRESSION_RLE:
+          info.compression = COMPRESS_RLE;
+          break;
 
-      info.gimp         = gimp;
-      info.seekable     = G_SEEKABLE (info.output);
-      info.progress     = progress;
-      info.filename     = filename;
+        case GIMP_XCF_COMPRESSION_ZLIB:
+          info.compression = COMPRESS_ZLIB;
+          break;
 
-      if (compat_mode)
-        info.compression = COMPRESS_RLE;
-      else
-        info.compression = COMPRESS_ZLIB;
+        case GIMP_XCF_COMPRESSION_ZSTD:
+          info.compression = COMPRESS_ZSTD;
+          break;
+        }
 
-      info.file_version = gimp_image_get_xcf_version (image,
-                                                      info.compression ==
-                                                      COMPRESS_ZLIB,
+      info.file_version = gimp_image_get_xcf_version (image, compression,
                                                       NULL, NULL);
 
+      if (info.file_version >= 10)
+        info.bytes_per_offset = 8;
+      else
+        info.bytes_per_offset = 4;
+
       if (progress)
         gimp_progress_start (progress, FALSE, _("Saving '%s'"), filename);
 
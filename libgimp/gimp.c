@@ -120,6 +120,7 @@
 
 
 #define TILE_MAP_SIZE (_tile_width * _tile_height * 32)
+#define SHM_SIZE      (TILE_MAP_SIZE * _shm_n_tiles)
 
 #define ERRMSG_SHM_FAILED "Could not attach to gimp shared memory segment"
 
@@ -177,6 +178,9 @@ static void       gimp_set_pdb_error           (const GimpParam *return_vals,
 static GIOChannel *_readchannel  = NULL;
 GIOChannel *_writechannel = NULL;
 
+/*  the number of tiles the shared memory segment can hold  */
+gint        _shm_n_tiles  = 1;
+
 #ifdef USE_WIN32_SHM
 static HANDLE shm_handle;
 #endif
@@ -1700,7 +1704,7 @@ gimp_close (void)
 #elif defined(USE_POSIX_SHM)
 
   if ((_shm_ID != -1) && (_shm_addr != MAP_FAILED))
-    munmap (_shm_addr, TILE_MAP_SIZE);
+    munmap (_shm_addr, SHM_SIZE);
 
 #endif
 
@@ -1940,6 +1944,7 @@ gimp_loop (void)
         case GP_TILE_REQ:
         case GP_TILE_ACK:
         case GP_TILE_DATA:
+        case GP_TILE_BATCH:
           g_warning ("unexpected tile message received (should not happen)");
           break;
 
@@ -1999,6 +2004,7 @@ gimp_config (GPConfig *config)
   _tile_width       = config->tile_width;
   _tile_height      = config->tile_height;
   _shm_ID           = config->shm_ID;
+  _shm_n_tiles      = MAX (config->shm_n_tiles, 1);
   _check_size       = config->check_size;
   _check_type       = config->check_type;
   _install_cmap     = config->install_cmap     ? TRUE : FALSE;
@@ -2052,7 +2058,7 @@ gimp_config (GPConfig *config)
           /* Map the shared memory into our address space for use */
           _shm_addr = (guchar *) MapViewOfFile (shm_handle,
                                                 FILE_MAP_ALL_ACCESS,
-                                                0, 0, TILE_MAP_SIZE);
+                                                0, 0, SHM_SIZE);
 
           /* Verify that we mapped our view */
           if (!_shm_addr)
@@ -2083,7 +2089,7 @@ gimp_config (GPConfig *config)
       if (shm_fd != -1)
         {
           /* Map the shared memory into our address space for use */
-          _shm_addr = (guchar *) mmap (NULL, TILE_MAP_SIZE,
+          _shm_addr = (guchar *) mmap (NULL, SHM_SIZE,
                                        PROT_READ | PROT_WRITE, MAP_SHARED,
                                        shm_fd, 0);
 
@@ -2176,6 +2182,7 @@ gimp_process_message (GimpWireMessage *msg)
     case GP_TILE_REQ:
     case GP_TILE_ACK:
     case GP_TILE_DATA:
+    case GP_TILE_BATCH:
       g_warning ("unexpected tile message received (should not happen)");
       break;
     case GP_PROC_RUN:
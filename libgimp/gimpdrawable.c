@@ -117,32 +117,41 @@ gimp_drawable_detach (GimpDrawable *drawable)
 void
 gimp_drawable_flush (GimpDrawable *drawable)
 {
-  GimpTile *tiles;
-  gint      n_tiles;
-  gint      i;
+  GimpTile  *tiles;
+  GimpTile **dirty;
+  gint       n_tiles;
+  gint       n_dirty = 0;
+  gint       i;
 
   g_return_if_fail (drawable != NULL);
 
+  n_tiles = drawable->ntile_rows * drawable->ntile_cols;
+
+  /*  collect the dirty tiles, so they are sent several at a time  */
+  dirty = g_new (GimpTile *, 2 * n_tiles);
+
   if (drawable->tiles)
     {
-      tiles   = drawable->tiles;
-      n_tiles = drawable->ntile_rows * drawable->ntile_cols;
+      tiles = drawable->tiles;
 
       for (i = 0; i < n_tiles; i++)
         if ((tiles[i].ref_count > 0) && tiles[i].dirty)
-          gimp_tile_flush (&tiles[i]);
+          dirty[n_dirty++] = &tiles[i];
     }
 
   if (drawable->shadow_tiles)
     {
-      tiles   = drawable->shadow_tiles;
-      n_tiles = drawable->ntile_rows * drawable->ntile_cols;
+      tiles = drawable->shadow_tiles;
 
       for (i = 0; i < n_tiles; i++)
         if ((tiles[i].ref_count > 0) && tiles[i].dirty)
-          gimp_tile_flush (&tiles[i]);
+          dirty[n_dirty++] = &tiles[i];
     }
 
+  _gimp_tile_flush_batch (dirty, n_dirty);
+
+  g_free (dirty);
+
   /*  nuke all references to this drawable from the cache  */
   _gimp_tile_cache_flush_drawable (drawable);
 }
@@ -22,6 +22,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "gimp.h"
 
 
@@ -274,3 +276,73 @@ gimp_image_undo_thaw (gint32 image_ID)
 
   return thawed;
 }
+
+/**
+ * gimp_image_undo_get_memsize:
+ * @image_ID: The image.
+ * @undo_memsize: The memory used by the undo steps, in bytes.
+ * @redo_memsize: The memory used by the redo steps, in bytes.
+ * @num_undo_types: The number of undo types.
+ * @undo_types: The nicks of the undo types on the undo stack.
+ * @num_type_memsizes: The number of undo types.
+ * @type_memsizes: The memory used by each undo type, in bytes.
+ *
+ * Returns the memory used by the image's undo and redo steps.
+ *
+ * This procedure returns the number of bytes used by the image's undo
+ * and redo stacks, and how the memory of the undo stack is distributed
+ * over the different kinds of undo steps. The undo types are sorted by
+ * the memory they use, largest first.
+ *
+ * Returns: TRUE on success.
+ *
+ * Since: 2.10
+ **/
+gboolean
+gimp_image_undo_get_memsize (gint32     image_ID,
+                             gdouble   *undo_memsize,
+                             gdouble   *redo_memsize,
+                             gint      *num_undo_types,
+                             gchar   ***undo_types,
+                             gint      *num_type_memsizes,
+                             gdouble  **type_memsizes)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+  gint i;
+
+  return_vals = gimp_run_procedure ("gimp-image-undo-get-memsize",
+                                    &nreturn_vals,
+                                    GIMP_PDB_IMAGE, image_ID,
+                                    GIMP_PDB_END);
+
+  *undo_memsize = 0.0;
+  *redo_memsize = 0.0;
+  *num_undo_types = 0;
+  *undo_types = NULL;
+  *num_type_memsizes = 0;
+  *type_memsizes = NULL;
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  if (success)
+    {
+      *undo_memsize = return_vals[1].data.d_float;
+      *redo_memsize = return_vals[2].data.d_float;
+      *num_undo_types = return_vals[3].data.d_int32;
+      *undo_types = g_new (gchar *, *num_undo_types + 1);
+      for (i = 0; i < *num_undo_types; i++)
+        (*undo_types)[i] = g_strdup (return_vals[4].data.d_stringarray[i]);
+      (*undo_types)[i] = NULL;
+      *num_type_memsizes = return_vals[5].data.d_int32;
+      *type_memsizes = g_new (gdouble, *num_type_memsizes);
+      memcpy (*type_memsizes,
+              return_vals[6].data.d_floatarray,
+              *num_type_memsizes * sizeof (gdouble));
+    }
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
@@ -32,13 +32,20 @@ G_BEGIN_DECLS
 /* For information look into the C source or the html documentation */
 
 
-gboolean gimp_image_undo_group_start (gint32 image_ID);
-gboolean gimp_image_undo_group_end   (gint32 image_ID);
-gboolean gimp_image_undo_is_enabled  (gint32 image_ID);
-gboolean gimp_image_undo_disable     (gint32 image_ID);
-gboolean gimp_image_undo_enable      (gint32 image_ID);
-gboolean gimp_image_undo_freeze      (gint32 image_ID);
-gboolean gimp_image_undo_thaw        (gint32 image_ID);
+gboolean gimp_image_undo_group_start (gint32     image_ID);
+gboolean gimp_image_undo_group_end   (gint32     image_ID);
+gboolean gimp_image_undo_is_enabled  (gint32     image_ID);
+gboolean gimp_image_undo_disable     (gint32     image_ID);
+gboolean gimp_image_undo_enable      (gint32     image_ID);
+gboolean gimp_image_undo_freeze      (gint32     image_ID);
+gboolean gimp_image_undo_thaw        (gint32     image_ID);
+gboolean gimp_image_undo_get_memsize (gint32     image_ID,
+                                      gdouble   *undo_memsize,
+                                      gdouble   *redo_memsize,
+                                      gint      *num_undo_types,
+                                      gchar   ***undo_types,
+                                      gint      *num_type_memsizes,
+                                      gdouble  **type_memsizes);
 
 
 G_END_DECLS
@@ -70,6 +70,11 @@ static gint     gimp_get_portion_height   (GimpPixelRgnIterator *pri);
 static gpointer gimp_pixel_rgns_configure (GimpPixelRgnIterator *pri);
 static void     gimp_pixel_rgn_configure  (GimpPixelRgnHolder   *prh,
                                            GimpPixelRgnIterator *pri);
+static gint     gimp_pixel_rgn_ref_row    (GimpPixelRgn         *pr,
+                                           GimpTile            **tiles,
+                                           gint                  x,
+                                           gint                  y,
+                                           gint                  width);
 
 /**
  * gimp_pixel_rgn_init:
@@ -352,13 +357,15 @@ gimp_pixel_rgn_get_rect (GimpPixelRgn *pr,
                          gint          width,
                          gint          height)
 {
-  gulong  bufstride;
-  gint    xstart, ystart;
-  gint    xend, yend;
-  gint    xboundary;
-  gint    yboundary;
-  gint    xstep, ystep;
-  gint    ty, bpp;
+  gulong     bufstride;
+  gint       xstart, ystart;
+  gint       xend, yend;
+  gint       xboundary;
+  gint       yboundary;
+  gint       xstep, ystep;
+  gint       ty, bpp;
+  GimpTile **row;
+  gint       n_row;
 
   g_return_if_fail (pr != NULL && pr->drawable != NULL);
   g_return_if_fail (buf != NULL);
@@ -376,8 +383,13 @@ gimp_pixel_rgn_get_rect (GimpPixelRgn *pr,
   yend = y + height;
   ystep = 0;
 
+  row = g_new (GimpTile *, pr->drawable->ntile_cols);
+
   while (y < yend)
     {
+      /*  fetch the whole row of tiles at once  */
+      n_row = gimp_pixel_rgn_ref_row (pr, row, xstart, y, width);
+
       x = xstart;
 
       while (x < xend)
@@ -410,8 +422,12 @@ gimp_pixel_rgn_get_rect (GimpPixelRgn *pr,
           x += xstep;
         }
 
+      _gimp_tile_unref_batch (row, n_row, FALSE);
+
       y += ystep;
     }
+
+  g_free (row);
 }
 
 /**
@@ -586,13 +602,15 @@ gimp_pixel_rgn_set_rect (GimpPixelRgn *pr,
                          gint          width,
                          gint          height)
 {
-  gulong  bufstride;
-  gint    xstart, ystart;
-  gint    xend, yend;
-  gint    xboundary;
-  gint    yboundary;
-  gint    xstep, ystep;
-  gint    ty, bpp;
+  gulong     bufstride;
+  gint       xstart, ystart;
+  gint       xend, yend;
+  gint       xboundary;
+  gint       yboundary;
+  gint       xstep, ystep;
+  gint       ty, bpp;
+  GimpTile **row;
+  gint       n_row;
 
   g_return_if_fail (pr != NULL && pr->drawable != NULL);
   g_return_if_fail (buf != NULL);
@@ -610,8 +628,13 @@ gimp_pixel_rgn_set_rect (GimpPixelRgn *pr,
   yend = y + height;
   ystep = 0;
 
+  row = g_new (GimpTile *, pr->drawable->ntile_cols);
+
   while (y < yend)
     {
+      /*  fetch the whole row of tiles at once  */
+      n_row = gimp_pixel_rgn_ref_row (pr, row, xstart, y, width);
+
       x = xstart;
 
       while (x < xend)
@@ -644,8 +667,13 @@ gimp_pixel_rgn_set_rect (GimpPixelRgn *pr,
           x += xstep;
         }
 
+      /*  send the tiles back at once  */
+      _gimp_tile_unref_batch (row, n_row, FALSE);
+
       y += ystep;
     }
+
+  g_free (row);
 }
 
 /**
@@ -963,3 +991,26 @@ gimp_pixel_rgn_configure (GimpPixelRgnHolder   *prh,
   prh->pr->w = pri->portion_width;
   prh->pr->h = pri->portion_height;
 }
+
+/*  References the tiles covering the row of tiles at @y between @x
+ *  and @x + @width in a single transfer, and stores them in @tiles.
+ *  Returns the number of tiles.
+ */
+static gint
+gimp_pixel_rgn_ref_row (GimpPixelRgn  *pr,
+                        GimpTile     **tiles,
+                        gint           x,
+                        gint           y,
+                        gint           width)
+{
+  gint end     = x + width;
+  gint n_tiles = 0;
+
+  for (x -= x % TILE_WIDTH; x < end; x += TILE_WIDTH)
+    tiles[n_tiles++] = gimp_drawable_get_tile2 (pr->drawable, pr->shadow,
+                                                x, y);
+
+  _gimp_tile_ref_batch (tiles, n_tiles);
+
+  return n_tiles;
+}
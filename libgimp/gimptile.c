@@ -48,14 +48,23 @@
  */
 #define FREE_QUANTUM 0.1
 
+/*  The size of a tile slot in the shared memory segment, see gimp.c  */
+#define TILE_MAP_SIZE (gimp_tile_width () * gimp_tile_height () * 32)
 
-void         gimp_read_expect_msg   (GimpWireMessage *msg,
-                                     gint             type);
 
-static void  gimp_tile_get          (GimpTile        *tile);
-static void  gimp_tile_put          (GimpTile        *tile);
-static void  gimp_tile_cache_insert (GimpTile        *tile);
-static void  gimp_tile_cache_flush  (GimpTile        *tile);
+void             gimp_read_expect_msg     (GimpWireMessage *msg,
+                                           gint             type);
+
+static void      gimp_tile_get            (GimpTile        *tile);
+static void      gimp_tile_put            (GimpTile        *tile);
+static void      gimp_tile_transfer       (GimpTile       **tiles,
+                                           gint             n_tiles,
+                                           gboolean         put);
+static void      gimp_tile_transfer_batch (GimpTile       **tiles,
+                                           gint             n_tiles,
+                                           gboolean         put);
+static void      gimp_tile_cache_insert   (GimpTile        *tile);
+static gboolean  gimp_tile_cache_remove   (GimpTile        *tile);
 
 
 /*  private variables  */
@@ -168,10 +177,17 @@ gimp_tile_cache_ntiles (gulong ntiles)
 void
 _gimp_tile_cache_flush_drawable (GimpDrawable *drawable)
 {
-  GList *list;
+  GimpTile **tiles;
+  gint       n_tiles = 0;
+  GList     *list;
 
   g_return_if_fail (drawable != NULL);
 
+  if (! tile_hash_table)
+    return;
+
+  tiles = g_new (GimpTile *, g_hash_table_size (tile_hash_table));
+
   list = tile_list_head;
   while (list)
     {
@@ -179,9 +195,123 @@ _gimp_tile_cache_flush_drawable (GimpDrawable *drawable)
 
       list = list->next;
 
-      if (tile->drawable == drawable)
-        gimp_tile_cache_flush (tile);
+      if (tile->drawable == drawable && gimp_tile_cache_remove (tile))
+        tiles[n_tiles++] = tile;
     }
+
+  /*  send the dirty tiles back together  */
+  _gimp_tile_unref_batch (tiles, n_tiles, FALSE);
+
+  g_free (tiles);
+}
+
+/*  Like calling gimp_tile_ref() on all @tiles, but the tiles which
+ *  need to be fetched are transferred several at a time.
+ */
+void
+_gimp_tile_ref_batch (GimpTile **tiles,
+                      gint       n_tiles)
+{
+  GimpTile **fetch;
+  gint       n_fetch = 0;
+  gint       i;
+
+  g_return_if_fail (tiles != NULL || n_tiles == 0);
+
+  fetch = g_new (GimpTile *, n_tiles);
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      tiles[i]->ref_count++;
+
+      if (tiles[i]->ref_count == 1)
+        fetch[n_fetch++] = tiles[i];
+    }
+
+  gimp_tile_transfer (fetch, n_fetch, FALSE);
+
+  for (i = 0; i < n_fetch; i++)
+    fetch[i]->dirty = FALSE;
+
+  g_free (fetch);
+
+  for (i = 0; i < n_tiles; i++)
+    gimp_tile_cache_insert (tiles[i]);
+}
+
+/*  Like calling gimp_tile_unref() on all @tiles, but the dirty tiles
+ *  which are released are sent back several at a time.
+ */
+void
+_gimp_tile_unref_batch (GimpTile **tiles,
+                        gint       n_tiles,
+                        gboolean   dirty)
+{
+  GimpTile **flush;
+  gint       n_flush = 0;
+  gint       i;
+
+  g_return_if_fail (tiles != NULL || n_tiles == 0);
+
+  flush = g_new (GimpTile *, n_tiles);
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      tiles[i]->dirty |= dirty;
+
+      if (tiles[i]->ref_count == 1)
+        flush[n_flush++] = tiles[i];
+    }
+
+  _gimp_tile_flush_batch (flush, n_flush);
+
+  g_free (flush);
+
+  for (i = 0; i < n_tiles; i++)
+    gimp_tile_unref (tiles[i], FALSE);
+}
+
+/*  Like calling gimp_tile_flush() on all @tiles, but the dirty tiles
+ *  are sent several at a time.
+ */
+void
+_gimp_tile_flush_batch (GimpTile **tiles,
+                        gint       n_tiles)
+{
+  GimpTile **put;
+  gint       n_put = 0;
+  gint       i;
+
+  g_return_if_fail (tiles != NULL || n_tiles == 0);
+
+  put = g_new (GimpTile *, n_tiles);
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      if (tiles[i]->data && tiles[i]->dirty)
+        put[n_put++] = tiles[i];
+    }
+
+  gimp_tile_transfer (put, n_put, TRUE);
+
+  for (i = 0; i < n_put; i++)
+    put[i]->dirty = FALSE;
+
+  g_free (put);
+}
+
+/*  Returns the number of tiles which are transferred in one round
+ *  trip, which is 1 if tiles can't be batched.
+ */
+gint
+_gimp_tile_get_batch_size (void)
+{
+  extern gint _shm_n_tiles;
+
+  if (! gimp_shm_addr ())
+    return 1;
+
+  return _shm_n_tiles;
 }
 
 
@@ -283,6 +413,118 @@ gimp_tile_put (GimpTile *tile)
   gimp_wire_destroy (&msg);
 }
 
+/*  Gets or puts @tiles, using GP_TILE_BATCH for each run of up to
+ *  _gimp_tile_get_batch_size() tiles of the same drawable if the core
+ *  supports it.
+ */
+static void
+gimp_tile_transfer (GimpTile **tiles,
+                    gint       n_tiles,
+                    gboolean   put)
+{
+  gint batch_size = _gimp_tile_get_batch_size ();
+  gint start      = 0;
+
+  if (batch_size < 2)
+    {
+      for (start = 0; start < n_tiles; start++)
+        {
+          if (put)
+            gimp_tile_put (tiles[start]);
+          else
+            gimp_tile_get (tiles[start]);
+        }
+
+      return;
+    }
+
+  while (start < n_tiles)
+    {
+      gint n = 1;
+
+      while (start + n < n_tiles &&
+             n < batch_size      &&
+             tiles[start + n]->drawable == tiles[start]->drawable &&
+             tiles[start + n]->shadow   == tiles[start]->shadow)
+        {
+          n++;
+        }
+
+      gimp_tile_transfer_batch (tiles + start, n, put);
+
+      start += n;
+    }
+}
+
+static void
+gimp_tile_transfer_batch (GimpTile **tiles,
+                          gint       n_tiles,
+                          gboolean   put)
+{
+  extern GIOChannel *_writechannel;
+
+  GPTileBatch      tile_batch;
+  GPTileBatch     *tile_reply;
+  GimpWireMessage  msg;
+  guchar          *shm_addr = gimp_shm_addr ();
+  gint             i;
+
+  tile_batch.drawable_ID = tiles[0]->drawable->drawable_id;
+  tile_batch.shadow      = tiles[0]->shadow;
+  tile_batch.put         = put;
+  tile_batch.bpp         = tiles[0]->bpp;
+  tile_batch.n_tiles     = n_tiles;
+  tile_batch.tile_nums   = g_new (guint32, n_tiles);
+
+  for (i = 0; i < n_tiles; i++)
+    tile_batch.tile_nums[i] = tiles[i]->tile_num;
+
+  if (! gp_tile_batch_write (_writechannel, &tile_batch, NULL))
+    gimp_quit ();
+
+  g_free (tile_batch.tile_nums);
+
+  /*  the shared memory belongs to us only once the core sent the
+   *  batch back, and until we acknowledge it
+   */
+  gimp_read_expect_msg (&msg, GP_TILE_BATCH);
+
+  tile_reply = msg.data;
+  if (tile_reply->drawable_ID != tile_batch.drawable_ID ||
+      tile_reply->shadow      != tile_batch.shadow      ||
+      tile_reply->put         != tile_batch.put         ||
+      tile_reply->bpp         != tile_batch.bpp         ||
+      tile_reply->n_tiles     != tile_batch.n_tiles)
+    {
+      g_message ("received tile info did not match computed tile info");
+      gimp_quit ();
+    }
+
+  gimp_wire_destroy (&msg);
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      GimpTile *tile = tiles[i];
+
+      if (put)
+        memcpy (shm_addr + (gsize) i * TILE_MAP_SIZE,
+                tile->data,
+                tile->ewidth * tile->eheight * tile->bpp);
+      else
+        tile->data = g_memdup (shm_addr + (gsize) i * TILE_MAP_SIZE,
+                               tile->ewidth * tile->eheight * tile->bpp);
+    }
+
+  if (! gp_tile_ack_write (_writechannel, NULL))
+    gimp_quit ();
+
+  if (put)
+    {
+      gimp_read_expect_msg (&msg, GP_TILE_ACK);
+      gimp_wire_destroy (&msg);
+    }
+}
+
 /* This function is nearly identical to the function 'tile_cache_insert'
  *  in the file 'tile_cache.c' which is part of the main gimp application.
  */
@@ -332,13 +574,28 @@ gimp_tile_cache_insert (GimpTile *tile)
 
       if ((cur_cache_size + max_tile_size) > max_cache_size)
         {
+          GimpTile **evicted;
+          gint       n_evicted = 0;
+
+          evicted = g_new (GimpTile *, g_hash_table_size (tile_hash_table));
+
           while (tile_list_head &&
                  (cur_cache_size +
                   max_cache_size * FREE_QUANTUM) > max_cache_size)
             {
-              gimp_tile_cache_flush ((GimpTile *) tile_list_head->data);
+              GimpTile *evict = tile_list_head->data;
+
+              gimp_tile_cache_remove (evict);
+              evicted[n_evicted++] = evict;
             }
 
+          /*  the dirty tiles which drop out of the cache are sent back
+           *  together instead of one round trip each
+           */
+          _gimp_tile_unref_batch (evicted, n_evicted, FALSE);
+
+          g_free (evicted);
+
           if ((cur_cache_size + max_tile_size) > max_cache_size)
             return;
         }
@@ -368,13 +625,16 @@ gimp_tile_cache_insert (GimpTile *tile)
     }
 }
 
-static void
-gimp_tile_cache_flush (GimpTile *tile)
+/*  Removes @tile from the cache without releasing the cache's
+ *  reference, returns whether it was in the cache.
+ */
+static gboolean
+gimp_tile_cache_remove (GimpTile *tile)
 {
   GList *list;
 
   if (! tile_hash_table)
-    return;
+    return FALSE;
 
   /* Find where the tile is in the cache.
    */
@@ -403,8 +663,8 @@ gimp_tile_cache_flush (GimpTile *tile)
        */
       cur_cache_size -= max_tile_size;
 
-      /* Unreference the tile.
-       */
-      gimp_tile_unref (tile, FALSE);
+      return TRUE;
     }
+
+  return FALSE;
 }
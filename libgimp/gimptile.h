@@ -64,6 +64,15 @@ void    gimp_tile_cache_ntiles (gulong     ntiles);
 
 G_GNUC_INTERNAL void _gimp_tile_cache_flush_drawable (GimpDrawable *drawable);
 
+G_GNUC_INTERNAL void _gimp_tile_ref_batch            (GimpTile    **tiles,
+                                                      gint          n_tiles);
+G_GNUC_INTERNAL void _gimp_tile_unref_batch          (GimpTile    **tiles,
+                                                      gint          n_tiles,
+                                                      gboolean      dirty);
+G_GNUC_INTERNAL void _gimp_tile_flush_batch          (GimpTile    **tiles,
+                                                      gint          n_tiles);
+G_GNUC_INTERNAL gint _gimp_tile_get_batch_size       (void);
+
 
 G_END_DECLS
 
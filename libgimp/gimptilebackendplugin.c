@@ -73,9 +73,20 @@ static void       gimp_tile_write_mul (GimpTileBackendPlugin *backend_plugin,
                                        gint                   y,
                                        guchar                *source);
 
-static GeglTile * gimp_tile_read_mul (GimpTileBackendPlugin *backend_plugin,
-                                      gint                   x,
-                                      gint                   y);
+static GeglTile * gimp_tile_read_mul  (GimpTileBackendPlugin *backend_plugin,
+                                       gint                   x,
+                                       gint                   y);
+
+static gint       gimp_tile_get_mul   (GimpTileBackendPlugin *backend_plugin,
+                                       gint                   x,
+                                       gint                   y,
+                                       GimpTile             **tiles);
+static gint       gimp_tile_prefetch  (GimpTileBackendPlugin *backend_plugin,
+                                       gint                   x,
+                                       gint                   y,
+                                       GimpTile             **tiles,
+                                       gint                   n_tiles,
+                                       gint                   max_tiles);
 
 
 G_DEFINE_TYPE (GimpTileBackendPlugin, _gimp_tile_backend_plugin,
@@ -158,54 +169,61 @@ gimp_tile_read_mul (GimpTileBackendPlugin *backend_plugin,
   GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
   GeglTileBackend              *backend = GEGL_TILE_BACKEND (backend_plugin);
   GeglTile                     *tile;
+  GimpTile                    **tiles;
+  gint                          n_tiles;
+  gint                          n_fetched;
+  gint                          max_tiles;
   gint                          tile_size;
-  gint                          u, v;
-  gint                          mul = priv->mul;
+  gint                          i;
+  gint                          mul    = priv->mul;
+  gint                          n_cols = priv->drawable->ntile_cols;
   guchar                       *tile_data;
 
-  x *= mul;
-  y *= mul;
-
   tile_size  = gegl_tile_backend_get_tile_size (backend);
   tile       = gegl_tile_new (tile_size);
   tile_data  = gegl_tile_get_data (tile);
 
-  for (u = 0; u < mul; u++)
-    {
-      for (v = 0; v < mul; v++)
-        {
-          GimpTile *gimp_tile;
+  max_tiles = mul * mul + _gimp_tile_get_batch_size ();
 
-          if (x + u >= priv->drawable->ntile_cols ||
-              y + v >= priv->drawable->ntile_rows)
-            continue;
+  tiles   = g_new (GimpTile *, max_tiles);
+  n_tiles = gimp_tile_get_mul (backend_plugin, x, y, tiles);
+
+  /*  fetch the tiles of this GEGL tile together with the ones of the
+   *  GEGL tiles to its right, which are most likely asked for next,
+   *  so they arrive in as few tile batches as possible and wait in
+   *  the tile cache.  each batch holds the core's shared memory for
+   *  its whole exchange, see gimp_tile_transfer_batch()
+   */
+  n_fetched = gimp_tile_prefetch (backend_plugin, x, y, tiles, n_tiles,
+                                  max_tiles);
+
+  _gimp_tile_ref_batch (tiles, n_fetched);
 
-          gimp_tile = gimp_drawable_get_tile (priv->drawable,
-                                              priv->shadow,
-                                              y + v, x + u);
-          gimp_tile_ref (gimp_tile);
-
-          {
-            gint ewidth           = gimp_tile->ewidth;
-            gint eheight          = gimp_tile->eheight;
-            gint bpp              = gimp_tile->bpp;
-            gint tile_stride      = mul * TILE_WIDTH * bpp;
-            gint gimp_tile_stride = ewidth * bpp;
-            gint row;
-
-            for (row = 0; row < eheight; row++)
-              {
-                memcpy (tile_data + (row + TILE_HEIGHT * v) *
-                        tile_stride + u * TILE_WIDTH * bpp,
-                        ((gchar *) gimp_tile->data) + row * gimp_tile_stride,
-                        gimp_tile_stride);
-              }
-          }
-
-          gimp_tile_unref (gimp_tile, FALSE);
+  for (i = 0; i < n_tiles; i++)
+    {
+      GimpTile *gimp_tile        = tiles[i];
+      gint      u                = (gimp_tile->tile_num % n_cols) - x * mul;
+      gint      v                = (gimp_tile->tile_num / n_cols) - y * mul;
+      gint      ewidth           = gimp_tile->ewidth;
+      gint      eheight          = gimp_tile->eheight;
+      gint      bpp              = gimp_tile->bpp;
+      gint      tile_stride      = mul * TILE_WIDTH * bpp;
+      gint      gimp_tile_stride = ewidth * bpp;
+      gint      row;
+
+      for (row = 0; row < eheight; row++)
+        {
+          memcpy (tile_data + (row + TILE_HEIGHT * v) *
+                  tile_stride + u * TILE_WIDTH * bpp,
+                  ((gchar *) gimp_tile->data) + row * gimp_tile_stride,
+                  gimp_tile_stride);
         }
     }
 
+  _gimp_tile_unref_batch (tiles, n_fetched, FALSE);
+
+  g_free (tiles);
+
   return tile;
 }
 
@@ -216,8 +234,60 @@ gimp_tile_write_mul (GimpTileBackendPlugin *backend_plugin,
                      guchar                *source)
 {
   GimpTileBackendPluginPrivate *priv = backend_plugin->priv;
+  GimpTile                    **tiles;
+  gint                          n_tiles;
+  gint                          i;
+  gint                          mul    = priv->mul;
+  gint                          n_cols = priv->drawable->ntile_cols;
+
+  tiles   = g_new (GimpTile *, mul * mul);
+  n_tiles = gimp_tile_get_mul (backend_plugin, x, y, tiles);
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      GimpTile *gimp_tile        = tiles[i];
+      gint      u                = (gimp_tile->tile_num % n_cols) - x * mul;
+      gint      v                = (gimp_tile->tile_num / n_cols) - y * mul;
+      gint      ewidth           = gimp_tile->ewidth;
+      gint      eheight          = gimp_tile->eheight;
+      gint      bpp              = gimp_tile->bpp;
+      gint      tile_stride      = mul * TILE_WIDTH * bpp;
+      gint      gimp_tile_stride = ewidth * bpp;
+      gint      row;
+
+      /*  the GEGL tile covers the whole tile, no need to fetch it
+       *  from the core first
+       */
+      gimp_tile_ref_zero (gimp_tile);
+
+      for (row = 0; row < eheight; row++)
+        memcpy (((gchar *)gimp_tile->data) + row * gimp_tile_stride,
+                source + (row + v * TILE_HEIGHT) *
+                tile_stride + u * TILE_WIDTH * bpp,
+                gimp_tile_stride);
+    }
+
+  /*  the dirty tiles normally stay in the tile cache and are sent
+   *  together by gimp_drawable_flush() on GEGL_TILE_FLUSH
+   */
+  _gimp_tile_unref_batch (tiles, n_tiles, TRUE);
+
+  g_free (tiles);
+}
+
+/*  Stores the drawable's tiles which make up the GEGL tile at @x, @y
+ *  in @tiles and returns their number.
+ */
+static gint
+gimp_tile_get_mul (GimpTileBackendPlugin *backend_plugin,
+                   gint                   x,
+                   gint                   y,
+                   GimpTile             **tiles)
+{
+  GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
+  gint                          mul     = priv->mul;
+  gint                          n_tiles = 0;
   gint                          u, v;
-  gint                          mul = priv->mul;
 
   x *= mul;
   y *= mul;
@@ -226,35 +296,75 @@ gimp_tile_write_mul (GimpTileBackendPlugin *backend_plugin,
     {
       for (u = 0; u < mul; u++)
         {
-          GimpTile *gimp_tile;
-
           if (x + u >= priv->drawable->ntile_cols ||
               y + v >= priv->drawable->ntile_rows)
             continue;
 
-          gimp_tile = gimp_drawable_get_tile (priv->drawable,
-                                              priv->shadow,
-                                              y+v, x+u);
-          gimp_tile_ref (gimp_tile);
-
-          {
-            gint ewidth           = gimp_tile->ewidth;
-            gint eheight          = gimp_tile->eheight;
-            gint bpp              = gimp_tile->bpp;
-            gint tile_stride      = mul * TILE_WIDTH * bpp;
-            gint gimp_tile_stride = ewidth * bpp;
-            gint row;
-
-            for (row = 0; row < eheight; row++)
-              memcpy (((gchar *)gimp_tile->data) + row * gimp_tile_stride,
-                      source + (row + v * TILE_HEIGHT) *
-                      tile_stride + u * TILE_WIDTH * bpp,
-                      gimp_tile_stride);
-          }
-
-          gimp_tile_unref (gimp_tile, TRUE);
+          tiles[n_tiles++] = gimp_drawable_get_tile (priv->drawable,
+                                                     priv->shadow,
+                                                     y + v, x + u);
+        }
+    }
+
+  return n_tiles;
+}
+
+/*  Appends to @tiles the tiles of the GEGL tiles right of @x, @y
+ *  which are not in the tile cache yet, as many as fit into one tile
+ *  batch together with the uncached ones among the first @n_tiles,
+ *  and returns the new number of tiles.
+ */
+static gint
+gimp_tile_prefetch (GimpTileBackendPlugin *backend_plugin,
+                    gint                   x,
+                    gint                   y,
+                    GimpTile             **tiles,
+                    gint                   n_tiles,
+                    gint                   max_tiles)
+{
+  GimpTileBackendPluginPrivate *priv       = backend_plugin->priv;
+  gint                          mul        = priv->mul;
+  gint                          n_cols     = ((priv->drawable->ntile_cols +
+                                               mul - 1) / mul);
+  gint                          batch_size = _gimp_tile_get_batch_size ();
+  gint                          n_fetch    = 0;
+  GimpTile                    **next;
+  gint                          i;
+
+  /*  without batches, prefetching only adds round trips, which is
+   *  also the case if the shared memory couldn't be attached
+   */
+  if (batch_size < 2)
+    return n_tiles;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      if (tiles[i]->ref_count == 0)
+        n_fetch++;
+    }
+
+  next = g_new (GimpTile *, mul * mul);
+
+  for (x = x + 1; x < n_cols && n_fetch < batch_size; x++)
+    {
+      gint n_next = gimp_tile_get_mul (backend_plugin, x, y, next);
+
+      for (i = 0; i < n_next; i++)
+        {
+          if (n_fetch == batch_size || n_tiles == max_tiles)
+            break;
+
+          if (next[i]->ref_count == 0)
+            {
+              tiles[n_tiles++] = next[i];
+              n_fetch++;
+            }
         }
     }
+
+  g_free (next);
+
+  return n_tiles;
 }
 
 GeglTileBackend *
@@ -140,6 +140,14 @@ static void _gp_has_init_write           (GIOChannel       *channel,
                                           gpointer          user_data);
 static void _gp_has_init_destroy         (GimpWireMessage  *msg);
 
+static void _gp_tile_batch_read          (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_batch_write         (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_batch_destroy       (GimpWireMessage  *msg);
+
 
 
 void
@@ -197,6 +205,10 @@ gp_init (void)
                       _gp_has_init_read,
                       _gp_has_init_write,
                       _gp_has_init_destroy);
+  gimp_wire_register (GP_TILE_BATCH,
+                      _gp_tile_batch_read,
+                      _gp_tile_batch_write,
+                      _gp_tile_batch_destroy);
 }
 
 gboolean
@@ -442,6 +454,25 @@ gp_has_init_write (GIOChannel *channel,
   return TRUE;
 }
 
+gboolean
+gp_tile_batch_write (GIOChannel  *channel,
+                     GPTileBatch *tile_batch,
+                     gpointer     user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILE_BATCH;
+  msg.data = tile_batch;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
 /*  quit  */
 
 static void
@@ -503,7 +534,7 @@ _gp_config_read (GIOChannel      *channel,
                               user_data))
     goto cleanup;
   if (! _gimp_wire_read_int8 (channel,
-                              (guint8 *) &config->gimp_reserved_6, 1,
+                              (guint8 *) &config->shm_n_tiles, 1,
                               user_data))
     goto cleanup;
   if (! _gimp_wire_read_int8 (channel,
@@ -595,7 +626,7 @@ _gp_config_write (GIOChannel      *channel,
                                user_data))
     return;
   if (! _gimp_wire_write_int8 (channel,
-                               (const guint8 *) &config->gimp_reserved_6, 1,
+                               (const guint8 *) &config->shm_n_tiles, 1,
                                user_data))
     return;
   if (! _gimp_wire_write_int8 (channel,
@@ -1868,3 +1899,93 @@ static void
 _gp_has_init_destroy (GimpWireMessage *msg)
 {
 }
+
+/*  tile_batch  */
+
+static void
+_gp_tile_batch_read (GIOChannel      *channel,
+                     GimpWireMessage *msg,
+                     gpointer         user_data)
+{
+  GPTileBatch *tile_batch = g_slice_new0 (GPTileBatch);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tile_batch->drawable_ID, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch->put, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch->bpp, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_batch->n_tiles, 1, user_data))
+    goto cleanup;
+
+  if (tile_batch->n_tiles > GP_TILE_BATCH_MAX_TILES)
+    goto cleanup;
+
+  if (tile_batch->n_tiles > 0)
+    {
+      tile_batch->tile_nums = g_new (guint32, tile_batch->n_tiles);
+
+      if (! _gimp_wire_read_int32 (channel,
+                                   tile_batch->tile_nums,
+                                   tile_batch->n_tiles,
+                                   user_data))
+        goto cleanup;
+    }
+
+  msg->data = tile_batch;
+  return;
+
+ cleanup:
+  g_free (tile_batch->tile_nums);
+  g_slice_free (GPTileBatch, tile_batch);
+  msg->data = NULL;
+}
+
+static void
+_gp_tile_batch_write (GIOChannel      *channel,
+                      GimpWireMessage *msg,
+                      gpointer         user_data)
+{
+  GPTileBatch *tile_batch = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tile_batch->drawable_ID, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch->put, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch->bpp, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_batch->n_tiles, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                tile_batch->tile_nums,
+                                tile_batch->n_tiles, user_data))
+    return;
+}
+
+static void
+_gp_tile_batch_destroy (GimpWireMessage *msg)
+{
+  GPTileBatch *tile_batch = msg->data;
+
+  if (tile_batch)
+    {
+      g_free (tile_batch->tile_nums);
+      g_slice_free (GPTileBatch, tile_batch);
+    }
+}
@@ -26,7 +26,12 @@ G_BEGIN_DECLS
 
 /* Increment every time the protocol changes
  */
-#define GIMP_PROTOCOL_VERSION  0x0015
+#define GIMP_PROTOCOL_VERSION  0x0016
+
+/* The most tiles a GP_TILE_BATCH can transfer, the config's
+ * shm_n_tiles can't be larger
+ */
+#define GP_TILE_BATCH_MAX_TILES  G_MAXINT8
 
 
 enum
@@ -43,7 +48,8 @@ enum
   GP_PROC_INSTALL,
   GP_PROC_UNINSTALL,
   GP_EXTENSION_ACK,
-  GP_HAS_INIT
+  GP_HAS_INIT,
+  GP_TILE_BATCH
 };
 
 
@@ -51,6 +57,7 @@ typedef struct _GPConfig        GPConfig;
 typedef struct _GPTileReq       GPTileReq;
 typedef struct _GPTileAck       GPTileAck;
 typedef struct _GPTileData      GPTileData;
+typedef struct _GPTileBatch     GPTileBatch;
 typedef struct _GPParam         GPParam;
 typedef struct _GPParamDef      GPParamDef;
 typedef struct _GPProcRun       GPProcRun;
@@ -70,7 +77,7 @@ struct _GPConfig
   gint8    show_help_button;
   gint8    use_cpu_accel;
   gint8    use_opencl;
-  gint8    gimp_reserved_6;
+  gint8    shm_n_tiles;
   gint8    gimp_reserved_7;
   gint8    gimp_reserved_8;
   gint8    install_cmap;
@@ -103,6 +110,30 @@ struct _GPTileData
   guchar  *data;
 };
 
+/*  Transfers several tiles of one drawable in a single round trip.
+ *  Tile i is stored in the i-th tile sized slot of the shared memory
+ *  segment, which is shared by all plug-ins, so like with GP_TILE_REQ
+ *  the core owns it until the exchange is complete:
+ *
+ *  get: the plug-in sends the batch, the core fills the slots and
+ *       sends the batch back, the plug-in copies the slots out and
+ *       sends a GP_TILE_ACK.
+ *  put: the plug-in sends the batch, the core sends it back to grant
+ *       the slots, the plug-in fills them and sends a GP_TILE_ACK, the
+ *       core stores the tiles and sends a GP_TILE_ACK.
+ *
+ *  Only used if the config's shm_n_tiles is at least n_tiles.
+ */
+struct _GPTileBatch
+{
+  gint32   drawable_ID;
+  guint32  shadow;
+  guint32  put;
+  guint32  bpp;
+  guint32  n_tiles;
+  guint32 *tile_nums;
+};
+
 struct _GPParam
 {
   guint32 type;
@@ -224,6 +255,9 @@ gboolean  gp_extension_ack_write    (GIOChannel      *channel,
                                      gpointer         user_data);
 gboolean  gp_has_init_write         (GIOChannel      *channel,
                                      gpointer         user_data);
+gboolean  gp_tile_batch_write       (GIOChannel      *channel,
+                                     GPTileBatch     *tile_batch,
+                                     gpointer         user_data);
 
 void      gp_params_destroy         (GPParam         *params,
                                      gint             nparams);